@@ -0,0 +1,233 @@
+#include "MMapDataset.h"
+#include "Dataset.h"
+#include "ATen/ATen.h"
+#include "TH/THAllocator.h"
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace at;
+
+namespace {
+
+const char magic[8] = {'A', 'T', 'M', 'M', 'A', 'P', 'D', 'S'};
+const uint32_t version = 1;
+const uint64_t alignment = 64;
+
+// maps a file with THMapAllocator. Once the storage is mapped, unmapping it
+// frees the context, otherwise it is freed with the allocator:
+struct MapAllocator final : public Allocator {
+   MapAllocator(const std::string& filename, int flags)
+      : ctx_(THMapAllocatorContext_new(filename.c_str(), flags)), mapped_(false) {}
+   ~MapAllocator() {
+      if(!mapped_)
+         THMapAllocatorContext_free(ctx_);
+   }
+   void* allocate(std::size_t n) const override {
+      void* ptr = THMapAllocator.malloc(ctx_, n);
+      mapped_ = true;
+      return ptr;
+   }
+   void deallocate(void* ptr) const override {
+      THMapAllocator.free(ctx_, ptr);
+   }
+private:
+   THMapAllocatorContext* ctx_;
+   mutable bool mapped_;
+};
+
+struct FieldHeader {
+   std::string key;
+   ScalarType type;
+   std::vector<int64_t> sizes;
+   uint64_t offset;
+};
+
+template<typename T>
+void writeValue(std::ofstream& file, T value) {
+   file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+T readValue(std::ifstream& file, uint64_t& remaining) {
+   if(remaining < sizeof(T))
+      throw std::runtime_error("MMapDataset: truncated header");
+   remaining -= sizeof(T);
+   T value;
+   file.read(reinterpret_cast<char*>(&value), sizeof(T));
+   if(!file)
+      throw std::runtime_error("MMapDataset: truncated header");
+   return value;
+}
+
+uint64_t headerSize(const std::vector<FieldHeader>& headers) {
+   uint64_t size = sizeof(magic) + 2 * sizeof(uint32_t) + sizeof(uint64_t);
+   for(auto& header : headers) {
+      size += sizeof(uint32_t) + header.key.size() + sizeof(int32_t) + sizeof(uint32_t);
+      size += header.sizes.size() * sizeof(int64_t) + sizeof(uint64_t);
+   }
+   return size;
+}
+
+uint64_t alignUp(uint64_t n) {
+   return (n + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+MMapDataset::MMapDataset(const std::string& filename) {
+
+   // read header:
+   std::ifstream file(filename, std::ios::binary | std::ios::ate);
+   if(!file)
+      throw std::runtime_error("MMapDataset: unable to open " + filename);
+   uint64_t filesize = file.tellg();
+   file.seekg(0);
+   char filemagic[sizeof(magic)];
+   file.read(filemagic, sizeof(magic));
+   if(!file || memcmp(filemagic, magic, sizeof(magic)) != 0)
+      throw std::runtime_error("MMapDataset: " + filename + " is not a dataset file");
+   uint64_t remaining = filesize - sizeof(magic);
+   if(readValue<uint32_t>(file, remaining) != version)
+      throw std::runtime_error("MMapDataset: unsupported version of " + filename);
+   uint32_t numfields = readValue<uint32_t>(file, remaining);
+   size_ = readValue<uint64_t>(file, remaining);
+   if(size_ > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+      throw std::runtime_error("MMapDataset: invalid number of samples in " + filename);
+   std::vector<FieldHeader> headers;
+   for(uint32_t i = 0; i < numfields; ++i) {
+      FieldHeader header;
+      uint32_t keysize = readValue<uint32_t>(file, remaining);
+      if(keysize > remaining)
+         throw std::runtime_error("MMapDataset: truncated header");
+      remaining -= keysize;
+      header.key.resize(keysize);
+      file.read(&header.key[0], keysize);
+      int32_t type = readValue<int32_t>(file, remaining);
+      if(type < 0 || type >= static_cast<int32_t>(ScalarType::NumOptions))
+         throw std::runtime_error("MMapDataset: invalid type of field " + header.key);
+      header.type = static_cast<ScalarType>(type);
+      uint32_t ndims = readValue<uint32_t>(file, remaining);
+      if(ndims > remaining / sizeof(int64_t))
+         throw std::runtime_error("MMapDataset: truncated header");
+      header.sizes.resize(ndims);
+      for(auto& size : header.sizes) {
+         size = readValue<int64_t>(file, remaining);
+         if(size < 0)
+            throw std::runtime_error("MMapDataset: invalid size of field " + header.key);
+      }
+      header.offset = readValue<uint64_t>(file, remaining);
+      headers.push_back(header);
+   }
+
+   // map the file once per scalar type, and create views of the arrays:
+   std::map<ScalarType, std::unique_ptr<Storage>> storages;
+   for(auto& header : headers) {
+      Type& type = CPU(header.type);
+      uint64_t elementsize = type.elementSizeInBytes();
+      if(header.offset % elementsize != 0)
+         throw std::runtime_error("MMapDataset: field " + header.key + " is misaligned");
+      if(header.offset > filesize)
+         throw std::runtime_error("MMapDataset: " + filename + " is truncated");
+      // the number of elements that fit behind the offset bounds the field
+      uint64_t available = (filesize - header.offset) / elementsize;
+      uint64_t numel = size_;
+      for(auto size : header.sizes) {
+         if(size != 0 && numel > available / size)
+            throw std::runtime_error("MMapDataset: " + filename + " is truncated");
+         numel *= size;
+      }
+      if(numel > available)
+         throw std::runtime_error("MMapDataset: " + filename + " is truncated");
+      auto& storage = storages[header.type];
+      if(!storage) {
+         storage = type.storageWithAllocator(filesize / elementsize,
+            std::unique_ptr<Allocator>(new MapAllocator(filename, 0)));
+      }
+      std::vector<int64_t> fieldsize;
+      fieldsize.push_back(size_);
+      fieldsize.insert(fieldsize.end(), header.sizes.begin(), header.sizes.end());
+      fields_[header.key] = type.tensor(*storage, header.offset / elementsize, fieldsize);
+      addFieldKey(header.key);
+   }
+}
+
+void MMapDataset::getField(uint64_t idx, std::string& fieldkey, at::Tensor& field) {
+
+   // assertions:
+   assert(idx < size());
+   assert(hasField(fieldkey));
+
+   field = select(fields_[fieldkey], 0, idx);
+}
+
+uint64_t MMapDataset::size() {
+   return size_;
+}
+
+void MMapDataset::write(Dataset& dataset, const std::string& filename) {
+
+   // use the first sample to determine the types and sizes of the fields:
+   uint64_t numsamples = dataset.size();
+   assert(numsamples > 0);
+   std::vector<FieldHeader> headers;
+   for(auto& fieldkey : dataset.fieldKeys()) {
+      FieldHeader header;
+      header.key = fieldkey;
+      Tensor sample;
+      dataset.getField(0, header.key, sample);
+      header.type = sample.type().scalarType();
+      header.sizes = sample.sizes().vec();
+      headers.push_back(header);
+   }
+   uint64_t offset = alignUp(headerSize(headers));
+   for(auto& header : headers) {
+      header.offset = offset;
+      uint64_t numel = numsamples;
+      for(auto size : header.sizes)
+         numel *= size;
+      offset = alignUp(offset + numel * CPU(header.type).elementSizeInBytes());
+   }
+
+   // write header:
+   std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+   if(!file)
+      throw std::runtime_error("MMapDataset: unable to create " + filename);
+   file.write(magic, sizeof(magic));
+   writeValue<uint32_t>(file, version);
+   writeValue<uint32_t>(file, headers.size());
+   writeValue<uint64_t>(file, numsamples);
+   for(auto& header : headers) {
+      writeValue<uint32_t>(file, header.key.size());
+      file.write(header.key.data(), header.key.size());
+      writeValue<int32_t>(file, static_cast<int32_t>(header.type));
+      writeValue<uint32_t>(file, header.sizes.size());
+      for(auto size : header.sizes)
+         writeValue<int64_t>(file, size);
+      writeValue<uint64_t>(file, header.offset);
+   }
+
+   // stream samples, one field at a time:
+   for(auto& header : headers) {
+      std::vector<char> padding(header.offset - file.tellp(), 0);
+      file.write(padding.data(), padding.size());
+      for(uint64_t idx = 0; idx < numsamples; ++idx) {
+         Tensor sample;
+         dataset.getField(idx, header.key, sample);
+         if(sample.type().scalarType() != header.type || sample.sizes().vec() != header.sizes)
+            throw std::runtime_error("MMapDataset: samples of field " + header.key +
+                                     " differ in type or size");
+         sample = sample.toBackend(kCPU).contiguous();
+         file.write(static_cast<const char*>(sample.data_ptr()),
+                    sample.numel() * sample.type().elementSizeInBytes());
+      }
+   }
+   std::vector<char> padding(offset - file.tellp(), 0);
+   file.write(padding.data(), padding.size());
+   if(!file)
+      throw std::runtime_error("MMapDataset: error while writing " + filename);
+}
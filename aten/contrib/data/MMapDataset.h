@@ -0,0 +1,42 @@
+#ifndef AT_MMAP_DATASET_H
+#define AT_MMAP_DATASET_H
+
+#include "Dataset.h"
+#include "ATen/ATen.h"
+#include <map>
+#include <string>
+
+// Dataset backed by a memory-mapped file. The file starts with a header
+// describing every field (name, scalar type and per-sample shape), followed
+// by one contiguous array per field, holding the field of all samples and
+// starting at a 64-byte aligned offset:
+//
+//    char[8]   magic ("ATMMAPDS")
+//    uint32_t  version
+//    uint32_t  number of fields
+//    uint64_t  number of samples
+//    per field:
+//       uint32_t  length of the name, followed by the name
+//       int32_t   at::ScalarType
+//       uint32_t  number of dimensions of a sample, followed by int64_t sizes
+//       uint64_t  offset of the array from the beginning of the file
+//
+// The file is opened read-only and mapped privately, so all processes that
+// open it share the page cache, and getField returns views into the mapping
+// without copying. Writing into these views copies the touched pages, and
+// never modifies the file.
+class MMapDataset : public Dataset
+{
+public:
+   MMapDataset(const std::string& filename);
+   virtual void getField(uint64_t idx, std::string& fieldkey, at::Tensor& field);
+   virtual uint64_t size();
+
+   // streams all the fields of dataset into filename
+   static void write(Dataset& dataset, const std::string& filename);
+private:
+   uint64_t size_;
+   std::map<std::string, at::Tensor> fields_;
+};
+
+#endif
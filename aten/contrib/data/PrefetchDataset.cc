@@ -0,0 +1,151 @@
+#include "PrefetchDataset.h"
+#include "Dataset.h"
+#include "ATen/ATen.h"
+#include "ATen/PinnedMemoryAllocator.h"
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+using namespace at;
+
+PrefetchDataset::PrefetchDataset(Dataset& dataset, uint64_t batchsize, uint64_t numthreads,
+                                 uint64_t queuedepth, bool pinned, bool fullbatches) {
+
+   // assertions:
+   assert(batchsize > 0);
+   assert(numthreads > 0);
+   assert(queuedepth > 0);
+
+   dataset_ = &dataset;
+   batchsize_ = batchsize;
+   numthreads_ = numthreads;
+   size_ = dataset_->size() / batchsize_;
+   if(!fullbatches && dataset_->size() % batchsize_ != 0)
+      size_++;
+   next_ = 0;
+   for(auto& fieldkey : dataset_->fieldKeys()) {
+      std::string key = fieldkey;
+      addFieldKey(key);
+   }
+
+   // allocate buffers, using the first sample to determine the sizes. One
+   // slot more than queuedepth, because the batch returned last is still in
+   // use while the next ones are being fetched:
+   for(uint64_t n = 0; n < queuedepth + 1; ++n)
+      slots_.emplace_back(new Slot());
+   for(auto& fieldkey : fieldKeys()) {
+      std::string key = fieldkey;
+      Tensor sample;
+      dataset_->getField(0, key, sample);
+      std::vector<int64_t> fieldsize;
+      fieldsize.push_back(batchsize_);
+      for(int64_t d = 0; d < sample.dim(); ++d)
+         fieldsize.push_back(sample.size(d));
+      for(auto& slot : slots_) {
+         if(pinned) {
+            slot->fields[key] = sample.type().tensorWithAllocator(
+               fieldsize, std::unique_ptr<Allocator>(new PinnedMemoryAllocator()));
+         } else {
+            slot->fields[key] = sample.type().tensor(fieldsize);
+         }
+      }
+   }
+   pool_.reset(new ThreadPool(numthreads_));
+   for(uint64_t n = 0; n < queuedepth && n < size_; ++n)
+      schedule(n);
+}
+
+PrefetchDataset::~PrefetchDataset() {
+   // the fetch tasks refer to the slots, so wait for them first:
+   for(auto& slot : slots_)
+      wait(*slot);
+}
+
+uint64_t PrefetchDataset::batchSize(uint64_t batch) {
+   return std::min(batchsize_, dataset_->size() - batch * batchsize_);
+}
+
+void PrefetchDataset::schedule(uint64_t batch) {
+   Slot& slot = *slots_[batch % slots_.size()];
+   wait(slot);
+   slot.batch = batch;
+   slot.error = nullptr;
+
+   // split the batch into one chunk of samples per thread:
+   uint64_t maxsize = batchSize(batch);
+   uint64_t chunksize = (maxsize + numthreads_ - 1) / numthreads_;
+   uint64_t begin = batch * batchsize_;
+   for(uint64_t n = 0; n < maxsize; n += chunksize) {
+      uint64_t end = std::min(n + chunksize, maxsize);
+      unsigned int handle = pool_->enqueue(&PrefetchDataset::fetch, this, &slot,
+                                           begin + n, begin + end);
+      tasks_[handle] = &slot;
+      slot.pending++;
+   }
+   next_ = batch + 1;
+}
+
+void PrefetchDataset::wait(Slot& slot) {
+   while(slot.pending > 0) {
+      auto it = tasks_.find(pool_->waitFor());
+      assert(it != tasks_.end());
+      it->second->pending--;
+      tasks_.erase(it);
+   }
+}
+
+void PrefetchDataset::fetch(Slot* slot, uint64_t begin, uint64_t end) {
+   // errors are rethrown by getField, ThreadPool can't recover from them:
+   try {
+      uint64_t first = slot->batch * batchsize_;
+      for(uint64_t idx = begin; idx < end; ++idx) {
+         for(auto& field : slot->fields) {
+            std::string fieldkey = field.first;
+            Tensor row = select(field.second, 0, idx - first);
+            Tensor sample = row;
+            dataset_->getField(idx, fieldkey, sample);
+            // datasets that don't write into the given tensor need a copy:
+            if(sample.data_ptr() != row.data_ptr())
+               row.copy_(sample);
+         }
+      }
+   } catch(...) {
+      std::lock_guard<std::mutex> lock(slot->mutex);
+      slot->error = std::current_exception();
+   }
+}
+
+void PrefetchDataset::getField(uint64_t idx, std::string& fieldkey, at::Tensor& field) {
+
+   // assertions:
+   assert(idx < size());
+   assert(hasField(fieldkey));
+
+   // batches outside of the prefetched window restart prefetching:
+   Slot& slot = *slots_[idx % slots_.size()];
+   if(slot.batch != (int64_t) idx) {
+      for(auto& s : slots_)
+         wait(*s);
+      schedule(idx);
+   }
+   wait(slot);
+   if(slot.error) {
+      std::exception_ptr error = slot.error;
+      slot.error = nullptr;
+      slot.batch = -1;
+      std::rethrow_exception(error);
+   }
+
+   // keep queuedepth batches in flight after this one:
+   while(next_ < (int64_t) size_ && next_ < (int64_t) (idx + slots_.size()))
+      schedule(next_);
+
+   uint64_t maxsize = batchSize(idx);
+   field = slot.fields[fieldkey];
+   if(maxsize < batchsize_)
+      field = field.narrow(0, 0, maxsize);
+}
+
+uint64_t PrefetchDataset::size() {
+   return size_;
+}
@@ -0,0 +1,52 @@
+#ifndef AT_PREFETCH_DATASET_H
+#define AT_PREFETCH_DATASET_H
+
+#include "Dataset.h"
+#include "threadpool/ThreadPool.h"
+#include "ATen/ATen.h"
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Batches a dataset like BatchDataset, but fetches the samples of the next
+// queuedepth batches in the background, using numthreads threads. Samples are
+// written straight into pre-allocated (optionally pinned) batch buffers.
+//
+// Batches are expected to be requested in order. The tensor returned by
+// getField is a view of an internal buffer, which is reused as soon as the
+// next batch is requested.
+class PrefetchDataset : public Dataset
+{
+public:
+   PrefetchDataset(Dataset& dataset, uint64_t batchsize, uint64_t numthreads,
+                   uint64_t queuedepth, bool pinned = false, bool fullbatches = true);
+   virtual ~PrefetchDataset();
+   virtual void getField(uint64_t idx, std::string& fieldkey, at::Tensor& field);
+   virtual uint64_t size();
+private:
+   struct Slot {
+      int64_t batch = -1;        // batch held (or being fetched) by this slot
+      uint64_t pending = 0;      // number of unfinished fetch tasks
+      Fields fields;             // batch buffers of all fields
+      std::exception_ptr error;  // first error raised while fetching
+      std::mutex mutex;          // guards error
+   };
+   void schedule(uint64_t batch);
+   void wait(Slot& slot);
+   void fetch(Slot* slot, uint64_t begin, uint64_t end);
+   uint64_t batchSize(uint64_t batch);
+
+   Dataset* dataset_;
+   uint64_t batchsize_;
+   uint64_t size_;
+   uint64_t numthreads_;
+   int64_t next_;                // next batch to be scheduled
+   std::vector<std::unique_ptr<Slot>> slots_;
+   std::map<unsigned int, Slot*> tasks_;
+   std::unique_ptr<ThreadPool> pool_;
+};
+
+#endif
@@ -18,6 +18,9 @@ void TensorDataset::getField(uint64_t idx, std::string& fieldkey, Tensor& field)
 
    // get sample:
    Tensor buffer = select(t_, 0, idx);
+   if(!field.defined())
+      field = buffer.type().tensor();
+   field.resize_(buffer.sizes());
    field.copy_(buffer);
 
 }
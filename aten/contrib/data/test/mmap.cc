@@ -0,0 +1,65 @@
+#include "MMapDataset.h"
+#include "TensorDataset.h"
+#include "ATen/test/test_assert.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+using namespace at;
+
+int main()
+{
+   const char* tmpdir = std::getenv("TMPDIR");
+   std::string dirname = std::string(tmpdir ? tmpdir : "/tmp") + "/test-mmap-XXXXXX";
+   ASSERT(mkdtemp(&dirname[0]) != nullptr);
+   std::string filename = dirname + "/test.dataset";
+   Tensor input = CPU(kFloat).rand({37, 3, 5});
+   std::string key = "input";
+   TensorDataset dataset(input, key);
+   MMapDataset::write(dataset, filename);
+
+   {
+      MMapDataset mmap(filename);
+      ASSERT(mmap.size() == 37);
+      ASSERT(mmap.hasField(key));
+      for(uint64_t idx = 0; idx < mmap.size(); ++idx) {
+         Tensor sample;
+         mmap.getField(idx, key, sample);
+         ASSERT(sample.sizes().vec() == std::vector<int64_t>({3, 5}));
+         ASSERT(sample.equal(input.select(0, idx)));
+      }
+      // samples are views into the same mapping
+      Tensor first, second;
+      mmap.getField(0, key, first);
+      mmap.getField(1, key, second);
+      ASSERT(static_cast<float*>(second.data_ptr()) - static_cast<float*>(first.data_ptr()) == 15);
+      // the mapping is private, writes don't reach the file
+      first.zero_();
+   }
+   {
+      MMapDataset mmap(filename);
+      Tensor first;
+      mmap.getField(0, key, first);
+      ASSERT(first.equal(input.select(0, 0)));
+   }
+
+   // corrupt the scalar type of the field, which follows magic, version,
+   // number of fields, number of samples and the key
+   {
+      std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+      file.seekp(8 + 4 + 4 + 8 + 4 + key.size());
+      int32_t type = 1000;
+      file.write(reinterpret_cast<const char*>(&type), sizeof(type));
+   }
+   ASSERT_THROWS(MMapDataset mmap(filename), "invalid type");
+   // a header that ends early is detected before anything is mapped
+   ASSERT(truncate(filename.c_str(), 30) == 0);
+   ASSERT_THROWS(MMapDataset mmap(filename), "truncated header");
+
+   std::remove(filename.c_str());
+   rmdir(dirname.c_str());
+   std::cout << "mmap: OK\n";
+   return 0;
+}
@@ -0,0 +1,31 @@
+#include "PrefetchDataset.h"
+#include "TensorDataset.h"
+#include "ATen/test/test_assert.h"
+#include <iostream>
+
+using namespace at;
+
+int main()
+{
+   Tensor tensor = CPU(kFloat).rand({103, 7});
+   std::string key = "input";
+   TensorDataset dataset(tensor, key);
+
+   for(bool fullbatches : {true, false}) {
+      PrefetchDataset prefetch(dataset, 10, 3, 4, false, fullbatches);
+      ASSERT(prefetch.size() == (fullbatches ? 10 : 11));
+      for(uint64_t idx = 0; idx < prefetch.size(); ++idx) {
+         Tensor batch;
+         prefetch.getField(idx, key, batch);
+         uint64_t n = std::min<uint64_t>(10, 103 - idx * 10);
+         ASSERT(batch.size(0) == (int64_t) n);
+         ASSERT(batch.equal(tensor.narrow(0, idx * 10, n)));
+      }
+      // random access restarts prefetching
+      Tensor batch;
+      prefetch.getField(2, key, batch);
+      ASSERT(batch.equal(tensor.narrow(0, 20, 10)));
+   }
+   std::cout << "prefetch: OK\n";
+   return 0;
+}
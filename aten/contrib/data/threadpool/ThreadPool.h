@@ -2,6 +2,9 @@
 #define AT_THREADPOOL_H
 
 // dependencies:
+#include <functional>
+#include <memory>
+#include <stdexcept>
 #include <vector>
 #include <queue>
 #include <thread>
@@ -8,6 +8,7 @@
 namespace at {
 
 struct Allocator {
+  virtual ~Allocator() {}
   virtual void* allocate(std::size_t n) const = 0;
   virtual void deallocate(void* ptr) const = 0;
 };
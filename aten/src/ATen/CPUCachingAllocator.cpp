@@ -0,0 +1,15 @@
+#include "CPUCachingAllocator.h"
+
+#include <TH/THAllocator.h>
+
+namespace at {
+
+void* CPUCachingAllocator::allocate(std::size_t n) const {
+  return THCachingAllocator.malloc(nullptr, n);
+}
+
+void CPUCachingAllocator::deallocate(void* ptr) const {
+  THCachingAllocator.free(nullptr, ptr);
+}
+
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "Allocator.h"
+
+namespace at {
+
+// Allocates from TH's caching allocator (THCachingAllocator), whether or not
+// it's enabled as the default for new storages.
+struct CPUCachingAllocator final : public Allocator {
+  void* allocate(std::size_t n) const override;
+  void deallocate(void* ptr) const override;
+};
+
+}
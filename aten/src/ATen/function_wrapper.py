@@ -209,7 +209,7 @@ CHECKED_CAST = {
             'check_generator<${Backend}Generator>(${arg_name}, &context->defaultGenerator(backend()))'),
     'THSize*': CodeTemplate('THLongStorageView::makeFromSize(${arg_name})'),
     'THStride*': CodeTemplate('THLongStorageView::makeFromStride(${arg_name}, ${noelem_to_empty})'),
-    'real': CodeTemplate('${arg_name}.to${ScalarName}()'),
+    'real': CodeTemplate('${to_th_real}(${arg_name}.to${ScalarName}())'),
     'accreal': CodeTemplate('${arg_name}.to${AccScalarName}()'),
     'TensorList': CodeTemplate('tensor_list_checked_cast<${Tensor}, Tensor, '
                                '${THTensor}>(${arg_name},"${arg_name}",${arg_pos})'),
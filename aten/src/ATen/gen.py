@@ -237,6 +237,7 @@ def generate_storage_type_and_tensor(backend, density, scalar_type, declarations
         env['storage_device'] = 'throw std::runtime_error("CPU storage has no device");'
         env['Generator'] = 'CPUGenerator'
     env['AS_REAL'] = env['ScalarType']
+    env['to_th_real'] = ''
     if scalar_name == "Half":
         env['SparseTensor'] = 'Tensor'
         if backend == "CUDA":
@@ -247,6 +248,7 @@ def generate_storage_type_and_tensor(backend, density, scalar_type, declarations
         else:
             env['to_th_type'] = 'HalfFix<THHalf,Half>'
             env['to_at_type'] = 'HalfFix<Half,THHalf>'
+            env['to_th_real'] = 'HalfFix<THHalf,Half>'
     elif scalar_name == 'Long':
         env['to_th_type'] = 'long'
         env['to_at_type'] = 'int64_t'
@@ -0,0 +1,155 @@
+#include "ATen/native/FFTPlan.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace at { namespace native {
+
+namespace {
+
+bool is_pow2(int64_t n) {
+  return (n & (n - 1)) == 0;
+}
+
+// Plans are cheap to keep around, but sizes can come from user input, so
+// the cache is dropped once it grows past this many entries.
+constexpr size_t max_cached_plans = 256;
+
+} // anonymous namespace
+
+FFTPlan::FFTPlan(int64_t n) : n(n) {
+  if (n <= 0) {
+    throw std::runtime_error("FFTPlan: expected a positive size");
+  }
+  const double pi = std::acos(-1.0);
+  if (is_pow2(n)) {
+    twiddles.resize(n / 2);
+    for (int64_t k = 0; k < n / 2; k++) {
+      twiddles[k] = std::polar(1.0, -2 * pi * k / n);
+    }
+    int64_t log2n = 0;
+    while ((int64_t(1) << log2n) < n) log2n++;
+    bitrev.resize(n);
+    for (int64_t k = 0; k < n; k++) {
+      int64_t r = 0;
+      for (int64_t b = 0; b < log2n; b++) {
+        r |= ((k >> b) & 1) << (log2n - 1 - b);
+      }
+      bitrev[k] = r;
+    }
+    return;
+  }
+  int64_t m = 1;
+  while (m < 2 * n - 1) m <<= 1;
+  conv_plan = fft_plan(m);
+  chirp.resize(n);
+  for (int64_t k = 0; k < n; k++) {
+    // reduce k^2 modulo 2n to keep the phase accurate for large k
+    int64_t k2 = (k * k) % (2 * n);
+    chirp[k] = std::polar(1.0, -pi * k2 / n);
+  }
+  chirp_fft.assign(m, complex_type(0));
+  chirp_fft[0] = std::conj(chirp[0]);
+  for (int64_t k = 1; k < n; k++) {
+    chirp_fft[k] = chirp_fft[m - k] = std::conj(chirp[k]);
+  }
+  conv_plan->execute_pow2(chirp_fft.data(), false);
+}
+
+int64_t FFTPlan::scratch_size() const {
+  return conv_plan ? conv_plan->n : 0;
+}
+
+void FFTPlan::execute_pow2(complex_type* data, bool inverse) const {
+  for (int64_t k = 0; k < n; k++) {
+    if (k < bitrev[k]) {
+      std::swap(data[k], data[bitrev[k]]);
+    }
+  }
+  auto twiddle = [&](int64_t k) {
+    return inverse ? std::conj(twiddles[k]) : twiddles[k];
+  };
+  // multiplication by -i (forward) or i (inverse)
+  auto rotate = [&](complex_type x) {
+    return inverse ? complex_type(-x.imag(), x.real()) : complex_type(x.imag(), -x.real());
+  };
+  int64_t h = 1;
+  int64_t log2n = 0;
+  while ((int64_t(1) << log2n) < n) log2n++;
+  if (log2n % 2 == 1) {
+    for (int64_t k = 0; k < n; k += 2) {
+      complex_type a = data[k], b = data[k + 1];
+      data[k] = a + b;
+      data[k + 1] = a - b;
+    }
+    h = 2;
+  }
+  // each pass fuses the radix-2 stages of half sizes h and 2h
+  for (; h < n; h *= 4) {
+    const int64_t step1 = n / (2 * h);
+    const int64_t step2 = n / (4 * h);
+    for (int64_t block = 0; block < n; block += 4 * h) {
+      for (int64_t j = 0; j < h; j++) {
+        complex_type* p = data + block + j;
+        complex_type w1 = twiddle(j * step1);
+        complex_type w2 = twiddle(j * step2);
+        complex_type b = w1 * p[h], d = w1 * p[3 * h];
+        complex_type a1 = p[0] + b, b1 = p[0] - b;
+        complex_type c1 = p[2 * h] + d, d1 = p[2 * h] - d;
+        complex_type c2 = w2 * c1, d2 = rotate(w2 * d1);
+        p[0] = a1 + c2;
+        p[2 * h] = a1 - c2;
+        p[h] = b1 + d2;
+        p[3 * h] = b1 - d2;
+      }
+    }
+  }
+}
+
+void FFTPlan::execute(complex_type* data, bool inverse, complex_type* scratch) const {
+  if (!conv_plan) {
+    execute_pow2(data, inverse);
+    return;
+  }
+  // the inverse transform is the conjugate of the forward transform of the
+  // conjugated input
+  const int64_t m = conv_plan->n;
+  for (int64_t k = 0; k < n; k++) {
+    scratch[k] = (inverse ? std::conj(data[k]) : data[k]) * chirp[k];
+  }
+  std::fill(scratch + n, scratch + m, complex_type(0));
+  conv_plan->execute_pow2(scratch, false);
+  for (int64_t k = 0; k < m; k++) {
+    scratch[k] *= chirp_fft[k];
+  }
+  conv_plan->execute_pow2(scratch, true);
+  const double scale = 1.0 / m;
+  for (int64_t k = 0; k < n; k++) {
+    complex_type x = scratch[k] * chirp[k] * scale;
+    data[k] = inverse ? std::conj(x) : x;
+  }
+}
+
+std::shared_ptr<const FFTPlan> fft_plan(int64_t n) {
+  static std::mutex mutex;
+  static std::unordered_map<int64_t, std::shared_ptr<const FFTPlan>> cache;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(n);
+    if (it != cache.end()) {
+      return it->second;
+    }
+  }
+  // build outside of the lock; Bluestein plans look up their convolution plan
+  auto plan = std::make_shared<const FFTPlan>(n);
+  std::lock_guard<std::mutex> lock(mutex);
+  if (cache.size() >= max_cached_plans) {
+    cache.clear();
+  }
+  return cache.emplace(n, plan).first->second;
+}
+
+}} // namespace at::native
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace at { namespace native {
+
+// A plan for unnormalized one-dimensional complex FFTs of a fixed size,
+// computed in double precision.
+//
+// Power-of-two sizes are transformed with an iterative radix-2^2 algorithm
+// (two radix-2 stages fused into one radix-4 butterfly, plus a single radix-2
+// stage when log2(n) is odd). Other sizes use Bluestein's algorithm, which
+// turns the transform into a circular convolution of power-of-two size.
+//
+// Plans are immutable once constructed and can be shared between threads.
+struct FFTPlan {
+  using complex_type = std::complex<double>;
+
+  explicit FFTPlan(int64_t n);
+
+  // Transforms n elements of data in place. scratch must point to at least
+  // scratch_size() elements and must not be shared between threads.
+  void execute(complex_type* data, bool inverse, complex_type* scratch) const;
+  int64_t scratch_size() const;
+
+  const int64_t n;
+
+private:
+  void execute_pow2(complex_type* data, bool inverse) const;
+
+  // power of two sizes
+  std::vector<complex_type> twiddles;   // exp(-2 pi i k / n), k < n / 2
+  std::vector<int64_t> bitrev;
+  // Bluestein
+  std::shared_ptr<const FFTPlan> conv_plan;
+  std::vector<complex_type> chirp;      // exp(-pi i k^2 / n), k < n
+  std::vector<complex_type> chirp_fft;  // FFT of the chirp filter
+};
+
+// Returns a plan for size n, from a process-wide cache.
+std::shared_ptr<const FFTPlan> fft_plan(int64_t n);
+
+}} // namespace at::native
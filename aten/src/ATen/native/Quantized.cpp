@@ -0,0 +1,361 @@
+#include "ATen/ATen.h"
+#include "ATen/NativeFunctions.h"
+#include "ATen/Dispatch.h"
+
+#include <TH/TH.h>
+#include <THNN/THNN.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Linear quantization maps a real value x to the int8 value
+//   q = clamp(round(x / scale) + zero_point, -128, 127)
+// and back to (q - zero_point) * scale. Weights are quantized per output
+// channel with a zero point of 0, activations are quantized per tensor on
+// the fly, with a range that always contains 0 so that zero padding is
+// represented exactly. Products are accumulated in int32.
+
+namespace at { namespace native {
+
+namespace {
+
+static const int64_t qmin = -128;
+static const int64_t qmax = 127;
+
+// Clamps before converting, since converting a double that is out of the
+// range of int64_t (including inf) is undefined. NaN maps to qmin.
+static inline int8_t quantize_val(double x, double inv_scale, int64_t zero_point) {
+  double q = std::nearbyint(x * inv_scale) + zero_point;
+  q = q >= qmin ? q : qmin;
+  q = q <= qmax ? q : qmax;
+  return static_cast<int8_t>(q);
+}
+
+static void check_zero_point(int64_t zero_point) {
+  if (zero_point < qmin || zero_point > qmax) {
+    runtime_error("quantize: zero_point should be in [%lld, %lld], but got %lld",
+                  (long long)qmin, (long long)qmax, (long long)zero_point);
+  }
+}
+
+// Views a contiguous tensor as [outer, channels, inner] around axis.
+static void channel_dims(const Tensor& self, int64_t axis, int64_t& outer, int64_t& channels, int64_t& inner) {
+  if (axis < 0 || axis >= self.dim()) {
+    runtime_error("quantize: axis %lld out of range for a %lldD tensor",
+                  (long long)axis, (long long)self.dim());
+  }
+  outer = 1;
+  inner = 1;
+  channels = self.size(axis);
+  for (int64_t d = 0; d < axis; d++) outer *= self.size(d);
+  for (int64_t d = axis + 1; d < self.dim(); d++) inner *= self.size(d);
+}
+
+template <typename scalar_t>
+struct quantize_kernel {
+  // scales and zero_points hold one value per channel
+  static void apply(const Tensor& self, Tensor& output, int64_t outer, int64_t channels, int64_t inner,
+                    const std::vector<double>& scales, const std::vector<int64_t>& zero_points) {
+    const scalar_t* in = self.data<scalar_t>();
+    int8_t* out = output.data<int8_t>();
+    int64_t numel = outer * channels * inner;
+    int64_t i;
+    #pragma omp parallel for if (numel > 100000) private(i)
+    for (i = 0; i < numel; i++) {
+      int64_t c = (i / inner) % channels;
+      out[i] = quantize_val(in[i], 1.0 / scales[c], zero_points[c]);
+    }
+  }
+};
+
+template <typename scalar_t>
+struct dequantize_kernel {
+  static void apply(const Tensor& self, Tensor& output, int64_t outer, int64_t channels, int64_t inner,
+                    const std::vector<double>& scales, const std::vector<int64_t>& zero_points) {
+    const int8_t* in = self.data<int8_t>();
+    scalar_t* out = output.data<scalar_t>();
+    int64_t numel = outer * channels * inner;
+    int64_t i;
+    #pragma omp parallel for if (numel > 100000) private(i)
+    for (i = 0; i < numel; i++) {
+      int64_t c = (i / inner) % channels;
+      out[i] = static_cast<scalar_t>((in[i] - zero_points[c]) * scales[c]);
+    }
+  }
+};
+
+static Tensor quantize_impl(const Tensor& self, int64_t outer, int64_t channels, int64_t inner,
+                            const std::vector<double>& scales, const std::vector<int64_t>& zero_points) {
+  for (int64_t c = 0; c < channels; c++) {
+    if (!(scales[c] > 0)) {
+      runtime_error("quantize: scale should be positive, but got %g", scales[c]);
+    }
+    check_zero_point(zero_points[c]);
+  }
+  auto input = self.contiguous();
+  auto output = self.type().toScalarType(kChar).tensor(self.sizes());
+  dispatch_floating_types<quantize_kernel>(self.type(), "quantize_linear",
+                                           input, output, outer, channels, inner, scales, zero_points);
+  return output;
+}
+
+static Tensor dequantize_impl(const Tensor& self, int64_t outer, int64_t channels, int64_t inner,
+                              const std::vector<double>& scales, const std::vector<int64_t>& zero_points) {
+  if (self.type().scalarType() != kChar) {
+    runtime_error("dequantize: expected a CharTensor, but got %s", self.type().toString());
+  }
+  auto input = self.contiguous();
+  auto output = self.type().toScalarType(kFloat).tensor(self.sizes());
+  dequantize_kernel<float>::apply(input, output, outer, channels, inner, scales, zero_points);
+  return output;
+}
+
+static std::vector<double> to_double_vector(const Tensor& t) {
+  auto c = t.toType(t.type().toScalarType(kDouble)).contiguous();
+  return std::vector<double>(c.data<double>(), c.data<double>() + c.numel());
+}
+
+static std::vector<int64_t> to_long_vector(const Tensor& t) {
+  auto c = t.toType(t.type().toScalarType(kLong)).contiguous();
+  return std::vector<int64_t>(c.data<int64_t>(), c.data<int64_t>() + c.numel());
+}
+
+static void per_channel_params(const Tensor& self, const Tensor& scales, const Tensor& zero_points, int64_t axis,
+                               int64_t& outer, int64_t& channels, int64_t& inner,
+                               std::vector<double>& scales_, std::vector<int64_t>& zero_points_) {
+  channel_dims(self, axis, outer, channels, inner);
+  if (scales.numel() != channels || zero_points.numel() != channels) {
+    runtime_error("quantize: expected %lld scales and zero points, but got %lld and %lld",
+                  (long long)channels, (long long)scales.numel(), (long long)zero_points.numel());
+  }
+  scales_ = to_double_vector(scales);
+  zero_points_ = to_long_vector(zero_points);
+}
+
+// Picks the per tensor parameters covering [min(x, 0), max(x, 0)].
+static void choose_params(const Tensor& x, double& scale, int64_t& zero_point) {
+  if (x.numel() == 0) {
+    // min() and max() reject empty tensors, use the parameters of all zeros
+    scale = 1;
+    zero_point = qmin;
+    return;
+  }
+  double min = std::min(x.min().toCDouble(), 0.0);
+  double max = std::max(x.max().toCDouble(), 0.0);
+  scale = (max - min) / (qmax - qmin);
+  if (scale == 0) {
+    scale = 1;
+  }
+  zero_point = static_cast<int64_t>(std::nearbyint(qmin - min / scale));
+  zero_point = std::min(std::max(zero_point, qmin), qmax);
+}
+
+// Row sums of the quantized weight, used to remove the activation zero
+// point from the accumulators: sum (qx - zp) qw = sum qx qw - zp sum qw.
+static std::vector<int32_t> weight_row_sums(const Tensor& weight, int64_t rows, int64_t cols) {
+  const int8_t* w = weight.data<int8_t>();
+  std::vector<int32_t> sums(rows);
+  for (int64_t r = 0; r < rows; r++) {
+    int32_t s = 0;
+    for (int64_t c = 0; c < cols; c++) s += w[r * cols + c];
+    sums[r] = s;
+  }
+  return sums;
+}
+
+static void check_weight(const Tensor& weight, const Tensor& weight_scales, const char* name) {
+  if (weight.type().scalarType() != kChar) {
+    runtime_error("%s: expected a CharTensor weight, but got %s", name, weight.type().toString());
+  }
+  if (weight_scales.numel() != weight.size(0)) {
+    runtime_error("%s: expected %lld weight scales, but got %lld", name,
+                  (long long)weight.size(0), (long long)weight_scales.numel());
+  }
+}
+
+// output[n, o, p] = scale * weight_scales[o] * (acc[n, o, p] - zero_point * row_sums[o]) + bias[o]
+template <typename scalar_t>
+struct requantize_kernel {
+  static void apply(const int32_t* acc, Tensor& output, int64_t batch, int64_t channels, int64_t inner,
+                    double scale, int64_t zero_point, const std::vector<double>& weight_scales,
+                    const std::vector<int32_t>& row_sums, const Tensor& bias) {
+    scalar_t* out = output.data<scalar_t>();
+    std::vector<double> bias_(channels, 0);
+    if (bias.defined()) {
+      bias_ = to_double_vector(bias);
+    }
+    int64_t numel = batch * channels * inner;
+    int64_t i;
+    #pragma omp parallel for if (numel > 100000) private(i)
+    for (i = 0; i < numel; i++) {
+      int64_t c = (i / inner) % channels;
+      out[i] = static_cast<scalar_t>(scale * weight_scales[c] * (acc[i] - zero_point * row_sums[c]) + bias_[c]);
+    }
+  }
+};
+
+template <typename scalar_t> struct unfold;
+template <> struct unfold<float> {
+  static void apply(Tensor& finput, const Tensor& input, int kW, int kH, int dW, int dH, int padW, int padH,
+                    int nInputPlane, int inputWidth, int inputHeight, int outputWidth, int outputHeight) {
+    THNN_Floatunfolded_copy((THFloatTensor*)finput.unsafeGetTH(false), (THFloatTensor*)input.unsafeGetTH(false),
+                            kW, kH, dW, dH, padW, padH, nInputPlane, inputWidth, inputHeight, outputWidth, outputHeight);
+  }
+};
+template <> struct unfold<double> {
+  static void apply(Tensor& finput, const Tensor& input, int kW, int kH, int dW, int dH, int padW, int padH,
+                    int nInputPlane, int inputWidth, int inputHeight, int outputWidth, int outputHeight) {
+    THNN_Doubleunfolded_copy((THDoubleTensor*)finput.unsafeGetTH(false), (THDoubleTensor*)input.unsafeGetTH(false),
+                             kW, kH, dW, dH, padW, padH, nInputPlane, inputWidth, inputHeight, outputWidth, outputHeight);
+  }
+};
+
+// Quantizes the [rows, cols] matrix x transposed into out, so that the
+// columns of x become contiguous for the int8 dot products.
+template <typename scalar_t>
+struct quantize_transposed_kernel {
+  static void apply(const Tensor& x, int8_t* out, int64_t rows, int64_t cols, double scale, int64_t zero_point) {
+    const scalar_t* in = x.data<scalar_t>();
+    double inv_scale = 1.0 / scale;
+    int64_t c;
+    #pragma omp parallel for if (rows * cols > 100000) private(c)
+    for (c = 0; c < cols; c++) {
+      for (int64_t r = 0; r < rows; r++) {
+        out[c * rows + r] = quantize_val(in[r * cols + c], inv_scale, zero_point);
+      }
+    }
+  }
+};
+
+template <typename scalar_t>
+struct quantized_conv2d_kernel {
+  static void apply(const Tensor& input, const Tensor& weight, Tensor& output,
+                    int kW, int kH, int dW, int dH, int padW, int padH,
+                    double scale, int64_t zero_point, const std::vector<double>& weight_scales,
+                    const std::vector<int32_t>& row_sums, const Tensor& bias) {
+    int64_t batch = input.size(0);
+    int64_t nInputPlane = input.size(1);
+    int64_t inputHeight = input.size(2);
+    int64_t inputWidth = input.size(3);
+    int64_t nOutputPlane = weight.size(0);
+    int64_t outputHeight = output.size(2);
+    int64_t outputWidth = output.size(3);
+    int64_t k = nInputPlane * kH * kW;
+    int64_t p = outputHeight * outputWidth;
+
+    auto finput = input.type().tensor({k, p});
+    std::vector<int8_t> columns(k * p);
+    auto acc = input.type().toScalarType(kInt).tensor({batch, nOutputPlane, p});
+    int32_t* acc_data = acc.data<int32_t>();
+    for (int64_t n = 0; n < batch; n++) {
+      auto input_n = input.select(0, n);
+      unfold<scalar_t>::apply(finput, input_n, kW, kH, dW, dH, padW, padH, nInputPlane,
+                              inputWidth, inputHeight, outputWidth, outputHeight);
+      quantize_transposed_kernel<scalar_t>::apply(finput, columns.data(), k, p, scale, zero_point);
+      // acc[n] is [nOutputPlane, p] row major, i.e. column major p x nOutputPlane
+      THCharBlas_gemmI32('t', 'n', p, nOutputPlane, k, columns.data(), k,
+                         weight.data<int8_t>(), k, acc_data + n * nOutputPlane * p, p);
+    }
+    requantize_kernel<scalar_t>::apply(acc_data, output, batch, nOutputPlane, p, scale, zero_point,
+                                       weight_scales, row_sums, bias);
+  }
+};
+
+} // anonymous namespace
+
+Tensor quantize_linear_cpu(const Tensor& self, double scale, int64_t zero_point) {
+  return quantize_impl(self, 1, 1, self.numel(), {scale}, {zero_point});
+}
+
+Tensor quantize_linear_per_channel_cpu(const Tensor& self, const Tensor& scales, const Tensor& zero_points, int64_t axis) {
+  int64_t outer, channels, inner;
+  std::vector<double> scales_;
+  std::vector<int64_t> zero_points_;
+  per_channel_params(self, scales, zero_points, axis, outer, channels, inner, scales_, zero_points_);
+  return quantize_impl(self, outer, channels, inner, scales_, zero_points_);
+}
+
+Tensor dequantize_linear_cpu(const Tensor& self, double scale, int64_t zero_point) {
+  return dequantize_impl(self, 1, 1, self.numel(), {scale}, {zero_point});
+}
+
+Tensor dequantize_linear_per_channel_cpu(const Tensor& self, const Tensor& scales, const Tensor& zero_points, int64_t axis) {
+  int64_t outer, channels, inner;
+  std::vector<double> scales_;
+  std::vector<int64_t> zero_points_;
+  per_channel_params(self, scales, zero_points, axis, outer, channels, inner, scales_, zero_points_);
+  return dequantize_impl(self, outer, channels, inner, scales_, zero_points_);
+}
+
+Tensor quantized_linear_cpu(const Tensor& input, const Tensor& weight, const Tensor& weight_scales, const Tensor& bias) {
+  check_weight(weight, weight_scales, "quantized_linear");
+  if (input.numel() == 0) {
+    // an empty tensor has no features to check, an empty batch gives an empty output
+    return input.type().tensor();
+  }
+  if (weight.dim() != 2 || input.dim() < 1 || input.size(-1) != weight.size(1)) {
+    runtime_error("quantized_linear: input with %lld features doesn't match a weight of size [%lld, %lld]",
+                  (long long)(input.dim() ? input.size(-1) : 0),
+                  (long long)weight.size(0), (long long)(weight.dim() > 1 ? weight.size(1) : 0));
+  }
+  int64_t in_features = weight.size(1);
+  int64_t out_features = weight.size(0);
+  auto x = input.contiguous().view({-1, in_features});
+  int64_t batch = x.size(0);
+
+  double scale;
+  int64_t zero_point;
+  choose_params(x, scale, zero_point);
+  auto qx = quantize_linear_cpu(x, scale, zero_point);
+  auto qw = weight.contiguous();
+
+  // acc is [batch, out_features] row major, i.e. column major out_features x batch
+  auto acc = input.type().toScalarType(kInt).tensor({batch, out_features});
+  THCharBlas_gemmI32('t', 'n', out_features, batch, in_features, qw.data<int8_t>(), in_features,
+                     qx.data<int8_t>(), in_features, acc.data<int32_t>(), out_features);
+
+  auto output_size = input.sizes().vec();
+  output_size.back() = out_features;
+  auto output = input.type().tensor({batch, out_features});
+  dispatch_floating_types<requantize_kernel>(input.type(), "quantized_linear",
+                                             acc.data<int32_t>(), output, batch, out_features, 1,
+                                             scale, zero_point, to_double_vector(weight_scales),
+                                             weight_row_sums(qw, out_features, in_features), bias);
+  return output.view(output_size);
+}
+
+Tensor quantized_conv2d_cpu(const Tensor& input, const Tensor& weight, const Tensor& weight_scales,
+                            IntList stride, IntList padding, const Tensor& bias) {
+  check_weight(weight, weight_scales, "quantized_conv2d");
+  if (input.dim() != 4 || weight.dim() != 4 || input.size(1) != weight.size(1)) {
+    runtime_error("quantized_conv2d: expected a 4D input and a 4D weight with the same number of input planes");
+  }
+  if (stride.size() != 2 || padding.size() != 2) {
+    runtime_error("quantized_conv2d: expected stride and padding of size 2");
+  }
+  int64_t kH = weight.size(2), kW = weight.size(3);
+  int64_t outputHeight = (input.size(2) + 2 * padding[0] - kH) / stride[0] + 1;
+  int64_t outputWidth = (input.size(3) + 2 * padding[1] - kW) / stride[1] + 1;
+  if (outputHeight < 1 || outputWidth < 1) {
+    runtime_error("quantized_conv2d: output size is too small");
+  }
+
+  auto x = input.contiguous();
+  double scale;
+  int64_t zero_point;
+  choose_params(x, scale, zero_point);
+  auto qw = weight.contiguous();
+  int64_t nOutputPlane = weight.size(0);
+  auto output = input.type().tensor({input.size(0), nOutputPlane, outputHeight, outputWidth});
+  dispatch_floating_types<quantized_conv2d_kernel>(input.type(), "quantized_conv2d",
+                                                   x, qw, output, kW, kH, stride[1], stride[0],
+                                                   padding[1], padding[0], scale, zero_point,
+                                                   to_double_vector(weight_scales),
+                                                   weight_row_sums(qw, nOutputPlane, qw.numel() / nOutputPlane),
+                                                   bias);
+  return output;
+}
+
+}} // namespace at::native
@@ -2,8 +2,12 @@
 #include "ATen/NativeFunctions.h"
 #include "ATen/WrapDimUtils.h"
 #include "ATen/ExpandUtils.h"
+#include "ATen/Dispatch.h"
+#include "ATen/native/FFTPlan.h"
 
 #include <algorithm>
+#include <cmath>
+#include <complex>
 #include <functional>
 #include <numeric>
 #include <vector>
@@ -18,6 +22,202 @@ static inline int64_t infer_ft_complex_length(int64_t real_length) {
   return (real_length >> 1) + 1;
 }
 
+namespace {
+
+using complex_type = FFTPlan::complex_type;
+
+// Transforms every signal of the batch. Complex values are stored as pairs of
+// (real, imaginary) in the last dimension. Real-to-complex and
+// complex-to-real transforms of even size n run a complex FFT of size n / 2
+// on the signal packed as x[2j] + i x[2j + 1] and untangle the even and odd
+// halves afterwards.
+template <typename scalar_t>
+struct fft_kernel {
+  static void apply(const Tensor& input, Tensor& output, int64_t batch,
+                    bool complex_input, bool complex_output, bool inverse,
+                    int64_t n, double scale, bool onesided) {
+    const scalar_t* in = input.data<scalar_t>();
+    scalar_t* out = output.data<scalar_t>();
+    const bool half_size = n % 2 == 0 && complex_input != complex_output;
+    const int64_t plan_size = half_size ? n / 2 : n;
+    auto plan = fft_plan(plan_size);
+    // twiddles exp(-2 pi i k / n) used to untangle half size transforms
+    std::vector<complex_type> twiddles;
+    if (half_size) {
+      const double pi = std::acos(-1.0);
+      twiddles.resize(plan_size);
+      for (int64_t k = 0; k < plan_size; k++) {
+        twiddles[k] = std::polar(1.0, -2 * pi * k / n);
+      }
+    }
+    const int64_t in_stride = complex_input ? (inverse && !complex_output ? n / 2 + 1 : n) * 2 : n;
+    const int64_t out_n = complex_output ? (onesided ? n / 2 + 1 : n) : n;
+    const int64_t out_stride = complex_output ? out_n * 2 : n;
+
+    #pragma omp parallel if (batch > 1)
+    {
+      std::vector<complex_type> buf(plan_size);
+      std::vector<complex_type> scratch(plan->scratch_size());
+      #pragma omp for
+      for (int64_t b = 0; b < batch; b++) {
+        const scalar_t* x = in + b * in_stride;
+        scalar_t* y = out + b * out_stride;
+        if (complex_input && complex_output) {
+          for (int64_t k = 0; k < n; k++) {
+            buf[k] = complex_type(x[2 * k], x[2 * k + 1]);
+          }
+          plan->execute(buf.data(), inverse, scratch.data());
+          for (int64_t k = 0; k < n; k++) {
+            y[2 * k] = buf[k].real() * scale;
+            y[2 * k + 1] = buf[k].imag() * scale;
+          }
+        } else if (complex_output) {
+          // real-to-complex
+          if (half_size) {
+            for (int64_t k = 0; k < plan_size; k++) {
+              buf[k] = complex_type(x[2 * k], x[2 * k + 1]);
+            }
+            plan->execute(buf.data(), false, scratch.data());
+            for (int64_t k = 0; k <= plan_size; k++) {
+              complex_type z = buf[k % plan_size];
+              complex_type zc = std::conj(buf[(plan_size - k) % plan_size]);
+              complex_type even = (z + zc) * 0.5;
+              complex_type odd = (z - zc) * complex_type(0, -0.5);
+              complex_type w = k < plan_size ? twiddles[k] : complex_type(-1);
+              complex_type value = (even + w * odd) * scale;
+              y[2 * k] = value.real();
+              y[2 * k + 1] = value.imag();
+            }
+          } else {
+            for (int64_t k = 0; k < n; k++) {
+              buf[k] = complex_type(x[k], 0);
+            }
+            plan->execute(buf.data(), false, scratch.data());
+            for (int64_t k = 0; k <= n / 2; k++) {
+              y[2 * k] = buf[k].real() * scale;
+              y[2 * k + 1] = buf[k].imag() * scale;
+            }
+          }
+          // fill in the redundant half from the Hermitian symmetry
+          for (int64_t k = n / 2 + 1; k < out_n; k++) {
+            y[2 * k] = y[2 * (n - k)];
+            y[2 * k + 1] = -y[2 * (n - k) + 1];
+          }
+        } else {
+          // complex-to-real, from the n / 2 + 1 non-redundant values; the
+          // imaginary parts of the zero and Nyquist frequencies are ignored
+          if (half_size) {
+            auto value = [&](int64_t k) {
+              bool real = k == 0 || k == plan_size;
+              return complex_type(x[2 * k], real ? 0 : x[2 * k + 1]);
+            };
+            for (int64_t k = 0; k < plan_size; k++) {
+              complex_type v = value(k);
+              complex_type vc = std::conj(value(plan_size - k));
+              buf[k] = (v + vc) + complex_type(0, 1) * (v - vc) * std::conj(twiddles[k]);
+            }
+            plan->execute(buf.data(), true, scratch.data());
+            for (int64_t k = 0; k < plan_size; k++) {
+              y[2 * k] = buf[k].real() * scale;
+              y[2 * k + 1] = buf[k].imag() * scale;
+            }
+          } else {
+            buf[0] = complex_type(x[0], 0);
+            for (int64_t k = 1; k <= n / 2; k++) {
+              buf[k] = complex_type(x[2 * k], x[2 * k + 1]);
+              buf[n - k] = std::conj(buf[k]);
+            }
+            plan->execute(buf.data(), true, scratch.data());
+            for (int64_t k = 0; k < n; k++) {
+              y[k] = buf[k].real() * scale;
+            }
+          }
+        }
+      }
+    }
+  }
+};
+
+} // anonymous namespace
+
+// All CPU transforms go through this function so that they share one
+// derivative formula (see fft_backward in tools/autograd/templates/Functions.cpp).
+// Transforms are along the last (real) or second to last (complex) dimension,
+// and complex-to-real transforms take the n / 2 + 1 non-redundant values of a
+// Hermitian signal of size signal_size.
+Tensor _fft_with_size(const Tensor& self, bool complex_input, bool complex_output,
+                      bool inverse, int64_t signal_size, bool normalized,
+                      bool onesided) {
+  if (self.type().is_cuda()) {
+    throw std::runtime_error("fft: only CPU tensors are supported");
+  }
+  if (!at::isFloatingType(self.type().scalarType())) {
+    throw std::runtime_error("fft: expected a tensor of floating types");
+  }
+  if (!complex_input && !complex_output) {
+    throw std::runtime_error("fft: expected complex input or output");
+  }
+  if (signal_size <= 0) {
+    std::ostringstream ss;
+    ss << "fft: expected signal_size > 0, but got signal_size=" << signal_size;
+    throw std::runtime_error(ss.str());
+  }
+  int64_t n = signal_size;
+  // only a real signal has a redundant half to leave out
+  onesided = onesided && !complex_input;
+  int64_t signal_dim = complex_input ? self.dim() - 2 : self.dim() - 1;
+  if (signal_dim < 0 || (complex_input && self.size(-1) != 2)) {
+    std::ostringstream ss;
+    ss << "fft: expected a " << (complex_input ? "complex" : "real")
+       << " tensor, but got size {" << self.sizes() << "}";
+    if (complex_input) {
+      ss << " (complex tensors have a last dimension of size 2)";
+    }
+    throw std::runtime_error(ss.str());
+  }
+  int64_t expected_size = (complex_input && !complex_output) ? n / 2 + 1 : n;
+  if (self.size(signal_dim) != expected_size) {
+    std::ostringstream ss;
+    ss << "fft: expected a signal of size " << expected_size << " for signal_size="
+       << n << ", but got size {" << self.sizes() << "}";
+    throw std::runtime_error(ss.str());
+  }
+
+  std::vector<int64_t> output_sizes(self.sizes().begin(), self.sizes().begin() + signal_dim);
+  int64_t batch = std::accumulate(output_sizes.begin(), output_sizes.end(),
+                                  int64_t(1), std::multiplies<int64_t>());
+  if (complex_output) {
+    output_sizes.push_back(onesided ? n / 2 + 1 : n);
+    output_sizes.push_back(2);
+  } else {
+    output_sizes.push_back(n);
+  }
+  auto input = self.contiguous();
+  auto output = self.type().tensor(output_sizes);
+  double scale = normalized ? 1.0 / std::sqrt(static_cast<double>(n))
+                            : (inverse ? 1.0 / n : 1.0);
+  dispatch_floating_types<fft_kernel>(self.type(), "fft", input, output, batch,
+                                      complex_input, complex_output, inverse,
+                                      n, scale, onesided);
+  return output;
+}
+
+Tensor fft(const Tensor& self, bool normalized) {
+  return at::_fft_with_size(self, true, true, false, self.size(-2), normalized, false);
+}
+
+Tensor ifft(const Tensor& self, bool normalized) {
+  return at::_fft_with_size(self, true, true, true, self.size(-2), normalized, false);
+}
+
+Tensor rfft(const Tensor& self, bool normalized, bool onesided) {
+  return at::_fft_with_size(self, false, true, false, self.size(-1), normalized, onesided);
+}
+
+Tensor irfft(const Tensor& self, int64_t signal_size, bool normalized) {
+  return at::_fft_with_size(self, true, false, true, signal_size, normalized, true);
+}
+
 Tensor stft(const Tensor& self, const int64_t frame_length,
                                 const int64_t hop, const int64_t fft_size,
                                 const bool return_onesided,
@@ -81,6 +281,31 @@ Tensor stft(const Tensor& self, const int64_t frame_length,
   }
   #undef REPR
   int64_t return_size = return_onesided ? infer_ft_complex_length(fft_size) : fft_size;
+  if (!self.type().is_cuda()) {
+    // frames of size [batch x num_frames x frame_length]
+    auto frames = input.unfold(1, frame_length, hop);
+    if (window.defined()) {
+      frames = frames * window;
+    }
+    int64_t num_frames = frames.size(1);
+    if (fft_size > frame_length) {
+      frames = at::cat({frames, self.type().zeros({batch, num_frames, fft_size - frame_length})}, 2);
+    } else if (fft_size < frame_length) {
+      // only frequencies that are multiples of 1 / fft_size are computed, so
+      // samples that are fft_size apart alias into the same bin
+      int64_t folds = (frame_length + fft_size - 1) / fft_size;
+      if (folds * fft_size != frame_length) {
+        frames = at::cat({frames, self.type().zeros({batch, num_frames, folds * fft_size - frame_length})}, 2);
+      }
+      frames = frames.contiguous().view({batch, num_frames, folds, fft_size}).sum(2);
+    }
+    auto out = at::_fft_with_size(frames, false, true, false, fft_size, false, return_onesided);
+    if (self.dim() == 1) {
+      return out.squeeze_(0);
+    } else {
+      return out;
+    }
+  }
   // build ft kernel
   // k[omega, t] = cos (2 pi omega t / N) - j sin (2 pi omega t / N)
   double N = static_cast<double>(fft_size);
@@ -0,0 +1,111 @@
+#include "ATen/ATen.h"
+#include "ATen/CPUCachingAllocator.h"
+#include "test_assert.h"
+
+#include <TH/THAllocator.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+using namespace at;
+
+static THCachingAllocatorStats stats() {
+  THCachingAllocatorStats s;
+  THCachingAllocator_getStats(&s);
+  return s;
+}
+
+int main() {
+  THCachingAllocator_setEnabled(1);
+  THCachingAllocator_resetStats();
+
+  // blocks are aligned and reused for requests of the same size class
+  {
+    CPUCachingAllocator allocator;
+    void* small = allocator.allocate(3);
+    void* big = allocator.allocate(100000);
+    ASSERT(reinterpret_cast<uintptr_t>(small) % 64 == 0);
+    ASSERT(reinterpret_cast<uintptr_t>(big) % 64 == 0);
+    ASSERT(stats().bytesInUse >= 100003);
+    allocator.deallocate(big);
+    ASSERT(stats().bytesCached >= 100000);
+    void* big2 = allocator.allocate(99000);
+    ASSERT(big2 == big);
+    allocator.deallocate(big2);
+    allocator.deallocate(small);
+    ASSERT(stats().bytesInUse == 0);
+    ASSERT(stats().hits == 1 && stats().misses == 2);
+  }
+
+  // new storages use it once it's enabled, and resize through it
+  {
+    auto t = CPU(kFloat).zeros({1000});
+    auto s = stats();
+    ASSERT(s.bytesInUse >= 4000);
+    t.resize_({1001});
+    ASSERT(stats().hits + stats().misses == s.hits + s.misses);
+    t.resize_({100000});
+    t.fill_(2);
+    ASSERT(t.sum().toCFloat() == 200000);
+    auto data = t.data_ptr();
+    t = Tensor();
+    auto t2 = CPU(kFloat).zeros({100000});
+    ASSERT(t2.data_ptr() == data);
+  }
+
+  // blocks too big to cache go straight back
+  {
+    CPUCachingAllocator allocator;
+    auto cached = stats().bytesCached;
+    void* huge = allocator.allocate((std::size_t(1) << 30) + 1);
+    allocator.deallocate(huge);
+    ASSERT(stats().bytesCached == cached);
+  }
+
+  // the blocks cached by a thread are released when it exits
+  {
+    auto cached = stats().bytesCached;
+    std::thread([] {
+      CPUCachingAllocator allocator;
+      allocator.deallocate(allocator.allocate(1000));
+      ASSERT(stats().bytesCached > 0);
+    }).join();
+    ASSERT(stats().bytesCached == cached);
+  }
+
+  // and trim releases them from any thread
+  {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool cached = false, trimmed = false;
+    std::thread worker([&] {
+      CPUCachingAllocator allocator;
+      allocator.deallocate(allocator.allocate(1000));
+      std::unique_lock<std::mutex> lock(mutex);
+      cached = true;
+      cv.notify_all();
+      cv.wait(lock, [&] { return trimmed; });
+      // the thread's lists are still usable
+      allocator.deallocate(allocator.allocate(1000));
+    });
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&] { return cached; });
+      THCachingAllocator_trim();
+      ASSERT(stats().bytesCached == 0);
+      trimmed = true;
+      cv.notify_all();
+    }
+    worker.join();
+  }
+
+  THCachingAllocator_trim();
+  ASSERT(stats().bytesCached == 0);
+
+  THCachingAllocator_setEnabled(0);
+  auto t = CPU(kFloat).ones({10});
+  ASSERT(stats().bytesInUse == 0);
+  return 0;
+}
@@ -18,6 +18,12 @@
 #include <windows.h>
 #endif
 
+#if defined(TH_HAVE_THREAD) && !defined(_WIN32)
+#include <pthread.h>
+/* caches of exiting threads are released by a pthread key destructor */
+#define TH_CACHING_THREAD_EXIT 1
+#endif
+
 #if HAVE_MMAP
 #include <sys/types.h>
 #include <sys/mman.h>
@@ -45,6 +51,403 @@ THAllocator THDefaultAllocator = {
   &THDefaultAllocator_free
 };
 
+/* Caching allocator */
+
+#if defined(TH_HAVE_THREAD) && defined(_MSC_VER)
+#define __thread __declspec( thread )
+#endif
+
+#define TH_CACHING_ALIGNMENT 64
+/* Size classes cover 64 bytes to 1GB: one class up to 64 bytes, then four
+ * per power of two. Bigger blocks are allocated and freed directly. */
+#define TH_CACHING_NUM_CLASSES 97
+#define TH_CACHING_MAX_SIZE ((ptrdiff_t)1 << 30)
+/* Limits of the per-thread free lists, which take their thread's own spinlock
+ * rather than the global one. */
+#define TH_CACHING_THREAD_MAX_BLOCK (256 * 1024)
+#define TH_CACHING_THREAD_MAX_BYTES (4 * 1024 * 1024)
+
+/* Header stored in the TH_CACHING_ALIGNMENT bytes before each block. */
+typedef struct THCachingBlock {
+  struct THCachingBlock *next; /* next block in a free list */
+  void *base;                  /* what malloc returned */
+  ptrdiff_t size;              /* usable size, the size of the class */
+  int sizeClass;               /* -1 for blocks that aren't cached */
+} THCachingBlock;
+
+static int32_t volatile cachingEnabled = 0;
+static int32_t volatile cachingLock = 0;
+static THCachingBlock *cachingFreeLists[TH_CACHING_NUM_CLASSES];
+static ptrdiff_t volatile cachingMaxBytes = PTRDIFF_MAX;
+static ptrdiff_t volatile cachingBytesInUse = 0;
+static ptrdiff_t volatile cachingBytesCached = 0;
+static int64_t volatile cachingHits = 0;
+static int64_t volatile cachingMisses = 0;
+
+#ifdef TH_HAVE_THREAD
+/* Free lists of a single thread. Only that thread adds and takes blocks, so
+ * its lock is uncontended, but trim can drain the lists from any thread.
+ * Caches are linked into cachingThreadCaches (guarded by cachingLock), and
+ * released when their thread exits. */
+typedef struct THCachingThreadCache {
+  THCachingBlock *freeLists[TH_CACHING_NUM_CLASSES];
+  ptrdiff_t cachedBytes;
+  int32_t volatile lock;
+  struct THCachingThreadCache *prev;
+  struct THCachingThreadCache *next;
+} THCachingThreadCache;
+
+static THCachingThreadCache *cachingThreadCaches = NULL;
+static __thread THCachingThreadCache *threadCache = NULL;
+#endif
+
+#ifdef TH_CACHING_THREAD_EXIT
+static pthread_key_t cachingThreadKey;
+static pthread_once_t cachingThreadKeyOnce = PTHREAD_ONCE_INIT;
+#endif
+
+static void THCachingAllocator_lock(int32_t volatile *lock)
+{
+  while (!THAtomicCompareAndSwap(lock, 0, 1))
+    ;
+}
+
+static void THCachingAllocator_unlock(int32_t volatile *lock)
+{
+  THAtomicSet(lock, 0);
+}
+
+/* Returns the class of size and sets *classSize to its size, or returns -1
+ * if size is too big to be cached. */
+static int THCachingAllocator_sizeClass(ptrdiff_t size, ptrdiff_t *classSize)
+{
+  int k = 6;
+  ptrdiff_t step, rounded;
+
+  if (size <= TH_CACHING_ALIGNMENT) {
+    *classSize = TH_CACHING_ALIGNMENT;
+    return 0;
+  }
+  if (size > TH_CACHING_MAX_SIZE) {
+    *classSize = size;
+    return -1;
+  }
+
+  /* 2^k < size <= 2^(k+1), rounded up to a multiple of 2^(k-2) */
+  while (((ptrdiff_t)1 << (k + 1)) < size)
+    k++;
+  step = (ptrdiff_t)1 << (k - 2);
+  rounded = (size + step - 1) & ~(step - 1);
+  *classSize = rounded;
+  return 1 + (k - 6) * 4 + (int)(rounded >> (k - 2)) - 5;
+}
+
+static THCachingBlock *THCachingAllocator_newBlock(ptrdiff_t size, int sizeClass)
+{
+  ptrdiff_t rawSize = size + 2 * TH_CACHING_ALIGNMENT - 1;
+  void *base = malloc(rawSize);
+  if (!base) {
+    /* blocks are always released with free(), so don't fall back to THAlloc */
+    THCachingAllocator_trim();
+    base = malloc(rawSize);
+    if (!base)
+      THError("$ Torch: not enough memory: you tried to allocate %dGB. Buy new RAM!", rawSize/1073741824);
+  }
+
+  uintptr_t data = ((uintptr_t)base + 2 * TH_CACHING_ALIGNMENT - 1) & ~(uintptr_t)(TH_CACHING_ALIGNMENT - 1);
+  THCachingBlock *block = (THCachingBlock*)(data - TH_CACHING_ALIGNMENT);
+  block->next = NULL;
+  block->base = base;
+  block->size = size;
+  block->sizeClass = sizeClass;
+  return block;
+}
+
+static void *THCachingAllocator_data(THCachingBlock *block)
+{
+  return (char*)block + TH_CACHING_ALIGNMENT;
+}
+
+static THCachingBlock *THCachingAllocator_block(void *ptr)
+{
+  return (THCachingBlock*)((char*)ptr - TH_CACHING_ALIGNMENT);
+}
+
+static void THCachingAllocator_releaseList(THCachingBlock *block)
+{
+  while (block) {
+    THCachingBlock *next = block->next;
+    THAtomicAddPtrdiff(&cachingBytesCached, -block->size);
+    free(block->base);
+    block = next;
+  }
+}
+
+/* Appends list to the end of head and returns the result. */
+static THCachingBlock *THCachingAllocator_concat(THCachingBlock *head, THCachingBlock *list)
+{
+  THCachingBlock *tail = head;
+  if (!head)
+    return list;
+  while (tail->next)
+    tail = tail->next;
+  tail->next = list;
+  return head;
+}
+
+#ifdef TH_HAVE_THREAD
+/* Takes all the blocks out of cache, which has to be locked. */
+static THCachingBlock *THCachingAllocator_drainThreadCache(THCachingThreadCache *cache)
+{
+  THCachingBlock *blocks = NULL;
+  int i;
+  for (i = 0; i < TH_CACHING_NUM_CLASSES; i++) {
+    blocks = THCachingAllocator_concat(blocks, cache->freeLists[i]);
+    cache->freeLists[i] = NULL;
+  }
+  cache->cachedBytes = 0;
+  return blocks;
+}
+
+#ifdef TH_CACHING_THREAD_EXIT
+static void THCachingAllocator_threadExit(void *ptr)
+{
+  THCachingThreadCache *cache = (THCachingThreadCache*)ptr;
+  THCachingBlock *blocks;
+
+  THCachingAllocator_lock(&cachingLock);
+  if (cache->prev)
+    cache->prev->next = cache->next;
+  else
+    cachingThreadCaches = cache->next;
+  if (cache->next)
+    cache->next->prev = cache->prev;
+  THCachingAllocator_unlock(&cachingLock);
+
+  /* trim can't reach the cache anymore */
+  blocks = THCachingAllocator_drainThreadCache(cache);
+  THCachingAllocator_releaseList(blocks);
+  threadCache = NULL;
+  free(cache);
+}
+
+static void THCachingAllocator_createThreadKey(void)
+{
+  pthread_key_create(&cachingThreadKey, THCachingAllocator_threadExit);
+}
+#endif
+
+/* Returns the cache of the calling thread, creating it if needed, or NULL if
+ * it can't be allocated. */
+static THCachingThreadCache *THCachingAllocator_threadCache(void)
+{
+  THCachingThreadCache *cache = threadCache;
+  if (cache)
+    return cache;
+
+  cache = (THCachingThreadCache*)calloc(1, sizeof(THCachingThreadCache));
+  if (!cache)
+    return NULL;
+#ifdef TH_CACHING_THREAD_EXIT
+  pthread_once(&cachingThreadKeyOnce, THCachingAllocator_createThreadKey);
+  if (pthread_setspecific(cachingThreadKey, cache) != 0) {
+    free(cache);
+    return NULL;
+  }
+#endif
+  THCachingAllocator_lock(&cachingLock);
+  cache->next = cachingThreadCaches;
+  if (cache->next)
+    cache->next->prev = cache;
+  cachingThreadCaches = cache;
+  THCachingAllocator_unlock(&cachingLock);
+  threadCache = cache;
+  return cache;
+}
+#endif
+
+static void *THCachingAllocator_alloc(void* ctx, ptrdiff_t size)
+{
+  ptrdiff_t classSize;
+  int sizeClass;
+  THCachingBlock *block = NULL;
+
+  if (size < 0)
+    THError("$ Torch: invalid memory size -- maybe an overflow?");
+  if (size == 0)
+    return NULL;
+
+  sizeClass = THCachingAllocator_sizeClass(size, &classSize);
+  if (sizeClass >= 0) {
+#ifdef TH_HAVE_THREAD
+    THCachingThreadCache *cache = threadCache;
+    if (cache && cache->freeLists[sizeClass]) {
+      THCachingAllocator_lock(&cache->lock);
+      block = cache->freeLists[sizeClass];
+      if (block) {
+        cache->freeLists[sizeClass] = block->next;
+        cache->cachedBytes -= classSize;
+      }
+      THCachingAllocator_unlock(&cache->lock);
+    }
+#endif
+    if (!block && cachingFreeLists[sizeClass]) {
+      THCachingAllocator_lock(&cachingLock);
+      block = cachingFreeLists[sizeClass];
+      if (block)
+        cachingFreeLists[sizeClass] = block->next;
+      THCachingAllocator_unlock(&cachingLock);
+    }
+  }
+
+  if (block) {
+    THAtomicAddPtrdiff(&cachingBytesCached, -classSize);
+    THAtomicAddLong(&cachingHits, 1);
+  } else {
+    block = THCachingAllocator_newBlock(classSize, sizeClass);
+    THAtomicAddLong(&cachingMisses, 1);
+  }
+  THAtomicAddPtrdiff(&cachingBytesInUse, classSize);
+  return THCachingAllocator_data(block);
+}
+
+static void THCachingAllocator_free(void* ctx, void* ptr)
+{
+  THCachingBlock *block;
+  int sizeClass;
+  ptrdiff_t size;
+
+  if (!ptr)
+    return;
+
+  block = THCachingAllocator_block(ptr);
+  sizeClass = block->sizeClass;
+  size = block->size;
+  THAtomicAddPtrdiff(&cachingBytesInUse, -size);
+
+  if (sizeClass < 0 || !THAtomicGet(&cachingEnabled) ||
+      THAtomicGetPtrdiff(&cachingBytesCached) + size > THAtomicGetPtrdiff(&cachingMaxBytes)) {
+    free(block->base);
+    return;
+  }
+
+  THAtomicAddPtrdiff(&cachingBytesCached, size);
+#ifdef TH_HAVE_THREAD
+  if (size <= TH_CACHING_THREAD_MAX_BLOCK) {
+    THCachingThreadCache *cache = THCachingAllocator_threadCache();
+    if (cache) {
+      int cached = 0;
+      THCachingAllocator_lock(&cache->lock);
+      if (cache->cachedBytes + size <= TH_CACHING_THREAD_MAX_BYTES) {
+        block->next = cache->freeLists[sizeClass];
+        cache->freeLists[sizeClass] = block;
+        cache->cachedBytes += size;
+        cached = 1;
+      }
+      THCachingAllocator_unlock(&cache->lock);
+      if (cached)
+        return;
+    }
+  }
+#endif
+  THCachingAllocator_lock(&cachingLock);
+  block->next = cachingFreeLists[sizeClass];
+  cachingFreeLists[sizeClass] = block;
+  THCachingAllocator_unlock(&cachingLock);
+}
+
+static void *THCachingAllocator_realloc(void* ctx, void* ptr, ptrdiff_t size)
+{
+  THCachingBlock *block;
+  ptrdiff_t classSize;
+  void *newptr;
+
+  if (!ptr)
+    return THCachingAllocator_alloc(ctx, size);
+  if (size == 0) {
+    THCachingAllocator_free(ctx, ptr);
+    return NULL;
+  }
+
+  block = THCachingAllocator_block(ptr);
+  if (block->sizeClass >= 0 &&
+      THCachingAllocator_sizeClass(size, &classSize) == block->sizeClass)
+    return ptr;
+
+  newptr = THCachingAllocator_alloc(ctx, size);
+  memcpy(newptr, ptr, size < block->size ? size : block->size);
+  THCachingAllocator_free(ctx, ptr);
+  return newptr;
+}
+
+THAllocator THCachingAllocator = {
+  &THCachingAllocator_alloc,
+  &THCachingAllocator_realloc,
+  &THCachingAllocator_free
+};
+
+void THCachingAllocator_setEnabled(int enabled)
+{
+  THAtomicSet(&cachingEnabled, enabled != 0);
+  if (!enabled)
+    THCachingAllocator_trim();
+}
+
+int THCachingAllocator_isEnabled(void)
+{
+  return THAtomicGet(&cachingEnabled);
+}
+
+void THCachingAllocator_setMaxCachedBytes(ptrdiff_t maxBytes)
+{
+  THAtomicSetPtrdiff(&cachingMaxBytes, maxBytes);
+}
+
+void THCachingAllocator_trim(void)
+{
+  THCachingBlock *blocks = NULL;
+  int i;
+
+  /* the blocks are only freed once no lock is held */
+  THCachingAllocator_lock(&cachingLock);
+  for (i = 0; i < TH_CACHING_NUM_CLASSES; i++) {
+    blocks = THCachingAllocator_concat(blocks, cachingFreeLists[i]);
+    cachingFreeLists[i] = NULL;
+  }
+#ifdef TH_HAVE_THREAD
+  {
+    THCachingThreadCache *cache;
+    for (cache = cachingThreadCaches; cache; cache = cache->next) {
+      THCachingAllocator_lock(&cache->lock);
+      blocks = THCachingAllocator_concat(blocks, THCachingAllocator_drainThreadCache(cache));
+      THCachingAllocator_unlock(&cache->lock);
+    }
+  }
+#endif
+  THCachingAllocator_unlock(&cachingLock);
+
+  THCachingAllocator_releaseList(blocks);
+}
+
+void THCachingAllocator_getStats(THCachingAllocatorStats *stats)
+{
+  stats->bytesInUse = THAtomicGetPtrdiff(&cachingBytesInUse);
+  stats->bytesCached = THAtomicGetPtrdiff(&cachingBytesCached);
+  stats->hits = THAtomicGetLong(&cachingHits);
+  stats->misses = THAtomicGetLong(&cachingMisses);
+}
+
+void THCachingAllocator_resetStats(void)
+{
+  THAtomicSetLong(&cachingHits, 0);
+  THAtomicSetLong(&cachingMisses, 0);
+}
+
+THAllocator* THDefaultStorageAllocator(void)
+{
+  return THAtomicGet(&cachingEnabled) ? &THCachingAllocator : &THDefaultAllocator;
+}
+
 #if defined(_WIN32) || defined(HAVE_MMAP)
 
 struct THMapAllocatorContext_ {
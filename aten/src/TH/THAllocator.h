@@ -24,6 +24,40 @@ typedef struct THAllocator {
  */
 TH_API THAllocator THDefaultAllocator;
 
+/* Caching allocator for CPU memory. Freed blocks are kept in per-thread and
+ * global free lists of size classes (four per power of two) and handed out
+ * again for requests of the same class, instead of going back to malloc.
+ * All blocks are aligned to 64 bytes.
+ *
+ * THCachingAllocator can always be passed to THStorage_(newWithAllocator).
+ * Once enabled, it's also used by every storage created without an explicit
+ * allocator (see THDefaultStorageAllocator). Small blocks are cached per
+ * thread, under a spinlock of that thread's cache, which only trim contends
+ * for. The global lists share one spinlock. The blocks cached by a thread
+ * are released when it exits.
+ */
+typedef struct THCachingAllocatorStats {
+  ptrdiff_t bytesInUse;   /* size of the blocks handed out, by size class */
+  ptrdiff_t bytesCached;  /* size of the blocks kept in free lists */
+  int64_t hits;           /* allocations served from a free list */
+  int64_t misses;         /* allocations that went to malloc */
+} THCachingAllocatorStats;
+
+TH_API THAllocator THCachingAllocator;
+TH_API void THCachingAllocator_setEnabled(int enabled);
+TH_API int THCachingAllocator_isEnabled(void);
+/* Frees blocks instead of caching them once this many bytes are cached. */
+TH_API void THCachingAllocator_setMaxCachedBytes(ptrdiff_t maxBytes);
+/* Releases the blocks cached globally and by every thread. */
+TH_API void THCachingAllocator_trim(void);
+TH_API void THCachingAllocator_getStats(THCachingAllocatorStats *stats);
+TH_API void THCachingAllocator_resetStats(void);
+
+/* The allocator of storages created without one: THCachingAllocator if it's
+ * enabled, THDefaultAllocator otherwise.
+ */
+TH_API THAllocator* THDefaultStorageAllocator(void);
+
 /* file map allocator
  */
 typedef struct THMapAllocatorContext_  THMapAllocatorContext;
@@ -1,4 +1,5 @@
 #include "THBlas.h"
+#include "THVector.h"
 
 #include "generic/THBlas.c"
 #include "THGenerateAllTypes.h"
@@ -30,14 +30,10 @@ void TH_halfbits2float(unsigned short* src, float* res)
         exponent = 0xff;
     } else if (!exponent) {  /* Denorm or Zero */
         if (mantissa) {
-            unsigned int msb;
-            exponent = 0x71;
-            do {
-                msb = (mantissa & 0x400000);
-                mantissa <<= 1;  /* normalize */
-                --exponent;
-            } while (!msb);
-            mantissa &= 0x7fffff;  /* 1.mantissa is implicit */
+            /* a denormal is (h & 0x3ff) * 2^-24, which is exact in single precision */
+            float f = (float)(h & 0x3ff) * 5.9604644775390625e-8f;
+            *res = sign ? -f : f;
+            return;
         }
     } else {
         exponent += 0x70;
@@ -42,13 +42,30 @@ void THGenerator_free(THGenerator *self)
 
 int THGenerator_isValid(THGenerator *_generator)
 {
-  if ((_generator->seeded == 1) &&
+  if (_generator->engine == TH_RANDOM_ENGINE_PHILOX)
+    return _generator->seeded == 1 &&
+      _generator->philox_left >= 0 && _generator->philox_left <= 4;
+
+  if ((_generator->engine == TH_RANDOM_ENGINE_MT19937) && (_generator->seeded == 1) &&
     (_generator->left > 0 && _generator->left <= n) && (_generator->next <= n))
     return 1;
 
   return 0;
 }
 
+void THGenerator_setEngine(THGenerator *_generator, int engine)
+{
+  THArgCheck(engine == TH_RANDOM_ENGINE_MT19937 || engine == TH_RANDOM_ENGINE_PHILOX, 2,
+             "unknown random engine %d", engine);
+  _generator->engine = engine;
+  THRandom_manualSeed(_generator, _generator->the_initial_seed);
+}
+
+int THGenerator_engine(THGenerator *_generator)
+{
+  return _generator->engine;
+}
+
 #ifndef _WIN32
 static uint64_t readURandomLong()
 {
@@ -140,11 +157,13 @@ uint64_t THRandom_seed(THGenerator *_generator)
 void THRandom_manualSeed(THGenerator *_generator, uint64_t the_seed_)
 {
   int j;
+  int engine = _generator->engine;
 
   /* This ensures reseeding resets all of the state (i.e. state for Gaussian numbers) */
   THGenerator *blank = THGenerator_newUnseeded();
   THGenerator_copy(_generator, blank);
   THGenerator_free(blank);
+  _generator->engine = engine;
 
   _generator->the_initial_seed = the_seed_;
   _generator->state[0] = _generator->the_initial_seed & 0xffffffffUL;
@@ -183,6 +202,63 @@ void THRandom_nextState(THGenerator *_generator)
   *p = p[m-n] ^ TWIST(p[0], _generator->state[0]);
 }
 
+/* Philox4x32-10, from Salmon et al., "Parallel Random Numbers: As Easy as
+   1, 2, 3" (SC 2011). The 64-bit counter and key are split in two words
+   each; the two high words of the counter are always 0. */
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U
+#define PHILOX_W1 0xBB67AE85U
+
+void THRandom_philox(uint64_t key, uint64_t counter, uint32_t *out, ptrdiff_t nblocks)
+{
+  ptrdiff_t i;
+  int r;
+  for (i = 0; i < nblocks; i++) {
+    uint64_t ctr = counter + i;
+    uint32_t c0 = (uint32_t)ctr, c1 = (uint32_t)(ctr >> 32), c2 = 0, c3 = 0;
+    uint32_t k0 = (uint32_t)key, k1 = (uint32_t)(key >> 32);
+    for (r = 0; r < 10; r++) {
+      uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+      uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+      uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+      uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+      c1 = (uint32_t)p1;
+      c3 = (uint32_t)p0;
+      c0 = n0;
+      c2 = n2;
+      k0 += PHILOX_W0;
+      k1 += PHILOX_W1;
+    }
+    out[4*i] = c0;
+    out[4*i+1] = c1;
+    out[4*i+2] = c2;
+    out[4*i+3] = c3;
+  }
+}
+
+uint64_t THRandom_philoxReserve(THGenerator *_generator, uint64_t nblocks)
+{
+  uint64_t counter;
+  THArgCheck(_generator->engine == TH_RANDOM_ENGINE_PHILOX, 1,
+             "generator doesn't use the Philox engine");
+  counter = _generator->philox_counter;
+  _generator->philox_counter += nblocks;
+  /* the next single draw starts a new block */
+  _generator->philox_left = 0;
+  return counter;
+}
+
+static uint32_t philox_next(THGenerator *_generator)
+{
+  if (_generator->philox_left == 0) {
+    THRandom_philox(_generator->the_initial_seed, _generator->philox_counter++,
+                    _generator->philox_block, 1);
+    _generator->philox_left = 4;
+  }
+  return _generator->philox_block[4 - _generator->philox_left--];
+}
+
 // TODO: this only returns 32-bits of randomness but as a uint64_t. This is
 // weird and should be fixed. We should also fix the state to be uint32_t
 // instead of uint64_t. (Or switch to a 64-bit random number generator).
@@ -190,6 +266,9 @@ uint64_t THRandom_random(THGenerator *_generator)
 {
   uint64_t y;
 
+  if (_generator->engine == TH_RANDOM_ENGINE_PHILOX)
+    return philox_next(_generator);
+
   if (--(_generator->left) == 0)
     THRandom_nextState(_generator);
   y = *(_generator->state + (_generator->next)++);
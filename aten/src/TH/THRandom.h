@@ -5,6 +5,28 @@
 
 #define _MERSENNE_STATE_N 624
 #define _MERSENNE_STATE_M 397
+
+/* Engines a THGenerator can draw from. */
+#define TH_RANDOM_ENGINE_MT19937 0
+/* Philox4x32-10, a counter-based generator: block i of the stream is a
+   function of the seed and i only, so samplers can fill a contiguous tensor
+   in parallel and still give the same values for any number of threads. */
+#define TH_RANDOM_ENGINE_PHILOX 1
+
+/* The state of a THGenerator before the engines were added. States saved with
+   this layout can still be loaded, so it must remain a prefix of THGenerator. */
+typedef struct THGeneratorLegacyState {
+  uint64_t the_initial_seed;
+  int left;
+  int seeded;
+  uint64_t next;
+  uint64_t state[_MERSENNE_STATE_N];
+  double normal_x;
+  double normal_y;
+  double normal_rho;
+  int normal_is_valid;
+} THGeneratorLegacyState;
+
 /* A THGenerator contains all the state required for a single random number stream */
 typedef struct THGenerator {
   /* The initial seed. */
@@ -20,6 +42,13 @@ typedef struct THGenerator {
   double normal_y;
   double normal_rho;
   int normal_is_valid; /* = 0; */
+
+  int engine; /* = TH_RANDOM_ENGINE_MT19937 */
+  /* For the Philox engine: the next block of the stream and the words of
+     the current one that haven't been used yet. */
+  uint64_t philox_counter;
+  uint32_t philox_block[4];
+  int philox_left;
 } THGenerator;
 
 #define torch_Generator "torch.Generator"
@@ -42,6 +71,18 @@ TH_API void THRandom_manualSeed(THGenerator *_generator, uint64_t the_seed_);
 /* Returns the starting seed used. */
 TH_API uint64_t THRandom_initialSeed(THGenerator *_generator);
 
+/* Switches to one of the TH_RANDOM_ENGINE_* engines and restarts its stream
+   from the current initial seed. */
+TH_API void THGenerator_setEngine(THGenerator *_generator, int engine);
+TH_API int THGenerator_engine(THGenerator *_generator);
+
+/* Philox engine only: reserves the next nblocks blocks (of four 32-bit words) of
+   the stream and returns the counter of the first one. Block i is then
+   THRandom_philox(THRandom_initialSeed(gen), counter + i, ...). */
+TH_API uint64_t THRandom_philoxReserve(THGenerator *_generator, uint64_t nblocks);
+/* Computes nblocks consecutive blocks of the Philox stream of key. */
+TH_API void THRandom_philox(uint64_t key, uint64_t counter, uint32_t *out, ptrdiff_t nblocks);
+
 /* Generates a uniform 32 bits integer. */
 TH_API uint64_t THRandom_random(THGenerator *_generator);
 
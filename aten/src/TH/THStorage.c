@@ -1,5 +1,6 @@
 #include "THAtomic.h"
 #include "THStorage.h"
+#include "THVector.h"
 
 #include "generic/THStorage.c"
 #include "THGenerateAllTypes.h"
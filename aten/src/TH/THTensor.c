@@ -7,6 +7,7 @@
 #include "THLapack.h"
 #include "THRandom.h"
 #include "THTensorDimApply.h"
+#include "THTensorDimReduce.h"
 #include "THMath.h"
 
 #include "generic/THTensor.c"
@@ -27,6 +28,9 @@
 #include "generic/THTensorMath.c"
 #include "THGenerateAllTypes.h"
 
+#include "generic/THTensorHalfMath.c"
+#include "THGenerateHalfType.h"
+
 #include "generic/THTensorConv.c"
 #include "THGenerateAllTypes.h"
 
@@ -31,6 +31,9 @@
 #include "generic/THTensorMath.h"
 #include "THGenerateAllTypes.h"
 
+#include "generic/THTensorHalfMath.h"
+#include "THGenerateHalfType.h"
+
 /* convolutions */
 #include "generic/THTensorConv.h"
 #include "THGenerateAllTypes.h"
@@ -1,6 +1,8 @@
 #ifndef TH_TENSOR_APPLY_INC
 #define TH_TENSOR_APPLY_INC
 
+#include "THGeneral.h"
+
 /*
  * The basic strategy for apply is as follows:
  *
@@ -235,4 +237,462 @@
 #define TH_TENSOR_APPLY(TYPE, TENSOR, CODE) \
   TH_TENSOR_APPLY_D(TYPE, TENSOR, -1, CODE)
 
+#ifdef _OPENMP
+#include <omp.h>
+#ifndef _WIN32
+#define TH_APPLY_OMP_PRAGMA(P) _Pragma(#P)
+#else
+#define TH_APPLY_OMP_PRAGMA(P) __pragma(P)
+#endif
+#else
+#define TH_APPLY_OMP_PRAGMA(P)
+#endif
+
+/*
+ * Starting threads only pays off when there is enough work to share, and how
+ * many elements that takes depends on the op. TH_OMP_OVERHEAD_THRESHOLD is
+ * the amount of work, counted in adds, below which an op stays on one
+ * thread, and the costs below are rough per element costs of common ops in
+ * the same unit. An op is run in parallel when its number of elements times
+ * its cost is over the threshold, so that exp or pow go parallel on much
+ * smaller tensors than add.
+ */
+#define TH_OMP_OVERHEAD_THRESHOLD 100000
+#define TH_OMP_COST_CHEAP 1            /* copy, add, mul, clamp, comparisons */
+#define TH_OMP_COST_MODERATE 4         /* division, fmod, sqrt, rounding */
+#define TH_OMP_COST_TRANSCENDENTAL 40  /* exp, log, pow, trigonometric, erf */
+
+#define TH_OMP_WORTHWHILE(N, COST) ((N) * (COST) > TH_OMP_OVERHEAD_THRESHOLD)
+
+/*
+ * The parallel versions of apply, TH_TENSOR_APPLY*_OMP, give CODE the same
+ * TENSOR##_data pointers as TH_TENSOR_APPLY*, but CODE may only read and
+ * write the current elements: it can't accumulate into a shared variable,
+ * use the loop counters, or break out of the loop, and the elements aren't
+ * visited in order.
+ *
+ * When all the tensors have the same size and one of them is transposed,
+ * i.e. a dimension other than the last one has a smaller stride than the
+ * last one, the elements are visited in square tiles spanning both
+ * dimensions, so that every tensor reads whole cache lines. Otherwise the
+ * elements are numbered in the order TH_TENSOR_APPLY visits them, and each
+ * thread gets one range of that order: it finds where its range starts in
+ * every tensor, and walks it one run of the innermost dimension at a time.
+ */
+
+#define TH_APPLY_TILE 32
+
+/* The dimensions of a tensor that apply has to walk, with size-1
+ * dimensions dropped and contiguous ones merged. */
+typedef struct THApplyLayout
+{
+  int dim;
+  int64_t *sizes;
+  int64_t *strides;
+} THApplyLayout;
+
+static inline int64_t THApplyLayout_init(THApplyLayout *layout, int nDimension,
+                                         const int64_t *size, const int64_t *stride)
+{
+  int64_t n = nDimension ? 1 : 0;
+  int d;
+
+  layout->sizes = (int64_t*)THAlloc(sizeof(int64_t) * 2 * (nDimension > 0 ? nDimension : 1));
+  layout->strides = layout->sizes + (nDimension > 0 ? nDimension : 1);
+  layout->dim = 0;
+  for (d = 0; d < nDimension; d++) {
+    n *= size[d];
+    if (size[d] == 1)
+      continue;
+    if (layout->dim > 0 && layout->strides[layout->dim-1] == stride[d] * size[d]) {
+      layout->sizes[layout->dim-1] *= size[d];
+      layout->strides[layout->dim-1] = stride[d];
+    } else {
+      layout->sizes[layout->dim] = size[d];
+      layout->strides[layout->dim] = stride[d];
+      layout->dim++;
+    }
+  }
+  if (layout->dim == 0) {
+    layout->sizes[0] = 1;
+    layout->strides[0] = 1;
+    layout->dim = 1;
+  }
+  return n;
+}
+
+static inline void THApplyLayout_free(THApplyLayout *layout)
+{
+  THFree(layout->sizes);
+}
+
+/* Sets counter to the position of the index-th element, and returns its
+ * offset. */
+static inline int64_t THApplyLayout_seek(const THApplyLayout *layout, int64_t index, int64_t *counter)
+{
+  int64_t offset = 0;
+  int d;
+  for (d = layout->dim - 1; d >= 0; d--) {
+    counter[d] = index % layout->sizes[d];
+    index /= layout->sizes[d];
+    offset += counter[d] * layout->strides[d];
+  }
+  return offset;
+}
+
+/* Moves counter and offset forward by len elements, which must not go past
+ * the end of the current run of the innermost dimension. */
+static inline int64_t THApplyLayout_advance(const THApplyLayout *layout, int64_t len,
+                                            int64_t *counter, int64_t offset)
+{
+  int d = layout->dim - 1;
+  counter[d] += len;
+  offset += len * layout->strides[d];
+  while (d > 0 && counter[d] == layout->sizes[d]) {
+    offset -= counter[d] * layout->strides[d];
+    counter[d] = 0;
+    d--;
+    counter[d]++;
+    offset += layout->strides[d];
+  }
+  return offset;
+}
+
+/* Length of the run of the innermost dimension left from counter. */
+#define TH_APPLY_OMP_RUN(LAYOUT, COUNTER) \
+  ((LAYOUT).sizes[(LAYOUT).dim-1] - (COUNTER)[(LAYOUT).dim-1])
+
+/* Splits N elements between the threads of the current parallel region. */
+#ifdef _OPENMP
+#define TH_APPLY_OMP_RANGE(N, BEGIN, END) \
+  { \
+    int64_t TH_APPLY_threads = omp_get_num_threads(); \
+    int64_t TH_APPLY_tid = omp_get_thread_num(); \
+    BEGIN = (N) / TH_APPLY_threads * TH_APPLY_tid + \
+            (TH_APPLY_tid < (N) % TH_APPLY_threads ? TH_APPLY_tid : (N) % TH_APPLY_threads); \
+    END = BEGIN + (N) / TH_APPLY_threads + (TH_APPLY_tid < (N) % TH_APPLY_threads); \
+  }
+#else
+#define TH_APPLY_OMP_RANGE(N, BEGIN, END) \
+  BEGIN = 0; \
+  END = (N);
+#endif
+
+/* Tiles of up to TH_APPLY_TILE x TH_APPLY_TILE elements of tensors of the
+ * same size, spanning the innermost dimension and the block dimension. A
+ * tile is walked one row of the block dimension at a time. */
+typedef struct THApplyTiles
+{
+  int ntensors;
+  int dim;
+  int inner;
+  int block;
+  int64_t *sizes;
+  int64_t *strides;       /* ntensors x dim */
+  int64_t innerTiles;
+  int64_t blockTiles;
+  int64_t items;
+} THApplyTiles;
+
+/* Returns 0, and doesn't need THApplyTiles_free, unless the tensors have
+ * the same size and one of them is transposed. */
+static inline int THApplyTiles_init(THApplyTiles *tiles, int ntensors, const int *nDimension,
+                                    const int64_t **size, const int64_t **stride)
+{
+  int nd = nDimension[0];
+  int d, k;
+
+  for (k = 1; k < ntensors; k++) {
+    if (nDimension[k] != nd)
+      return 0;
+    for (d = 0; d < nd; d++)
+      if (size[k][d] != size[0][d])
+        return 0;
+  }
+  if (nd < 2)
+    return 0;
+
+  tiles->ntensors = ntensors;
+  tiles->sizes = (int64_t*)THAlloc(sizeof(int64_t) * (ntensors + 1) * nd);
+  tiles->strides = tiles->sizes + nd;
+  tiles->dim = 0;
+  for (d = 0; d < nd; d++) {
+    int merge = tiles->dim > 0;
+    if (size[0][d] == 1)
+      continue;
+    for (k = 0; k < ntensors && merge; k++)
+      merge = tiles->strides[k*nd + tiles->dim-1] == stride[k][d] * size[0][d];
+    if (merge) {
+      tiles->sizes[tiles->dim-1] *= size[0][d];
+    } else {
+      tiles->sizes[tiles->dim] = size[0][d];
+      tiles->dim++;
+    }
+    for (k = 0; k < ntensors; k++)
+      tiles->strides[k*nd + tiles->dim-1] = stride[k][d];
+  }
+
+  tiles->inner = tiles->dim - 1;
+  tiles->block = -1;
+  for (k = 0; k < ntensors && tiles->block < 0 && tiles->dim >= 2; k++) {
+    const int64_t *s = tiles->strides + k*nd;
+    int best = -1;
+    for (d = 0; d < tiles->inner; d++)
+      if (s[d] > 0 && (best < 0 || s[d] < s[best]))
+        best = d;
+    if (best >= 0 && s[best] < s[tiles->inner])
+      tiles->block = best;
+  }
+  if (tiles->block < 0) {
+    THFree(tiles->sizes);
+    return 0;
+  }
+
+  /* strides are looked up as strides[k*dim + d] from now on */
+  for (k = 1; k < ntensors; k++)
+    for (d = 0; d < tiles->dim; d++)
+      tiles->strides[k*tiles->dim + d] = tiles->strides[k*nd + d];
+
+  tiles->innerTiles = (tiles->sizes[tiles->inner] + TH_APPLY_TILE - 1) / TH_APPLY_TILE;
+  tiles->blockTiles = (tiles->sizes[tiles->block] + TH_APPLY_TILE - 1) / TH_APPLY_TILE;
+  tiles->items = tiles->innerTiles * tiles->blockTiles;
+  for (d = 0; d < tiles->dim; d++)
+    if (d != tiles->inner && d != tiles->block)
+      tiles->items *= tiles->sizes[d];
+  return 1;
+}
+
+static inline void THApplyTiles_free(THApplyTiles *tiles)
+{
+  THFree(tiles->sizes);
+}
+
+/* Sets offset to the offsets of the first element of a tile in every
+ * tensor, and rows and len to the tile's size. */
+static inline void THApplyTiles_tile(const THApplyTiles *tiles, int64_t item,
+                                     int64_t *offset, int64_t *rows, int64_t *len)
+{
+  int64_t innerTile = item % tiles->innerTiles;
+  int64_t blockTile = item / tiles->innerTiles % tiles->blockTiles;
+  int64_t rest = item / tiles->innerTiles / tiles->blockTiles;
+  int d, k;
+
+  *len = tiles->sizes[tiles->inner] - innerTile * TH_APPLY_TILE;
+  *len = *len < TH_APPLY_TILE ? *len : TH_APPLY_TILE;
+  *rows = tiles->sizes[tiles->block] - blockTile * TH_APPLY_TILE;
+  *rows = *rows < TH_APPLY_TILE ? *rows : TH_APPLY_TILE;
+  for (k = 0; k < tiles->ntensors; k++) {
+    const int64_t *s = tiles->strides + k*tiles->dim;
+    offset[k] = innerTile * TH_APPLY_TILE * s[tiles->inner] +
+                blockTile * TH_APPLY_TILE * s[tiles->block];
+  }
+  for (d = tiles->dim - 1; d >= 0; d--) {
+    int64_t index;
+    if (d == tiles->inner || d == tiles->block)
+      continue;
+    index = rest % tiles->sizes[d];
+    rest /= tiles->sizes[d];
+    for (k = 0; k < tiles->ntensors; k++)
+      offset[k] += index * tiles->strides[k*tiles->dim + d];
+  }
+}
+
+#define TH_APPLY_TILE_STRIDE(TILES, K, D) ((TILES).strides[(K)*(TILES).dim + (D)])
+
+#define TH_TENSOR_APPLY3_OMP(TYPE1, TENSOR1, TYPE2, TENSOR2, TYPE3, TENSOR3, COST, CODE) \
+{ \
+  THApplyLayout TENSOR1##_layout, TENSOR2##_layout, TENSOR3##_layout; \
+  THApplyTiles TH_APPLY_tiles; \
+  int TH_APPLY_nDimension[3] = {TENSOR1->nDimension, TENSOR2->nDimension, TENSOR3->nDimension}; \
+  const int64_t *TH_APPLY_size[3] = {TENSOR1->size, TENSOR2->size, TENSOR3->size}; \
+  const int64_t *TH_APPLY_stride[3] = {TENSOR1->stride, TENSOR2->stride, TENSOR3->stride}; \
+  int64_t TH_APPLY_n1 = THApplyLayout_init(&TENSOR1##_layout, TENSOR1->nDimension, TENSOR1->size, TENSOR1->stride); \
+  int64_t TH_APPLY_n2 = THApplyLayout_init(&TENSOR2##_layout, TENSOR2->nDimension, TENSOR2->size, TENSOR2->stride); \
+  int64_t TH_APPLY_n3 = THApplyLayout_init(&TENSOR3##_layout, TENSOR3->nDimension, TENSOR3->size, TENSOR3->stride); \
+  if (TH_APPLY_n1 != TH_APPLY_n2 || TH_APPLY_n1 != TH_APPLY_n3) { \
+    THDescBuff T1buff = _THSizeDesc(TENSOR1->size, TENSOR1->nDimension); \
+    THDescBuff T2buff = _THSizeDesc(TENSOR2->size, TENSOR2->nDimension); \
+    THDescBuff T3buff = _THSizeDesc(TENSOR3->size, TENSOR3->nDimension); \
+    THApplyLayout_free(&TENSOR1##_layout); \
+    THApplyLayout_free(&TENSOR2##_layout); \
+    THApplyLayout_free(&TENSOR3##_layout); \
+    THError("inconsistent tensor size, expected %s %s, %s %s and %s %s to have the same " \
+            "number of elements, but got %d, %d and %d elements respectively", \
+            #TENSOR1, T1buff.str, #TENSOR2, T2buff.str, #TENSOR3, T3buff.str, \
+            TH_APPLY_n1, TH_APPLY_n2, TH_APPLY_n3); \
+  } \
+  if (THApplyTiles_init(&TH_APPLY_tiles, 3, TH_APPLY_nDimension, TH_APPLY_size, TH_APPLY_stride)) { \
+    int64_t TH_APPLY_item; \
+    TH_APPLY_OMP_PRAGMA(omp parallel for if(TH_OMP_WORTHWHILE(TH_APPLY_n1, COST))) \
+    for (TH_APPLY_item = 0; TH_APPLY_item < TH_APPLY_tiles.items; TH_APPLY_item++) { \
+      int64_t TH_APPLY_offset[3], TH_APPLY_rows, TH_APPLY_len, TH_APPLY_r, TH_APPLY_i; \
+      int64_t TENSOR1##_stride = TH_APPLY_TILE_STRIDE(TH_APPLY_tiles, 0, TH_APPLY_tiles.inner); \
+      int64_t TENSOR2##_stride = TH_APPLY_TILE_STRIDE(TH_APPLY_tiles, 1, TH_APPLY_tiles.inner); \
+      int64_t TENSOR3##_stride = TH_APPLY_TILE_STRIDE(TH_APPLY_tiles, 2, TH_APPLY_tiles.inner); \
+      THApplyTiles_tile(&TH_APPLY_tiles, TH_APPLY_item, TH_APPLY_offset, &TH_APPLY_rows, &TH_APPLY_len); \
+      for (TH_APPLY_r = 0; TH_APPLY_r < TH_APPLY_rows; TH_APPLY_r++) { \
+        TYPE1 *TENSOR1##_data = TENSOR1->storage->data + TENSOR1->storageOffset + TH_APPLY_offset[0] + \
+                                TH_APPLY_r * TH_APPLY_TILE_STRIDE(TH_APPLY_tiles, 0, TH_APPLY_tiles.block); \
+        TYPE2 *TENSOR2##_data = TENSOR2->storage->data + TENSOR2->storageOffset + TH_APPLY_offset[1] + \
+                                TH_APPLY_r * TH_APPLY_TILE_STRIDE(TH_APPLY_tiles, 1, TH_APPLY_tiles.block); \
+        TYPE3 *TENSOR3##_data = TENSOR3->storage->data + TENSOR3->storageOffset + TH_APPLY_offset[2] + \
+                                TH_APPLY_r * TH_APPLY_TILE_STRIDE(TH_APPLY_tiles, 2, TH_APPLY_tiles.block); \
+        for (TH_APPLY_i = 0; TH_APPLY_i < TH_APPLY_len; TH_APPLY_i++, \
+             TENSOR1##_data += TENSOR1##_stride, TENSOR2##_data += TENSOR2##_stride, \
+             TENSOR3##_data += TENSOR3##_stride) { \
+          CODE \
+        } \
+      } \
+    } \
+    THApplyTiles_free(&TH_APPLY_tiles); \
+  } else { \
+    TH_APPLY_OMP_PRAGMA(omp parallel if(TH_OMP_WORTHWHILE(TH_APPLY_n1, COST))) \
+    { \
+      int64_t TH_APPLY_index, TH_APPLY_end; \
+      TH_APPLY_OMP_RANGE(TH_APPLY_n1, TH_APPLY_index, TH_APPLY_end) \
+      if (TH_APPLY_index < TH_APPLY_end) { \
+        int64_t *TENSOR1##_counter = (int64_t*)THAlloc(sizeof(int64_t) * \
+            (TENSOR1##_layout.dim + TENSOR2##_layout.dim + TENSOR3##_layout.dim)); \
+        int64_t *TENSOR2##_counter = TENSOR1##_counter + TENSOR1##_layout.dim; \
+        int64_t *TENSOR3##_counter = TENSOR2##_counter + TENSOR2##_layout.dim; \
+        int64_t TENSOR1##_offset = THApplyLayout_seek(&TENSOR1##_layout, TH_APPLY_index, TENSOR1##_counter); \
+        int64_t TENSOR2##_offset = THApplyLayout_seek(&TENSOR2##_layout, TH_APPLY_index, TENSOR2##_counter); \
+        int64_t TENSOR3##_offset = THApplyLayout_seek(&TENSOR3##_layout, TH_APPLY_index, TENSOR3##_counter); \
+        int64_t TENSOR1##_stride = TENSOR1##_layout.strides[TENSOR1##_layout.dim-1]; \
+        int64_t TENSOR2##_stride = TENSOR2##_layout.strides[TENSOR2##_layout.dim-1]; \
+        int64_t TENSOR3##_stride = TENSOR3##_layout.strides[TENSOR3##_layout.dim-1]; \
+        while (TH_APPLY_index < TH_APPLY_end) { \
+          int64_t TH_APPLY_len = TH_APPLY_end - TH_APPLY_index, TH_APPLY_i; \
+          TYPE1 *TENSOR1##_data = TENSOR1->storage->data + TENSOR1->storageOffset + TENSOR1##_offset; \
+          TYPE2 *TENSOR2##_data = TENSOR2->storage->data + TENSOR2->storageOffset + TENSOR2##_offset; \
+          TYPE3 *TENSOR3##_data = TENSOR3->storage->data + TENSOR3->storageOffset + TENSOR3##_offset; \
+          if (TH_APPLY_len > TH_APPLY_OMP_RUN(TENSOR1##_layout, TENSOR1##_counter)) \
+            TH_APPLY_len = TH_APPLY_OMP_RUN(TENSOR1##_layout, TENSOR1##_counter); \
+          if (TH_APPLY_len > TH_APPLY_OMP_RUN(TENSOR2##_layout, TENSOR2##_counter)) \
+            TH_APPLY_len = TH_APPLY_OMP_RUN(TENSOR2##_layout, TENSOR2##_counter); \
+          if (TH_APPLY_len > TH_APPLY_OMP_RUN(TENSOR3##_layout, TENSOR3##_counter)) \
+            TH_APPLY_len = TH_APPLY_OMP_RUN(TENSOR3##_layout, TENSOR3##_counter); \
+          for (TH_APPLY_i = 0; TH_APPLY_i < TH_APPLY_len; TH_APPLY_i++, \
+               TENSOR1##_data += TENSOR1##_stride, TENSOR2##_data += TENSOR2##_stride, \
+               TENSOR3##_data += TENSOR3##_stride) { \
+            CODE \
+          } \
+          TENSOR1##_offset = THApplyLayout_advance(&TENSOR1##_layout, TH_APPLY_len, TENSOR1##_counter, TENSOR1##_offset); \
+          TENSOR2##_offset = THApplyLayout_advance(&TENSOR2##_layout, TH_APPLY_len, TENSOR2##_counter, TENSOR2##_offset); \
+          TENSOR3##_offset = THApplyLayout_advance(&TENSOR3##_layout, TH_APPLY_len, TENSOR3##_counter, TENSOR3##_offset); \
+          TH_APPLY_index += TH_APPLY_len; \
+        } \
+        THFree(TENSOR1##_counter); \
+      } \
+    } \
+  } \
+  THApplyLayout_free(&TENSOR1##_layout); \
+  THApplyLayout_free(&TENSOR2##_layout); \
+  THApplyLayout_free(&TENSOR3##_layout); \
+}
+
+#define TH_TENSOR_APPLY2_OMP(TYPE1, TENSOR1, TYPE2, TENSOR2, COST, CODE) \
+{ \
+  THApplyLayout TENSOR1##_layout, TENSOR2##_layout; \
+  THApplyTiles TH_APPLY_tiles; \
+  int TH_APPLY_nDimension[2] = {TENSOR1->nDimension, TENSOR2->nDimension}; \
+  const int64_t *TH_APPLY_size[2] = {TENSOR1->size, TENSOR2->size}; \
+  const int64_t *TH_APPLY_stride[2] = {TENSOR1->stride, TENSOR2->stride}; \
+  int64_t TH_APPLY_n1 = THApplyLayout_init(&TENSOR1##_layout, TENSOR1->nDimension, TENSOR1->size, TENSOR1->stride); \
+  int64_t TH_APPLY_n2 = THApplyLayout_init(&TENSOR2##_layout, TENSOR2->nDimension, TENSOR2->size, TENSOR2->stride); \
+  if (TH_APPLY_n1 != TH_APPLY_n2) { \
+    THDescBuff T1buff = _THSizeDesc(TENSOR1->size, TENSOR1->nDimension); \
+    THDescBuff T2buff = _THSizeDesc(TENSOR2->size, TENSOR2->nDimension); \
+    THApplyLayout_free(&TENSOR1##_layout); \
+    THApplyLayout_free(&TENSOR2##_layout); \
+    THError("inconsistent tensor size, expected %s %s and %s %s to have the same " \
+            "number of elements, but got %d and %d elements respectively", \
+            #TENSOR1, T1buff.str, #TENSOR2, T2buff.str, TH_APPLY_n1, TH_APPLY_n2); \
+  } \
+  if (THApplyTiles_init(&TH_APPLY_tiles, 2, TH_APPLY_nDimension, TH_APPLY_size, TH_APPLY_stride)) { \
+    int64_t TH_APPLY_item; \
+    TH_APPLY_OMP_PRAGMA(omp parallel for if(TH_OMP_WORTHWHILE(TH_APPLY_n1, COST))) \
+    for (TH_APPLY_item = 0; TH_APPLY_item < TH_APPLY_tiles.items; TH_APPLY_item++) { \
+      int64_t TH_APPLY_offset[2], TH_APPLY_rows, TH_APPLY_len, TH_APPLY_r, TH_APPLY_i; \
+      int64_t TENSOR1##_stride = TH_APPLY_TILE_STRIDE(TH_APPLY_tiles, 0, TH_APPLY_tiles.inner); \
+      int64_t TENSOR2##_stride = TH_APPLY_TILE_STRIDE(TH_APPLY_tiles, 1, TH_APPLY_tiles.inner); \
+      THApplyTiles_tile(&TH_APPLY_tiles, TH_APPLY_item, TH_APPLY_offset, &TH_APPLY_rows, &TH_APPLY_len); \
+      for (TH_APPLY_r = 0; TH_APPLY_r < TH_APPLY_rows; TH_APPLY_r++) { \
+        TYPE1 *TENSOR1##_data = TENSOR1->storage->data + TENSOR1->storageOffset + TH_APPLY_offset[0] + \
+                                TH_APPLY_r * TH_APPLY_TILE_STRIDE(TH_APPLY_tiles, 0, TH_APPLY_tiles.block); \
+        TYPE2 *TENSOR2##_data = TENSOR2->storage->data + TENSOR2->storageOffset + TH_APPLY_offset[1] + \
+                                TH_APPLY_r * TH_APPLY_TILE_STRIDE(TH_APPLY_tiles, 1, TH_APPLY_tiles.block); \
+        for (TH_APPLY_i = 0; TH_APPLY_i < TH_APPLY_len; TH_APPLY_i++, \
+             TENSOR1##_data += TENSOR1##_stride, TENSOR2##_data += TENSOR2##_stride) { \
+          CODE \
+        } \
+      } \
+    } \
+    THApplyTiles_free(&TH_APPLY_tiles); \
+  } else { \
+    TH_APPLY_OMP_PRAGMA(omp parallel if(TH_OMP_WORTHWHILE(TH_APPLY_n1, COST))) \
+    { \
+      int64_t TH_APPLY_index, TH_APPLY_end; \
+      TH_APPLY_OMP_RANGE(TH_APPLY_n1, TH_APPLY_index, TH_APPLY_end) \
+      if (TH_APPLY_index < TH_APPLY_end) { \
+        int64_t *TENSOR1##_counter = (int64_t*)THAlloc(sizeof(int64_t) * \
+            (TENSOR1##_layout.dim + TENSOR2##_layout.dim)); \
+        int64_t *TENSOR2##_counter = TENSOR1##_counter + TENSOR1##_layout.dim; \
+        int64_t TENSOR1##_offset = THApplyLayout_seek(&TENSOR1##_layout, TH_APPLY_index, TENSOR1##_counter); \
+        int64_t TENSOR2##_offset = THApplyLayout_seek(&TENSOR2##_layout, TH_APPLY_index, TENSOR2##_counter); \
+        int64_t TENSOR1##_stride = TENSOR1##_layout.strides[TENSOR1##_layout.dim-1]; \
+        int64_t TENSOR2##_stride = TENSOR2##_layout.strides[TENSOR2##_layout.dim-1]; \
+        while (TH_APPLY_index < TH_APPLY_end) { \
+          int64_t TH_APPLY_len = TH_APPLY_end - TH_APPLY_index, TH_APPLY_i; \
+          TYPE1 *TENSOR1##_data = TENSOR1->storage->data + TENSOR1->storageOffset + TENSOR1##_offset; \
+          TYPE2 *TENSOR2##_data = TENSOR2->storage->data + TENSOR2->storageOffset + TENSOR2##_offset; \
+          if (TH_APPLY_len > TH_APPLY_OMP_RUN(TENSOR1##_layout, TENSOR1##_counter)) \
+            TH_APPLY_len = TH_APPLY_OMP_RUN(TENSOR1##_layout, TENSOR1##_counter); \
+          if (TH_APPLY_len > TH_APPLY_OMP_RUN(TENSOR2##_layout, TENSOR2##_counter)) \
+            TH_APPLY_len = TH_APPLY_OMP_RUN(TENSOR2##_layout, TENSOR2##_counter); \
+          for (TH_APPLY_i = 0; TH_APPLY_i < TH_APPLY_len; TH_APPLY_i++, \
+               TENSOR1##_data += TENSOR1##_stride, TENSOR2##_data += TENSOR2##_stride) { \
+            CODE \
+          } \
+          TENSOR1##_offset = THApplyLayout_advance(&TENSOR1##_layout, TH_APPLY_len, TENSOR1##_counter, TENSOR1##_offset); \
+          TENSOR2##_offset = THApplyLayout_advance(&TENSOR2##_layout, TH_APPLY_len, TENSOR2##_counter, TENSOR2##_offset); \
+          TH_APPLY_index += TH_APPLY_len; \
+        } \
+        THFree(TENSOR1##_counter); \
+      } \
+    } \
+  } \
+  THApplyLayout_free(&TENSOR1##_layout); \
+  THApplyLayout_free(&TENSOR2##_layout); \
+}
+
+#define TH_TENSOR_APPLY_OMP(TYPE, TENSOR, COST, CODE) \
+{ \
+  THApplyLayout TENSOR##_layout; \
+  int64_t TH_APPLY_n = THApplyLayout_init(&TENSOR##_layout, TENSOR->nDimension, TENSOR->size, TENSOR->stride); \
+  TH_APPLY_OMP_PRAGMA(omp parallel if(TH_OMP_WORTHWHILE(TH_APPLY_n, COST))) \
+  { \
+    int64_t TH_APPLY_index, TH_APPLY_end; \
+    TH_APPLY_OMP_RANGE(TH_APPLY_n, TH_APPLY_index, TH_APPLY_end) \
+    if (TH_APPLY_index < TH_APPLY_end) { \
+      int64_t *TENSOR##_counter = (int64_t*)THAlloc(sizeof(int64_t) * TENSOR##_layout.dim); \
+      int64_t TENSOR##_offset = THApplyLayout_seek(&TENSOR##_layout, TH_APPLY_index, TENSOR##_counter); \
+      int64_t TENSOR##_stride = TENSOR##_layout.strides[TENSOR##_layout.dim-1]; \
+      while (TH_APPLY_index < TH_APPLY_end) { \
+        int64_t TH_APPLY_len = TH_APPLY_end - TH_APPLY_index, TH_APPLY_i; \
+        TYPE *TENSOR##_data = TENSOR->storage->data + TENSOR->storageOffset + TENSOR##_offset; \
+        if (TH_APPLY_len > TH_APPLY_OMP_RUN(TENSOR##_layout, TENSOR##_counter)) \
+          TH_APPLY_len = TH_APPLY_OMP_RUN(TENSOR##_layout, TENSOR##_counter); \
+        for (TH_APPLY_i = 0; TH_APPLY_i < TH_APPLY_len; TH_APPLY_i++, TENSOR##_data += TENSOR##_stride) { \
+          CODE \
+        } \
+        TENSOR##_offset = THApplyLayout_advance(&TENSOR##_layout, TH_APPLY_len, TENSOR##_counter, TENSOR##_offset); \
+        TH_APPLY_index += TH_APPLY_len; \
+      } \
+      THFree(TENSOR##_counter); \
+    } \
+  } \
+  THApplyLayout_free(&TENSOR##_layout); \
+}
+
 #endif
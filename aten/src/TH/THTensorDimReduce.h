@@ -0,0 +1,301 @@
+#ifndef TH_TENSOR_DIM_REDUCE_INC
+#define TH_TENSOR_DIM_REDUCE_INC
+
+#ifdef _OPENMP
+#include <omp.h>
+#ifndef _WIN32
+#define TH_DIM_REDUCE_PRAGMA(P) _Pragma(#P)
+#else
+#define TH_DIM_REDUCE_PRAGMA(P) __pragma(P)
+#endif
+#else
+#define TH_DIM_REDUCE_PRAGMA(P)
+#endif
+
+// Independent accumulators used for a contiguous reduced dimension, so that
+// the inner loop vectorizes.
+#define TH_DIM_REDUCE_LANES 8
+
+// Width of the slabs of a contiguous output dimension reduced together. Long
+// rows keep the hardware prefetcher busy when the reduced stride is large.
+#define TH_DIM_REDUCE_BLOCK 512
+
+// Slices at least twice this long are split into pieces of this length
+// that are reduced in parallel and merged pairwise, when there are too few
+// slices to keep the threads busy. The split only depends on the shape, so
+// results don't change with the number of threads.
+#define TH_DIM_REDUCE_CHUNK 32768
+#define TH_DIM_REDUCE_SPLIT_ITEMS 64
+
+// How TH_TENSOR_DIM_REDUCE walks a reduction, worked out from the strides.
+// Every output element is the reduction of a slice of n input elements
+// t_step apart. Output elements are grouped in items: when some other
+// dimension is contiguous in the input (vec_dim), an item is a block of up
+// to TH_DIM_REDUCE_BLOCK elements along it, whose slices are reduced
+// together one input row at a time. Otherwise an item is a single output
+// element, reduced with TH_DIM_REDUCE_LANES accumulators if its slice is
+// contiguous.
+typedef struct THDimReducePlan
+{
+  int64_t n;
+  int64_t t_step;
+  int vec_dim;
+  int64_t width;      // size of vec_dim, or 1
+  int64_t r_vec;      // stride of vec_dim in the outputs
+  int64_t i_vec;
+  int64_t nblocks;
+  int64_t item_width; // output elements per item: min(width, TH_DIM_REDUCE_BLOCK)
+  int lanes;
+  int ndim;           // outer dimensions, i.e. all but the reduced one and vec_dim
+  int64_t *size;
+  int64_t *t_stride;
+  int64_t *r_stride;
+  int64_t *i_stride;
+  int64_t numel;
+  int64_t items;
+  int64_t chunks;
+  int64_t chunk;
+} THDimReducePlan;
+
+static inline void THDimReducePlan_init(THDimReducePlan *plan, int nDimension, int dimension,
+                                        const int64_t *size, const int64_t *t_stride,
+                                        const int64_t *r_stride, const int64_t *i_stride)
+{
+  int64_t outer = 1;
+  int d;
+
+  plan->n = size[dimension];
+  plan->t_step = t_stride[dimension];
+  plan->vec_dim = -1;
+  if (plan->t_step != 1 && plan->n > 1) {
+    for (d = nDimension - 1; d >= 0; d--) {
+      if (d != dimension && t_stride[d] == 1 && size[d] > 1) {
+        plan->vec_dim = d;
+        break;
+      }
+    }
+  }
+  plan->width = plan->vec_dim >= 0 ? size[plan->vec_dim] : 1;
+  plan->r_vec = plan->vec_dim >= 0 ? r_stride[plan->vec_dim] : 0;
+  plan->i_vec = plan->vec_dim >= 0 && i_stride ? i_stride[plan->vec_dim] : 0;
+  plan->nblocks = (plan->width + TH_DIM_REDUCE_BLOCK - 1) / TH_DIM_REDUCE_BLOCK;
+  plan->item_width = plan->width < TH_DIM_REDUCE_BLOCK ? plan->width : TH_DIM_REDUCE_BLOCK;
+  plan->lanes = plan->vec_dim < 0 && plan->t_step == 1 &&
+                plan->n >= 2*TH_DIM_REDUCE_LANES ? TH_DIM_REDUCE_LANES : 1;
+
+  plan->size = (int64_t*)THAlloc(sizeof(int64_t) * 4 * (nDimension > 0 ? nDimension : 1));
+  plan->t_stride = plan->size + nDimension;
+  plan->r_stride = plan->t_stride + nDimension;
+  plan->i_stride = plan->r_stride + nDimension;
+  plan->ndim = 0;
+  for (d = 0; d < nDimension; d++) {
+    if (d == dimension || d == plan->vec_dim)
+      continue;
+    plan->size[plan->ndim] = size[d];
+    plan->t_stride[plan->ndim] = t_stride[d];
+    plan->r_stride[plan->ndim] = r_stride[d];
+    plan->i_stride[plan->ndim] = i_stride ? i_stride[d] : 0;
+    outer *= size[d];
+    plan->ndim++;
+  }
+
+  plan->numel = outer * plan->width * plan->n;
+  plan->items = outer * plan->nblocks;
+  plan->chunk = plan->n;
+  plan->chunks = 1;
+  if (plan->items < TH_DIM_REDUCE_SPLIT_ITEMS && plan->n >= 2*TH_DIM_REDUCE_CHUNK) {
+    plan->chunk = TH_DIM_REDUCE_CHUNK;
+    plan->chunks = (plan->n + TH_DIM_REDUCE_CHUNK - 1) / TH_DIM_REDUCE_CHUNK;
+  }
+}
+
+static inline void THDimReducePlan_free(THDimReducePlan *plan)
+{
+  THFree(plan->size);
+}
+
+// Offsets of the first output element of item in the input and outputs.
+// Returns the item's index along the last outer dimension.
+static inline int64_t THDimReducePlan_offsets(const THDimReducePlan *plan, int64_t item,
+                                              int64_t *t_off, int64_t *r_off, int64_t *i_off)
+{
+  int64_t block = item % plan->nblocks;
+  int64_t rest = item / plan->nblocks;
+  int64_t last = 0;
+  int d;
+
+  *t_off = block * TH_DIM_REDUCE_BLOCK;
+  *r_off = block * TH_DIM_REDUCE_BLOCK * plan->r_vec;
+  *i_off = block * TH_DIM_REDUCE_BLOCK * plan->i_vec;
+  for (d = plan->ndim - 1; d >= 0; d--) {
+    int64_t index = rest % plan->size[d];
+    if (d == plan->ndim - 1)
+      last = index;
+    rest /= plan->size[d];
+    *t_off += index * plan->t_stride[d];
+    *r_off += index * plan->r_stride[d];
+    *i_off += index * plan->i_stride[d];
+  }
+  return last;
+}
+
+// Moves the offsets from item - 1 to item, which is cheap unless a
+// dimension other than the last outer one changes.
+static inline void THDimReducePlan_next(const THDimReducePlan *plan, int64_t item, int64_t *last,
+                                        int64_t *t_off, int64_t *r_off, int64_t *i_off)
+{
+  int d = plan->ndim - 1;
+  if (plan->nblocks == 1 && d >= 0 && ++*last < plan->size[d]) {
+    *t_off += plan->t_stride[d];
+    *r_off += plan->r_stride[d];
+    *i_off += plan->i_stride[d];
+  } else {
+    *last = THDimReducePlan_offsets(plan, item, t_off, r_off, i_off);
+  }
+}
+
+// Reduces TENSOR along DIMENSION into RESULT, and INDICES unless it's NULL.
+// Both must already have TENSOR's size with a size of 1 at DIMENSION. COST
+// is the cost of an update, one of the TH_OMP_COST_* values. The reduction
+// is described by a STATE type and four function-like macros:
+//   INIT(s)                 starts an empty reduction
+//   UPDATE(s, x, k)         adds the element x, at index k of the slice
+//   MERGE(a, b)             folds b into a; b may cover indices before a's,
+//                           so anything that depends on the order has to
+//                           compare indices
+//   FINALIZE(s, value, ix)  stores the results in the real value and the
+//                           int64_t ix (which is ignored without INDICES)
+// Inputs are read in whichever order suits the strides, so results only
+// match a sequential loop up to rounding.
+#define TH_TENSOR_DIM_REDUCE(TYPE, TENSOR, DIMENSION, RESULT, INDICES, STATE, COST, INIT, UPDATE, MERGE, FINALIZE) \
+{ \
+  THDimReducePlan TH_DIM_REDUCE_plan; \
+  TYPE *TH_DIM_REDUCE_t_data = THTensor_(data)(TENSOR); \
+  real *TH_DIM_REDUCE_r_data = THTensor_(data)(RESULT); \
+  THLongTensor *TH_DIM_REDUCE_indices = (INDICES); \
+  int64_t *TH_DIM_REDUCE_i_data = TH_DIM_REDUCE_indices ? THLongTensor_data(TH_DIM_REDUCE_indices) : NULL; \
+  STATE *TH_DIM_REDUCE_partials = NULL; \
+  int64_t TH_DIM_REDUCE_tile; \
+  int64_t TH_DIM_REDUCE_work; \
+  int64_t TH_DIM_REDUCE_w; \
+\
+  THDimReducePlan_init(&TH_DIM_REDUCE_plan, (TENSOR)->nDimension, DIMENSION, \
+                       (TENSOR)->size, (TENSOR)->stride, (RESULT)->stride, \
+                       TH_DIM_REDUCE_indices ? TH_DIM_REDUCE_indices->stride : NULL); \
+  if (TH_DIM_REDUCE_plan.chunks > 1) \
+    TH_DIM_REDUCE_partials = (STATE*)THAlloc(sizeof(STATE) * TH_DIM_REDUCE_plan.items * \
+                                             TH_DIM_REDUCE_plan.chunks * \
+                                             TH_DIM_REDUCE_plan.item_width); \
+  /* consecutive items are grouped in at most 256 tiles */ \
+  TH_DIM_REDUCE_tile = (TH_DIM_REDUCE_plan.items + 255) / 256; \
+  TH_DIM_REDUCE_work = (TH_DIM_REDUCE_plan.items + TH_DIM_REDUCE_tile - 1) / TH_DIM_REDUCE_tile * \
+                       TH_DIM_REDUCE_plan.chunks; \
+\
+  TH_DIM_REDUCE_PRAGMA(omp parallel for if(TH_DIM_REDUCE_work > 1 && \
+                                            TH_OMP_WORTHWHILE(TH_DIM_REDUCE_plan.numel, COST))) \
+  for (TH_DIM_REDUCE_w = 0; TH_DIM_REDUCE_w < TH_DIM_REDUCE_work; TH_DIM_REDUCE_w++) { \
+    const THDimReducePlan *p = &TH_DIM_REDUCE_plan; \
+    int64_t chunk = TH_DIM_REDUCE_w % p->chunks; \
+    int64_t k0 = chunk * p->chunk; \
+    int64_t k1 = k0 + p->chunk < p->n ? k0 + p->chunk : p->n; \
+    int64_t first = TH_DIM_REDUCE_w / p->chunks * TH_DIM_REDUCE_tile; \
+    int64_t item_end = first + TH_DIM_REDUCE_tile < p->items ? first + TH_DIM_REDUCE_tile : p->items; \
+    int64_t item; \
+    int64_t t_off, r_off, i_off, last, width, j, k; \
+    STATE acc[TH_DIM_REDUCE_BLOCK > TH_DIM_REDUCE_LANES ? TH_DIM_REDUCE_BLOCK : TH_DIM_REDUCE_LANES]; \
+\
+    last = THDimReducePlan_offsets(p, first, &t_off, &r_off, &i_off); \
+    for (item = first; item < item_end; item++) { \
+      const TYPE *in; \
+      if (item > first) \
+        THDimReducePlan_next(p, item, &last, &t_off, &r_off, &i_off); \
+      in = TH_DIM_REDUCE_t_data + t_off; \
+      if (p->vec_dim >= 0) { \
+        /* slices side by side: vectorized across the contiguous output dimension */ \
+        width = p->width - (item % p->nblocks) * TH_DIM_REDUCE_BLOCK; \
+        if (width > TH_DIM_REDUCE_BLOCK) \
+          width = TH_DIM_REDUCE_BLOCK; \
+        for (j = 0; j < width; j++) { \
+          INIT(acc[j]); \
+        } \
+        for (k = k0; k < k1; k++) { \
+          const TYPE *row = in + k * p->t_step; \
+          for (j = 0; j < width; j++) { \
+            UPDATE(acc[j], row[j], k); \
+          } \
+        } \
+      } else if (p->lanes > 1) { \
+        /* contiguous slice: independent accumulators, merged pairwise */ \
+        int l, stride; \
+        width = 1; \
+        for (l = 0; l < TH_DIM_REDUCE_LANES; l++) { \
+          INIT(acc[l]); \
+        } \
+        for (k = k0; k + TH_DIM_REDUCE_LANES <= k1; k += TH_DIM_REDUCE_LANES) { \
+          for (l = 0; l < TH_DIM_REDUCE_LANES; l++) { \
+            UPDATE(acc[l], in[k + l], k + l); \
+          } \
+        } \
+        for (l = 0; k < k1; k++, l++) { \
+          UPDATE(acc[l], in[k], k); \
+        } \
+        for (stride = 1; stride < TH_DIM_REDUCE_LANES; stride *= 2) { \
+          for (l = 0; l + stride < TH_DIM_REDUCE_LANES; l += 2*stride) { \
+            MERGE(acc[l], acc[l + stride]); \
+          } \
+        } \
+      } else { \
+        width = 1; \
+        INIT(acc[0]); \
+        for (k = k0; k < k1; k++) { \
+          UPDATE(acc[0], in[k * p->t_step], k); \
+        } \
+      } \
+\
+      if (p->chunks > 1) { \
+        STATE *partial = TH_DIM_REDUCE_partials + (item * p->chunks + chunk) * p->item_width; \
+        for (j = 0; j < width; j++) \
+          partial[j] = acc[j]; \
+      } else { \
+        for (j = 0; j < width; j++) { \
+          int64_t TH_DIM_REDUCE_ignored_index; \
+          FINALIZE(acc[j], TH_DIM_REDUCE_r_data[r_off + j * p->r_vec], \
+                   *(TH_DIM_REDUCE_i_data ? TH_DIM_REDUCE_i_data + i_off + j * p->i_vec \
+                                          : &TH_DIM_REDUCE_ignored_index)); \
+        } \
+      } \
+    } \
+  } \
+\
+  if (TH_DIM_REDUCE_partials) { \
+    /* tree reduction of the pieces of each slice */ \
+    int64_t TH_DIM_REDUCE_item; \
+    TH_DIM_REDUCE_PRAGMA(omp parallel for if(TH_DIM_REDUCE_plan.items > 1)) \
+    for (TH_DIM_REDUCE_item = 0; TH_DIM_REDUCE_item < TH_DIM_REDUCE_plan.items; TH_DIM_REDUCE_item++) { \
+      const THDimReducePlan *p = &TH_DIM_REDUCE_plan; \
+      STATE *partial = TH_DIM_REDUCE_partials + TH_DIM_REDUCE_item * p->chunks * p->item_width; \
+      int64_t t_off, r_off, i_off, width, j, c, stride; \
+      THDimReducePlan_offsets(p, TH_DIM_REDUCE_item, &t_off, &r_off, &i_off); \
+      width = p->width - (TH_DIM_REDUCE_item % p->nblocks) * TH_DIM_REDUCE_BLOCK; \
+      if (width > TH_DIM_REDUCE_BLOCK) \
+        width = TH_DIM_REDUCE_BLOCK; \
+      for (stride = 1; stride < p->chunks; stride *= 2) { \
+        for (c = 0; c + stride < p->chunks; c += 2*stride) { \
+          for (j = 0; j < width; j++) { \
+            MERGE(partial[c * p->item_width + j], partial[(c + stride) * p->item_width + j]); \
+          } \
+        } \
+      } \
+      for (j = 0; j < width; j++) { \
+        int64_t TH_DIM_REDUCE_ignored_index; \
+        FINALIZE(partial[j], TH_DIM_REDUCE_r_data[r_off + j * p->r_vec], \
+                 *(TH_DIM_REDUCE_i_data ? TH_DIM_REDUCE_i_data + i_off + j * p->i_vec \
+                                        : &TH_DIM_REDUCE_ignored_index)); \
+      } \
+    } \
+    THFree(TH_DIM_REDUCE_partials); \
+  } \
+  THDimReducePlan_free(&TH_DIM_REDUCE_plan); \
+}
+
+#endif
@@ -23,6 +23,10 @@
 #include "vector/AVX2.h"
 #endif
 
+#if defined(USE_F16C)
+#include "vector/F16C.h"
+#endif
+
 #include "generic/THVectorDefault.c"
 #include "THGenerateAllTypes.h"
 
@@ -79,6 +79,18 @@ SET(AVX2_CODE "
   }
 ")
 
+SET(F16C_CODE "
+  #include <immintrin.h>
+
+  int main()
+  {
+    __m128i a = _mm_setzero_si128();
+    __m256 b = _mm256_cvtph_ps(a);
+    a = _mm256_cvtps_ph(b, 0);
+    return 0;
+  }
+")
+
 MACRO(CHECK_SSE lang type flags)
   SET(__FLAG_I 1)
   SET(CMAKE_REQUIRED_FLAGS_SAVE ${CMAKE_REQUIRED_FLAGS})
@@ -115,6 +127,7 @@ CHECK_SSE(C "SSE4_1" " ;-msse4.1;-msse4;/arch:SSE4")
 CHECK_SSE(C "SSE4_2" " ;-msse4.2;-msse4;/arch:SSE4")
 CHECK_SSE(C "AVX" " ;-mavx;/arch:AVX")
 CHECK_SSE(C "AVX2" " ;-mavx2 -mfma;/arch:AVX2")
+CHECK_SSE(C "F16C" " ;-mavx -mf16c;/arch:AVX")
 
 CHECK_SSE(CXX "SSE1" " ;-msse;/arch:SSE")
 CHECK_SSE(CXX "SSE2" " ;-msse2;/arch:SSE2")
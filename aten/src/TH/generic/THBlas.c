@@ -292,6 +292,161 @@ void THBlas_(ger)(int64_t m, int64_t n, real alpha, real *x, int64_t incx, real
   }
 }
 
+#ifndef TH_GEMM_BLOCKING
+#define TH_GEMM_BLOCKING
+/* Blocking of the fallback gemm: op(A) is packed by blocks of MC x KC and
+   op(B) by blocks of KC x NC, the micro-kernel computes MR x NR tiles of C in
+   registers. Threads work on separate MC x NT tiles of C. */
+#define TH_GEMM_MR 8
+#define TH_GEMM_NR 4
+#define TH_GEMM_MC 128
+#define TH_GEMM_KC 256
+#define TH_GEMM_NC 4096
+#define TH_GEMM_NT 256
+#define TH_GEMM_OMP_THRESHOLD (64 * 64 * 64)
+#endif
+
+/* Packs the mc x kc block of op(A) starting at (i0, p0) into row panels of
+   TH_GEMM_MR rows, padding the last panel with zeros. */
+static void THBlas_(gemmPackA)(int transa, int64_t mc, int64_t kc, real *a, int64_t lda,
+                               int64_t i0, int64_t p0, real *packed)
+{
+  int64_t ir, p, i;
+  for (ir = 0; ir < mc; ir += TH_GEMM_MR) {
+    int64_t mr = THMin(TH_GEMM_MR, mc - ir);
+    for (p = 0; p < kc; p++) {
+      for (i = 0; i < mr; i++) {
+        int64_t row = i0 + ir + i, col = p0 + p;
+        packed[i] = transa ? a[col + row*lda] : a[row + col*lda];
+      }
+      for (; i < TH_GEMM_MR; i++)
+        packed[i] = 0;
+      packed += TH_GEMM_MR;
+    }
+  }
+}
+
+/* Packs the kc x nc block of op(B) starting at (p0, j0) into column panels
+   of TH_GEMM_NR columns, padding the last panel with zeros. */
+static void THBlas_(gemmPackB)(int transb, int64_t kc, int64_t nc, real *b, int64_t ldb,
+                               int64_t p0, int64_t j0, real *packed)
+{
+  int64_t jr;
+  /* called inside the parallel region of gemmBlocked, so the panels are
+     shared between its threads */
+#pragma omp for private(jr)
+  for (jr = 0; jr < nc; jr += TH_GEMM_NR) {
+    int64_t nr = THMin(TH_GEMM_NR, nc - jr);
+    real *panel = packed + jr * kc;
+    int64_t p, j;
+    for (p = 0; p < kc; p++) {
+      for (j = 0; j < nr; j++) {
+        int64_t row = p0 + p, col = j0 + jr + j;
+        panel[j] = transb ? b[col + row*ldb] : b[row + col*ldb];
+      }
+      for (; j < TH_GEMM_NR; j++)
+        panel[j] = 0;
+      panel += TH_GEMM_NR;
+    }
+  }
+}
+
+/* acc = a * b for a packed TH_GEMM_MR x kc panel of A and kc x TH_GEMM_NR
+   panel of B, acc being column major. The fixed trip counts let the compiler
+   keep acc in registers and vectorize over the rows. */
+static void THBlas_(gemmKernel)(int64_t kc, const real *a, const real *b, real *acc)
+{
+  int64_t p;
+  int i, j;
+  for (i = 0; i < TH_GEMM_MR * TH_GEMM_NR; i++)
+    acc[i] = 0;
+  for (p = 0; p < kc; p++) {
+    for (j = 0; j < TH_GEMM_NR; j++) {
+      real bj = b[j];
+      for (i = 0; i < TH_GEMM_MR; i++)
+        acc[j*TH_GEMM_MR + i] += a[i] * bj;
+    }
+    a += TH_GEMM_MR;
+    b += TH_GEMM_NR;
+  }
+}
+
+/* c = alpha * op(a) * op(b) + beta * c for types without (or too large for)
+   an external BLAS. Half has no THBlas: like the rest of its CPU math, a half
+   gemm would convert its operands to float and use THFloatBlas_gemm, rather
+   than accumulate in half precision here. */
+static void THBlas_(gemmBlocked)(int transa, int transb, int64_t m, int64_t n, int64_t k,
+                                 real alpha, real *a, int64_t lda, real *b, int64_t ldb,
+                                 real beta, real *c, int64_t ldc)
+{
+  int64_t j;
+  int parallel = m * n * k > TH_GEMM_OMP_THRESHOLD;
+
+#pragma omp parallel for if(parallel) private(j)
+  for (j = 0; j < n; j++) {
+    real *c_ = c + j*ldc;
+    int64_t i;
+    if (beta == 0) {
+      for (i = 0; i < m; i++)
+        c_[i] = 0;
+    } else if (beta != 1) {
+      for (i = 0; i < m; i++)
+        c_[i] *= beta;
+    }
+  }
+  if (k == 0 || alpha == 0)
+    return;
+
+  real *packedB = (real*)THAlloc(sizeof(real) * TH_GEMM_KC *
+                                 (THMin(TH_GEMM_NC, n) + TH_GEMM_NR));
+  /* one region for the whole product: every thread packs its tiles of A into
+     its own buffer, and the barriers at the end of the worksharing loops keep
+     packedB from being repacked while it is in use */
+#pragma omp parallel if(parallel)
+  {
+    int64_t jc, pc;
+    real *packedA = (real*)THAlloc(sizeof(real) * THMin(TH_GEMM_KC, k) *
+                                   (THMin(TH_GEMM_MC, m) + TH_GEMM_MR));
+    for (jc = 0; jc < n; jc += TH_GEMM_NC) {
+      int64_t nc = THMin(TH_GEMM_NC, n - jc);
+      for (pc = 0; pc < k; pc += TH_GEMM_KC) {
+        int64_t kc = THMin(TH_GEMM_KC, k - pc);
+        int64_t numRowTiles = (m + TH_GEMM_MC - 1) / TH_GEMM_MC;
+        int64_t numColTiles = (nc + TH_GEMM_NT - 1) / TH_GEMM_NT;
+        int64_t tile;
+        THBlas_(gemmPackB)(transb, kc, nc, b, ldb, pc, jc, packedB);
+
+#pragma omp for private(tile)
+        for (tile = 0; tile < numRowTiles * numColTiles; tile++) {
+          int64_t ic = (tile % numRowTiles) * TH_GEMM_MC;
+          int64_t jt = (tile / numRowTiles) * TH_GEMM_NT;
+          int64_t mc = THMin(TH_GEMM_MC, m - ic);
+          int64_t nt = THMin(TH_GEMM_NT, nc - jt);
+          int64_t ir, jr;
+          real acc[TH_GEMM_MR * TH_GEMM_NR];
+          THBlas_(gemmPackA)(transa, mc, kc, a, lda, ic, pc, packedA);
+
+          for (jr = 0; jr < nt; jr += TH_GEMM_NR) {
+            int64_t nr = THMin(TH_GEMM_NR, nt - jr);
+            real *panelB = packedB + (jt + jr) * kc;
+            for (ir = 0; ir < mc; ir += TH_GEMM_MR) {
+              int64_t mr = THMin(TH_GEMM_MR, mc - ir);
+              real *c_ = c + (ic + ir) + (jc + jt + jr)*ldc;
+              int64_t i, jj;
+              THBlas_(gemmKernel)(kc, packedA + ir * kc, panelB, acc);
+              for (jj = 0; jj < nr; jj++)
+                for (i = 0; i < mr; i++)
+                  c_[i + jj*ldc] += alpha * acc[jj*TH_GEMM_MR + i];
+            }
+          }
+        }
+      }
+    }
+    THFree(packedA);
+  }
+  THFree(packedB);
+}
+
 void THBlas_(gemm)(char transa, char transb, int64_t m, int64_t n, int64_t k, real alpha, real *a, int64_t lda, real *b, int64_t ldb, real beta, real *c, int64_t ldc)
 {
   int transa_ = ((transa == 't') || (transa == 'T'));
@@ -347,89 +502,59 @@ void THBlas_(gemm)(char transa, char transb, int64_t m, int64_t n, int64_t k, re
     return;
   }
 #endif
-  {
-    int64_t i, j, l;
-    if(!transa_ && !transb_)
-    {
-      real *a_ = a;
-      for(i = 0; i < m; i++)
-      {
-        real *b_ = b;
-        for(j = 0; j < n; j++)
-        {
-          real sum = 0;
-          for(l = 0; l < k; l++)
-            sum += a_[l*lda]*b_[l];
-          b_ += ldb;
-	  if (beta == 0)
-	    c[j*ldc+i] = alpha*sum;
-	  else
-	    c[j*ldc+i] = beta*c[j*ldc+i]+alpha*sum;
-        }
-        a_++;
-      }
-    }
-    else if(transa_ && !transb_)
-    {
-      real *a_ = a;
-      for(i = 0; i < m; i++)
-      {
-        real *b_ = b;
-        for(j = 0; j < n; j++)
-        {
-          real sum = 0;
-          for(l = 0; l < k; l++)
-            sum += a_[l]*b_[l];
-          b_ += ldb;
-	  if (beta == 0)
-	    c[j*ldc+i] = alpha*sum;
-	  else
-	    c[j*ldc+i] = beta*c[j*ldc+i]+alpha*sum;
-        }
-        a_ += lda;
-      }
-    }
-    else if(!transa_ && transb_)
-    {
-      real *a_ = a;
-      for(i = 0; i < m; i++)
-      {
-        real *b_ = b;
-        for(j = 0; j < n; j++)
-        {
-          real sum = 0;
-          for(l = 0; l < k; l++)
-            sum += a_[l*lda]*b_[l*ldb];
-          b_++;
-	  if (beta == 0)
-	    c[j*ldc+i] = alpha*sum;
-	  else
-	    c[j*ldc+i] = beta*c[j*ldc+i]+alpha*sum;
-        }
-        a_++;
-      }
-    }
-    else
-    {
-      real *a_ = a;
-      for(i = 0; i < m; i++)
-      {
-        real *b_ = b;
-        for(j = 0; j < n; j++)
-        {
-          real sum = 0;
-          for(l = 0; l < k; l++)
-            sum += a_[l]*b_[l*ldb];
-          b_++;
-	  if (beta == 0)
-	    c[j*ldc+i] = alpha*sum;
-	  else
-	    c[j*ldc+i] = beta*c[j*ldc+i]+alpha*sum;
-        }
-        a_ += lda;
-      }
+  THBlas_(gemmBlocked)(transa_, transb_, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+
+#if defined(TH_REAL_IS_CHAR)
+void THBlas_(gemmI32)(char transa, char transb, int64_t m, int64_t n, int64_t k, real *a, int64_t lda, real *b, int64_t ldb, int32_t *c, int64_t ldc)
+{
+  int transa_ = ((transa == 't') || (transa == 'T'));
+  int transb_ = ((transb == 't') || (transb == 'T'));
+  real *rows = a, *cols = b;
+  int64_t ldrows = lda, ldcols = ldb;
+  int64_t i, j, l, tile;
+
+  /* the dot products run over rows of op(a) and columns of op(b), which are
+     contiguous when a is transposed and b is not, otherwise they are packed */
+  if (!transa_) {
+    rows = (real*)THAlloc(sizeof(real) * m * k);
+    ldrows = k;
+    for (i = 0; i < m; i++)
+      for (l = 0; l < k; l++)
+        rows[i*k + l] = a[i + l*lda];
+  }
+  if (transb_) {
+    cols = (real*)THAlloc(sizeof(real) * n * k);
+    ldcols = k;
+    for (j = 0; j < n; j++)
+      for (l = 0; l < k; l++)
+        cols[j*k + l] = b[j + l*ldb];
+  }
+
+  /* tiles of TH_GEMM_MC rows x TH_GEMM_NT columns of c */
+  int64_t numRowTiles = (m + TH_GEMM_MC - 1) / TH_GEMM_MC;
+  int64_t numColTiles = (n + TH_GEMM_NT - 1) / TH_GEMM_NT;
+#pragma omp parallel for if(m * n * k > TH_GEMM_OMP_THRESHOLD) private(tile)
+  for (tile = 0; tile < numRowTiles * numColTiles; tile++) {
+    int64_t i0 = (tile % numRowTiles) * TH_GEMM_MC;
+    int64_t j0 = (tile / numRowTiles) * TH_GEMM_NT;
+    int64_t i1 = THMin(i0 + TH_GEMM_MC, m);
+    int64_t nt = THMin(TH_GEMM_NT, n - j0);
+    int32_t dots[TH_GEMM_NT];
+    int64_t ii, jj;
+    for (ii = i0; ii < i1; ii++) {
+      THVector_(dotI32)(dots, rows + ii*ldrows, cols + j0*ldcols, ldcols, nt, k);
+      for (jj = 0; jj < nt; jj++)
+        c[ii + (j0 + jj)*ldc] = dots[jj];
     }
   }
+
+  if (rows != a)
+    THFree(rows);
+  if (cols != b)
+    THFree(cols);
 }
+#endif
 
 #endif
@@ -16,4 +16,9 @@ TH_API void THBlas_(ger)(int64_t m, int64_t n, real alpha, real *x, int64_t incx
 /* Level 3 */
 TH_API void THBlas_(gemm)(char transa, char transb, int64_t m, int64_t n, int64_t k, real alpha, real *a, int64_t lda, real *b, int64_t ldb, real beta, real *c, int64_t ldc);
 
+#if defined(TH_REAL_IS_CHAR)
+/* c = op(a) * op(b) with 32 bit accumulation, for quantized inference */
+TH_API void THBlas_(gemmI32)(char transa, char transb, int64_t m, int64_t n, int64_t k, real *a, int64_t lda, real *b, int64_t ldb, int32_t *c, int64_t ldc);
+#endif
+
 #endif
@@ -24,7 +24,7 @@ THStorage* THStorage_(new)(void)
 
 THStorage* THStorage_(newWithSize)(ptrdiff_t size)
 {
-  return THStorage_(newWithAllocator)(size, &THDefaultAllocator, NULL);
+  return THStorage_(newWithAllocator)(size, THDefaultStorageAllocator(), NULL);
 }
 
 THStorage* THStorage_(newWithAllocator)(ptrdiff_t size,
@@ -83,14 +83,14 @@ void THTensor_(copy)(THTensor *tensor, THTensor *src)
     THTensor_(copyTranspose)(tensor, src);
 #endif
   } else {
-    TH_TENSOR_APPLY2(real, tensor, real, src, *tensor_data = *src_data;)
+    TH_TENSOR_APPLY2_OMP(real, tensor, real, src, TH_OMP_COST_CHEAP, *tensor_data = *src_data;)
   }
 }
 
 #define IMPLEMENT_THTensor_COPY(TYPENAMESRC, TYPE_SRC) \
 void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src) \
 { \
-  TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, *tensor_data = (real)(*src_data);) \
+  TH_TENSOR_APPLY2_OMP(real, tensor, TYPE_SRC, src, TH_OMP_COST_CHEAP, *tensor_data = (real)(*src_data);) \
 }
 
 #define IMPLEMENT_THTensor_COPY_TO_HALF(TYPENAMESRC, TYPE_SRC) \
@@ -111,6 +111,30 @@ void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src
  TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, *tensor_data = *src_data;) \
 }
 
+#if defined(TH_REAL_IS_FLOAT)
+void THTensor_(copyHalf)(THTensor *tensor, THHalfTensor *src)
+{
+  if (THTensor_(isContiguous)(tensor) && THHalfTensor_isContiguous(src) &&
+      THTensor_(nElement)(tensor) == THHalfTensor_nElement(src)) {
+    THVector_(fromHalf)(THTensor_(data)(tensor), THHalfTensor_data(src), THTensor_(nElement)(tensor));
+  } else {
+    TH_TENSOR_APPLY2(real, tensor, THHalf, src, *tensor_data = TH_half2float(*src_data);)
+  }
+}
+#endif
+
+#if defined(TH_REAL_IS_HALF)
+void THTensor_(copyFloat)(THTensor *tensor, THFloatTensor *src)
+{
+  if (THTensor_(isContiguous)(tensor) && THFloatTensor_isContiguous(src) &&
+      THTensor_(nElement)(tensor) == THFloatTensor_nElement(src)) {
+    THFloatVector_toHalf(THTensor_(data)(tensor), THFloatTensor_data(src), THTensor_(nElement)(tensor));
+  } else {
+    TH_TENSOR_APPLY2(real, tensor, float, src, *tensor_data = TH_float2half(*src_data);)
+  }
+}
+#endif
+
 #ifndef TH_REAL_IS_HALF
 IMPLEMENT_THTensor_COPY(Byte, uint8_t)
 IMPLEMENT_THTensor_COPY(Char, int8_t)
@@ -119,7 +143,9 @@ IMPLEMENT_THTensor_COPY(Int, int32_t)
 IMPLEMENT_THTensor_COPY(Long, int64_t)
 IMPLEMENT_THTensor_COPY(Float, float)
 IMPLEMENT_THTensor_COPY(Double, double)
+#ifndef TH_REAL_IS_FLOAT
 IMPLEMENT_THTensor_COPY_FROM_HALF(Half, THHalf)
+#endif
 #else
 /* only allow pass-through for Half */
 IMPLEMENT_THTensor_COPY_TO_FROM_HALF(Half, THHalf)
@@ -128,7 +154,6 @@ IMPLEMENT_THTensor_COPY_TO_HALF(Char, int8_t)
 IMPLEMENT_THTensor_COPY_TO_HALF(Short, int16_t)
 IMPLEMENT_THTensor_COPY_TO_HALF(Int, int32_t)
 IMPLEMENT_THTensor_COPY_TO_HALF(Long, int64_t)
-IMPLEMENT_THTensor_COPY_TO_HALF(Float, float)
 IMPLEMENT_THTensor_COPY_TO_HALF(Double, double)
 
 #endif /* REAL_IS_HALF */
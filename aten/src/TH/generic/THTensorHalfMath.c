@@ -0,0 +1,278 @@
+#ifndef TH_GENERIC_FILE
+#define TH_GENERIC_FILE "generic/THTensorHalfMath.c"
+#else
+
+#ifndef TH_HALF_MATH_HELPERS
+#define TH_HALF_MATH_HELPERS
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define TH_HALF_BLOCK_SIZE 256
+#define TH_HALF_OMP_THRESHOLD 100000
+
+/* r = op(t, src, value) on float blocks of n elements */
+typedef void (*THHalfMathOp)(float *r, const float *t, const float *src, float value, ptrdiff_t n);
+
+static void THHalfMath_adds(float *r, const float *t, const float *src, float value, ptrdiff_t n) {
+  THFloatVector_adds(r, t, value, n);
+}
+
+static void THHalfMath_muls(float *r, const float *t, const float *src, float value, ptrdiff_t n) {
+  THFloatVector_muls(r, t, value, n);
+}
+
+static void THHalfMath_divs(float *r, const float *t, const float *src, float value, ptrdiff_t n) {
+  THFloatVector_divs(r, t, value, n);
+}
+
+static void THHalfMath_cadd(float *r, const float *t, const float *src, float value, ptrdiff_t n) {
+  THFloatVector_cadd(r, t, src, value, n);
+}
+
+static void THHalfMath_cmul(float *r, const float *t, const float *src, float value, ptrdiff_t n) {
+  THFloatVector_cmul(r, t, src, n);
+}
+
+static void THHalfMath_cdiv(float *r, const float *t, const float *src, float value, ptrdiff_t n) {
+  THFloatVector_cdiv(r, t, src, n);
+}
+
+/* sum of x[i] (times y[i] when y is given) over n contiguous elements */
+static double THHalfMath_sumBlocks(const THHalf *x, const THHalf *y, ptrdiff_t n) {
+  float xbuf[TH_HALF_BLOCK_SIZE], ybuf[TH_HALF_BLOCK_SIZE];
+  double sum = 0;
+  ptrdiff_t b, i;
+  for (b = 0; b < n; b += TH_HALF_BLOCK_SIZE) {
+    ptrdiff_t bn = n - b < TH_HALF_BLOCK_SIZE ? n - b : TH_HALF_BLOCK_SIZE;
+    float bsum = 0;
+    THFloatVector_fromHalf(xbuf, x + b, bn);
+    if (y) {
+      THFloatVector_fromHalf(ybuf, y + b, bn);
+      THFloatVector_cmul(xbuf, xbuf, ybuf, bn);
+    }
+    for (i = 0; i < bn; i++)
+      bsum += xbuf[i];
+    sum += bsum;
+  }
+  return sum;
+}
+
+#endif
+
+/* Returns a contiguous tensor to write the result for r_ into. It has to be
+ * released with THTensor_(releaseResult). */
+static THTensor *THTensor_(newResult)(THTensor *r_)
+{
+  THTensor *rc;
+  if (THTensor_(isContiguous)(r_)) {
+    rc = r_;
+    THTensor_(retain)(rc);
+  } else {
+    rc = THTensor_(new)();
+    THTensor_(resizeAs)(rc, r_);
+  }
+  return rc;
+}
+
+static void THTensor_(releaseResult)(THTensor *rc, THTensor *r_)
+{
+  if (rc != r_) {
+    THTensor_(freeCopyTo)(rc, r_);
+  } else {
+    THTensor_(free)(rc);
+  }
+}
+
+static void THTensor_(pointwise)(THTensor *r_, THTensor *t, THTensor *src, float value, THHalfMathOp op)
+{
+  THTensor *tc, *sc = NULL, *rc;
+  real *rp, *tp, *sp = NULL;
+  ptrdiff_t n, b;
+
+  n = THTensor_(nElement)(t);
+  if (src) {
+    THArgCheck(THTensor_(nElement)(src) == n, 3, "sizes do not match");
+  }
+  THTensor_(resizeAs)(r_, t);
+
+  tc = THTensor_(newContiguous)(t);
+  tp = THTensor_(data)(tc);
+  if (src) {
+    sc = THTensor_(newContiguous)(src);
+    sp = THTensor_(data)(sc);
+  }
+  rc = THTensor_(newResult)(r_);
+  rp = THTensor_(data)(rc);
+
+  #pragma omp parallel for if(n > TH_HALF_OMP_THRESHOLD) private(b)
+  for (b = 0; b < n; b += TH_HALF_BLOCK_SIZE) {
+    float rbuf[TH_HALF_BLOCK_SIZE], tbuf[TH_HALF_BLOCK_SIZE], sbuf[TH_HALF_BLOCK_SIZE];
+    ptrdiff_t bn = n - b < TH_HALF_BLOCK_SIZE ? n - b : TH_HALF_BLOCK_SIZE;
+    THFloatVector_fromHalf(tbuf, tp + b, bn);
+    if (sp) {
+      THFloatVector_fromHalf(sbuf, sp + b, bn);
+    }
+    op(rbuf, tbuf, sbuf, value, bn);
+    THFloatVector_toHalf(rp + b, rbuf, bn);
+  }
+
+  THTensor_(free)(tc);
+  if (sc) {
+    THTensor_(free)(sc);
+  }
+  THTensor_(releaseResult)(rc, r_);
+}
+
+void THTensor_(fill)(THTensor *r_, real value)
+{
+  TH_TENSOR_APPLY(real, r_, *r__data = value;);
+}
+
+void THTensor_(zero)(THTensor *r_)
+{
+  if (THTensor_(isContiguous)(r_)) {
+    memset(THTensor_(data)(r_), 0, THTensor_(nElement)(r_) * sizeof(real));
+  } else {
+    real zero = TH_HALF_BITS_TO_LITERAL(TH_HALF_ZERO);
+    THTensor_(fill)(r_, zero);
+  }
+}
+
+accreal THTensor_(dot)(THTensor *t, THTensor *src)
+{
+  THTensor *tc, *sc;
+  double sum;
+  THArgCheck(THTensor_(nElement)(t) == THTensor_(nElement)(src), 2, "sizes do not match");
+  tc = THTensor_(newContiguous)(t);
+  sc = THTensor_(newContiguous)(src);
+  sum = THHalfMath_sumBlocks(THTensor_(data)(tc), THTensor_(data)(sc), THTensor_(nElement)(tc));
+  THTensor_(free)(tc);
+  THTensor_(free)(sc);
+  return (accreal)sum;
+}
+
+accreal THTensor_(sumall)(THTensor *t)
+{
+  THTensor *tc = THTensor_(newContiguous)(t);
+  real *tp = THTensor_(data)(tc);
+  ptrdiff_t n = THTensor_(nElement)(tc);
+  ptrdiff_t chunk = 64 * TH_HALF_BLOCK_SIZE;
+  ptrdiff_t c;
+  double sum = 0;
+
+  #pragma omp parallel for if(n > TH_HALF_OMP_THRESHOLD) private(c) reduction(+:sum)
+  for (c = 0; c < n; c += chunk) {
+    sum += THHalfMath_sumBlocks(tp + c, NULL, n - c < chunk ? n - c : chunk);
+  }
+
+  THTensor_(free)(tc);
+  return (accreal)sum;
+}
+
+void THTensor_(add)(THTensor *r_, THTensor *t, real value)
+{
+  THTensor_(pointwise)(r_, t, NULL, TH_half2float(value), THHalfMath_adds);
+}
+
+void THTensor_(sub)(THTensor *r_, THTensor *t, real value)
+{
+  THTensor_(pointwise)(r_, t, NULL, -TH_half2float(value), THHalfMath_adds);
+}
+
+void THTensor_(add_scaled)(THTensor *r_, THTensor *t, real value, real alpha)
+{
+  THTensor_(pointwise)(r_, t, NULL, TH_half2float(value) * TH_half2float(alpha), THHalfMath_adds);
+}
+
+void THTensor_(sub_scaled)(THTensor *r_, THTensor *t, real value, real alpha)
+{
+  THTensor_(pointwise)(r_, t, NULL, -TH_half2float(value) * TH_half2float(alpha), THHalfMath_adds);
+}
+
+void THTensor_(mul)(THTensor *r_, THTensor *t, real value)
+{
+  THTensor_(pointwise)(r_, t, NULL, TH_half2float(value), THHalfMath_muls);
+}
+
+void THTensor_(div)(THTensor *r_, THTensor *t, real value)
+{
+  THTensor_(pointwise)(r_, t, NULL, TH_half2float(value), THHalfMath_divs);
+}
+
+void THTensor_(cadd)(THTensor *r_, THTensor *t, real value, THTensor *src)
+{
+  THTensor_(pointwise)(r_, t, src, TH_half2float(value), THHalfMath_cadd);
+}
+
+void THTensor_(csub)(THTensor *r_, THTensor *t, real value, THTensor *src)
+{
+  THTensor_(pointwise)(r_, t, src, -TH_half2float(value), THHalfMath_cadd);
+}
+
+void THTensor_(cmul)(THTensor *r_, THTensor *t, THTensor *src)
+{
+  THTensor_(pointwise)(r_, t, src, 0, THHalfMath_cmul);
+}
+
+void THTensor_(cdiv)(THTensor *r_, THTensor *t, THTensor *src)
+{
+  THTensor_(pointwise)(r_, t, src, 0, THHalfMath_cdiv);
+}
+
+void THTensor_(sum)(THTensor *r_, THTensor *t, int dimension, int keepdim)
+{
+  THLongStorage *dim;
+  THTensor *tc, *rc;
+  real *tp, *rp;
+  int64_t outer = 1, size, inner = 1, o;
+  int d;
+
+  THArgCheck(dimension >= 0 && dimension < THTensor_(nDimension)(t), 2, "dimension %d out of range",
+      dimension + TH_INDEX_BASE);
+
+  dim = THTensor_(newSizeOf)(t);
+  THLongStorage_set(dim, dimension, 1);
+  THTensor_(resize)(r_, dim, NULL);
+  THLongStorage_free(dim);
+
+  for (d = 0; d < dimension; d++)
+    outer *= t->size[d];
+  size = t->size[dimension];
+  for (d = dimension + 1; d < t->nDimension; d++)
+    inner *= t->size[d];
+
+  tc = THTensor_(newContiguous)(t);
+  tp = THTensor_(data)(tc);
+  rc = THTensor_(newResult)(r_);
+  rp = THTensor_(data)(rc);
+
+  #pragma omp parallel for if(outer * size * inner > TH_HALF_OMP_THRESHOLD) private(o)
+  for (o = 0; o < outer; o++) {
+    float acc[TH_HALF_BLOCK_SIZE], buf[TH_HALF_BLOCK_SIZE];
+    int64_t i, k;
+    if (inner == 1) {
+      rp[o] = TH_float2half((float)THHalfMath_sumBlocks(tp + o * size, NULL, size));
+      continue;
+    }
+    for (i = 0; i < inner; i += TH_HALF_BLOCK_SIZE) {
+      ptrdiff_t bn = inner - i < TH_HALF_BLOCK_SIZE ? inner - i : TH_HALF_BLOCK_SIZE;
+      THFloatVector_fill(acc, 0, bn);
+      for (k = 0; k < size; k++) {
+        THFloatVector_fromHalf(buf, tp + (o * size + k) * inner + i, bn);
+        THFloatVector_cadd(acc, acc, buf, 1, bn);
+      }
+      THFloatVector_toHalf(rp + o * inner + i, acc, bn);
+    }
+  }
+
+  THTensor_(free)(tc);
+  THTensor_(releaseResult)(rc, r_);
+
+  if (!keepdim) {
+    THTensor_(squeeze1d)(r_, r_, dimension);
+  }
+}
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef TH_GENERIC_FILE
+#define TH_GENERIC_FILE "generic/THTensorHalfMath.h"
+#else
+
+/* Half precision math on CPU. The operands are converted to float in blocks,
+ * the computation is done in float and the result is rounded back once. */
+
+TH_API void THTensor_(fill)(THTensor *r_, real value);
+TH_API void THTensor_(zero)(THTensor *r_);
+
+TH_API accreal THTensor_(dot)(THTensor *t, THTensor *src);
+TH_API accreal THTensor_(sumall)(THTensor *t);
+
+TH_API void THTensor_(add)(THTensor *r_, THTensor *t, real value);
+TH_API void THTensor_(sub)(THTensor *r_, THTensor *t, real value);
+TH_API void THTensor_(add_scaled)(THTensor *r_, THTensor *t, real value, real alpha);
+TH_API void THTensor_(sub_scaled)(THTensor *r_, THTensor *t, real value, real alpha);
+TH_API void THTensor_(mul)(THTensor *r_, THTensor *t, real value);
+TH_API void THTensor_(div)(THTensor *r_, THTensor *t, real value);
+
+TH_API void THTensor_(cadd)(THTensor *r_, THTensor *t, real value, THTensor *src);
+TH_API void THTensor_(csub)(THTensor *self, THTensor *src1, real value, THTensor *src2);
+TH_API void THTensor_(cmul)(THTensor *r_, THTensor *t, THTensor *src);
+TH_API void THTensor_(cdiv)(THTensor *r_, THTensor *t, THTensor *src);
+
+TH_API void THTensor_(sum)(THTensor *r_, THTensor *t, int dimension, int keepdim);
+
+#endif
@@ -10,8 +10,6 @@
 #include <omp.h>
 #endif
 
-#define TH_OMP_OVERHEAD_THRESHOLD 100000
-
 #ifdef _OPENMP
 
 #ifndef _WIN32
@@ -20,10 +18,10 @@
 #define PRAGMA(P) __pragma(P)
 #endif
 
-#define TH_TENSOR_APPLY_CONTIG(TYPE, TENSOR, CODE) \
+#define TH_TENSOR_APPLY_CONTIG(TYPE, TENSOR, COST, CODE) \
 { \
   ptrdiff_t TH_TENSOR_size = THTensor_(nElement)(TENSOR); \
-  PRAGMA(omp parallel if (TH_TENSOR_size > TH_OMP_OVERHEAD_THRESHOLD)) \
+  PRAGMA(omp parallel if (TH_OMP_WORTHWHILE(TH_TENSOR_size, COST))) \
   { \
     size_t num_threads = omp_get_num_threads(); \
     size_t tid = omp_get_thread_num(); \
@@ -36,7 +34,7 @@
   } \
 }
 #else
-#define TH_TENSOR_APPLY_CONTIG(TYPE, TENSOR, CODE) \
+#define TH_TENSOR_APPLY_CONTIG(TYPE, TENSOR, COST, CODE) \
 { \
   TYPE *TENSOR##_data = THTensor_(data)(TENSOR); \
   ptrdiff_t TENSOR##_len = THTensor_(nElement)(TENSOR); \
@@ -45,10 +43,10 @@
 #endif
 
 #ifdef _OPENMP
-#define TH_TENSOR_APPLY2_CONTIG(TYPE1, TENSOR1, TYPE2, TENSOR2, CODE) \
+#define TH_TENSOR_APPLY2_CONTIG(TYPE1, TENSOR1, TYPE2, TENSOR2, COST, CODE) \
 { \
   ptrdiff_t TH_TENSOR_size = THTensor_(nElement)(TENSOR1); \
-  PRAGMA(omp parallel if (TH_TENSOR_size > TH_OMP_OVERHEAD_THRESHOLD)) \
+  PRAGMA(omp parallel if (TH_OMP_WORTHWHILE(TH_TENSOR_size, COST))) \
   { \
     size_t num_threads = omp_get_num_threads(); \
     size_t tid = omp_get_thread_num(); \
@@ -62,7 +60,7 @@
   } \
 }
 #else
-#define TH_TENSOR_APPLY2_CONTIG(TYPE1, TENSOR1, TYPE2, TENSOR2, CODE) \
+#define TH_TENSOR_APPLY2_CONTIG(TYPE1, TENSOR1, TYPE2, TENSOR2, COST, CODE) \
 { \
   TYPE1 *TENSOR1##_data = THTensor_(data)(TENSOR1); \
   TYPE2 *TENSOR2##_data = THTensor_(data)(TENSOR2); \
@@ -72,10 +70,10 @@
 #endif
 
 #ifdef _OPENMP
-#define TH_TENSOR_APPLY3_CONTIG(TYPE1, TENSOR1, TYPE2, TENSOR2, TYPE3, TENSOR3, CODE) \
+#define TH_TENSOR_APPLY3_CONTIG(TYPE1, TENSOR1, TYPE2, TENSOR2, TYPE3, TENSOR3, COST, CODE) \
 { \
   ptrdiff_t TH_TENSOR_size = THTensor_(nElement)(TENSOR1); \
-  PRAGMA(omp parallel if (TH_TENSOR_size > TH_OMP_OVERHEAD_THRESHOLD)) \
+  PRAGMA(omp parallel if (TH_OMP_WORTHWHILE(TH_TENSOR_size, COST))) \
   { \
     size_t num_threads = omp_get_num_threads(); \
     size_t tid = omp_get_thread_num(); \
@@ -90,7 +88,7 @@
   } \
 }
 #else
-#define TH_TENSOR_APPLY3_CONTIG(TYPE1, TENSOR1, TYPE2, TENSOR2, TYPE3, TENSOR3, CODE) \
+#define TH_TENSOR_APPLY3_CONTIG(TYPE1, TENSOR1, TYPE2, TENSOR2, TYPE3, TENSOR3, COST, CODE) \
 { \
   TYPE1 *TENSOR1##_data = THTensor_(data)(TENSOR1); \
   TYPE2 *TENSOR2##_data = THTensor_(data)(TENSOR2); \
@@ -113,7 +111,7 @@
 void THTensor_(fill)(THTensor *r_, real value)
 {
   if (THTensor_(isContiguous)(r_) || THTensor_(isTransposed)(r_)) {
-    TH_TENSOR_APPLY_CONTIG(real, r_, THVector_(fill)(r__data, value, r__len););
+    TH_TENSOR_APPLY_CONTIG(real, r_, TH_OMP_COST_CHEAP, THVector_(fill)(r__data, value, r__len););
   } else {
     TH_TENSOR_APPLY(real, r_,
       if (r__stride == 1) {
@@ -752,9 +750,9 @@ void THTensor_(add)(THTensor *r_, THTensor *t, real value)
 {
   THTensor_(resizeAs)(r_, t);
   if (THTensor_(isContiguous)(r_) && THTensor_(isContiguous)(t) && THTensor_(nElement)(r_) == THTensor_(nElement)(t)) {
-    TH_TENSOR_APPLY2_CONTIG(real, r_, real, t, THVector_(adds)(r__data, t_data, value, r__len););
+    TH_TENSOR_APPLY2_CONTIG(real, r_, real, t, TH_OMP_COST_CHEAP, THVector_(adds)(r__data, t_data, value, r__len););
   } else {
-    TH_TENSOR_APPLY2(real, r_, real, t, *r__data = *t_data + value;);
+    TH_TENSOR_APPLY2_OMP(real, r_, real, t, TH_OMP_COST_CHEAP, *r__data = *t_data + value;);
   }
 }
 
@@ -777,9 +775,9 @@ void THTensor_(mul)(THTensor *r_, THTensor *t, real value)
 {
   THTensor_(resizeAs)(r_, t);
   if (THTensor_(isContiguous)(r_) && THTensor_(isContiguous)(t) && THTensor_(nElement)(r_) == THTensor_(nElement)(t)) {
-    TH_TENSOR_APPLY2_CONTIG(real, r_, real, t, THVector_(muls)(r__data, t_data, value, r__len););
+    TH_TENSOR_APPLY2_CONTIG(real, r_, real, t, TH_OMP_COST_CHEAP, THVector_(muls)(r__data, t_data, value, r__len););
   } else {
-    TH_TENSOR_APPLY2(real, r_, real, t, *r__data = *t_data * value;);
+    TH_TENSOR_APPLY2_OMP(real, r_, real, t, TH_OMP_COST_CHEAP, *r__data = *t_data * value;);
   }
 }
 
@@ -787,9 +785,9 @@ void THTensor_(div)(THTensor *r_, THTensor *t, real value)
 {
   THTensor_(resizeAs)(r_, t);
   if (THTensor_(isContiguous)(r_) && THTensor_(isContiguous)(t) && THTensor_(nElement)(r_) == THTensor_(nElement)(t)) {
-    TH_TENSOR_APPLY2_CONTIG(real, r_, real, t, THVector_(divs)(r__data, t_data, value, r__len););
+    TH_TENSOR_APPLY2_CONTIG(real, r_, real, t, TH_OMP_COST_MODERATE, THVector_(divs)(r__data, t_data, value, r__len););
   } else {
-    TH_TENSOR_APPLY2(real, r_, real, t, *r__data = *t_data / value;);
+    TH_TENSOR_APPLY2_OMP(real, r_, real, t, TH_OMP_COST_MODERATE, *r__data = *t_data / value;);
   }
 }
 
@@ -872,7 +870,7 @@ void THTensor_(fmod)(THTensor *r_, THTensor *t, real value)
       real *rp = THTensor_(data)(r_);
       ptrdiff_t sz = THTensor_(nElement)(t);
       ptrdiff_t i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+      #pragma omp parallel for if(TH_OMP_WORTHWHILE(sz, TH_OMP_COST_MODERATE)) private(i)
       for (i=0; i<sz; i++) {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
           rp[i] = fmod(tp[i], value);
@@ -882,9 +880,11 @@ void THTensor_(fmod)(THTensor *r_, THTensor *t, real value)
       }
   } else {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
-      TH_TENSOR_APPLY2(real, r_, real, t, *r__data = fmod(*t_data, value););
+      TH_TENSOR_APPLY2_OMP(real, r_, real, t, TH_OMP_COST_MODERATE,
+                           *r__data = fmod(*t_data, value););
 #else
-      TH_TENSOR_APPLY2(real, r_, real, t, *r__data = (*t_data % value););
+      TH_TENSOR_APPLY2_OMP(real, r_, real, t, TH_OMP_COST_MODERATE,
+                           *r__data = (*t_data % value););
 #endif
   }
 }
@@ -897,7 +897,7 @@ void THTensor_(remainder)(THTensor *r_, THTensor *t, real value)
       real *rp = THTensor_(data)(r_);
       ptrdiff_t sz = THTensor_(nElement)(t);
       ptrdiff_t i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+      #pragma omp parallel for if(TH_OMP_WORTHWHILE(sz, TH_OMP_COST_MODERATE)) private(i)
       for (i=0; i<sz; i++) {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
           rp[i] = (value == 0)? NAN : tp[i] - value * floor(tp[i] / value);
@@ -910,11 +910,13 @@ void THTensor_(remainder)(THTensor *r_, THTensor *t, real value)
       }
   } else {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
-      TH_TENSOR_APPLY2(real, r_, real, t, *r__data = (value == 0)? NAN : *t_data - value * floor(*t_data / value););
+      TH_TENSOR_APPLY2_OMP(real, r_, real, t, TH_OMP_COST_MODERATE,
+                           *r__data = (value == 0)? NAN : *t_data - value * floor(*t_data / value););
 #else
        // There is no NAN for integers
-      TH_TENSOR_APPLY2(real, r_, real, t, *r__data = *t_data % value;
-                                          if (*r__data * value < 0) *r__data += value;);
+      TH_TENSOR_APPLY2_OMP(real, r_, real, t, TH_OMP_COST_MODERATE,
+                           *r__data = *t_data % value;
+                           if (*r__data * value < 0) *r__data += value;);
 #endif
   }
 }
@@ -997,11 +999,12 @@ void THTensor_(clamp)(THTensor *r_, THTensor *t, real min_value, real max_value)
     /* real t_val; */
     ptrdiff_t sz = THTensor_(nElement)(t);
     ptrdiff_t i;
-    #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+    #pragma omp parallel for if(TH_OMP_WORTHWHILE(sz, TH_OMP_COST_CHEAP)) private(i)
     for (i=0; i<sz; i++)
       rp[i] = (tp[i] < min_value) ? min_value : (tp[i] > max_value ? max_value : tp[i]);
   } else {
-    TH_TENSOR_APPLY2(real, r_, real, t, *r__data = (*t_data < min_value) ? min_value : (*t_data > max_value ? max_value : *t_data););
+    TH_TENSOR_APPLY2_OMP(real, r_, real, t, TH_OMP_COST_CHEAP,
+                         *r__data = (*t_data < min_value) ? min_value : (*t_data > max_value ? max_value : *t_data););
   }
 }
 
@@ -1012,10 +1015,10 @@ void THTensor_(cadd)(THTensor *r_, THTensor *t, real value, THTensor *src)
     if(r_ == t) {
       THBlas_(axpy)(THTensor_(nElement)(t), value, THTensor_(data)(src), 1, THTensor_(data)(r_), 1);
     } else {
-      TH_TENSOR_APPLY3_CONTIG(real, r_, real, t, real, src, THVector_(cadd)(r__data, t_data, src_data, value, r__len););
+      TH_TENSOR_APPLY3_CONTIG(real, r_, real, t, real, src, TH_OMP_COST_CHEAP, THVector_(cadd)(r__data, t_data, src_data, value, r__len););
     }
   } else {
-    TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = *t_data + value * *src_data;);
+    TH_TENSOR_APPLY3_OMP(real, r_, real, t, real, src, TH_OMP_COST_CHEAP, *r__data = *t_data + value * *src_data;);
   }
 }
 
@@ -1028,9 +1031,9 @@ void THTensor_(cmul)(THTensor *r_, THTensor *t, THTensor *src)
 {
   THTensor_(resizeAs)(r_, t);
   if (THTensor_(isContiguous)(r_) && THTensor_(isContiguous)(t) && THTensor_(isContiguous)(src) && THTensor_(nElement)(r_) == THTensor_(nElement)(src)) {
-    TH_TENSOR_APPLY3_CONTIG(real, r_, real, t, real, src, THVector_(cmul)(r__data, t_data, src_data, r__len););
+    TH_TENSOR_APPLY3_CONTIG(real, r_, real, t, real, src, TH_OMP_COST_CHEAP, THVector_(cmul)(r__data, t_data, src_data, r__len););
   } else {
-    TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = *t_data * *src_data;);
+    TH_TENSOR_APPLY3_OMP(real, r_, real, t, real, src, TH_OMP_COST_CHEAP, *r__data = *t_data * *src_data;);
   }
 }
 
@@ -1043,11 +1046,12 @@ void THTensor_(cpow)(THTensor *r_, THTensor *t, THTensor *src)
     real *rp = THTensor_(data)(r_);
     ptrdiff_t sz = THTensor_(nElement)(t);
     ptrdiff_t i;
-    #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+    #pragma omp parallel for if(TH_OMP_WORTHWHILE(sz, TH_OMP_COST_TRANSCENDENTAL)) private(i)
     for (i=0; i<sz; i++)
       rp[i] = pow(tp[i], sp[i]);
   } else {
-    TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = pow(*t_data, *src_data););
+    TH_TENSOR_APPLY3_OMP(real, r_, real, t, real, src, TH_OMP_COST_TRANSCENDENTAL,
+                         *r__data = pow(*t_data, *src_data););
   }
 }
 
@@ -1055,9 +1059,9 @@ void THTensor_(cdiv)(THTensor *r_, THTensor *t, THTensor *src)
 {
   THTensor_(resizeAs)(r_, t);
   if (THTensor_(isContiguous)(r_) && THTensor_(isContiguous)(t) && THTensor_(isContiguous)(src) && THTensor_(nElement)(r_) == THTensor_(nElement)(src)) {
-    TH_TENSOR_APPLY3_CONTIG(real, r_, real, t, real, src, THVector_(cdiv)(r__data, t_data, src_data, r__len););
+    TH_TENSOR_APPLY3_CONTIG(real, r_, real, t, real, src, TH_OMP_COST_MODERATE, THVector_(cdiv)(r__data, t_data, src_data, r__len););
   } else {
-    TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = *t_data / *src_data;);
+    TH_TENSOR_APPLY3_OMP(real, r_, real, t, real, src, TH_OMP_COST_MODERATE, *r__data = *t_data / *src_data;);
   }
 }
 
@@ -1150,7 +1154,7 @@ void THTensor_(cfmod)(THTensor *r_, THTensor *t, THTensor *src)
       real *rp = THTensor_(data)(r_);
       ptrdiff_t sz = THTensor_(nElement)(t);
       ptrdiff_t i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+      #pragma omp parallel for if(TH_OMP_WORTHWHILE(sz, TH_OMP_COST_MODERATE)) private(i)
       for (i=0; i<sz; i++) {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
           rp[i] = fmod(tp[i], sp[i]);
@@ -1160,9 +1164,11 @@ void THTensor_(cfmod)(THTensor *r_, THTensor *t, THTensor *src)
       }
   } else {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
-      TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = fmod(*t_data, *src_data););
+      TH_TENSOR_APPLY3_OMP(real, r_, real, t, real, src, TH_OMP_COST_MODERATE,
+                           *r__data = fmod(*t_data, *src_data););
 #else
-      TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = (*t_data % *src_data););
+      TH_TENSOR_APPLY3_OMP(real, r_, real, t, real, src, TH_OMP_COST_MODERATE,
+                           *r__data = (*t_data % *src_data););
 #endif
 
   }
@@ -1177,7 +1183,7 @@ void THTensor_(cremainder)(THTensor *r_, THTensor *t, THTensor *src)
       real *rp = THTensor_(data)(r_);
       ptrdiff_t sz = THTensor_(nElement)(t);
       ptrdiff_t i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+      #pragma omp parallel for if(TH_OMP_WORTHWHILE(sz, TH_OMP_COST_MODERATE)) private(i)
       for (i=0; i<sz; i++) {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
           rp[i] = (sp[i] == 0)? NAN : tp[i] - sp[i] * floor(tp[i] / sp[i]);
@@ -1190,11 +1196,13 @@ void THTensor_(cremainder)(THTensor *r_, THTensor *t, THTensor *src)
       }
   } else {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
-      TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = (*src_data == 0)? NAN : *t_data - *src_data * floor(*t_data / *src_data););
+      TH_TENSOR_APPLY3_OMP(real, r_, real, t, real, src, TH_OMP_COST_MODERATE,
+                           *r__data = (*src_data == 0)? NAN : *t_data - *src_data * floor(*t_data / *src_data););
 #else
       // There is no NAN for integers
-      TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = *t_data % *src_data;
-                                                     if (*r__data * *src_data < 0) *r__data += *src_data;);
+      TH_TENSOR_APPLY3_OMP(real, r_, real, t, real, src, TH_OMP_COST_MODERATE,
+                           *r__data = *t_data % *src_data;
+                           if (*r__data * *src_data < 0) *r__data += *src_data;);
 #endif
 
   }
@@ -1283,11 +1291,12 @@ void THTensor_(tpow)(THTensor *r_, real value, THTensor *t)
     real *rp = THTensor_(data)(r_);
     ptrdiff_t sz = THTensor_(nElement)(t);
     ptrdiff_t i;
-    #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+    #pragma omp parallel for if(TH_OMP_WORTHWHILE(sz, TH_OMP_COST_TRANSCENDENTAL)) private(i)
     for (i=0; i<sz; i++)
       rp[i] = pow(value, tp[i]);
   } else {
-    TH_TENSOR_APPLY2(real, r_, real, t, *r__data = pow(value, *t_data););
+    TH_TENSOR_APPLY2_OMP(real, r_, real, t, TH_OMP_COST_TRANSCENDENTAL,
+                         *r__data = pow(value, *t_data););
   }
 }
 
@@ -1299,7 +1308,8 @@ void THTensor_(addcmul)(THTensor *r_, THTensor *t, real value, THTensor *src1, T
     THTensor_(copy)(r_, t);
   }
 
-  TH_TENSOR_APPLY3(real, r_, real, src1, real, src2, *r__data += value * *src1_data * *src2_data;);
+  TH_TENSOR_APPLY3_OMP(real, r_, real, src1, real, src2, TH_OMP_COST_CHEAP,
+                       *r__data += value * *src1_data * *src2_data;);
 }
 
 
@@ -1311,7 +1321,8 @@ void THTensor_(addcdiv)(THTensor *r_, THTensor *t, real value, THTensor *src1, T
     THTensor_(copy)(r_, t);
   }
 
-  TH_TENSOR_APPLY3(real, r_, real, src1, real, src2, *r__data += value * *src1_data / *src2_data;);
+  TH_TENSOR_APPLY3_OMP(real, r_, real, src1, real, src2, TH_OMP_COST_MODERATE,
+                       *r__data += value * *src1_data / *src2_data;);
 }
 
 void THTensor_(addmv)(THTensor *r_, real beta, THTensor *t, real alpha, THTensor *mat, THTensor *vec)
@@ -1708,6 +1719,68 @@ ptrdiff_t THTensor_(numel)(THTensor *t)
   return THTensor_(nElement)(t);
 }
 
+// Reducers for TH_TENSOR_DIM_REDUCE. The arg ones keep the first index of
+// the extremum, or of the first NaN. They start from the lowest (highest)
+// value at index 0, which only survives if every element equals it, in
+// which case 0 is the right index.
+typedef struct THTensor_(ArgExtremum)
+{
+  real value;
+  int64_t index;
+} THTensor_(ArgExtremum);
+
+#undef TH_REAL_LOWEST
+#undef TH_REAL_HIGHEST
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+#define TH_REAL_LOWEST (-INFINITY)
+#define TH_REAL_HIGHEST INFINITY
+#elif defined(TH_REAL_IS_BYTE)
+#define TH_REAL_LOWEST 0
+#define TH_REAL_HIGHEST UINT8_MAX
+#elif defined(TH_REAL_IS_CHAR)
+#define TH_REAL_LOWEST INT8_MIN
+#define TH_REAL_HIGHEST INT8_MAX
+#elif defined(TH_REAL_IS_SHORT)
+#define TH_REAL_LOWEST INT16_MIN
+#define TH_REAL_HIGHEST INT16_MAX
+#elif defined(TH_REAL_IS_INT)
+#define TH_REAL_LOWEST INT32_MIN
+#define TH_REAL_HIGHEST INT32_MAX
+#else
+#define TH_REAL_LOWEST INT64_MIN
+#define TH_REAL_HIGHEST INT64_MAX
+#endif
+
+#define TH_ARGMAX_INIT(s) (s).value = TH_REAL_LOWEST; (s).index = 0
+#define TH_ARGMIN_INIT(s) (s).value = TH_REAL_HIGHEST; (s).index = 0
+#define TH_ARG_BETTER(b, a, OP) \
+  (th_isnan((b).value) ? (!th_isnan((a).value) || (b).index < (a).index) \
+                       : (!th_isnan((a).value) && \
+                          ((b).value OP (a).value || ((b).value == (a).value && (b).index < (a).index))))
+#define TH_ARGMAX_UPDATE(s, x, k) \
+  { \
+    int take = !((x) <= (s).value) & !th_isnan((s).value); \
+    (s).value = take ? (x) : (s).value; \
+    (s).index = take ? (k) : (s).index; \
+  }
+#define TH_ARGMIN_UPDATE(s, x, k) \
+  { \
+    int take = !((x) >= (s).value) & !th_isnan((s).value); \
+    (s).value = take ? (x) : (s).value; \
+    (s).index = take ? (k) : (s).index; \
+  }
+#define TH_ARGMAX_MERGE(a, b) if (TH_ARG_BETTER(b, a, >)) (a) = (b);
+#define TH_ARGMIN_MERGE(a, b) if (TH_ARG_BETTER(b, a, <)) (a) = (b);
+#define TH_ARG_STORE(s, v, ix) (v) = (s).value; (ix) = (s).index
+
+#define TH_ACC_ZERO(s) (s) = 0
+#define TH_ACC_ONE(s) (s) = 1
+#define TH_ACC_ADD(s, x, k) (s) += (x)
+#define TH_ACC_MUL(s, x, k) (s) *= (x)
+#define TH_ACC_MERGE_ADD(a, b) (a) += (b)
+#define TH_ACC_MERGE_MUL(a, b) (a) *= (b)
+#define TH_ACC_STORE(s, v, ix) (v) = (real)(s)
+
 void THTensor_(max)(THTensor *values_, THLongTensor *indices_, THTensor *t, int dimension, int keepdim)
 {
   THLongStorage *dim;
@@ -1721,67 +1794,8 @@ void THTensor_(max)(THTensor *values_, THLongTensor *indices_, THTensor *t, int
   THLongTensor_resize(indices_, dim, NULL);
   THLongStorage_free(dim);
 
-  // two implementations optimized for data locality
-  if (t->stride[dimension] == 1) {
-    real theMax;
-    real value;
-    int64_t theIndex;
-    int64_t i;
-    TH_TENSOR_DIM_APPLY3(real, t, real, values_, int64_t, indices_, dimension,
-                         TH_TENSOR_DIM_APPLY3_SIZE_EQ_EXCEPT_DIM,
-                         theMax = t_data[0];
-                         theIndex = 0;
-
-                         for(i = 0; i < t_size; i++)
-                         {
-                           value = t_data[i*t_stride];
-                           /* This is not the same as value>theMax in the case of NaNs */
-                           if(!(value <= theMax))
-                           {
-                             theIndex = i;
-                             theMax = value;
-                             th_isnan_break(value)
-                           }
-                         }
-                         *indices__data = theIndex;
-                         *values__data = theMax;);
-  } else {
-    if (THTensor_(nDimension)(t) > 1) {
-      THTensor *t0 = THTensor_(newSelect)(t, dimension, 0);
-      THTensor_(copy)(values_, t0);
-      THTensor_(free)(t0);
-    } else {
-      THTensor_(fill)(values_, THTensor_(get1d)(t, 0));
-    }
-    THLongTensor_zero(indices_);
-
-    if(t->size[dimension] == 1) {
-      if (!keepdim) {
-        THTensor_(squeeze1d)(values_, values_, dimension);
-        THLongTensor_squeeze1d(indices_, indices_, dimension);
-      }
-      return;
-    }
-
-    THTensor *tempValues_ = THTensor_(newWithTensor)(values_);
-    // tempValues_.expand_as(t)
-    tempValues_->size[dimension] = t->size[dimension];
-    tempValues_->stride[dimension] = 0;
-
-    THLongTensor *tempIndices_ = THLongTensor_newWithTensor(indices_);
-    // tempIndices_.expand_as(t)
-    tempIndices_->size[dimension] = t->size[dimension];
-    tempIndices_->stride[dimension] = 0;
-
-    TH_TENSOR_APPLY3_D(real, t, real, tempValues_, int64_t, tempIndices_, dimension,
-                          if(!(*t_data <= *tempValues__data) && !th_isnan(*tempValues__data)) {
-                            *tempValues__data = *t_data;
-                            *tempIndices__data = *tempIndices__dimOffset;
-                          });
-
-    THTensor_(free)(tempValues_);
-    THLongTensor_free(tempIndices_);
-  }
+  TH_TENSOR_DIM_REDUCE(real, t, dimension, values_, indices_, THTensor_(ArgExtremum), TH_OMP_COST_CHEAP,
+                       TH_ARGMAX_INIT, TH_ARGMAX_UPDATE, TH_ARGMAX_MERGE, TH_ARG_STORE);
 
   if (!keepdim) {
     THTensor_(squeeze1d)(values_, values_, dimension);
@@ -1802,67 +1816,8 @@ void THTensor_(min)(THTensor *values_, THLongTensor *indices_, THTensor *t, int
   THLongTensor_resize(indices_, dim, NULL);
   THLongStorage_free(dim);
 
-  // two implementations optimized for data locality
-  if (t->stride[dimension] == 1) {
-    real theMax;
-    real value;
-    int64_t theIndex;
-    int64_t i;
-    TH_TENSOR_DIM_APPLY3(real, t, real, values_, int64_t, indices_, dimension,
-                         TH_TENSOR_DIM_APPLY3_SIZE_EQ_EXCEPT_DIM,
-                         theMax = t_data[0];
-                         theIndex = 0;
-
-                         for(i = 0; i < t_size; i++)
-                         {
-                           value = t_data[i*t_stride];
-                           /* This is not the same as value>theMax in the case of NaNs */
-                           if(!(value >= theMax))
-                           {
-                             theIndex = i;
-                             theMax = value;
-                             th_isnan_break(value)
-                           }
-                         }
-                         *indices__data = theIndex;
-                         *values__data = theMax;);
-  } else {
-    if (THTensor_(nDimension)(t) > 1) {
-      THTensor *t0 = THTensor_(newSelect)(t, dimension, 0);
-      THTensor_(copy)(values_, t0);
-      THTensor_(free)(t0);
-    } else {
-      THTensor_(fill)(values_, THTensor_(get1d)(t, 0));
-    }
-    THLongTensor_zero(indices_);
-
-    if(t->size[dimension] == 1) {
-      if (!keepdim) {
-        THTensor_(squeeze1d)(values_, values_, dimension);
-        THLongTensor_squeeze1d(indices_, indices_, dimension);
-      }
-      return;
-    }
-
-    THTensor *tempValues_ = THTensor_(newWithTensor)(values_);
-    // tempValues_.expand_as(t)
-    tempValues_->size[dimension] = t->size[dimension];
-    tempValues_->stride[dimension] = 0;
-
-    THLongTensor *tempIndices_ = THLongTensor_newWithTensor(indices_);
-    // tempIndices_.expand_as(t)
-    tempIndices_->size[dimension] = t->size[dimension];
-    tempIndices_->stride[dimension] = 0;
-
-    TH_TENSOR_APPLY3_D(real, t, real, tempValues_, int64_t, tempIndices_, dimension,
-                          if(!(*t_data >= *tempValues__data) && !th_isnan(*tempValues__data)) {
-                            *tempValues__data = *t_data;
-                            *tempIndices__data = *tempIndices__dimOffset;
-                          });
-
-    THTensor_(free)(tempValues_);
-    THLongTensor_free(tempIndices_);
-  }
+  TH_TENSOR_DIM_REDUCE(real, t, dimension, values_, indices_, THTensor_(ArgExtremum), TH_OMP_COST_CHEAP,
+                       TH_ARGMIN_INIT, TH_ARGMIN_UPDATE, TH_ARGMIN_MERGE, TH_ARG_STORE);
 
   if (!keepdim) {
     THTensor_(squeeze1d)(values_, values_, dimension);
@@ -1883,24 +1838,8 @@ void THTensor_(sum)(THTensor *r_, THTensor *t, int dimension, int keepdim)
   THTensor_(resize)(r_, dim, NULL);
   THLongStorage_free(dim);
 
-  // two implementations optimized for data locality
-  if (t->stride[dimension] == 1) {
-    TH_TENSOR_DIM_APPLY2(real, t, real, r_, dimension,
-                         accreal sum = 0;
-                         int64_t i;
-                         for(i = 0; i < t_size; i++)
-                           sum += t_data[i*t_stride];
-                         *r__data = (real)sum;);
-  } else {
-    THTensor_(zero)(r_);
-    THTensor *temp_ = THTensor_(newWithTensor)(r_);
-    // r_.expand_as(t)
-    temp_->size[dimension] = t->size[dimension];
-    temp_->stride[dimension] = 0;
-
-    TH_TENSOR_APPLY2(real, temp_, real, t, *temp__data = *temp__data + *t_data;);
-    THTensor_(free)(temp_);
-  }
+  TH_TENSOR_DIM_REDUCE(real, t, dimension, r_, NULL, accreal, TH_OMP_COST_CHEAP,
+                       TH_ACC_ZERO, TH_ACC_ADD, TH_ACC_MERGE_ADD, TH_ACC_STORE);
 
   if (!keepdim) {
     THTensor_(squeeze1d)(r_, r_, dimension);
@@ -1919,24 +1858,8 @@ void THTensor_(prod)(THTensor *r_, THTensor *t, int dimension, int keepdim)
   THTensor_(resize)(r_, dim, NULL);
   THLongStorage_free(dim);
 
-  // two implementations optimized for data locality
-  if (t->stride[dimension] == 1) {
-    TH_TENSOR_DIM_APPLY2(real, t, real, r_, dimension,
-                         accreal prod = 1;
-                         int64_t i;
-                         for(i = 0; i < t_size; i++)
-                           prod *= t_data[i*t_stride];
-                         *r__data = (real)prod;);
-  } else {
-    THTensor_(fill)(r_, 1);
-    THTensor *temp_ = THTensor_(newWithTensor)(r_);
-    // r_.expand_as(t)
-    temp_->size[dimension] = t->size[dimension];
-    temp_->stride[dimension] = 0;
-
-    TH_TENSOR_APPLY2(real, temp_, real, t, *temp__data = *temp__data * *t_data;);
-    THTensor_(free)(temp_);
-  }
+  TH_TENSOR_DIM_REDUCE(real, t, dimension, r_, NULL, accreal, TH_OMP_COST_CHEAP,
+                       TH_ACC_ONE, TH_ACC_MUL, TH_ACC_MERGE_MUL, TH_ACC_STORE);
 
   if (!keepdim) {
     THTensor_(squeeze1d)(r_, r_, dimension);
@@ -2451,8 +2374,122 @@ static void THTensor_(quicksortdescend)(real *arr, int64_t *idx, int64_t element
 #undef MAX_LEVELS
 #undef M_SMALL
 
+#ifndef TH_SORT_HELPERS
+#define TH_SORT_HELPERS
+/* Sorting and selection cost O(n log n) or several passes over each
+   element, so they are worth parallelizing for smaller tensors than
+   element-wise operations. */
+#define TH_OMP_SORT_THRESHOLD (TH_OMP_OVERHEAD_THRESHOLD / 10)
+/* topk uses a heap of the k best elements when k is at most this and at most
+   1/8 of the slice size, otherwise quickselect. */
+#define TH_TOPK_HEAP_MAX_K 1024
+#ifdef _OPENMP
+#define TH_OMP_MAX_THREADS omp_get_max_threads()
+#define TH_OMP_THREAD_NUM omp_get_thread_num()
+#else
+#define TH_OMP_MAX_THREADS 1
+#define TH_OMP_THREAD_NUM 0
+#endif
+#endif
+
+/* Offset of the slice'th one dimensional slice along dimension, with slices
+   enumerated in the same order as in TH_TENSOR_DIM_APPLY. */
+static ptrdiff_t THTensor_(sliceOffset)(int64_t *size, int64_t *stride, int nDimension,
+                                        int dimension, ptrdiff_t slice)
+{
+  ptrdiff_t offset = 0;
+  int d;
+  for (d = nDimension - 1; d >= 0; d--) {
+    if (d == dimension)
+      continue;
+    offset += (slice % size[d]) * stride[d];
+    slice /= size[d];
+  }
+  return offset;
+}
+
+/* Sorts a contiguous array with its indices: chunks are sorted concurrently
+   with quicksort, then merged pairwise in parallel until one run is left. */
+static void THTensor_(parallelSort)(real *arr, int64_t *idx, int64_t elements, int descendingOrder)
+{
+  int64_t num_chunks = TH_OMP_MAX_THREADS;
+  int64_t chunk, width, c;
+  real *arr_src = arr, *arr_dst, *arr_swap;
+  int64_t *idx_src = idx, *idx_dst, *idx_swap;
+
+  if (num_chunks > elements)
+    num_chunks = elements;
+  if (num_chunks <= 1) {
+    if (descendingOrder)
+      THTensor_(quicksortdescend)(arr, idx, elements, 1);
+    else
+      THTensor_(quicksortascend)(arr, idx, elements, 1);
+    return;
+  }
+
+  chunk = (elements + num_chunks - 1) / num_chunks;
+  #pragma omp parallel for private(c)
+  for (c = 0; c < num_chunks; c++) {
+    int64_t begin = c * chunk;
+    int64_t len = begin + chunk < elements ? chunk : elements - begin;
+    if (len <= 0)
+      continue;
+    if (descendingOrder)
+      THTensor_(quicksortdescend)(arr + begin, idx + begin, len, 1);
+    else
+      THTensor_(quicksortascend)(arr + begin, idx + begin, len, 1);
+  }
+
+  arr_dst = (real*)THAlloc(sizeof(real) * elements);
+  idx_dst = (int64_t*)THAlloc(sizeof(int64_t) * elements);
+  for (width = chunk; width < elements; width *= 2) {
+    int64_t num_pairs = (elements + 2 * width - 1) / (2 * width);
+    #pragma omp parallel for private(c)
+    for (c = 0; c < num_pairs; c++) {
+      int64_t lo = c * 2 * width;
+      int64_t mid = lo + width < elements ? lo + width : elements;
+      int64_t hi = lo + 2 * width < elements ? lo + 2 * width : elements;
+      int64_t i = lo, j = mid, o = lo;
+      while (i < mid && j < hi) {
+        /* ties are taken from the left run */
+        int right = descendingOrder ? arr_src[j] > arr_src[i] : arr_src[j] < arr_src[i];
+        if (right) {
+          arr_dst[o] = arr_src[j];
+          idx_dst[o++] = idx_src[j++];
+        } else {
+          arr_dst[o] = arr_src[i];
+          idx_dst[o++] = idx_src[i++];
+        }
+      }
+      for (; i < mid; i++, o++) {
+        arr_dst[o] = arr_src[i];
+        idx_dst[o] = idx_src[i];
+      }
+      for (; j < hi; j++, o++) {
+        arr_dst[o] = arr_src[j];
+        idx_dst[o] = idx_src[j];
+      }
+    }
+    arr_swap = arr_src; arr_src = arr_dst; arr_dst = arr_swap;
+    idx_swap = idx_src; idx_src = idx_dst; idx_dst = idx_swap;
+  }
+  if (arr_src != arr) {
+    memcpy(arr, arr_src, sizeof(real) * elements);
+    memcpy(idx, idx_src, sizeof(int64_t) * elements);
+    arr_dst = arr_src;
+    idx_dst = idx_src;
+  }
+  THFree(arr_dst);
+  THFree(idx_dst);
+}
+
 void THTensor_(sort)(THTensor *rt_, THLongTensor *ri_, THTensor *t, int dimension, int descendingOrder)
 {
+  ptrdiff_t slice, numSlices;
+  int64_t sliceSize;
+  real *rt__data;
+  int64_t *ri__data;
+
   THArgCheck(dimension >= 0 && dimension < THTensor_(nDimension)(t), 2, "invalid dimension %d",
       dimension + TH_INDEX_BASE);
 
@@ -2465,22 +2502,48 @@ void THTensor_(sort)(THTensor *rt_, THLongTensor *ri_, THTensor *t, int dimensio
     THLongStorage_free(size);
   }
 
-  if(descendingOrder)
-  {
-    TH_TENSOR_DIM_APPLY2(real, rt_, int64_t, ri_, dimension,
-                         int64_t i;
-                         for(i = 0; i < ri__size; i++)
-                           ri__data[i*ri__stride] = i;
-                         THTensor_(quicksortdescend)(rt__data, ri__data, rt__size, rt__stride);)
+  sliceSize = THTensor_(size)(t, dimension);
+  if (sliceSize == 0)
+    return;
+  numSlices = THTensor_(nElement)(t) / sliceSize;
+  rt__data = THTensor_(data)(rt_);
+  ri__data = THLongTensor_data(ri_);
+
+  if (numSlices < TH_OMP_MAX_THREADS && sliceSize > TH_OMP_SORT_THRESHOLD) {
+    /* few huge slices: sort each of them in parallel */
+    real *values = (real*)THAlloc(sizeof(real) * sliceSize);
+    int64_t *indices = (int64_t*)THAlloc(sizeof(int64_t) * sliceSize);
+    for (slice = 0; slice < numSlices; slice++) {
+      real *rt_slice = rt__data + THTensor_(sliceOffset)(rt_->size, rt_->stride, rt_->nDimension, dimension, slice);
+      int64_t *ri_slice = ri__data + THTensor_(sliceOffset)(ri_->size, ri_->stride, ri_->nDimension, dimension, slice);
+      int64_t rt__stride = rt_->stride[dimension], ri__stride = ri_->stride[dimension], i;
+      for (i = 0; i < sliceSize; i++) {
+        values[i] = rt_slice[i*rt__stride];
+        indices[i] = i;
       }
-  else
-  {
-    TH_TENSOR_DIM_APPLY2(real, rt_, int64_t, ri_, dimension,
-                         int64_t i;
-                         for(i = 0; i < ri__size; i++)
-                           ri__data[i*ri__stride] = i;
-                         THTensor_(quicksortascend)(rt__data, ri__data, rt__size, rt__stride);)
+      THTensor_(parallelSort)(values, indices, sliceSize, descendingOrder);
+      for (i = 0; i < sliceSize; i++) {
+        rt_slice[i*rt__stride] = values[i];
+        ri_slice[i*ri__stride] = indices[i];
       }
+    }
+    THFree(values);
+    THFree(indices);
+    return;
+  }
+
+  #pragma omp parallel for if(numSlices > 1 && numSlices * sliceSize > TH_OMP_SORT_THRESHOLD) private(slice)
+  for (slice = 0; slice < numSlices; slice++) {
+    real *rt_slice = rt__data + THTensor_(sliceOffset)(rt_->size, rt_->stride, rt_->nDimension, dimension, slice);
+    int64_t *ri_slice = ri__data + THTensor_(sliceOffset)(ri_->size, ri_->stride, ri_->nDimension, dimension, slice);
+    int64_t rt__stride = rt_->stride[dimension], ri__stride = ri_->stride[dimension], i;
+    for (i = 0; i < sliceSize; i++)
+      ri_slice[i*ri__stride] = i;
+    if (descendingOrder)
+      THTensor_(quicksortdescend)(rt_slice, ri_slice, sliceSize, rt__stride);
+    else
+      THTensor_(quicksortascend)(rt_slice, ri_slice, sliceSize, rt__stride);
+  }
 }
 
 /* Implementation of the Quickselect algorithm, based on Nicolas Devillard's
@@ -2651,11 +2714,11 @@ void THTensor_(mode)(THTensor *values_, THLongTensor *indices_, THTensor *t, int
 void THTensor_(kthvalue)(THTensor *values_, THLongTensor *indices_, THTensor *t, int64_t k, int dimension, int keepdim)
 {
   THLongStorage *dim;
-  THTensor *temp_;
-  THLongTensor *tempi_;
-  real *temp__data;
-  int64_t *tempi__data;
+  real *temp__data, *t_data, *values__data;
+  int64_t *tempi__data, *indices__data;
   int64_t t_size_dim;
+  ptrdiff_t slice, numSlices;
+  int parallel, numBuffers;
 
   THArgCheck(dimension >= 0 && dimension < THTensor_(nDimension)(t), 3, "dimension out of range");
   THArgCheck(k > 0 && k <= t->size[dimension], 2, "selected index out of range");
@@ -2667,28 +2730,35 @@ void THTensor_(kthvalue)(THTensor *values_, THLongTensor *indices_, THTensor *t,
   THLongStorage_free(dim);
 
   t_size_dim = THTensor_(size)(t, dimension);
+  numSlices = THTensor_(nElement)(t) / t_size_dim;
+
+  /* slices are processed in parallel, with one buffer per thread and no more
+     threads than slices */
+  parallel = numSlices > 1 && numSlices * t_size_dim > TH_OMP_SORT_THRESHOLD;
+  numBuffers = parallel ? (numSlices < TH_OMP_MAX_THREADS ? (int)numSlices : TH_OMP_MAX_THREADS) : 1;
+  temp__data = (real*)THAlloc(sizeof(real) * t_size_dim * numBuffers);
+  tempi__data = (int64_t*)THAlloc(sizeof(int64_t) * t_size_dim * numBuffers);
+  t_data = THTensor_(data)(t);
+  values__data = THTensor_(data)(values_);
+  indices__data = THLongTensor_data(indices_);
+
+  #pragma omp parallel for if(parallel) num_threads(numBuffers) private(slice)
+  for (slice = 0; slice < numSlices; slice++) {
+    real *temp = temp__data + t_size_dim * TH_OMP_THREAD_NUM;
+    int64_t *tempi = tempi__data + t_size_dim * TH_OMP_THREAD_NUM;
+    real *t_slice = t_data + THTensor_(sliceOffset)(t->size, t->stride, t->nDimension, dimension, slice);
+    int64_t t_stride = t->stride[dimension], i;
+    for (i = 0; i < t_size_dim; i++) {
+      temp[i] = t_slice[i*t_stride];
+      tempi[i] = i;
+    }
+    THTensor_(quickselect)(temp, tempi, k - 1, t_size_dim, 1);
+    values__data[THTensor_(sliceOffset)(values_->size, values_->stride, values_->nDimension, dimension, slice)] = temp[k-1];
+    indices__data[THTensor_(sliceOffset)(indices_->size, indices_->stride, indices_->nDimension, dimension, slice)] = tempi[k-1];
+  }
 
-  temp_ = THTensor_(new)();
-  THTensor_(resize1d)(temp_, t_size_dim);
-  temp__data = THTensor_(data)(temp_);
-
-  tempi_ = THLongTensor_new();
-  THLongTensor_resize1d(tempi_, t_size_dim);
-  tempi__data = THLongTensor_data(tempi_);
-
-  TH_TENSOR_DIM_APPLY3(real, t, real, values_, int64_t, indices_, dimension,
-                       TH_TENSOR_DIM_APPLY3_SIZE_EQ_EXCEPT_DIM,
-                       int64_t i;
-                       for(i = 0; i < t_size_dim; i++)
-                          temp__data[i] = t_data[i*t_stride];
-                       for(i = 0; i < t_size_dim; i++)
-                          tempi__data[i] = i;
-                       THTensor_(quickselect)(temp__data, tempi__data, k - 1, t_size_dim, 1);
-                       *values__data = temp__data[k-1];
-                       *indices__data = tempi__data[k-1];);
-
-  THTensor_(free)(temp_);
-  THLongTensor_free(tempi_);
+  THFree(temp__data);
+  THFree(tempi__data);
   if (!keepdim) {
     THTensor_(squeeze1d)(values_, values_, dimension);
     THLongTensor_squeeze1d(indices_, indices_, dimension);
@@ -2707,6 +2777,76 @@ void THTensor_(median)(THTensor *values_, THLongTensor *indices_, THTensor *t, i
   THTensor_(kthvalue)(values_, indices_, t, k+1, dimension, keepdim);
 }
 
+/* Restores the heap property below pos in a heap whose root is the worst of
+   its elements, i.e. the smallest one when looking for the largest elements
+   (dir != 0) and the largest one otherwise. */
+static void THTensor_(topkSiftDown)(real *vals, int64_t *inds, int64_t size, int64_t pos, int dir)
+{
+  real v = vals[pos];
+  int64_t ind = inds[pos];
+  while (1) {
+    int64_t child = 2 * pos + 1;
+    if (child >= size)
+      break;
+    if (child + 1 < size && (dir ? vals[child + 1] < vals[child] : vals[child + 1] > vals[child]))
+      child++;
+    if (!(dir ? vals[child] < v : vals[child] > v))
+      break;
+    vals[pos] = vals[child];
+    inds[pos] = inds[child];
+    pos = child;
+  }
+  vals[pos] = v;
+  inds[pos] = ind;
+}
+
+/* Collects the k best of elements [begin, end) of a strided array into a
+   heap whose root is the worst of them, so that most elements are rejected
+   with a single comparison. Indices are taken from src_inds if given.
+   Returns the number of elements in the heap. */
+static int64_t THTensor_(topkHeapSelect)(real *data, int64_t stride, const int64_t *src_inds,
+                                         int64_t begin, int64_t end, int64_t k, int dir,
+                                         real *vals, int64_t *inds)
+{
+  int64_t n = 0, i, j;
+  for (i = begin; i < end; i++) {
+    real v = data[i*stride];
+    if (n < k) {
+      vals[n] = v;
+      inds[n] = src_inds ? src_inds[i] : i;
+      n++;
+      if (n == k) {
+        for (j = k / 2 - 1; j >= 0; j--)
+          THTensor_(topkSiftDown)(vals, inds, k, j, dir);
+      }
+    } else if (dir ? v > vals[0] : v < vals[0]) {
+      vals[0] = v;
+      inds[0] = src_inds ? src_inds[i] : i;
+      THTensor_(topkSiftDown)(vals, inds, k, 0, dir);
+    }
+  }
+  if (n < k) {
+    for (j = n / 2 - 1; j >= 0; j--)
+      THTensor_(topkSiftDown)(vals, inds, n, j, dir);
+  }
+  return n;
+}
+
+/* Heap sort, leaves the best element first. */
+static void THTensor_(topkHeapSort)(real *vals, int64_t *inds, int64_t n, int dir)
+{
+  int64_t i;
+  for (i = n - 1; i > 0; i--) {
+    real v = vals[0];
+    int64_t ind = inds[0];
+    vals[0] = vals[i];
+    inds[0] = inds[i];
+    vals[i] = v;
+    inds[i] = ind;
+    THTensor_(topkSiftDown)(vals, inds, i, 0, dir);
+  }
+}
+
 void THTensor_(topk)(THTensor *rt_, THLongTensor *ri_, THTensor *t, int64_t k, int dim, int dir, int sorted)
 {
   int numDims = THTensor_(nDimension)(t);
@@ -2715,63 +2855,116 @@ void THTensor_(topk)(THTensor *rt_, THLongTensor *ri_, THTensor *t, int64_t k, i
   int64_t sliceSize = THTensor_(size)(t, dim);
   THArgCheck(k > 0 && k <= sliceSize, 2, "k not in range for dimension");
 
-  THTensor *tmpResults = THTensor_(new)();
-  THTensor_(resize1d)(tmpResults, sliceSize);
-  real *tmp__data = THTensor_(data)(tmpResults);
-
-  THLongTensor *tmpIndices = THLongTensor_new();
-  THLongTensor_resize1d(tmpIndices, sliceSize);
-  int64_t *tmpi__data = THLongTensor_data(tmpIndices);
-
   THLongStorage *topKSize = THTensor_(newSizeOf)(t);
   THLongStorage_set(topKSize, dim, k);
   THTensor_(resize)(rt_, topKSize, NULL);
   THLongTensor_resize(ri_, topKSize, NULL);
   THLongStorage_free(topKSize);
 
-  if (dir) {
-    /* k largest elements, descending order (optional: see sorted) */
-    int64_t K = sliceSize - k;
-    TH_TENSOR_DIM_APPLY3(real, t, real, rt_, int64_t, ri_, dim,
-                         TH_TENSOR_DIM_APPLY3_SIZE_EQ_EXCEPT_DIM,
-                         int64_t i;
-                         for(i = 0; i < sliceSize; i++)
-                         {
-                           tmp__data[i] = t_data[i*t_stride];
-                           tmpi__data[i] = i;
-                         }
-                         if (K > 0)
-                           THTensor_(quickselect)(tmp__data, tmpi__data, K - 1, sliceSize, 1);
-                         if (sorted)
-                           THTensor_(quicksortdescend)(tmp__data + K, tmpi__data + K, k, 1);
-                         for(i = 0; i < k; i++)
-                         {
-                           rt__data[i*rt__stride] = tmp__data[i + K];
-                           ri__data[i*ri__stride] = tmpi__data[i + K];
-                         })
-  }
-  else {
-    /* k smallest elements, ascending order (optional: see sorted) */
-    TH_TENSOR_DIM_APPLY3(real, t, real, rt_, int64_t, ri_, dim,
-                         TH_TENSOR_DIM_APPLY3_SIZE_EQ_EXCEPT_DIM,
-                         int64_t i;
-                         for(i = 0; i < sliceSize; i++)
-                         {
-                           tmp__data[i] = t_data[i*t_stride];
-                           tmpi__data[i] = i;
-                         }
-                         THTensor_(quickselect)(tmp__data, tmpi__data, k - 1, sliceSize, 1);
-                         if (sorted)
-                           THTensor_(quicksortascend)(tmp__data, tmpi__data, k - 1, 1);
-                         for(i = 0; i < k; i++)
-                         {
-                           rt__data[i*rt__stride] = tmp__data[i];
-                           ri__data[i*ri__stride] = tmpi__data[i];
-                         })
+  ptrdiff_t slice, numSlices = THTensor_(nElement)(t) / sliceSize;
+  int useHeap = k <= TH_TOPK_HEAP_MAX_K && k * 8 <= sliceSize;
+  /* heaps only need room for k elements, quickselect for the whole slice */
+  int64_t bufferSize = useHeap ? k : sliceSize;
+  int numThreads = TH_OMP_MAX_THREADS;
+  real *t_data = THTensor_(data)(t);
+  real *rt__data = THTensor_(data)(rt_);
+  int64_t *ri__data = THLongTensor_data(ri_);
+  int64_t t_stride = t->stride[dim], rt__stride = rt_->stride[dim], ri__stride = ri_->stride[dim];
+
+  if (useHeap && numSlices < numThreads && sliceSize > TH_OMP_SORT_THRESHOLD) {
+    /* few huge slices: every thread selects the k best elements of a chunk,
+       then the k best of these candidates are selected */
+    real *tmp__data = (real*)THAlloc(sizeof(real) * k * numThreads);
+    int64_t *tmpi__data = (int64_t*)THAlloc(sizeof(int64_t) * k * numThreads);
+    int64_t *counts = (int64_t*)THAlloc(sizeof(int64_t) * numThreads);
+    int64_t chunk = (sliceSize + numThreads - 1) / numThreads;
+    for (slice = 0; slice < numSlices; slice++) {
+      real *t_slice = t_data + THTensor_(sliceOffset)(t->size, t->stride, t->nDimension, dim, slice);
+      real *rt_slice = rt__data + THTensor_(sliceOffset)(rt_->size, rt_->stride, rt_->nDimension, dim, slice);
+      int64_t *ri_slice = ri__data + THTensor_(sliceOffset)(ri_->size, ri_->stride, ri_->nDimension, dim, slice);
+      int64_t c, n = 0, i;
+      #pragma omp parallel for private(c)
+      for (c = 0; c < numThreads; c++) {
+        int64_t begin = c * chunk;
+        int64_t end = begin + chunk < sliceSize ? begin + chunk : sliceSize;
+        counts[c] = begin < end ?
+          THTensor_(topkHeapSelect)(t_slice, t_stride, NULL, begin, end, k, dir,
+                                    tmp__data + c * k, tmpi__data + c * k) : 0;
+      }
+      /* compact the candidates */
+      for (c = 0; c < numThreads; c++) {
+        for (i = 0; i < counts[c]; i++, n++) {
+          tmp__data[n] = tmp__data[c * k + i];
+          tmpi__data[n] = tmpi__data[c * k + i];
+        }
+      }
+      {
+        real *vals = (real*)THAlloc(sizeof(real) * k);
+        int64_t *inds = (int64_t*)THAlloc(sizeof(int64_t) * k);
+        THTensor_(topkHeapSelect)(tmp__data, 1, tmpi__data, 0, n, k, dir, vals, inds);
+        if (sorted)
+          THTensor_(topkHeapSort)(vals, inds, k, dir);
+        for (i = 0; i < k; i++) {
+          rt_slice[i*rt__stride] = vals[i];
+          ri_slice[i*ri__stride] = inds[i];
+        }
+        THFree(vals);
+        THFree(inds);
+      }
+    }
+    THFree(tmp__data);
+    THFree(tmpi__data);
+    THFree(counts);
+    return;
   }
 
-  THTensor_(free)(tmpResults);
-  THLongTensor_free(tmpIndices);
+  /* slices are processed in parallel, with one buffer per thread and no more
+     threads than slices */
+  int parallel = numSlices > 1 && numSlices * sliceSize > TH_OMP_SORT_THRESHOLD;
+  int numBuffers = parallel ? (numSlices < numThreads ? (int)numSlices : numThreads) : 1;
+  real *tmp__data = (real*)THAlloc(sizeof(real) * bufferSize * numBuffers);
+  int64_t *tmpi__data = (int64_t*)THAlloc(sizeof(int64_t) * bufferSize * numBuffers);
+
+  #pragma omp parallel for if(parallel) num_threads(numBuffers) private(slice)
+  for (slice = 0; slice < numSlices; slice++) {
+    real *tmp = tmp__data + bufferSize * TH_OMP_THREAD_NUM;
+    int64_t *tmpi = tmpi__data + bufferSize * TH_OMP_THREAD_NUM;
+    real *t_slice = t_data + THTensor_(sliceOffset)(t->size, t->stride, t->nDimension, dim, slice);
+    real *rt_slice = rt__data + THTensor_(sliceOffset)(rt_->size, rt_->stride, rt_->nDimension, dim, slice);
+    int64_t *ri_slice = ri__data + THTensor_(sliceOffset)(ri_->size, ri_->stride, ri_->nDimension, dim, slice);
+    int64_t i, offset = 0;
+
+    if (useHeap) {
+      THTensor_(topkHeapSelect)(t_slice, t_stride, NULL, 0, sliceSize, k, dir, tmp, tmpi);
+      if (sorted)
+        THTensor_(topkHeapSort)(tmp, tmpi, k, dir);
+    } else {
+      for (i = 0; i < sliceSize; i++) {
+        tmp[i] = t_slice[i*t_stride];
+        tmpi[i] = i;
+      }
+      if (dir) {
+        /* k largest elements, descending order (optional: see sorted) */
+        offset = sliceSize - k;
+        if (offset > 0)
+          THTensor_(quickselect)(tmp, tmpi, offset - 1, sliceSize, 1);
+        if (sorted)
+          THTensor_(quicksortdescend)(tmp + offset, tmpi + offset, k, 1);
+      } else {
+        /* k smallest elements, ascending order (optional: see sorted) */
+        THTensor_(quickselect)(tmp, tmpi, k - 1, sliceSize, 1);
+        if (sorted)
+          THTensor_(quicksortascend)(tmp, tmpi, k - 1, 1);
+      }
+    }
+    for (i = 0; i < k; i++) {
+      rt_slice[i*rt__stride] = tmp[i + offset];
+      ri_slice[i*ri__stride] = tmpi[i + offset];
+    }
+  }
+
+  THFree(tmp__data);
+  THFree(tmpi__data);
 }
 
 void THTensor_(tril)(THTensor *r_, THTensor *t, int64_t k)
@@ -3017,25 +3210,25 @@ TENSOR_IMPLEMENT_LOGICAL(ge,>=)
 TENSOR_IMPLEMENT_LOGICAL(eq,==)
 TENSOR_IMPLEMENT_LOGICAL(ne,!=)
 
-#define LAB_IMPLEMENT_BASIC_FUNCTION(NAME, CFUNC)             \
+#define LAB_IMPLEMENT_BASIC_FUNCTION(NAME, CFUNC, COST)       \
   void THTensor_(NAME)(THTensor *r_, THTensor *t)                \
   {                                                           \
     THTensor_(resizeAs)(r_, t);                               \
     if (THTensor_(isContiguous)(r_) && THTensor_(isContiguous)(t)) { \
-      TH_TENSOR_APPLY2_CONTIG(real, r_, real, t, THVector_(NAME)(r__data, t_data, r__len););  \
+      TH_TENSOR_APPLY2_CONTIG(real, r_, real, t, COST, THVector_(NAME)(r__data, t_data, r__len););  \
     } else {  \
-      TH_TENSOR_APPLY2(real, r_, real, t, *r__data = CFUNC(*t_data);); \
+      TH_TENSOR_APPLY2_OMP(real, r_, real, t, COST, *r__data = CFUNC(*t_data);); \
     } \
   }
 
-LAB_IMPLEMENT_BASIC_FUNCTION(neg,-)
+LAB_IMPLEMENT_BASIC_FUNCTION(neg,-,TH_OMP_COST_CHEAP)
 
 #if defined(TH_REAL_IS_LONG)
-LAB_IMPLEMENT_BASIC_FUNCTION(abs,labs)
+LAB_IMPLEMENT_BASIC_FUNCTION(abs,labs,TH_OMP_COST_CHEAP)
 #endif /* int64_t only part */
 
 #if defined(TH_REAL_IS_SHORT) || defined(TH_REAL_IS_INT)
-LAB_IMPLEMENT_BASIC_FUNCTION(abs,abs)
+LAB_IMPLEMENT_BASIC_FUNCTION(abs,abs,TH_OMP_COST_CHEAP)
 #endif /* int only part */
 
 #if defined(TH_REAL_IS_BYTE)
@@ -3062,31 +3255,31 @@ TENSOR_IMPLEMENT_LOGICAL_SUM(logicalany, ||, 0)
 #define TH_MATH_NAME(fn) fn
 #endif
 
-LAB_IMPLEMENT_BASIC_FUNCTION(log,TH_MATH_NAME(log))
-LAB_IMPLEMENT_BASIC_FUNCTION(lgamma,TH_MATH_NAME(lgamma))
-LAB_IMPLEMENT_BASIC_FUNCTION(log1p,TH_MATH_NAME(log1p))
-LAB_IMPLEMENT_BASIC_FUNCTION(sigmoid,TH_MATH_NAME(TH_sigmoid))
-LAB_IMPLEMENT_BASIC_FUNCTION(exp,TH_MATH_NAME(exp))
-LAB_IMPLEMENT_BASIC_FUNCTION(cos,TH_MATH_NAME(cos))
-LAB_IMPLEMENT_BASIC_FUNCTION(acos,TH_MATH_NAME(acos))
-LAB_IMPLEMENT_BASIC_FUNCTION(cosh,TH_MATH_NAME(cosh))
-LAB_IMPLEMENT_BASIC_FUNCTION(sin,TH_MATH_NAME(sin))
-LAB_IMPLEMENT_BASIC_FUNCTION(asin,TH_MATH_NAME(asin))
-LAB_IMPLEMENT_BASIC_FUNCTION(sinh,TH_MATH_NAME(sinh))
-LAB_IMPLEMENT_BASIC_FUNCTION(tan,TH_MATH_NAME(tan))
-LAB_IMPLEMENT_BASIC_FUNCTION(atan,TH_MATH_NAME(atan))
-LAB_IMPLEMENT_BASIC_FUNCTION(tanh,TH_MATH_NAME(tanh))
-LAB_IMPLEMENT_BASIC_FUNCTION(erf,TH_MATH_NAME(erf))
-LAB_IMPLEMENT_BASIC_FUNCTION(erfinv,TH_erfinv)
-LAB_IMPLEMENT_BASIC_FUNCTION(sqrt,TH_MATH_NAME(sqrt))
-LAB_IMPLEMENT_BASIC_FUNCTION(rsqrt,TH_MATH_NAME(TH_rsqrt))
-LAB_IMPLEMENT_BASIC_FUNCTION(ceil,TH_MATH_NAME(ceil))
-LAB_IMPLEMENT_BASIC_FUNCTION(floor,TH_MATH_NAME(floor))
-LAB_IMPLEMENT_BASIC_FUNCTION(round,TH_MATH_NAME(round))
-LAB_IMPLEMENT_BASIC_FUNCTION(abs,TH_MATH_NAME(fabs))
-LAB_IMPLEMENT_BASIC_FUNCTION(trunc,TH_MATH_NAME(trunc))
-LAB_IMPLEMENT_BASIC_FUNCTION(frac,TH_MATH_NAME(TH_frac))
-LAB_IMPLEMENT_BASIC_FUNCTION(cinv, TH_MATH_NAME(1.0) / )
+LAB_IMPLEMENT_BASIC_FUNCTION(log,TH_MATH_NAME(log),TH_OMP_COST_TRANSCENDENTAL)
+LAB_IMPLEMENT_BASIC_FUNCTION(lgamma,TH_MATH_NAME(lgamma),TH_OMP_COST_TRANSCENDENTAL)
+LAB_IMPLEMENT_BASIC_FUNCTION(log1p,TH_MATH_NAME(log1p),TH_OMP_COST_TRANSCENDENTAL)
+LAB_IMPLEMENT_BASIC_FUNCTION(sigmoid,TH_MATH_NAME(TH_sigmoid),TH_OMP_COST_TRANSCENDENTAL)
+LAB_IMPLEMENT_BASIC_FUNCTION(exp,TH_MATH_NAME(exp),TH_OMP_COST_TRANSCENDENTAL)
+LAB_IMPLEMENT_BASIC_FUNCTION(cos,TH_MATH_NAME(cos),TH_OMP_COST_TRANSCENDENTAL)
+LAB_IMPLEMENT_BASIC_FUNCTION(acos,TH_MATH_NAME(acos),TH_OMP_COST_TRANSCENDENTAL)
+LAB_IMPLEMENT_BASIC_FUNCTION(cosh,TH_MATH_NAME(cosh),TH_OMP_COST_TRANSCENDENTAL)
+LAB_IMPLEMENT_BASIC_FUNCTION(sin,TH_MATH_NAME(sin),TH_OMP_COST_TRANSCENDENTAL)
+LAB_IMPLEMENT_BASIC_FUNCTION(asin,TH_MATH_NAME(asin),TH_OMP_COST_TRANSCENDENTAL)
+LAB_IMPLEMENT_BASIC_FUNCTION(sinh,TH_MATH_NAME(sinh),TH_OMP_COST_TRANSCENDENTAL)
+LAB_IMPLEMENT_BASIC_FUNCTION(tan,TH_MATH_NAME(tan),TH_OMP_COST_TRANSCENDENTAL)
+LAB_IMPLEMENT_BASIC_FUNCTION(atan,TH_MATH_NAME(atan),TH_OMP_COST_TRANSCENDENTAL)
+LAB_IMPLEMENT_BASIC_FUNCTION(tanh,TH_MATH_NAME(tanh),TH_OMP_COST_TRANSCENDENTAL)
+LAB_IMPLEMENT_BASIC_FUNCTION(erf,TH_MATH_NAME(erf),TH_OMP_COST_TRANSCENDENTAL)
+LAB_IMPLEMENT_BASIC_FUNCTION(erfinv,TH_erfinv,TH_OMP_COST_TRANSCENDENTAL)
+LAB_IMPLEMENT_BASIC_FUNCTION(sqrt,TH_MATH_NAME(sqrt),TH_OMP_COST_MODERATE)
+LAB_IMPLEMENT_BASIC_FUNCTION(rsqrt,TH_MATH_NAME(TH_rsqrt),TH_OMP_COST_MODERATE)
+LAB_IMPLEMENT_BASIC_FUNCTION(ceil,TH_MATH_NAME(ceil),TH_OMP_COST_MODERATE)
+LAB_IMPLEMENT_BASIC_FUNCTION(floor,TH_MATH_NAME(floor),TH_OMP_COST_MODERATE)
+LAB_IMPLEMENT_BASIC_FUNCTION(round,TH_MATH_NAME(round),TH_OMP_COST_MODERATE)
+LAB_IMPLEMENT_BASIC_FUNCTION(abs,TH_MATH_NAME(fabs),TH_OMP_COST_CHEAP)
+LAB_IMPLEMENT_BASIC_FUNCTION(trunc,TH_MATH_NAME(trunc),TH_OMP_COST_MODERATE)
+LAB_IMPLEMENT_BASIC_FUNCTION(frac,TH_MATH_NAME(TH_frac),TH_OMP_COST_MODERATE)
+LAB_IMPLEMENT_BASIC_FUNCTION(cinv, TH_MATH_NAME(1.0) /, TH_OMP_COST_MODERATE)
 
 
 void THTensor_(pow)(THTensor *r_, THTensor *t, real value)
@@ -3099,7 +3292,7 @@ void THTensor_(pow)(THTensor *r_, THTensor *t, real value)
     THTensor_(cmul)(r_, t, t);
   }
   else if(value == 3){
-    TH_TENSOR_APPLY2(real, r_, real, t, *r__data = *t_data * *t_data * *t_data;);
+    TH_TENSOR_APPLY2_OMP(real, r_, real, t, TH_OMP_COST_CHEAP, *r__data = *t_data * *t_data * *t_data;);
   }
   else if(value == 0.5){
     THTensor_(sqrt)(r_, t);
@@ -3111,24 +3304,28 @@ void THTensor_(pow)(THTensor *r_, THTensor *t, real value)
     THTensor_(cinv)(r_, t);
   }
   else if(value == -2){
-    TH_TENSOR_APPLY2(real, r_, real, t, *r__data = TH_MATH_NAME(1.0) / (*t_data * *t_data););
+    TH_TENSOR_APPLY2_OMP(real, r_, real, t, TH_OMP_COST_MODERATE,
+                         *r__data = TH_MATH_NAME(1.0) / (*t_data * *t_data););
   }
   else{
-    TH_TENSOR_APPLY2(real, r_, real, t, *r__data = TH_MATH_NAME(pow)(*t_data, value););
+    TH_TENSOR_APPLY2_OMP(real, r_, real, t, TH_OMP_COST_TRANSCENDENTAL,
+                         *r__data = TH_MATH_NAME(pow)(*t_data, value););
   }
 }
 
 void THTensor_(atan2)(THTensor *r_, THTensor *tx, THTensor *ty)
 {
   THTensor_(resizeAs)(r_, tx);
-  TH_TENSOR_APPLY3(real, r_, real, tx, real, ty, *r__data = TH_MATH_NAME(atan2)(*tx_data,*ty_data););
+  TH_TENSOR_APPLY3_OMP(real, r_, real, tx, real, ty, TH_OMP_COST_TRANSCENDENTAL,
+                       *r__data = TH_MATH_NAME(atan2)(*tx_data,*ty_data););
 }
 
 void THTensor_(lerp)(THTensor *r_, THTensor *a, THTensor *b, real weight)
 {
   THArgCheck(THTensor_(nElement)(a) == THTensor_(nElement)(b), 2, "sizes do not match");
   THTensor_(resizeAs)(r_, a);
-  TH_TENSOR_APPLY3(real, r_, real, a, real, b, *r__data = TH_MATH_NAME(TH_lerp)(*a_data, *b_data, weight););
+  TH_TENSOR_APPLY3_OMP(real, r_, real, a, real, b, TH_OMP_COST_CHEAP,
+                       *r__data = TH_MATH_NAME(TH_lerp)(*a_data, *b_data, weight););
 }
 
 void THTensor_(mean)(THTensor *r_, THTensor *t, int dimension, int keepdim)
@@ -3140,6 +3337,41 @@ void THTensor_(mean)(THTensor *r_, THTensor *t, int dimension, int keepdim)
   THTensor_(div)(r_, r_, t->size[dimension]);
 }
 
+// Mean and sum of squared deviations, updated with Welford's algorithm for
+// numeric stability and merged with Chan et al.'s formula.
+typedef struct THTensor_(Moments)
+{
+  accreal mean;
+  accreal m2;
+  int64_t n;
+} THTensor_(Moments);
+
+#define TH_MOMENTS_INIT(s) (s).mean = 0; (s).m2 = 0; (s).n = 0
+#define TH_MOMENTS_UPDATE(s, x, k) \
+  { \
+    accreal delta = (x) - (s).mean; \
+    (s).n++; \
+    (s).mean += delta / (s).n; \
+    (s).m2 += delta * ((x) - (s).mean); \
+  }
+#define TH_MOMENTS_MERGE(a, b) \
+  if ((b).n > 0) { \
+    int64_t total = (a).n + (b).n; \
+    accreal delta = (b).mean - (a).mean; \
+    (a).m2 += (b).m2 + delta * delta * (a).n * (b).n / total; \
+    (a).mean += delta * (b).n / total; \
+    (a).n = total; \
+  }
+#define TH_VAR_STORE(s, v, ix) (v) = THTensor_(momentsVar)(s, biased)
+#define TH_STD_STORE(s, v, ix) (v) = TH_MATH_NAME(sqrt)(THTensor_(momentsVar)(s, biased))
+
+static inline accreal THTensor_(momentsVar)(THTensor_(Moments) s, int biased)
+{
+  if (s.n >= 2 || (biased && s.n == 1))
+    return s.m2 / (biased ? s.n : s.n - 1);
+  return NAN;
+}
+
 void THTensor_(std)(THTensor *r_, THTensor *t, int dimension, int biased, int keepdim)
 {
   THLongStorage *dim;
@@ -3152,31 +3384,8 @@ void THTensor_(std)(THTensor *r_, THTensor *t, int dimension, int biased, int ke
   THTensor_(resize)(r_, dim, NULL);
   THLongStorage_free(dim);
 
-  TH_TENSOR_DIM_APPLY2(real, t, real, r_, dimension,
-                       // Uses Welford's algorithm for numeric stability
-                       accreal mean = 0;
-                       accreal M2 = 0;
-
-                       int64_t i;
-                       for (i = 0; i < t_size; i++)
-                       {
-                         real z = t_data[i*t_stride];
-                         real delta = z - mean;
-                         mean += delta / (i + 1);
-                         real delta2 = z - mean;
-                         M2 += delta * delta2;
-                       }
-
-                       if (biased && t_size >= 2)
-                       {
-                         *r__data = TH_MATH_NAME(sqrt)(M2 / t_size);
-                       } else if (!biased && t_size >= 2) {
-                         *r__data = TH_MATH_NAME(sqrt)(M2 / (t_size - 1));
-                       } else if (biased && t_size == 1) {
-                         *r__data = 0;
-                       } else {
-                         *r__data = NAN;
-                       });
+  TH_TENSOR_DIM_REDUCE(real, t, dimension, r_, NULL, THTensor_(Moments), TH_OMP_COST_MODERATE,
+                       TH_MOMENTS_INIT, TH_MOMENTS_UPDATE, TH_MOMENTS_MERGE, TH_STD_STORE);
 
   if (!keepdim) {
     THTensor_(squeeze1d)(r_, r_, dimension);
@@ -3195,37 +3404,21 @@ void THTensor_(var)(THTensor *r_, THTensor *t, int dimension, int biased, int ke
   THTensor_(resize)(r_, dim, NULL);
   THLongStorage_free(dim);
 
-  TH_TENSOR_DIM_APPLY2(real, t, real, r_, dimension,
-                       // Uses Welford's algorithm for numeric stability
-                       accreal mean = 0;
-                       accreal M2 = 0;
-
-                       int64_t i;
-                       for (i = 0; i < t_size; i++)
-                       {
-                         real z = t_data[i*t_stride];
-                         real delta = z - mean;
-                         mean += delta / (i + 1);
-                         real delta2 = z - mean;
-                         M2 += delta * delta2;
-                       }
-
-                       if (biased && t_size >= 2)
-                       {
-                         *r__data = M2 / t_size;
-                       } else if (!biased && t_size >= 2) {
-                         *r__data = M2 / (t_size - 1);
-                       } else if (biased && t_size == 1) {
-                         *r__data = 0;
-                       } else {
-                         *r__data = NAN;
-                       });
+  TH_TENSOR_DIM_REDUCE(real, t, dimension, r_, NULL, THTensor_(Moments), TH_OMP_COST_MODERATE,
+                       TH_MOMENTS_INIT, TH_MOMENTS_UPDATE, TH_MOMENTS_MERGE, TH_VAR_STORE);
 
   if (!keepdim) {
     THTensor_(squeeze1d)(r_, r_, dimension);
   }
 }
 
+#define TH_NORM0_UPDATE(s, x, k) (s) += (x) != 0
+#define TH_NORM1_UPDATE(s, x, k) (s) += TH_MATH_NAME(fabs)(x)
+#define TH_NORM2_UPDATE(s, x, k) (s) += (accreal)(x) * (x)
+#define TH_NORMP_UPDATE(s, x, k) (s) += TH_MATH_NAME(pow)(TH_MATH_NAME(fabs)(x), value)
+#define TH_NORM2_STORE(s, v, ix) (v) = TH_MATH_NAME(sqrt)(s)
+#define TH_NORMP_STORE(s, v, ix) (v) = TH_MATH_NAME(pow)(s, 1.0/value)
+
 void THTensor_(norm)(THTensor *r_, THTensor *t, real value, int dimension, int keepdim)
 {
   THLongStorage *dim;
@@ -3239,21 +3432,17 @@ void THTensor_(norm)(THTensor *r_, THTensor *t, real value, int dimension, int k
   THLongStorage_free(dim);
 
   if(value == 0) {
-    TH_TENSOR_DIM_APPLY2(real, t, real, r_, dimension,
-                         accreal sum = 0;
-                         int64_t i;
-                         for(i = 0; i < t_size; i++)
-                           sum += t_data[i*t_stride] != 0.0;
-                         *r__data = sum;)
+    TH_TENSOR_DIM_REDUCE(real, t, dimension, r_, NULL, accreal, TH_OMP_COST_CHEAP,
+                         TH_ACC_ZERO, TH_NORM0_UPDATE, TH_ACC_MERGE_ADD, TH_ACC_STORE);
+  } else if(value == 1) {
+    TH_TENSOR_DIM_REDUCE(real, t, dimension, r_, NULL, accreal, TH_OMP_COST_CHEAP,
+                         TH_ACC_ZERO, TH_NORM1_UPDATE, TH_ACC_MERGE_ADD, TH_ACC_STORE);
+  } else if(value == 2) {
+    TH_TENSOR_DIM_REDUCE(real, t, dimension, r_, NULL, accreal, TH_OMP_COST_CHEAP,
+                         TH_ACC_ZERO, TH_NORM2_UPDATE, TH_ACC_MERGE_ADD, TH_NORM2_STORE);
   } else {
-    TH_TENSOR_DIM_APPLY2(real, t, real, r_, dimension,
-                         accreal sum = 0;
-                         int64_t i;
-                         for(i = 0; i < t_size; i++) {
-                           sum += TH_MATH_NAME(pow)(
-                             TH_MATH_NAME(fabs)(t_data[i*t_stride]), value);
-                         }
-                         *r__data = TH_MATH_NAME(pow)(sum, 1.0/value);)
+    TH_TENSOR_DIM_REDUCE(real, t, dimension, r_, NULL, accreal, TH_OMP_COST_TRANSCENDENTAL,
+                         TH_ACC_ZERO, TH_NORMP_UPDATE, TH_ACC_MERGE_ADD, TH_NORMP_STORE);
   }
 
   if (!keepdim) {
@@ -2,8 +2,147 @@
 #define TH_GENERIC_FILE "generic/THTensorRandom.c"
 #else
 
+#ifndef TH_PHILOX_CHUNK
+/* Blocks of the Philox stream computed at once by each thread. */
+#define TH_PHILOX_CHUNK 256
+#define TH_PHILOX_OMP_THRESHOLD 16384
+
+#define TH_PHILOX_UNIFORM 0
+#define TH_PHILOX_NORMAL 1
+#define TH_PHILOX_BERNOULLI 2
+#define TH_PHILOX_RANDOM 3
+
+/* Same conversions as uniform_float and uniform_double in THRandom.c */
+#define TH_PHILOX_FLOAT(w) (((w) & ((1U << 24) - 1)) * (1.0f / (1U << 24)))
+#define TH_PHILOX_DOUBLE(hi, lo) \
+  (((((uint64_t)(hi)) << 32 | (lo)) & ((1ULL << 53) - 1)) * (1.0 / (1ULL << 53)))
+
+/* True for a scalar expanded to some size, like the probabilities ATen
+   passes to bernoulli_ for a single p. */
+static int THRandom_isExpandedScalar(int nDimension, const int64_t *stride)
+{
+  int d;
+  for (d = 0; d < nDimension; d++) {
+    if (stride[d] != 0)
+      return 0;
+  }
+  return nDimension > 0;
+}
+#endif
+
+static int THTensor_(philoxFillable)(THTensor *self, THGenerator *_generator)
+{
+  return _generator->engine == TH_RANDOM_ENGINE_PHILOX && THTensor_(isContiguous)(self);
+}
+
+/* Fills a contiguous tensor from the Philox stream of _generator. Elements
+   (or pairs of elements for TH_PHILOX_NORMAL) take words consecutive 32-bit
+   words each, in order, so the result doesn't depend on how the chunks are
+   split between threads. UNIFORM draws from [a, b), NORMAL uses mean a and
+   standard deviation b, BERNOULLI has probability a, and RANDOM gives
+   min + (x % range). */
+static void THTensor_(philoxFill)(THTensor *self, THGenerator *_generator, int kind, int words,
+                                  double a, double b, uint64_t range, int64_t min)
+{
+  real *data = THTensor_(data)(self);
+  ptrdiff_t size = THTensor_(nElement)(self);
+  int group = kind == TH_PHILOX_NORMAL ? 2 : 1;
+  int groupWords = group * words;
+  ptrdiff_t groupsPerChunk = TH_PHILOX_CHUNK * 4 / groupWords;
+  ptrdiff_t groups = (size + group - 1) / group;
+  ptrdiff_t blocks = (groups * groupWords + 3) / 4;
+  ptrdiff_t chunks = (blocks + TH_PHILOX_CHUNK - 1) / TH_PHILOX_CHUNK;
+  uint64_t key = THRandom_initialSeed(_generator);
+  uint64_t counter = THRandom_philoxReserve(_generator, blocks);
+  ptrdiff_t chunk;
+
+#pragma omp parallel for if (size > TH_PHILOX_OMP_THRESHOLD) private(chunk)
+  for (chunk = 0; chunk < chunks; chunk++) {
+    uint32_t w[TH_PHILOX_CHUNK * 4];
+    ptrdiff_t firstBlock = chunk * TH_PHILOX_CHUNK;
+    ptrdiff_t begin = chunk * groupsPerChunk * group;
+    ptrdiff_t count = THMin(groupsPerChunk * group, size - begin);
+    real *out = data + begin;
+    ptrdiff_t i;
+
+    THRandom_philox(key, counter + firstBlock, w, THMin(TH_PHILOX_CHUNK, blocks - firstBlock));
+
+    switch (kind) {
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+    case TH_PHILOX_UNIFORM:
+      for (i = 0; i < count; i++) {
+#if defined(TH_REAL_IS_FLOAT)
+        out[i] = TH_PHILOX_FLOAT(w[i]) * (float)(b - a) + (float)a;
+#else
+        out[i] = TH_PHILOX_DOUBLE(w[2*i], w[2*i+1]) * (b - a) + a;
+#endif
+      }
+      break;
+    case TH_PHILOX_NORMAL: {
+      /* Box-Muller, like THRandom_normal, over all the pairs of the chunk at
+         once so that THVector_(boxMuller) can take the AVX2 kernel */
+      real x[TH_PHILOX_CHUNK * 2], y[TH_PHILOX_CHUNK * 2];
+      real z0[TH_PHILOX_CHUNK * 2], z1[TH_PHILOX_CHUNK * 2];
+      ptrdiff_t pairs = (count + 1) / 2;
+      for (i = 0; i < pairs; i++) {
+#if defined(TH_REAL_IS_FLOAT)
+        x[i] = TH_PHILOX_FLOAT(w[2*i]);
+        y[i] = TH_PHILOX_FLOAT(w[2*i+1]);
+#else
+        x[i] = TH_PHILOX_DOUBLE(w[4*i], w[4*i+1]);
+        y[i] = TH_PHILOX_DOUBLE(w[4*i+2], w[4*i+3]);
+#endif
+      }
+      THVector_(boxMuller)(z0, z1, x, y, pairs);
+      for (i = 0; i < count / 2; i++) {
+        out[2*i] = z0[i] * (real)b + (real)a;
+        out[2*i+1] = z1[i] * (real)b + (real)a;
+      }
+      if (count % 2)
+        out[count-1] = z0[pairs-1] * (real)b + (real)a;
+      break;
+    }
+#endif
+    case TH_PHILOX_BERNOULLI: {
+      /* u < p for u = x / 2^32, compared as integers, like THRandom_bernoulli */
+      uint64_t threshold = (uint64_t)(a * (1ULL << 32));
+      for (i = 0; i < count; i++)
+        out[i] = (real)(w[i] < threshold);
+      break;
+    }
+    case TH_PHILOX_RANDOM:
+      if (words == 2) {
+        for (i = 0; i < count; i++)
+          out[i] = (real)(((((uint64_t)w[2*i]) << 32 | w[2*i+1]) % range) + min);
+      } else {
+        for (i = 0; i < count; i++)
+          out[i] = (real)((w[i] % range) + min);
+      }
+      break;
+    }
+  }
+}
+
 void THTensor_(random)(THTensor *self, THGenerator *_generator)
 {
+  if (THTensor_(philoxFillable)(self, _generator)) {
+#if defined(TH_REAL_IS_BYTE)
+    THTensor_(philoxFill)(self, _generator, TH_PHILOX_RANDOM, 1, 0, 0, UINT8_MAX + 1, 0);
+#elif defined(TH_REAL_IS_CHAR)
+    THTensor_(philoxFill)(self, _generator, TH_PHILOX_RANDOM, 1, 0, 0, INT8_MAX + 1, 0);
+#elif defined(TH_REAL_IS_SHORT)
+    THTensor_(philoxFill)(self, _generator, TH_PHILOX_RANDOM, 1, 0, 0, INT16_MAX + 1, 0);
+#elif defined(TH_REAL_IS_INT)
+    THTensor_(philoxFill)(self, _generator, TH_PHILOX_RANDOM, 1, 0, 0, INT32_MAX + 1UL, 0);
+#elif defined(TH_REAL_IS_LONG)
+    THTensor_(philoxFill)(self, _generator, TH_PHILOX_RANDOM, 2, 0, 0, LONG_MAX + 1ULL, 0);
+#elif defined(TH_REAL_IS_FLOAT)
+    THTensor_(philoxFill)(self, _generator, TH_PHILOX_RANDOM, 1, 0, 0, (1ULL << FLT_MANT_DIG) + 1, 0);
+#elif defined(TH_REAL_IS_DOUBLE)
+    THTensor_(philoxFill)(self, _generator, TH_PHILOX_RANDOM, 2, 0, 0, (1ULL << DBL_MANT_DIG) + 1, 0);
+#endif
+    return;
+  }
 
 #if defined(TH_REAL_IS_BYTE)
   TH_TENSOR_APPLY(real, self, *self_data = (uint8_t)(THRandom_random(_generator) % (UINT8_MAX + 1)););
@@ -28,6 +167,11 @@ void THTensor_(random)(THTensor *self, THGenerator *_generator)
 void THTensor_(clampedRandom)(THTensor *self, THGenerator *_generator, int64_t min, int64_t max) {
   THArgCheck(max > min, 2, "max must be greater than min, but got: min = %lld, max = %lld", min, max);
   uint64_t range = max - min;
+  if (THTensor_(philoxFillable)(self, _generator)) {
+    THTensor_(philoxFill)(self, _generator, TH_PHILOX_RANDOM, range >= 1ULL << 32 ? 2 : 1,
+                          0, 0, range, min);
+    return;
+  }
 #if defined(TH_REAL_IS_LONG) || defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
     if (range >= 1ULL << 32) {
       TH_TENSOR_APPLY(real, self, *self_data = (real)((THRandom_random64(_generator) % range) + min);)
@@ -49,16 +193,33 @@ void THTensor_(geometric)(THTensor *self, THGenerator *_generator, double p)
 
 void THTensor_(bernoulli)(THTensor *self, THGenerator *_generator, double p)
 {
+  if (THTensor_(philoxFillable)(self, _generator)) {
+    THArgCheck(p >= 0 && p <= 1, 1, "must be >= 0 and <= 1");
+    THTensor_(philoxFill)(self, _generator, TH_PHILOX_BERNOULLI, 1, p, 0, 0, 0);
+    return;
+  }
   TH_TENSOR_APPLY(real, self, *self_data = (real)THRandom_bernoulli(_generator, p););
 }
 
 void THTensor_(bernoulli_FloatTensor)(THTensor *self, THGenerator *_generator, THFloatTensor *p)
 {
+  if (THTensor_(philoxFillable)(self, _generator) &&
+      THRandom_isExpandedScalar(p->nDimension, p->stride) &&
+      THFloatTensor_nElement(p) == THTensor_(nElement)(self)) {
+    THTensor_(bernoulli)(self, _generator, *THFloatTensor_data(p));
+    return;
+  }
   TH_TENSOR_APPLY2(real, self, float, p, *self_data = (real)THRandom_bernoulli(_generator, (double)*p_data););
 }
 
 void THTensor_(bernoulli_DoubleTensor)(THTensor *self, THGenerator *_generator, THDoubleTensor *p)
 {
+  if (THTensor_(philoxFillable)(self, _generator) &&
+      THRandom_isExpandedScalar(p->nDimension, p->stride) &&
+      THDoubleTensor_nElement(p) == THTensor_(nElement)(self)) {
+    THTensor_(bernoulli)(self, _generator, *THDoubleTensor_data(p));
+    return;
+  }
   TH_TENSOR_APPLY2(real, self, double, p, *self_data = (real)THRandom_bernoulli(_generator, (double)*p_data););
 }
 
@@ -76,6 +237,14 @@ void THTensor_(bernoulli_Tensor)(THTensor *self, THGenerator *_generator, THTens
 
 void THTensor_(uniform)(THTensor *self, THGenerator *_generator, double a, double b)
 {
+  if (THTensor_(philoxFillable)(self, _generator)) {
+#if defined(TH_REAL_IS_FLOAT)
+    THTensor_(philoxFill)(self, _generator, TH_PHILOX_UNIFORM, 1, a, b, 0, 0);
+#else
+    THTensor_(philoxFill)(self, _generator, TH_PHILOX_UNIFORM, 2, a, b, 0, 0);
+#endif
+    return;
+  }
   #if defined(TH_REAL_IS_FLOAT)
   TH_TENSOR_APPLY(real, self, *self_data =
     (real)THRandom_uniformFloat(_generator, (real)a, (real)b););
@@ -87,6 +256,15 @@ void THTensor_(uniform)(THTensor *self, THGenerator *_generator, double a, doubl
 
 void THTensor_(normal)(THTensor *self, THGenerator *_generator, double mean, double stdv)
 {
+  if (THTensor_(philoxFillable)(self, _generator)) {
+    THArgCheck(stdv > 0, 2, "standard deviation must be strictly positive");
+#if defined(TH_REAL_IS_FLOAT)
+    THTensor_(philoxFill)(self, _generator, TH_PHILOX_NORMAL, 1, mean, stdv, 0, 0);
+#else
+    THTensor_(philoxFill)(self, _generator, TH_PHILOX_NORMAL, 2, mean, stdv, 0, 0);
+#endif
+    return;
+  }
   TH_TENSOR_APPLY(real, self, *self_data = (real)THRandom_normal(_generator, mean, stdv););
 }
 
@@ -427,10 +605,21 @@ void THTensor_(getRNGState)(THGenerator *_generator, THTensor *self)
 void THTensor_(setRNGState)(THGenerator *_generator, THTensor *self)
 {
   static const size_t size = sizeof(THGenerator);
+  static const size_t legacy_size = sizeof(THGeneratorLegacyState);
+  THGenerator legacy_state;
   THGenerator *rng_state;
-  THArgCheck(THTensor_(nElement)(self) == size, 1, "RNG state is wrong size");
+  ptrdiff_t nElement = THTensor_(nElement)(self);
+  THArgCheck(nElement == size || nElement == legacy_size, 1, "RNG state is wrong size");
   THArgCheck(THTensor_(isContiguous)(self), 1, "RNG state needs to be contiguous");
-  rng_state = (THGenerator *)THTensor_(data)(self);
+  if (nElement == legacy_size) {
+    /* saved before the engines were added, so it uses MT19937 */
+    memset(&legacy_state, 0, sizeof(THGenerator));
+    memcpy(&legacy_state, THTensor_(data)(self), legacy_size);
+    legacy_state.engine = TH_RANDOM_ENGINE_MT19937;
+    rng_state = &legacy_state;
+  } else {
+    rng_state = (THGenerator *)THTensor_(data)(self);
+  }
   THArgCheck(THGenerator_isValid(rng_state), 1, "Invalid RNG state");
   THGenerator_copy(_generator, rng_state);
 }
@@ -16,6 +16,17 @@ TH_API void THVector_(neg)(real *y, const real *x, const ptrdiff_t n);
 TH_API void THVector_(abs)(real *y, const real *x, const ptrdiff_t n);
 #endif
 
+#if defined(TH_REAL_IS_CHAR)
+/* z[j] = sum_i x[i] * y[j*ldy + i] for j < ny, accumulated in 32 bits */
+TH_API void THVector_(dotI32)(int32_t *z, const real *x, const real *y, const ptrdiff_t ldy, const ptrdiff_t ny, const ptrdiff_t n);
+#endif
+
+#if defined(TH_REAL_IS_FLOAT)
+/* bulk conversion from and to half precision, rounding to nearest even */
+TH_API void THVector_(fromHalf)(float *y, const THHalf *x, const ptrdiff_t n);
+TH_API void THVector_(toHalf)(THHalf *y, const float *x, const ptrdiff_t n);
+#endif
+
 /* floating point only now */
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
 
@@ -45,6 +56,9 @@ TH_API void THVector_(abs)(real *y, const real *x, const ptrdiff_t n);
 TH_API void THVector_(trunc)(real *y, const real *x, const ptrdiff_t n);
 TH_API void THVector_(frac)(real *y, const real *x, const ptrdiff_t n);
 TH_API void THVector_(cinv)(real *y, const real *x, const ptrdiff_t n);
+/* Box-Muller transform of uniforms x and y in [0, 1):
+   z0 = sqrt(-2 log(1 - y)) cos(2 pi x), z1 = sqrt(-2 log(1 - y)) sin(2 pi x) */
+TH_API void THVector_(boxMuller)(real *z0, real *z1, const real *x, const real *y, const ptrdiff_t n);
 
 #endif /* floating point only part */
 
@@ -166,6 +166,33 @@ VECTOR_IMPLEMENT_FUNCTION(abs,labs)
 VECTOR_IMPLEMENT_FUNCTION(abs,abs)
 #endif /* int only part */
 
+#if defined(TH_REAL_IS_CHAR)
+void THVector_(dotI32_DEFAULT)(int32_t *z, const real *x, const real *y, const ptrdiff_t ldy, const ptrdiff_t ny, const ptrdiff_t n) {
+  ptrdiff_t i, j;
+  for (j = 0; j < ny; j++) {
+    const real *y_ = y + j*ldy;
+    int32_t sum = 0;
+    for (i = 0; i < n; i++)
+      sum += (int32_t)x[i] * y_[i];
+    z[j] = sum;
+  }
+}
+#endif /* char only part */
+
+#if defined(TH_REAL_IS_FLOAT)
+void THVector_(fromHalf_DEFAULT)(float *y, const THHalf *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  for (i = 0; i < n; i++)
+    y[i] = TH_half2float(x[i]);
+}
+
+void THVector_(toHalf_DEFAULT)(THHalf *y, const float *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  for (i = 0; i < n; i++)
+    y[i] = TH_float2half(x[i]);
+}
+#endif /* float only part */
+
 
 /* floating point only now */
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
@@ -203,6 +230,16 @@ VECTOR_IMPLEMENT_FUNCTION(trunc,TH_MATH_NAME(trunc))
 VECTOR_IMPLEMENT_FUNCTION(frac,TH_MATH_NAME(TH_frac))
 VECTOR_IMPLEMENT_FUNCTION(cinv, TH_MATH_NAME(1.0) / )
 
+void THVector_(boxMuller_DEFAULT)(real *z0, real *z1, const real *x, const real *y, const ptrdiff_t n) {
+  ptrdiff_t i;
+  for (i = 0; i < n; i++) {
+    real rho = TH_MATH_NAME(sqrt)(-2 * TH_MATH_NAME(log)(1 - y[i]));
+    real theta = 2 * (real)M_PI * x[i];
+    z0[i] = rho * TH_MATH_NAME(cos)(theta);
+    z1[i] = rho * TH_MATH_NAME(sin)(theta);
+  }
+}
+
 #undef TH_MATH_NAME
 #endif /* floating point only part */
 
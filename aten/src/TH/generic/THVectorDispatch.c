@@ -239,6 +239,62 @@ void THVector_(copy)(real *y, const real *x, const ptrdiff_t n) {
   THVector_(copy_DISPATCHPTR)(y, x, n);
 }
 
+#if defined(TH_REAL_IS_CHAR)
+static void (*THVector_(dotI32_DISPATCHPTR))(int32_t *, const real *, const real *, const ptrdiff_t, const ptrdiff_t, const ptrdiff_t) = &THVector_(dotI32_DEFAULT);
+static FunctionDescription THVector_(dotI32_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX2)
+    FUNCTION_IMPL(THVector_(dotI32_AVX2), SIMDExtension_AVX2),
+  #endif
+
+  FUNCTION_IMPL(THVector_(dotI32_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(dotI32)(int32_t *z, const real *x, const real *y, const ptrdiff_t ldy, const ptrdiff_t ny, const ptrdiff_t n) {
+  THVector_(dotI32_DISPATCHPTR)(z, x, y, ldy, ny, n);
+}
+#endif
+
+#if defined(TH_REAL_IS_FLOAT)
+static void (*THVector_(fromHalf_DISPATCHPTR))(float *, const THHalf *, const ptrdiff_t) = &THVector_(fromHalf_DEFAULT);
+static FunctionDescription THVector_(fromHalf_DISPATCHTABLE)[] = {
+  #if defined(USE_F16C)
+    FUNCTION_IMPL(THVector_(fromHalf_F16C), SIMDExtension_F16C),
+  #endif
+
+  FUNCTION_IMPL(THVector_(fromHalf_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(fromHalf)(float *y, const THHalf *x, const ptrdiff_t n) {
+  THVector_(fromHalf_DISPATCHPTR)(y, x, n);
+}
+
+static void (*THVector_(toHalf_DISPATCHPTR))(THHalf *, const float *, const ptrdiff_t) = &THVector_(toHalf_DEFAULT);
+static FunctionDescription THVector_(toHalf_DISPATCHTABLE)[] = {
+  #if defined(USE_F16C)
+    FUNCTION_IMPL(THVector_(toHalf_F16C), SIMDExtension_F16C),
+  #endif
+
+  FUNCTION_IMPL(THVector_(toHalf_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(toHalf)(THHalf *y, const float *x, const ptrdiff_t n) {
+  THVector_(toHalf_DISPATCHPTR)(y, x, n);
+}
+#endif
+
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+static void (*THVector_(boxMuller_DISPATCHPTR))(real *, real *, const real *, const real *, const ptrdiff_t) = &THVector_(boxMuller_DEFAULT);
+static FunctionDescription THVector_(boxMuller_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX2)
+    #if defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(boxMuller_AVX2), SIMDExtension_AVX2),
+    #endif
+  #endif
+
+  FUNCTION_IMPL(THVector_(boxMuller_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(boxMuller)(real *z0, real *z1, const real *x, const real *y, const ptrdiff_t n) {
+  THVector_(boxMuller_DISPATCHPTR)(z0, z1, x, y, n);
+}
+#endif
+
 /* This needs to be called in order to initialize the dispatch pointers at runtime.
  * This function simply checks what SIMD extensions are available, and then walks the dispatch table
  * to choose the best function.
@@ -257,6 +313,16 @@ void THVector_(vectorDispatchInit)(void)
   INIT_DISPATCH_PTR(cdiv);
   INIT_DISPATCH_PTR(divs);
   INIT_DISPATCH_PTR(copy);
+#if defined(TH_REAL_IS_CHAR)
+  INIT_DISPATCH_PTR(dotI32);
+#endif
+#if defined(TH_REAL_IS_FLOAT)
+  INIT_DISPATCH_PTR(fromHalf);
+  INIT_DISPATCH_PTR(toHalf);
+#endif
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+  INIT_DISPATCH_PTR(boxMuller);
+#endif
 }
 
 #endif
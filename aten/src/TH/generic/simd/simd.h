@@ -12,6 +12,7 @@
 // Can be found on Intel ISA Reference for CPUID
 #define CPUID_AVX2_BIT 0x20       // Bit 5 of EBX for EAX=0x7
 #define CPUID_AVX_BIT  0x10000000 // Bit 28 of ECX for EAX=0x1
+#define CPUID_F16C_BIT 0x20000000 // Bit 29 of ECX for EAX=0x1
 #define CPUID_SSE_BIT  0x2000000  // bit 25 of EDX for EAX=0x1
 
 // Helper macros for initialization
@@ -49,6 +50,7 @@ enum SIMDExtensions
   SIMDExtension_AVX2    = 0x1,
   SIMDExtension_AVX     = 0x2,
   SIMDExtension_SSE     = 0x4,
+  SIMDExtension_F16C    = 0x8,
 #endif
   SIMDExtension_DEFAULT = 0x0
 };
@@ -124,7 +126,7 @@ static inline uint32_t detectHostSIMDExtensions()
 {
   uint32_t eax, ebx, ecx, edx;
   uint32_t hostSimdExts = 0x0;
-  int TH_NO_AVX = 1, TH_NO_AVX2 = 1, TH_NO_SSE = 1;
+  int TH_NO_AVX = 1, TH_NO_AVX2 = 1, TH_NO_SSE = 1, TH_NO_F16C = 1;
   char *evar;
 
   evar = getenv("TH_NO_AVX2");
@@ -150,6 +152,14 @@ static inline uint32_t detectHostSIMDExtensions()
     hostSimdExts |= SIMDExtension_AVX;
   }
 
+  // F16C instructions use the AVX register state
+  evar = getenv("TH_NO_F16C");
+  if (evar == NULL || strncmp(evar, "1", 2) != 0)
+    TH_NO_F16C = 0;
+  if (ecx & CPUID_F16C_BIT && ecx & CPUID_AVX_BIT && TH_NO_F16C == 0) {
+    hostSimdExts |= SIMDExtension_F16C;
+  }
+
   evar = getenv("TH_NO_SSE");
   if (evar == NULL || strncmp(evar, "1", 2) != 0)
     TH_NO_SSE = 0;
@@ -45,4 +45,152 @@ void THFloatVector_cadd_AVX2(float *z, const float *x, const float *y, const flo
   }
 }
 
+/* log(v) for normal v > 0, with the Cephes logf polynomial: v = m 2^e for
+   m in [sqrt(1/2), sqrt(2)), and log(v) = log1p(m - 1) + e log(2). */
+static inline __m256 THFloatVector_log_AVX2(__m256 v) {
+  __m256i bits = _mm256_castps_si256(v);
+  __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+  __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x7fffff)),
+                                                 _mm256_set1_epi32(0x3f800000)));
+  __m256 big = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+  __m256 f, z, p;
+  m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), big);
+  e = _mm256_add_ps(e, _mm256_and_ps(big, _mm256_set1_ps(1.f)));
+  f = _mm256_sub_ps(m, _mm256_set1_ps(1.f));
+  z = _mm256_mul_ps(f, f);
+  p = _mm256_set1_ps(7.0376836292E-2f);
+  p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(-1.1514610310E-1f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(1.1676998740E-1f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(-1.2420140846E-1f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(1.4249322787E-1f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(-1.6668057665E-1f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(2.0000714765E-1f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(-2.4999993993E-1f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(3.3333331174E-1f));
+  p = _mm256_mul_ps(_mm256_mul_ps(p, f), z);
+  p = _mm256_add_ps(p, _mm256_mul_ps(e, _mm256_set1_ps(-2.12194440E-4f)));
+  p = _mm256_sub_ps(p, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+  return _mm256_add_ps(_mm256_add_ps(f, p), _mm256_mul_ps(e, _mm256_set1_ps(0.693359375f)));
+}
+
+/* cos(2 pi x) and sin(2 pi x) for x in [0, 1]. x = q / 4 + r exactly, with
+   |r| <= 1/8, so the Cephes polynomials on [-pi/4, pi/4] apply to 2 pi r and
+   the quadrant q rotates the result. */
+static inline void THFloatVector_sincos2pi_AVX2(__m256 x, __m256 *c, __m256 *s) {
+  __m256 q = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(4.f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  __m256 r = _mm256_mul_ps(_mm256_sub_ps(x, _mm256_mul_ps(q, _mm256_set1_ps(0.25f))),
+                           _mm256_set1_ps(6.28318530717958647692f));
+  __m256 z = _mm256_mul_ps(r, r);
+  __m256i quadrant = _mm256_and_si256(_mm256_cvtps_epi32(q), _mm256_set1_epi32(3));
+  __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(1)),
+                                                       _mm256_set1_epi32(1)));
+  /* cos is negated in quadrants 1 and 2, sin in quadrants 2 and 3 */
+  __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+      _mm256_and_si256(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+  __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+      _mm256_and_si256(quadrant, _mm256_set1_epi32(2)), 30));
+  __m256 sr, cr;
+  sr = _mm256_set1_ps(-1.9515295891E-4f);
+  sr = _mm256_add_ps(_mm256_mul_ps(sr, z), _mm256_set1_ps(8.3321608736E-3f));
+  sr = _mm256_add_ps(_mm256_mul_ps(sr, z), _mm256_set1_ps(-1.6666654611E-1f));
+  sr = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(sr, z), r), r);
+  cr = _mm256_set1_ps(2.443315711809948E-5f);
+  cr = _mm256_add_ps(_mm256_mul_ps(cr, z), _mm256_set1_ps(-1.388731625493765E-3f));
+  cr = _mm256_add_ps(_mm256_mul_ps(cr, z), _mm256_set1_ps(4.166664568298827E-2f));
+  cr = _mm256_mul_ps(_mm256_mul_ps(cr, z), z);
+  cr = _mm256_add_ps(_mm256_sub_ps(cr, _mm256_mul_ps(z, _mm256_set1_ps(0.5f))), _mm256_set1_ps(1.f));
+  *c = _mm256_xor_ps(_mm256_blendv_ps(cr, sr, swap), cosSign);
+  *s = _mm256_xor_ps(_mm256_blendv_ps(sr, cr, swap), sinSign);
+}
+
+static inline void THFloatVector_boxMuller8_AVX2(float *z0, float *z1, const float *x, const float *y) {
+  __m256 c, s;
+  __m256 rho = _mm256_sqrt_ps(_mm256_mul_ps(_mm256_set1_ps(-2.f),
+      THFloatVector_log_AVX2(_mm256_sub_ps(_mm256_set1_ps(1.f), _mm256_loadu_ps(y)))));
+  THFloatVector_sincos2pi_AVX2(_mm256_loadu_ps(x), &c, &s);
+  _mm256_storeu_ps(z0, _mm256_mul_ps(rho, c));
+  _mm256_storeu_ps(z1, _mm256_mul_ps(rho, s));
+}
+
+/* Expects 1 - y to be normal, which holds for the uniforms of the Philox
+   generator (multiples of 2^-24). The error stays below 1.5 FLT_EPSILON * rho,
+   a bit less than logf, cosf and sinf of 2 pi x rounded to float. */
+void THFloatVector_boxMuller_AVX2(float *z0, float *z1, const float *x, const float *y, const ptrdiff_t n) {
+  ptrdiff_t i;
+  for (i = 0; i <= n - 8; i += 8)
+    THFloatVector_boxMuller8_AVX2(z0 + i, z1 + i, x + i, y + i);
+  if (i < n) {
+    /* pad the tail, so that every element takes the same path */
+    float xt[8] = {0}, yt[8] = {0}, z0t[8], z1t[8];
+    ptrdiff_t j;
+    for (j = 0; j < n - i; j++) {
+      xt[j] = x[i + j];
+      yt[j] = y[i + j];
+    }
+    THFloatVector_boxMuller8_AVX2(z0t, z1t, xt, yt);
+    for (j = 0; j < n - i; j++) {
+      z0[i + j] = z0t[j];
+      z1[i + j] = z1t[j];
+    }
+  }
+}
+
+static inline int32_t THCharVector_hsum_AVX2(__m256i x) {
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+  s = _mm_hadd_epi32(s, s);
+  s = _mm_hadd_epi32(s, s);
+  return _mm_cvtsi128_si32(s);
+}
+
+/* int8 values are widened to int16 and multiplied pairwise with
+   _mm256_madd_epi16, which cannot overflow, four rows of y at a time so
+   that every load of x is used four times. */
+void THCharVector_dotI32_AVX2(int32_t *z, const int8_t *x, const int8_t *y, const ptrdiff_t ldy, const ptrdiff_t ny, const ptrdiff_t n) {
+  ptrdiff_t i, j;
+  __m256i XMM, YMM0, YMM1, YMM2, YMM3;
+  for (j=0; j<=((ny)-4); j+=4) {
+    const int8_t *y0 = y + j*ldy, *y1 = y0 + ldy, *y2 = y1 + ldy, *y3 = y2 + ldy;
+    int32_t s0, s1, s2, s3;
+    YMM0 = _mm256_setzero_si256();
+    YMM1 = _mm256_setzero_si256();
+    YMM2 = _mm256_setzero_si256();
+    YMM3 = _mm256_setzero_si256();
+    for (i=0; i<=((n)-16); i+=16) {
+      XMM = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(x+i)));
+      YMM0 = _mm256_add_epi32(YMM0, _mm256_madd_epi16(XMM, _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(y0+i)))));
+      YMM1 = _mm256_add_epi32(YMM1, _mm256_madd_epi16(XMM, _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(y1+i)))));
+      YMM2 = _mm256_add_epi32(YMM2, _mm256_madd_epi16(XMM, _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(y2+i)))));
+      YMM3 = _mm256_add_epi32(YMM3, _mm256_madd_epi16(XMM, _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(y3+i)))));
+    }
+    s0 = THCharVector_hsum_AVX2(YMM0);
+    s1 = THCharVector_hsum_AVX2(YMM1);
+    s2 = THCharVector_hsum_AVX2(YMM2);
+    s3 = THCharVector_hsum_AVX2(YMM3);
+    for (; i<(n); i++) {
+      s0 += (int32_t)x[i] * y0[i];
+      s1 += (int32_t)x[i] * y1[i];
+      s2 += (int32_t)x[i] * y2[i];
+      s3 += (int32_t)x[i] * y3[i];
+    }
+    z[j] = s0;
+    z[j+1] = s1;
+    z[j+2] = s2;
+    z[j+3] = s3;
+  }
+  for (; j<(ny); j++) {
+    const int8_t *y0 = y + j*ldy;
+    int32_t s0;
+    YMM0 = _mm256_setzero_si256();
+    for (i=0; i<=((n)-16); i+=16) {
+      XMM = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(x+i)));
+      YMM0 = _mm256_add_epi32(YMM0, _mm256_madd_epi16(XMM, _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(y0+i)))));
+    }
+    s0 = THCharVector_hsum_AVX2(YMM0);
+    for (; i<(n); i++) {
+      s0 += (int32_t)x[i] * y0[i];
+    }
+    z[j] = s0;
+  }
+}
+
 #endif // defined(__AVX2__)
@@ -2,8 +2,11 @@
 #define TH_AVX2_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 void THDoubleVector_cadd_AVX2(double *z, const double *x, const double *y, const double c, const ptrdiff_t n);
 void THFloatVector_cadd_AVX2(float *z, const float *x, const float *y, const float c, const ptrdiff_t n);
+void THFloatVector_boxMuller_AVX2(float *z0, float *z1, const float *x, const float *y, const ptrdiff_t n);
+void THCharVector_dotI32_AVX2(int32_t *z, const int8_t *x, const int8_t *y, const ptrdiff_t ldy, const ptrdiff_t ny, const ptrdiff_t n);
 
 #endif
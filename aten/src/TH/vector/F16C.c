@@ -0,0 +1,38 @@
+#if defined(__F16C__) || defined(_MSC_VER)
+#ifndef _MSC_VER
+#include <x86intrin.h>
+#else
+#include <intrin.h>
+#endif
+
+#include "F16C.h"
+
+void THFloatVector_fromHalf_F16C(float *y, const THHalf *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  for (i=0; i<=((n)-16); i+=16) {
+    _mm256_storeu_ps(y+i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(x+i))));
+    _mm256_storeu_ps(y+i+8, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(x+i+8))));
+  }
+  for (; i<=((n)-8); i+=8) {
+    _mm256_storeu_ps(y+i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(x+i))));
+  }
+  for (; i<n; i++) {
+    y[i] = TH_half2float(x[i]);
+  }
+}
+
+void THFloatVector_toHalf_F16C(THHalf *y, const float *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  for (i=0; i<=((n)-16); i+=16) {
+    _mm_storeu_si128((__m128i*)(y+i), _mm256_cvtps_ph(_mm256_loadu_ps(x+i), _MM_FROUND_TO_NEAREST_INT));
+    _mm_storeu_si128((__m128i*)(y+i+8), _mm256_cvtps_ph(_mm256_loadu_ps(x+i+8), _MM_FROUND_TO_NEAREST_INT));
+  }
+  for (; i<=((n)-8); i+=8) {
+    _mm_storeu_si128((__m128i*)(y+i), _mm256_cvtps_ph(_mm256_loadu_ps(x+i), _MM_FROUND_TO_NEAREST_INT));
+  }
+  for (; i<n; i++) {
+    y[i] = TH_float2half(x[i]);
+  }
+}
+
+#endif // defined(__F16C__)
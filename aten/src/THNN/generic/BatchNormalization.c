@@ -2,6 +2,104 @@
 #define TH_GENERIC_FILE "generic/BatchNormalization.c"
 #else
 
+#define THNN_BATCHNORM_CHANNEL_BLOCK 64
+
+// Channels-last input: the statistics of a block of channels are gathered
+// in one pass over the pixels, with the channels as the inner loop, and
+// the output is normalized a pixel at a time.
+static void THNN_(BatchNormalization_updateOutput_channelsLast)(
+  THTensor *input, THTensor *output,
+  THTensor *weight, THTensor *bias,
+  THTensor *running_mean, THTensor *running_var,
+  THTensor *save_mean, THTensor *save_std,
+  bool train, double momentum, double eps)
+{
+  int64_t nInput = THTensor_(size)(input, 1);
+  ptrdiff_t n = THTensor_(nElement)(input) / nInput;
+  int64_t f, block;
+  ptrdiff_t p;
+
+  THNN_(resizeAsLayout)(output, input);
+  real *input_data = THTensor_(data)(input);
+  real *output_data = THTensor_(data)(output);
+  real *mean = (real*)THAlloc(sizeof(real) * nInput);
+  real *invstd = (real*)THAlloc(sizeof(real) * nInput);
+  real *w = (real*)THAlloc(sizeof(real) * nInput);
+  real *b = (real*)THAlloc(sizeof(real) * nInput);
+
+  if (train) {
+    #pragma omp parallel for private(f, p)
+    for (block = 0; block < nInput; block += THNN_BATCHNORM_CHANNEL_BLOCK) {
+      int64_t fend = block + THNN_BATCHNORM_CHANNEL_BLOCK < nInput ?
+                     block + THNN_BATCHNORM_CHANNEL_BLOCK : nInput;
+      accreal sum[THNN_BATCHNORM_CHANNEL_BLOCK];
+
+      // compute mean per input
+      for (f = block; f < fend; ++f)
+        sum[f - block] = 0;
+      for (p = 0; p < n; ++p) {
+        real *in = input_data + p*nInput;
+        for (f = block; f < fend; ++f)
+          sum[f - block] += in[f];
+      }
+      for (f = block; f < fend; ++f)
+        mean[f] = (real) sum[f - block] / n;
+
+      // compute variance per input
+      for (f = block; f < fend; ++f)
+        sum[f - block] = 0;
+      for (p = 0; p < n; ++p) {
+        real *in = input_data + p*nInput;
+        for (f = block; f < fend; ++f)
+          sum[f - block] += (in[f] - mean[f]) * (in[f] - mean[f]);
+      }
+
+      for (f = block; f < fend; ++f) {
+        accreal var_sum = sum[f - block];
+        if (var_sum == 0 && eps == 0.0) {
+          invstd[f] = 0;
+        } else {
+          invstd[f] = (real) (1 / sqrt(var_sum/n + eps));
+        }
+        THTensor_(set1d)(save_mean, f, (real) mean[f]);
+        THTensor_(set1d)(save_std, f, (real) invstd[f]);
+
+        // update running averages
+        THTensor_(set1d)(running_mean, f,
+          (real) (momentum * mean[f] + (1 - momentum) * THTensor_(get1d)(running_mean, f)));
+
+        accreal unbiased_var = var_sum / (n - 1);
+        THTensor_(set1d)(running_var, f,
+          (real) (momentum * unbiased_var + (1 - momentum) * THTensor_(get1d)(running_var, f)));
+      }
+    }
+  } else {
+    for (f = 0; f < nInput; ++f) {
+      mean[f] = THTensor_(get1d)(running_mean, f);
+      invstd[f] = 1 / sqrt(THTensor_(get1d)(running_var, f) + eps);
+    }
+  }
+
+  for (f = 0; f < nInput; ++f) {
+    w[f] = weight ? THTensor_(get1d)(weight, f) : 1;
+    b[f] = bias ? THTensor_(get1d)(bias, f) : 0;
+  }
+
+  // compute output
+  #pragma omp parallel for private(f)
+  for (p = 0; p < n; ++p) {
+    real *in = input_data + p*nInput;
+    real *out = output_data + p*nInput;
+    for (f = 0; f < nInput; ++f)
+      out[f] = (real) (((in[f] - mean[f]) * invstd[f]) * w[f] + b[f]);
+  }
+
+  THFree(mean);
+  THFree(invstd);
+  THFree(w);
+  THFree(b);
+}
+
 void THNN_(BatchNormalization_updateOutput)(
   THNNState *state, THTensor *input, THTensor *output,
   THTensor *weight, THTensor *bias,
@@ -9,6 +107,13 @@ void THNN_(BatchNormalization_updateOutput)(
   THTensor *save_mean, THTensor *save_std,
   bool train, double momentum, double eps)
 {
+  if (THNN_(isChannelsLast)(input)) {
+    THNN_(BatchNormalization_updateOutput_channelsLast)
+      (input, output, weight, bias, running_mean, running_var,
+       save_mean, save_std, train, momentum, eps);
+    return;
+  }
+
   THTensor_(resizeAs)(output, input);
   int64_t nInput = THTensor_(size)(input, 1);
   int64_t f;
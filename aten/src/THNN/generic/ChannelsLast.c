@@ -0,0 +1,53 @@
+#ifndef TH_GENERIC_FILE
+#define TH_GENERIC_FILE "generic/ChannelsLast.c"
+#else
+
+// A channels-last (NHWC) tensor keeps the usual N x C x H x W sizes, but its
+// strides put the channels innermost: (H*W*C, 1, W*C, C). Kernels with a
+// channels-last path read such inputs without a copy and give channels-last
+// outputs, so that a chain of them never goes back to NCHW. The stride of a
+// dimension of size 1 doesn't matter, and contiguous tensors are always
+// treated as NCHW.
+static int THNN_(isChannelsLast)(THTensor *tensor)
+{
+  if (tensor->nDimension != 4 || THTensor_(isContiguous)(tensor))
+    return 0;
+
+  int64_t nChannel = tensor->size[1];
+  int64_t height = tensor->size[2];
+  int64_t width = tensor->size[3];
+  return (tensor->size[0] == 1 || tensor->stride[0] == height*width*nChannel) &&
+         (nChannel == 1 || tensor->stride[1] == 1) &&
+         (height == 1 || tensor->stride[2] == width*nChannel) &&
+         (width == 1 || tensor->stride[3] == nChannel);
+}
+
+static void THNN_(resizeChannelsLast)(
+          THTensor *tensor,
+          int64_t nBatch, int64_t nChannel, int64_t height, int64_t width)
+{
+  int64_t size[4] = {nBatch, nChannel, height, width};
+  int64_t stride[4] = {height*width*nChannel, 1, width*nChannel, nChannel};
+  THTensor_(resizeNd)(tensor, 4, size, stride);
+}
+
+static void THNN_(resizeIndicesChannelsLast)(
+          THIndexTensor *tensor,
+          int64_t nBatch, int64_t nChannel, int64_t height, int64_t width)
+{
+  int64_t size[4] = {nBatch, nChannel, height, width};
+  int64_t stride[4] = {height*width*nChannel, 1, width*nChannel, nChannel};
+  THIndexTensor_(resizeNd)(tensor, 4, size, stride);
+}
+
+// Resizes output like input, keeping input's layout if it's channels-last.
+static void THNN_(resizeAsLayout)(THTensor *output, THTensor *input)
+{
+  if (THNN_(isChannelsLast)(input))
+    THNN_(resizeChannelsLast)(output, input->size[0], input->size[1],
+                              input->size[2], input->size[3]);
+  else
+    THTensor_(resizeAs)(output, input);
+}
+
+#endif
@@ -2,6 +2,52 @@
 #define TH_GENERIC_FILE "generic/FusedRNNKernel.c"
 #else
 
+#include <stdarg.h>
+
+#ifndef THNN_FUSED_RNN_OMP_THRESHOLD
+// Number of hidden units below which the cells are computed serially.
+#define THNN_FUSED_RNN_OMP_THRESHOLD 16384
+#endif
+
+// factor will be 3 for GRU and 4 for LSTM
+static void THNN_(FusedRNNAssertSizes)(int factor, int count, ...)
+{
+  va_list list;
+  va_start(list, count);
+  THTensor *input = va_arg(list, THTensor*);
+  THTensor *hidden = va_arg(list, THTensor*);
+  THArgCheck(THTensor_(nElement)(input) == THTensor_(nElement)(hidden),
+             3, "Input and Hidden tensor sizes should be the same.");
+
+  for (int arg = 2; arg < count; ++arg) {
+    THTensor *tens = va_arg(list, THTensor*);
+    THArgCheck(THTensor_(nElement)(input) == THTensor_(nElement)(tens) * factor,
+               3, "A pointwise tensor was not the right size, should have 1/%u the elements of input/hidden tensor.",
+               factor);
+  }
+
+  va_end(list);
+}
+
+// Gate tensors are viewed as [rows, factor * hsz] and cell tensors as
+// [rows, hsz], hsz being the size of the last dimension of the cell tensors.
+// Rows are split between threads. Within a row the gate pre-activations are
+// summed in place, then the activations run over the whole gate with the
+// THVector kernels. A missing bias is replaced by zeros so that the loops
+// have no branches.
+
+static real *THNN_(fusedBias)(THTensor *bias, real **zeros, int64_t n)
+{
+  if (bias) {
+    return THTensor_(data)(bias);
+  }
+  if (!*zeros) {
+    *zeros = (real*)THAlloc(n * sizeof(real));
+    THVector_(fill)(*zeros, 0, n);
+  }
+  return *zeros;
+}
+
 void THNN_(GRUFused_updateOutput)(
           THNNState *state,
           THTensor *input,
@@ -12,7 +58,74 @@ void THNN_(GRUFused_updateOutput)(
           THTensor *hy,
           THTensor *storage)
 {
-  THAssertMsg(false, "Not implemented for CPU");
+  THTensor_(resizeAs)(hy, hx);
+  THNN_(FusedRNNAssertSizes)(3, 4, input, hidden, hx, hy);
+  THArgCheck(THTensor_(nElement)(storage) == THTensor_(nElement)(hx) * 5,
+             3, "Storage tensor for fused kernel was not sized correctly.");
+
+  int64_t hsz = THTensor_(size)(hx, THTensor_(nDimension)(hx) - 1);
+  int64_t rows = THTensor_(nElement)(hx) / hsz;
+  if (bias1) {
+    THArgCheck(THTensor_(nElement)(bias1) == hsz * 3 && THTensor_(nElement)(bias2) == hsz * 3,
+               4, "Bias in pointwise operation is an incorrect size, must be 3 x feature size.");
+  }
+
+  input = THTensor_(newContiguous)(input);
+  hidden = THTensor_(newContiguous)(hidden);
+  hx = THTensor_(newContiguous)(hx);
+  bias1 = bias1 ? THTensor_(newContiguous)(bias1) : NULL;
+  bias2 = bias2 ? THTensor_(newContiguous)(bias2) : NULL;
+  THTensor *hy_ = THTensor_(newContiguous)(hy);
+  THTensor *storage_ = THTensor_(newContiguous)(storage);
+
+  real *input_data = THTensor_(data)(input);
+  real *hidden_data = THTensor_(data)(hidden);
+  real *hx_data = THTensor_(data)(hx);
+  real *hy_data = THTensor_(data)(hy_);
+  real *storage_data = THTensor_(data)(storage_);
+  real *zeros = NULL;
+  real *b1 = THNN_(fusedBias)(bias1, &zeros, 3 * hsz);
+  real *b2 = THNN_(fusedBias)(bias2, &zeros, 3 * hsz);
+
+  int64_t row;
+#pragma omp parallel for if(rows * hsz > THNN_FUSED_RNN_OMP_THRESHOLD) private(row)
+  for (row = 0; row < rows; row++) {
+    real *in = input_data + row * 3 * hsz;
+    real *hid = hidden_data + row * 3 * hsz;
+    real *x = hx_data + row * hsz;
+    real *y = hy_data + row * hsz;
+    // saved for backward: rg, ig, ng, hx, hn
+    real *rg = storage_data + row * 5 * hsz;
+    real *ig = rg + hsz;
+    real *ng = rg + 2 * hsz;
+    real *hx_saved = rg + 3 * hsz;
+    real *hn = rg + 4 * hsz;
+    int64_t j;
+
+    // reset and input gates are adjacent
+    for (j = 0; j < 2 * hsz; j++) {
+      rg[j] = in[j] + hid[j] + b1[j] + b2[j];
+    }
+    THVector_(sigmoid)(rg, rg, 2 * hsz);
+    for (j = 0; j < hsz; j++) {
+      hn[j] = hid[j + 2 * hsz] + b2[j + 2 * hsz];
+      ng[j] = in[j + 2 * hsz] + b1[j + 2 * hsz] + rg[j] * hn[j];
+    }
+    THVector_(tanh)(ng, ng, hsz);
+    for (j = 0; j < hsz; j++) {
+      y[j] = ng[j] + ig[j] * (x[j] - ng[j]);
+      hx_saved[j] = x[j];
+    }
+  }
+
+  THFree(zeros);
+  THTensor_(free)(input);
+  THTensor_(free)(hidden);
+  THTensor_(free)(hx);
+  if (bias1) THTensor_(free)(bias1);
+  if (bias2) THTensor_(free)(bias2);
+  THTensor_(freeCopyTo)(hy_, hy);
+  THTensor_(freeCopyTo)(storage_, storage);
 }
 
 void THNN_(GRUFused_updateGradInput)(
@@ -23,7 +136,63 @@ void THNN_(GRUFused_updateGradInput)(
           THTensor *gradInputHx,
           THTensor *storage)
 {
-  THAssertMsg(false, "Not implemented for CPU");
+  THTensor_(resizeAs)(gradInputHx, gradOutput);
+  THNN_(FusedRNNAssertSizes)(3, 4, gradInInput, gradInHidden, gradOutput, gradInputHx);
+  THArgCheck(THTensor_(nElement)(storage) == THTensor_(nElement)(gradOutput) * 5,
+             6, "Storage tensor for fused kernel was not sized correctly.");
+
+  int64_t hsz = THTensor_(size)(gradOutput, THTensor_(nDimension)(gradOutput) - 1);
+  int64_t rows = THTensor_(nElement)(gradOutput) / hsz;
+
+  gradOutput = THTensor_(newContiguous)(gradOutput);
+  storage = THTensor_(newContiguous)(storage);
+  THTensor *gradInInput_ = THTensor_(newContiguous)(gradInInput);
+  THTensor *gradInHidden_ = THTensor_(newContiguous)(gradInHidden);
+  THTensor *gradInputHx_ = THTensor_(newContiguous)(gradInputHx);
+
+  real *go_data = THTensor_(data)(gradOutput);
+  real *storage_data = THTensor_(data)(storage);
+  real *gii_data = THTensor_(data)(gradInInput_);
+  real *gih_data = THTensor_(data)(gradInHidden_);
+  real *ghx_data = THTensor_(data)(gradInputHx_);
+
+  int64_t row;
+#pragma omp parallel for if(rows * hsz > THNN_FUSED_RNN_OMP_THRESHOLD) private(row)
+  for (row = 0; row < rows; row++) {
+    real *go = go_data + row * hsz;
+    real *st = storage_data + row * 5 * hsz;
+    real *gii = gii_data + row * 3 * hsz;
+    real *gih = gih_data + row * 3 * hsz;
+    real *ghx = ghx_data + row * hsz;
+    int64_t j;
+    for (j = 0; j < hsz; j++) {
+      real rg = st[j];
+      real ig = st[j + hsz];
+      real ng = st[j + 2 * hsz];
+      real hx = st[j + 3 * hsz];
+      real hn = st[j + 4 * hsz];
+
+      real gig = go[j] * (hx - ng) * (1 - ig) * ig;
+      real gin = go[j] * (1 - ig) * (1 - ng * ng);
+      real grg = gin * hn * (1 - rg) * rg;
+
+      ghx[j] = go[j] * ig;
+
+      gii[j] = grg;
+      gii[j + hsz] = gig;
+      gii[j + 2 * hsz] = gin;
+
+      gih[j] = grg;
+      gih[j + hsz] = gig;
+      gih[j + 2 * hsz] = gin * rg;
+    }
+  }
+
+  THTensor_(free)(gradOutput);
+  THTensor_(free)(storage);
+  THTensor_(freeCopyTo)(gradInInput_, gradInInput);
+  THTensor_(freeCopyTo)(gradInHidden_, gradInHidden);
+  THTensor_(freeCopyTo)(gradInputHx_, gradInputHx);
 }
 
 void THNN_(LSTMFused_updateOutput)(
@@ -36,20 +205,143 @@ void THNN_(LSTMFused_updateOutput)(
           THTensor *hy,
           THTensor *cy)
 {
-  THAssertMsg(false, "Not implemented for CPU");
+  THTensor_(resizeAs)(hy, cx);
+  THTensor_(resizeAs)(cy, cx);
+  THNN_(FusedRNNAssertSizes)(4, 5, input, hidden, hy, cy, cx);
+
+  int64_t hsz = THTensor_(size)(cx, THTensor_(nDimension)(cx) - 1);
+  int64_t rows = THTensor_(nElement)(cx) / hsz;
+  if (bias1) {
+    THArgCheck(THTensor_(nElement)(bias1) == hsz * 4 && THTensor_(nElement)(bias2) == hsz * 4,
+               4, "Bias in pointwise operation is an incorrect size, must be 4 x feature size.");
+  }
+
+  // the activated gates are written back to input for the backward pass
+  THTensor *input_ = THTensor_(newContiguous)(input);
+  hidden = THTensor_(newContiguous)(hidden);
+  cx = THTensor_(newContiguous)(cx);
+  bias1 = bias1 ? THTensor_(newContiguous)(bias1) : NULL;
+  bias2 = bias2 ? THTensor_(newContiguous)(bias2) : NULL;
+  THTensor *hy_ = THTensor_(newContiguous)(hy);
+  THTensor *cy_ = THTensor_(newContiguous)(cy);
+
+  real *input_data = THTensor_(data)(input_);
+  real *hidden_data = THTensor_(data)(hidden);
+  real *cx_data = THTensor_(data)(cx);
+  real *hy_data = THTensor_(data)(hy_);
+  real *cy_data = THTensor_(data)(cy_);
+  real *zeros = NULL;
+  real *b1 = THNN_(fusedBias)(bias1, &zeros, 4 * hsz);
+  real *b2 = THNN_(fusedBias)(bias2, &zeros, 4 * hsz);
+
+  int64_t row;
+#pragma omp parallel for if(rows * hsz > THNN_FUSED_RNN_OMP_THRESHOLD) private(row)
+  for (row = 0; row < rows; row++) {
+    // the gates are ig, fg, cg, og
+    real *in = input_data + row * 4 * hsz;
+    real *hid = hidden_data + row * 4 * hsz;
+    real *c = cx_data + row * hsz;
+    real *h_out = hy_data + row * hsz;
+    real *c_out = cy_data + row * hsz;
+    real *ig = in, *fg = in + hsz, *cg = in + 2 * hsz, *og = in + 3 * hsz;
+    int64_t j;
+
+    for (j = 0; j < 4 * hsz; j++) {
+      in[j] += hid[j] + b1[j] + b2[j];
+    }
+    THVector_(sigmoid)(ig, ig, 2 * hsz);
+    THVector_(tanh)(cg, cg, hsz);
+    THVector_(sigmoid)(og, og, hsz);
+    for (j = 0; j < hsz; j++) {
+      c_out[j] = fg[j] * c[j] + ig[j] * cg[j];
+    }
+    THVector_(tanh)(h_out, c_out, hsz);
+    for (j = 0; j < hsz; j++) {
+      h_out[j] *= og[j];
+    }
+  }
+
+  THFree(zeros);
+  THTensor_(free)(hidden);
+  THTensor_(free)(cx);
+  if (bias1) THTensor_(free)(bias1);
+  if (bias2) THTensor_(free)(bias2);
+  THTensor_(freeCopyTo)(input_, input);
+  THTensor_(freeCopyTo)(hy_, hy);
+  THTensor_(freeCopyTo)(cy_, cy);
 }
 
 void THNN_(LSTMFused_updateGradInput)(
           THNNState *state,
           THTensor *storage,
           THTensor *gradInGates,
-          THTensor *prevC,
+          THTensor *cx,
           THTensor *cy,
           THTensor *gradOutput,
           THTensor *gradOutputCell,
           THTensor *gradInputCx)
 {
-  THAssertMsg(false, "Not implemented for CPU");
+  THTensor_(resizeAs)(gradInputCx, gradOutput);
+  THNN_(FusedRNNAssertSizes)(4, 7, storage, gradInGates, cx, cy,
+                             gradOutput, gradOutputCell, gradInputCx);
+
+  int64_t hsz = THTensor_(size)(gradOutput, THTensor_(nDimension)(gradOutput) - 1);
+  int64_t rows = THTensor_(nElement)(gradOutput) / hsz;
+
+  storage = THTensor_(newContiguous)(storage);
+  cx = THTensor_(newContiguous)(cx);
+  cy = THTensor_(newContiguous)(cy);
+  gradOutput = THTensor_(newContiguous)(gradOutput);
+  gradOutputCell = THTensor_(newContiguous)(gradOutputCell);
+  THTensor *gradInGates_ = THTensor_(newContiguous)(gradInGates);
+  THTensor *gradInputCx_ = THTensor_(newContiguous)(gradInputCx);
+
+  real *storage_data = THTensor_(data)(storage);
+  real *cx_data = THTensor_(data)(cx);
+  real *cy_data = THTensor_(data)(cy);
+  real *go_data = THTensor_(data)(gradOutput);
+  real *goc_data = THTensor_(data)(gradOutputCell);
+  real *gates_data = THTensor_(data)(gradInGates_);
+  real *gcx_data = THTensor_(data)(gradInputCx_);
+
+  int64_t row;
+#pragma omp parallel for if(rows * hsz > THNN_FUSED_RNN_OMP_THRESHOLD) private(row)
+  for (row = 0; row < rows; row++) {
+    real *st = storage_data + row * 4 * hsz;
+    real *gates = gates_data + row * 4 * hsz;
+    real *c_in = cx_data + row * hsz;
+    real *c_out = cy_data + row * hsz;
+    real *go = go_data + row * hsz;
+    real *goc = goc_data + row * hsz;
+    real *gcx = gcx_data + row * hsz;
+    int64_t j;
+    // gcx holds tanh(cy) until it is overwritten below
+    THVector_(tanh)(gcx, c_out, hsz);
+    for (j = 0; j < hsz; j++) {
+      real ig = st[j];
+      real fg = st[j + hsz];
+      real cg = st[j + 2 * hsz];
+      real og = st[j + 3 * hsz];
+
+      real tcy = gcx[j];
+      real gcell = go[j] * og * (1 - tcy * tcy) + goc[j];
+
+      gates[j] = gcell * cg * (1 - ig) * ig;
+      gates[j + hsz] = gcell * c_in[j] * (1 - fg) * fg;
+      gates[j + 2 * hsz] = gcell * ig * (1 - cg * cg);
+      gates[j + 3 * hsz] = go[j] * tcy * (1 - og) * og;
+
+      gcx[j] = gcell * fg;
+    }
+  }
+
+  THTensor_(free)(storage);
+  THTensor_(free)(cx);
+  THTensor_(free)(cy);
+  THTensor_(free)(gradOutput);
+  THTensor_(free)(gradOutputCell);
+  THTensor_(freeCopyTo)(gradInGates_, gradInGates);
+  THTensor_(freeCopyTo)(gradInputCx_, gradInputCx);
 }
 
 #endif
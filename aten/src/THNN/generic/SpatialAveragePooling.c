@@ -70,6 +70,77 @@ static inline void THNN_(SpatialAveragePooling_shapeCheck)(
   }
 }
 
+// Channels-last input: each window is summed a channel vector at a time
+// into the channels-last output.
+static void THNN_(SpatialAveragePooling_updateOutput_channelsLast)(
+          THTensor *input,
+          THTensor *output,
+          int kW,
+          int kH,
+          int dW,
+          int dH,
+          int padW,
+          int padH,
+          bool count_include_pad,
+          int64_t outputWidth,
+          int64_t outputHeight)
+{
+  int64_t nbatch = input->size[0];
+  int64_t nInputPlane = input->size[1];
+  int64_t inputHeight = input->size[2];
+  int64_t inputWidth = input->size[3];
+  int64_t p;
+
+  THNN_(resizeChannelsLast)(output, nbatch, nInputPlane, outputHeight, outputWidth);
+
+  real *input_data = THTensor_(data)(input);
+  real *output_data = THTensor_(data)(output);
+
+#pragma omp parallel for private(p)
+  for (p = 0; p < nbatch*outputHeight; p++)
+  {
+    int64_t b = p / outputHeight;
+    int64_t yy = p % outputHeight;
+    real *ptr_input = input_data + b*inputHeight*inputWidth*nInputPlane;
+    int64_t xx, k;
+    for (xx = 0; xx < outputWidth; xx++)
+    {
+      int64_t hstart = yy * dH - padH;
+      int64_t wstart = xx * dW - padW;
+      int64_t hend = fminf(hstart + kH, inputHeight + padH);
+      int64_t wend = fminf(wstart + kW, inputWidth + padW);
+      int pool_size = (hend - hstart) * (wend - wstart);
+      hstart = fmaxf(hstart, 0);
+      wstart = fmaxf(wstart, 0);
+      hend = fminf(hend, inputHeight);
+      wend = fminf(wend, inputWidth);
+
+      int divide_factor;
+      if(count_include_pad)
+        divide_factor = pool_size;
+      else
+        divide_factor = (hend - hstart) * (wend - wstart);
+
+      real *ptr_output = output_data + (p*outputWidth + xx)*nInputPlane;
+      for (k = 0; k < nInputPlane; k++)
+        ptr_output[k] = 0;
+
+      int64_t kx, ky;
+      for(ky = hstart; ky < hend; ky++)
+      {
+        for(kx = wstart; kx < wend; kx++)
+        {
+          real *ptr_window = ptr_input + (ky*inputWidth + kx)*nInputPlane;
+          for (k = 0; k < nInputPlane; k++)
+            ptr_output[k] += ptr_window[k];
+        }
+      }
+      for (k = 0; k < nInputPlane; k++)
+        ptr_output[k] /= divide_factor;
+    }
+  }
+}
+
 void THNN_(SpatialAveragePooling_updateOutput)(
           THNNState *state,
           THTensor *input,
@@ -133,6 +204,14 @@ void THNN_(SpatialAveragePooling_updateOutput)(
       --outputWidth;
   }
 
+  if (THNN_(isChannelsLast)(input))
+  {
+    THNN_(SpatialAveragePooling_updateOutput_channelsLast)
+      (input, output, kW, kH, dW, dH, padW, padH, count_include_pad,
+       outputWidth, outputHeight);
+    return;
+  }
+
   if (input->nDimension == 3)
     THTensor_(resize3d)(output, nInputPlane, outputHeight, outputWidth);
   else
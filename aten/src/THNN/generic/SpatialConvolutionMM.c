@@ -66,6 +66,97 @@ static THTensor* THNN_(view_weight_MM2d)(THTensor *weight) {
   return weight;
 }
 
+static inline int THNN_(SpatialConvolutionMM_isPointwise)(
+          int kW, int kH, int dW, int dH, int padW, int padH)
+{
+  return kW == 1 && kH == 1 && dW == 1 && dH == 1 && padW == 0 && padH == 0;
+}
+
+// finput only holds the unfolded input when updateOutput went through
+// unfold + gemm; the 1x1 and Winograd paths leave it empty or use it as
+// scratch space, and the columns are rebuilt for the weight gradient.
+static int THNN_(SpatialConvolutionMM_hasColumns)(
+          THTensor *input,
+          THTensor *finput,
+          int64_t nInputPlane,
+          int kW, int kH,
+          int64_t outputWidth, int64_t outputHeight)
+{
+  int batched = input->nDimension == 4;
+  if (finput->nDimension != (batched ? 3 : 2))
+    return 0;
+  if (batched && finput->size[0] != input->size[0])
+    return 0;
+  return finput->size[batched] == kW*kH*nInputPlane &&
+         finput->size[batched + 1] == outputHeight*outputWidth;
+}
+
+static void THNN_(SpatialConvolutionMM_updateOutput_winograd)(
+          const THNN_(WinogradTransform) *wt,
+          THTensor *input,
+          THTensor *output,
+          THTensor *weight,
+          THTensor *bias,
+          THTensor *finput,
+          int padW,
+          int padH,
+          int64_t nInputPlane,
+          int64_t inputWidth,
+          int64_t inputHeight,
+          int64_t nOutputPlane,
+          int64_t outputWidth,
+          int64_t outputHeight)
+{
+  int64_t wsize = THNN_(SpatialConvolutionWinograd_workspaceSize)
+    (wt, nInputPlane, nOutputPlane, outputWidth, outputHeight);
+  THTensor *U = THTensor_(newWithSize1d)((int64_t)wt->alpha * wt->alpha * nOutputPlane * nInputPlane);
+  THTensor *tbias = bias ? THTensor_(newContiguous)(bias) : NULL;
+  real *bias_data = tbias ? THTensor_(data)(tbias) : NULL;
+
+  THNN_(SpatialConvolutionWinograd_transformWeight)
+    (wt, THTensor_(data)(U), THTensor_(data)(weight), nInputPlane, nOutputPlane);
+
+  if (input->nDimension == 3)
+  {
+    THTensor_(resize1d)(finput, wsize);
+    THTensor_(resize3d)(output, nOutputPlane, outputHeight, outputWidth);
+
+    THNN_(SpatialConvolutionWinograd_frame)
+      (wt, THTensor_(data)(input), THTensor_(data)(output),
+       THTensor_(data)(U), bias_data, THTensor_(data)(finput),
+       padW, padH, nInputPlane, inputWidth, inputHeight,
+       nOutputPlane, outputWidth, outputHeight);
+  }
+  else
+  {
+    int64_t T = input->size[0];
+    int64_t t;
+    real *input_data, *output_data, *finput_data, *U_data;
+
+    THTensor_(resize2d)(finput, T, wsize);
+    THTensor_(resize4d)(output, T, nOutputPlane, outputHeight, outputWidth);
+    input_data = THTensor_(data)(input);
+    output_data = THTensor_(data)(output);
+    finput_data = THTensor_(data)(finput);
+    U_data = THTensor_(data)(U);
+
+#pragma omp parallel for private(t)
+    for(t = 0; t < T; t++)
+    {
+      THNN_(SpatialConvolutionWinograd_frame)
+        (wt, input_data + t*nInputPlane*inputHeight*inputWidth,
+         output_data + t*nOutputPlane*outputHeight*outputWidth,
+         U_data, bias_data, finput_data + t*wsize,
+         padW, padH, nInputPlane, inputWidth, inputHeight,
+         nOutputPlane, outputWidth, outputHeight);
+    }
+  }
+
+  if (tbias)
+    THTensor_(free)(tbias);
+  THTensor_(free)(U);
+}
+
 static void THNN_(SpatialConvolutionMM_updateOutput_frame)(
           THTensor *input,
           THTensor *output,
@@ -87,10 +178,20 @@ static void THNN_(SpatialConvolutionMM_updateOutput_frame)(
 {
   int64_t i;
   THTensor *output2d;
+  THTensor *columns;
 
-  THNN_(unfolded_copy)(finput, input, kW, kH, dW, dH, padW, padH,
-		       nInputPlane, inputWidth, inputHeight,
-		       outputWidth, outputHeight);
+  if (THNN_(SpatialConvolutionMM_isPointwise)(kW, kH, dW, dH, padW, padH)) {
+    // a 1x1 kernel with unit stride sees the input frame as its column matrix
+    columns = THTensor_(newWithStorage2d)(input->storage, input->storageOffset,
+                                          nInputPlane, -1,
+                                          inputHeight*inputWidth, -1);
+  } else {
+    THNN_(unfolded_copy)(finput, input, kW, kH, dW, dH, padW, padH,
+                         nInputPlane, inputWidth, inputHeight,
+                         outputWidth, outputHeight);
+    columns = finput;
+    THTensor_(retain)(columns);
+  }
 
   output2d = THTensor_(newWithStorage2d)(output->storage, output->storageOffset,
                                          nOutputPlane, -1,
@@ -104,11 +205,132 @@ static void THNN_(SpatialConvolutionMM_updateOutput_frame)(
     THTensor_(zero)(output);
   }
 
-  THTensor_(addmm)(output2d, 1, output2d, 1, weight, finput);
+  THTensor_(addmm)(output2d, 1, output2d, 1, weight, columns);
 
+  THTensor_(free)(columns);
   THTensor_(free)(output2d);
 }
 
+// Row p of the columns holds the kH x kW x nInputPlane window of output
+// pixel p in (kh, kw, plane) order, so channels-last input is unfolded by
+// copying whole channel vectors.
+static void THNN_(SpatialConvolutionMM_unfoldChannelsLast)(
+          real *columns,
+          real *input,
+          int kW, int kH,
+          int dW, int dH,
+          int padW, int padH,
+          int64_t nInputPlane,
+          int64_t inputWidth, int64_t inputHeight,
+          int64_t outputWidth, int64_t outputHeight)
+{
+  int64_t oh, ow;
+  int i, j;
+  for (oh = 0; oh < outputHeight; oh++) {
+    for (ow = 0; ow < outputWidth; ow++) {
+      real *col = columns + (oh*outputWidth + ow)*kH*kW*nInputPlane;
+      for (i = 0; i < kH; i++) {
+        int64_t ih = oh*dH - padH + i;
+        for (j = 0; j < kW; j++) {
+          int64_t iw = ow*dW - padW + j;
+          real *dst = col + (i*kW + j)*nInputPlane;
+          if (ih >= 0 && ih < inputHeight && iw >= 0 && iw < inputWidth)
+            memcpy(dst, input + (ih*inputWidth + iw)*nInputPlane, sizeof(real)*nInputPlane);
+          else
+            memset(dst, 0, sizeof(real)*nInputPlane);
+        }
+      }
+    }
+  }
+}
+
+// Channels-last input gives channels-last output: one gemm of the unfolded
+// input against the weight, with each output plane's kernel reordered to
+// (kh, kw, plane), writes every output pixel's channels contiguously. 1x1
+// stride 1 kernels multiply the input directly. finput is left 2D so that
+// the backward pass doesn't take it for the NCHW columns.
+static void THNN_(SpatialConvolutionMM_updateOutput_channelsLast)(
+          THTensor *input,
+          THTensor *output,
+          THTensor *weight,
+          THTensor *bias,
+          THTensor *finput,
+          int kW, int kH,
+          int dW, int dH,
+          int padW, int padH,
+          int64_t nInputPlane,
+          int64_t inputWidth, int64_t inputHeight,
+          int64_t nOutputPlane,
+          int64_t outputWidth, int64_t outputHeight)
+{
+  int64_t T = input->size[0];
+  int64_t kernelSize = kH*kW*nInputPlane;
+  int64_t outputSize = outputHeight*outputWidth;
+  int pointwise = THNN_(SpatialConvolutionMM_isPointwise)(kW, kH, dW, dH, padW, padH);
+  int64_t k, c, t;
+  int i, j;
+
+  THTensor *weight_t = NULL;
+  real *weight_data = THTensor_(data)(weight);
+  if (kW != 1 || kH != 1) {
+    weight_t = THTensor_(newWithSize2d)(nOutputPlane, kernelSize);
+    real *weight_t_data = THTensor_(data)(weight_t);
+    for (k = 0; k < nOutputPlane; k++)
+      for (c = 0; c < nInputPlane; c++)
+        for (i = 0; i < kH; i++)
+          for (j = 0; j < kW; j++)
+            weight_t_data[k*kernelSize + (i*kW + j)*nInputPlane + c] =
+              weight_data[((k*nInputPlane + c)*kH + i)*kW + j];
+    weight_data = weight_t_data;
+  }
+
+  THTensor *bias_c = bias ? THTensor_(newContiguous)(bias) : NULL;
+  real *bias_data = bias_c ? THTensor_(data)(bias_c) : NULL;
+
+  if (pointwise)
+    THTensor_(resize1d)(finput, 0);
+  else
+    THTensor_(resize2d)(finput, T, outputSize*kernelSize);
+  THNN_(resizeChannelsLast)(output, T, nOutputPlane, outputHeight, outputWidth);
+
+  real *input_data = THTensor_(data)(input);
+  real *output_data = THTensor_(data)(output);
+  real *finput_data = pointwise ? NULL : THTensor_(data)(finput);
+
+#pragma omp parallel for private(t)
+  for (t = 0; t < T; t++)
+  {
+    real *input_t = input_data + t*inputHeight*inputWidth*nInputPlane;
+    real *output_t = output_data + t*outputSize*nOutputPlane;
+    real *columns = input_t;
+    int64_t p;
+
+    if (!pointwise) {
+      columns = finput_data + t*outputSize*kernelSize;
+      THNN_(SpatialConvolutionMM_unfoldChannelsLast)
+        (columns, input_t, kW, kH, dW, dH, padW, padH,
+         nInputPlane, inputWidth, inputHeight, outputWidth, outputHeight);
+    }
+
+    for (p = 0; p < outputSize; p++) {
+      if (bias_data)
+        memcpy(output_t + p*nOutputPlane, bias_data, sizeof(real)*nOutputPlane);
+      else
+        memset(output_t + p*nOutputPlane, 0, sizeof(real)*nOutputPlane);
+    }
+
+    THBlas_(gemm)('t', 'n', nOutputPlane, outputSize, kernelSize,
+                  1, weight_data, kernelSize,
+                  columns, kernelSize,
+                  1, output_t, nOutputPlane);
+  }
+
+  if (bias_c)
+    THTensor_(free)(bias_c);
+  if (weight_t)
+    THTensor_(free)(weight_t);
+}
+
 void THNN_(SpatialConvolutionMM_updateOutput)(
           THNNState *state,
           THTensor *input,
@@ -129,7 +351,12 @@ void THNN_(SpatialConvolutionMM_updateOutput)(
   THNN_(SpatialConvolutionMM_shapeCheck)
     (input, NULL, weight, bias, kH, kW, dH, dW, padH, padW);
 
-  input = THTensor_(newContiguous)(input);
+  // channels-last input is dense already, and the output keeps its layout
+  int channelsLast = THNN_(isChannelsLast)(input);
+  if (channelsLast)
+    THTensor_(retain)(input);
+  else
+    input = THTensor_(newContiguous)(input);
   int ndim = input->nDimension;
   int dimf = 0;
   int dimh = 1;
@@ -148,9 +375,33 @@ void THNN_(SpatialConvolutionMM_updateOutput)(
   int64_t outputHeight = (inputHeight + 2*padH - kH) / dH + 1;
   int64_t outputWidth  = (inputWidth + 2*padW - kW) / dW + 1;
 
-  if(input->nDimension == 3)
+  // 3x3 stride 1 kernels with enough planes go through Winograd, 1x1 stride 1
+  // kernels multiply the input directly, everything else is unfold + gemm
+  const THNN_(WinogradTransform) *wt = THNN_(SpatialConvolutionWinograd_select)
+    (kW, kH, dW, dH, nInputPlane, nOutputPlane, outputWidth, outputHeight);
+  int pointwise = THNN_(SpatialConvolutionMM_isPointwise)(kW, kH, dW, dH, padW, padH);
+
+  if (channelsLast)
+  {
+    THNN_(SpatialConvolutionMM_updateOutput_channelsLast)
+      (input, output, weight, bias, finput,
+       kW, kH, dW, dH, padW, padH,
+       nInputPlane, inputWidth, inputHeight,
+       nOutputPlane, outputWidth, outputHeight);
+  }
+  else if (wt)
+  {
+    THNN_(SpatialConvolutionMM_updateOutput_winograd)
+      (wt, input, output, weight, bias, finput,
+       padW, padH, nInputPlane, inputWidth, inputHeight,
+       nOutputPlane, outputWidth, outputHeight);
+  }
+  else if(input->nDimension == 3)
   {
-    THTensor_(resize2d)(finput, kW*kH*nInputPlane, outputHeight*outputWidth);
+    if (pointwise)
+      THTensor_(resize1d)(finput, 0);
+    else
+      THTensor_(resize2d)(finput, kW*kH*nInputPlane, outputHeight*outputWidth);
     THTensor_(resize3d)(output, nOutputPlane, outputHeight, outputWidth);
 
     THNN_(SpatialConvolutionMM_updateOutput_frame)
@@ -164,7 +415,10 @@ void THNN_(SpatialConvolutionMM_updateOutput)(
     int64_t T = input->size[0];
     int64_t t;
 
-    THTensor_(resize3d)(finput, T, kW*kH*nInputPlane, outputHeight*outputWidth);
+    if (pointwise)
+      THTensor_(resize1d)(finput, 0);
+    else
+      THTensor_(resize3d)(finput, T, kW*kH*nInputPlane, outputHeight*outputWidth);
     THTensor_(resize4d)(output, T, nOutputPlane, outputHeight, outputWidth);
 
 #pragma omp parallel for private(t)
@@ -172,7 +426,7 @@ void THNN_(SpatialConvolutionMM_updateOutput)(
     {
       THTensor *input_t = THTensor_(newSelect)(input, 0, t);
       THTensor *output_t = THTensor_(newSelect)(output, 0, t);
-      THTensor *finput_t = THTensor_(newSelect)(finput, 0, t);
+      THTensor *finput_t = pointwise ? NULL : THTensor_(newSelect)(finput, 0, t);
 
       THNN_(SpatialConvolutionMM_updateOutput_frame)
 	(input_t, output_t, weight, bias, finput_t,
@@ -182,7 +436,8 @@ void THNN_(SpatialConvolutionMM_updateOutput)(
 
       THTensor_(free)(input_t);
       THTensor_(free)(output_t);
-      THTensor_(free)(finput_t);
+      if (finput_t)
+        THTensor_(free)(finput_t);
     }
   }
 
@@ -240,8 +495,15 @@ void THNN_(SpatialConvolutionMM_updateGradInput)(
   input = THTensor_(newContiguous)(input);
   gradOutput = THTensor_(newContiguous)(gradOutput);
 
+  int64_t nInputPlane = weight->size[1] / (kH * kW);
+  int64_t columnSize = gradOutput->size[gradOutput->nDimension - 2] *
+                       gradOutput->size[gradOutput->nDimension - 1];
+
   THTensor_(resizeAs)(gradInput, input);
-  THTensor_(resizeAs)(fgradInput, finput);
+  if (input->nDimension == 3)
+    THTensor_(resize2d)(fgradInput, kW*kH*nInputPlane, columnSize);
+  else
+    THTensor_(resize3d)(fgradInput, input->size[0], kW*kH*nInputPlane, columnSize);
 
   // depending on the BLAS library, fgradInput (result tensor) might
   // be left uninitialized on zero alpha, which might lead to weird behavior
@@ -346,10 +608,28 @@ void THNN_(SpatialConvolutionMM_accGradParameters)(
   input = THTensor_(newContiguous)(input);
   gradOutput = THTensor_(newContiguous)(gradOutput);
 
+  int ndim = input->nDimension;
+  int64_t nInputPlane  = input->size[ndim - 3];
+  int64_t inputHeight  = input->size[ndim - 2];
+  int64_t inputWidth   = input->size[ndim - 1];
+  int64_t outputHeight = gradOutput->size[ndim - 2];
+  int64_t outputWidth  = gradOutput->size[ndim - 1];
+  THTensor *columns = NULL;
+
+  if (!THNN_(SpatialConvolutionMM_hasColumns)
+        (input, finput, nInputPlane, kW, kH, outputWidth, outputHeight))
+  {
+    columns = THTensor_(newWithSize2d)(kW*kH*nInputPlane, outputHeight*outputWidth);
+  }
+
   if(input->nDimension == 3)
   {
+    if (columns)
+      THNN_(unfolded_copy)(columns, input, kW, kH, dW, dH, padW, padH,
+                           nInputPlane, inputWidth, inputHeight,
+                           outputWidth, outputHeight);
     THNN_(SpatialConvolutionMM_accGradParameters_frame)(gradOutput, gradWeight,
-							gradBias, finput, scale);
+							gradBias, columns ? columns : finput, scale);
   }
   else
   {
@@ -359,7 +639,19 @@ void THNN_(SpatialConvolutionMM_accGradParameters)(
     for(t = 0; t < T; t++)
     {
       THTensor *gradOutput_t = THTensor_(newSelect)(gradOutput, 0, t);
-      THTensor *finput_t = THTensor_(newSelect)(finput, 0, t);
+      THTensor *finput_t;
+
+      if (columns) {
+        THTensor *input_t = THTensor_(newSelect)(input, 0, t);
+        THNN_(unfolded_copy)(columns, input_t, kW, kH, dW, dH, padW, padH,
+                             nInputPlane, inputWidth, inputHeight,
+                             outputWidth, outputHeight);
+        THTensor_(free)(input_t);
+        finput_t = columns;
+        THTensor_(retain)(finput_t);
+      } else {
+        finput_t = THTensor_(newSelect)(finput, 0, t);
+      }
 
       THNN_(SpatialConvolutionMM_accGradParameters_frame)(gradOutput_t, gradWeight,
 							  gradBias, finput_t, scale);
@@ -369,6 +661,8 @@ void THNN_(SpatialConvolutionMM_accGradParameters)(
     }
   }
 
+  if (columns)
+    THTensor_(free)(columns);
   THTensor_(free)(input);
   THTensor_(free)(gradOutput);
   THTensor_(free)(gradWeight);
@@ -0,0 +1,285 @@
+#ifndef TH_GENERIC_FILE
+#define TH_GENERIC_FILE "generic/SpatialConvolutionWinograd.c"
+#else
+
+// Winograd minimal filtering F(m x m, 3 x 3) for stride 1, non-dilated 3x3
+// convolutions (Lavin & Gray, "Fast Algorithms for Convolutional Neural
+// Networks"). Every alpha x alpha input tile (alpha = m + 2) is transformed
+// to V = B^T d B and every filter to U = G g G^T. The reduction over input
+// planes then becomes alpha^2 independent gemms
+//   M[xi] (nOutputPlane x tiles) = U[xi] (nOutputPlane x nInputPlane) * V[xi] (nInputPlane x tiles)
+// and each m x m output tile is recovered as A^T M A.
+//
+// Layouts: U is [alpha^2][nOutputPlane][nInputPlane], V is
+// [alpha^2][nInputPlane][tiles] and M is [alpha^2][nOutputPlane][tiles].
+
+#ifndef THNN_WINOGRAD_MIN_PLANES
+// Number of input and output planes below which the transforms cost more
+// than they save in the gemms.
+#define THNN_WINOGRAD_MIN_PLANES 8
+#endif
+
+#ifndef THNN_WINOGRAD_OMP_THRESHOLD
+#define THNN_WINOGRAD_OMP_THRESHOLD 1024
+#endif
+
+// The input and output transforms are applied one dimension at a time by
+// the input1d / output1d kernels below, which spell out B^T and A^T; G is
+// only used once per weight and stays a plain matrix.
+typedef struct THNN_(WinogradTransform)
+{
+  int m;
+  int alpha;
+  const real *G;   // alpha x 3
+  void (*input1d)(real *out, int64_t os, const real *in, int64_t is);
+  void (*output1d)(real *out, int64_t os, const real *in, int64_t is);
+} THNN_(WinogradTransform);
+
+// F(2, 3)
+//   B^T = [1  0 -1  0]    A^T = [1  1  1  0]    G = [1    0    0  ]
+//         [0  1  1  0]          [0  1 -1 -1]        [1/2  1/2  1/2]
+//         [0 -1  1  0]                              [1/2 -1/2  1/2]
+//         [0  1  0 -1]                              [0    0    1  ]
+static const real THNN_(Winograd2x3_G)[12] = {
+  1,    0,    0,
+  0.5,  0.5,  0.5,
+  0.5, -0.5,  0.5,
+  0,    0,    1,
+};
+
+static void THNN_(Winograd2x3_input1d)(real *out, int64_t os, const real *in, int64_t is)
+{
+  real d0 = in[0], d1 = in[is], d2 = in[2*is], d3 = in[3*is];
+  out[0]    = d0 - d2;
+  out[os]   = d1 + d2;
+  out[2*os] = d2 - d1;
+  out[3*os] = d1 - d3;
+}
+
+static void THNN_(Winograd2x3_output1d)(real *out, int64_t os, const real *in, int64_t is)
+{
+  real m1 = in[is], m2 = in[2*is];
+  out[0]  = in[0] + m1 + m2;
+  out[os] = m1 - m2 - in[3*is];
+}
+
+// F(4, 3)
+//   B^T = [4  0 -5  0  1  0]    A^T = [1  1  1  1  1  0]
+//         [0 -4 -4  1  1  0]          [0  1 -1  2 -2  0]
+//         [0  4 -4 -1  1  0]          [0  1  1  4  4  0]
+//         [0 -2 -1  2  1  0]          [0  1 -1  8 -8  1]
+//         [0  2 -1 -2  1  0]
+//         [0  4  0 -5  0  1]
+static const real THNN_(Winograd4x3_G)[18] = {
+   1.0/4,       0,      0,
+  -1.0/6,  -1.0/6, -1.0/6,
+  -1.0/6,   1.0/6, -1.0/6,
+   1.0/24,  1.0/12, 1.0/6,
+   1.0/24, -1.0/12, 1.0/6,
+   0,       0,      1,
+};
+
+static void THNN_(Winograd4x3_input1d)(real *out, int64_t os, const real *in, int64_t is)
+{
+  real d0 = in[0], d1 = in[is], d2 = in[2*is], d3 = in[3*is], d4 = in[4*is], d5 = in[5*is];
+  real a = d4 - 4*d2;
+  real b = d3 - 4*d1;
+  real c = d4 - d2;
+  real e = 2*(d3 - d1);
+  out[0]    = 4*d0 - 5*d2 + d4;
+  out[os]   = a + b;
+  out[2*os] = a - b;
+  out[3*os] = c + e;
+  out[4*os] = c - e;
+  out[5*os] = 4*d1 - 5*d3 + d5;
+}
+
+static void THNN_(Winograd4x3_output1d)(real *out, int64_t os, const real *in, int64_t is)
+{
+  real m1 = in[is], m2 = in[2*is], m3 = in[3*is], m4 = in[4*is];
+  real s12 = m1 + m2, d12 = m1 - m2;
+  real s34 = m3 + m4, d34 = m3 - m4;
+  out[0]    = in[0] + s12 + s34;
+  out[os]   = d12 + 2*d34;
+  out[2*os] = s12 + 4*s34;
+  out[3*os] = d12 + 8*d34 + in[5*is];
+}
+
+static const THNN_(WinogradTransform) THNN_(Winograd2x3) = {
+  2, 4, THNN_(Winograd2x3_G), THNN_(Winograd2x3_input1d), THNN_(Winograd2x3_output1d)
+};
+
+static const THNN_(WinogradTransform) THNN_(Winograd4x3) = {
+  4, 6, THNN_(Winograd4x3_G), THNN_(Winograd4x3_input1d), THNN_(Winograd4x3_output1d)
+};
+
+// Returns the transform to use for this convolution, or NULL when it should
+// go through unfold + gemm instead.
+static const THNN_(WinogradTransform)* THNN_(SpatialConvolutionWinograd_select)(
+          int kW, int kH, int dW, int dH,
+          int64_t nInputPlane, int64_t nOutputPlane,
+          int64_t outputWidth, int64_t outputHeight)
+{
+  if (kW != 3 || kH != 3 || dW != 1 || dH != 1)
+    return NULL;
+  if (nInputPlane < THNN_WINOGRAD_MIN_PLANES || nOutputPlane < THNN_WINOGRAD_MIN_PLANES)
+    return NULL;
+  if (outputWidth >= 8 && outputHeight >= 8)
+    return &THNN_(Winograd4x3);
+  if (outputWidth >= 2 && outputHeight >= 2)
+    return &THNN_(Winograd2x3);
+  return NULL;
+}
+
+static inline int64_t THNN_(SpatialConvolutionWinograd_tiles)(
+          const THNN_(WinogradTransform) *wt,
+          int64_t outputWidth, int64_t outputHeight)
+{
+  return ((outputHeight + wt->m - 1) / wt->m) * ((outputWidth + wt->m - 1) / wt->m);
+}
+
+// Size of the per-frame V and M buffers.
+static int64_t THNN_(SpatialConvolutionWinograd_workspaceSize)(
+          const THNN_(WinogradTransform) *wt,
+          int64_t nInputPlane, int64_t nOutputPlane,
+          int64_t outputWidth, int64_t outputHeight)
+{
+  int64_t tiles = THNN_(SpatialConvolutionWinograd_tiles)(wt, outputWidth, outputHeight);
+  return (int64_t)wt->alpha * wt->alpha * (nInputPlane + nOutputPlane) * tiles;
+}
+
+// c (n x p) = a (n x k) * b (k x p), or a * b^T when b is given as p x k.
+static inline void THNN_(winogradMatMul)(real *c, const real *a, const real *b,
+                                          int n, int k, int p, int transb)
+{
+  int i, j, l;
+  for (i = 0; i < n; i++) {
+    for (j = 0; j < p; j++) {
+      real sum = 0;
+      for (l = 0; l < k; l++)
+        sum += a[i*k + l] * (transb ? b[j*k + l] : b[l*p + j]);
+      c[i*p + j] = sum;
+    }
+  }
+}
+
+// U = G g G^T for every (output plane, input plane) pair of a contiguous
+// nOutputPlane x nInputPlane x 3 x 3 weight.
+static void THNN_(SpatialConvolutionWinograd_transformWeight)(
+          const THNN_(WinogradTransform) *wt,
+          real *U,
+          const real *weight,
+          int64_t nInputPlane,
+          int64_t nOutputPlane)
+{
+  const int alpha = wt->alpha;
+  const int64_t planes = nOutputPlane * nInputPlane;
+  int64_t kc;
+
+#pragma omp parallel for if(planes > THNN_WINOGRAD_OMP_THRESHOLD) private(kc)
+  for (kc = 0; kc < planes; kc++) {
+    real tmp[6*3];
+    real u[6*6];
+    int xi;
+    THNN_(winogradMatMul)(tmp, wt->G, weight + kc*9, alpha, 3, 3, 0);
+    THNN_(winogradMatMul)(u, tmp, wt->G, alpha, 3, alpha, 1);
+    for (xi = 0; xi < alpha*alpha; xi++)
+      U[xi*planes + kc] = u[xi];
+  }
+}
+
+static void THNN_(SpatialConvolutionWinograd_frame)(
+          const THNN_(WinogradTransform) *wt,
+          const real *input,
+          real *output,
+          const real *U,
+          const real *bias,
+          real *workspace,
+          int padW,
+          int padH,
+          int64_t nInputPlane,
+          int64_t inputWidth,
+          int64_t inputHeight,
+          int64_t nOutputPlane,
+          int64_t outputWidth,
+          int64_t outputHeight)
+{
+  const int m = wt->m;
+  const int alpha = wt->alpha;
+  const int64_t tilesW = (outputWidth + m - 1) / m;
+  const int64_t tiles = THNN_(SpatialConvolutionWinograd_tiles)(wt, outputWidth, outputHeight);
+  real *V = workspace;
+  real *M = workspace + (int64_t)alpha * alpha * nInputPlane * tiles;
+  int64_t idx;
+  int xi;
+
+  // input transform, zero padding the tiles that hang over the border
+#pragma omp parallel for if(nInputPlane * tiles > THNN_WINOGRAD_OMP_THRESHOLD) private(idx)
+  for (idx = 0; idx < nInputPlane * tiles; idx++) {
+    int64_t c = idx / tiles;
+    int64_t p = idx % tiles;
+    int64_t y0 = (p / tilesW) * m - padH;
+    int64_t x0 = (p % tilesW) * m - padW;
+    const real *plane = input + c * inputHeight * inputWidth;
+    real d[6*6];
+    real tmp[6*6];
+    int i, j;
+    if (y0 >= 0 && y0 + alpha <= inputHeight && x0 >= 0 && x0 + alpha <= inputWidth) {
+      for (i = 0; i < alpha; i++)
+        wt->input1d(tmp + i, alpha, plane + y0*inputWidth + x0 + i, inputWidth);
+    } else {
+      for (i = 0; i < alpha; i++) {
+        for (j = 0; j < alpha; j++) {
+          int64_t y = y0 + i;
+          int64_t x = x0 + j;
+          d[i*alpha + j] = (y >= 0 && y < inputHeight && x >= 0 && x < inputWidth)
+            ? plane[y*inputWidth + x] : 0;
+        }
+      }
+      for (i = 0; i < alpha; i++)
+        wt->input1d(tmp + i, alpha, d + i, alpha);
+    }
+    // tmp = B^T d, columns of V[.][c][p] = tmp B
+    for (i = 0; i < alpha; i++)
+      wt->input1d(V + ((int64_t)i*alpha*nInputPlane + c)*tiles + p, nInputPlane*tiles,
+                  tmp + i*alpha, 1);
+  }
+
+  // Do GEMM (note: this is a bit confusing because gemm assumes column-major matrices)
+  for (xi = 0; xi < alpha*alpha; xi++) {
+    THBlas_(gemm)(
+      'n', 'n',
+      tiles, nOutputPlane, nInputPlane,
+      1,
+      V + xi*nInputPlane*tiles, tiles,
+      (real*)U + xi*nOutputPlane*nInputPlane, nInputPlane,
+      0,
+      M + xi*nOutputPlane*tiles, tiles
+    );
+  }
+
+  // output transform, dropping the part of the border tiles outside the output
+#pragma omp parallel for if(nOutputPlane * tiles > THNN_WINOGRAD_OMP_THRESHOLD) private(idx)
+  for (idx = 0; idx < nOutputPlane * tiles; idx++) {
+    int64_t k = idx / tiles;
+    int64_t p = idx % tiles;
+    int64_t y0 = (p / tilesW) * m;
+    int64_t x0 = (p % tilesW) * m;
+    real *plane = output + k * outputHeight * outputWidth;
+    real b = bias ? bias[k] : 0;
+    real tmp[4*6];
+    real y[4*4];
+    int i, j;
+    // tmp = A^T M, y = tmp A
+    for (j = 0; j < alpha; j++)
+      wt->output1d(tmp + j, alpha, M + ((int64_t)j*nOutputPlane + k)*tiles + p,
+                   (int64_t)alpha*nOutputPlane*tiles);
+    for (i = 0; i < m; i++)
+      wt->output1d(y + i*m, 1, tmp + i*alpha, 1);
+    for (i = 0; i < m && y0 + i < outputHeight; i++)
+      for (j = 0; j < m && x0 + j < outputWidth; j++)
+        plane[(y0 + i)*outputWidth + x0 + j] = y[i*m + j] + b;
+  }
+}
+
+#endif
@@ -0,0 +1,277 @@
+#ifndef TH_GENERIC_FILE
+#define TH_GENERIC_FILE "generic/SpatialDepthwiseConvolution.c"
+#else
+
+// Direct depthwise convolution: output plane k only sees input plane
+// k / depthwiseMultiplier, so there is no reduction over planes worth a gemm.
+// The loops run over kernel taps outermost and output columns innermost,
+// which keeps the inner loop a contiguous axpy for unit strides.
+
+static inline void THNN_(SpatialDepthwiseConvolution_shapeCheck)(
+	THTensor *input, THTensor *gradOutput,
+	THTensor *weight, THTensor *bias,
+	int kH, int kW, int dH, int dW, int padH, int padW,
+	int dilationH, int dilationW) {
+
+  THNN_ARGCHECK(input->nDimension == 4, 2, input,
+		"4D input tensor expected but got: %s");
+  THNN_ARGCHECK(weight->nDimension == 4 && weight->size[1] == 1, 4, weight,
+                "4D weight tensor (nOutputPlane,1,kH,kW) expected, "
+                "but got: %s");
+  THArgCheck(kW > 0 && kH > 0, 6,
+             "kernel size should be greater than zero, but got kH: %d kW: %d", kH, kW);
+  THArgCheck(dW > 0 && dH > 0, 8,
+             "stride should be greater than zero, but got dH: %d dW: %d", dH, dW);
+  THArgCheck(dilationW > 0 && dilationH > 0, 12,
+             "dilation should be greater than zero, but got dilationH: %d, dilationW: %d",
+             dilationH, dilationW);
+  THArgCheck(weight->size[0] % input->size[1] == 0, 4,
+             "number of output planes (%ld) should be a multiple of the number of input planes (%ld)",
+             weight->size[0], input->size[1]);
+
+  if (bias != NULL) {
+    THNN_CHECK_DIM_SIZE(bias, 1, 0, weight->size[0]);
+  }
+
+  int64_t inputHeight  = input->size[2];
+  int64_t inputWidth   = input->size[3];
+  int64_t outputHeight = (inputHeight + 2*padH - (dilationH * (kH - 1) + 1)) / dH + 1;
+  int64_t outputWidth  = (inputWidth + 2*padW - (dilationW * (kW - 1) + 1)) / dW + 1;
+
+  if (outputWidth < 1 || outputHeight < 1)
+    THError("Given input size: (%ld x %ld x %ld). "
+	    "Calculated output size: (%ld x %ld x %ld). Output size is too small",
+	    input->size[1],inputHeight,inputWidth,weight->size[0],outputHeight,outputWidth);
+
+  if (gradOutput != NULL) {
+    THNN_CHECK_DIM_SIZE(gradOutput, 4, 0, input->size[0]);
+    THNN_CHECK_DIM_SIZE(gradOutput, 4, 1, weight->size[0]);
+    THNN_CHECK_DIM_SIZE(gradOutput, 4, 2, outputHeight);
+    THNN_CHECK_DIM_SIZE(gradOutput, 4, 3, outputWidth);
+  }
+}
+
+// Range [*begin, *end) of output positions o for which the input position
+// o * stride + offset falls inside [0, size).
+static inline void THNN_(SpatialDepthwiseConvolution_range)(
+          int64_t offset, int stride, int64_t size, int64_t outputSize,
+          int64_t *begin, int64_t *end)
+{
+  int64_t b = offset < 0 ? (-offset + stride - 1) / stride : 0;
+  int64_t e = offset < size ? (size - 1 - offset) / stride + 1 : 0;
+  *begin = b;
+  *end = e < outputSize ? e : outputSize;
+}
+
+void THNN_(SpatialDepthwiseConvolution_updateOutput)(
+          THNNState *state,
+          THTensor *input,
+          THTensor *output,
+          THTensor *weight,
+          THTensor *bias,
+          int kW, int kH,
+          int dW, int dH,
+          int padW, int padH,
+          int dilationW, int dilationH)
+{
+  THNN_(SpatialDepthwiseConvolution_shapeCheck)
+    (input, NULL, weight, bias, kH, kW, dH, dW, padH, padW, dilationH, dilationW);
+
+  input = THTensor_(newContiguous)(input);
+  weight = THTensor_(newContiguous)(weight);
+  bias = bias ? THTensor_(newContiguous)(bias) : NULL;
+
+  int64_t batchSize    = input->size[0];
+  int64_t nInputPlane  = input->size[1];
+  int64_t inputHeight  = input->size[2];
+  int64_t inputWidth   = input->size[3];
+  int64_t nOutputPlane = weight->size[0];
+  int64_t outputHeight = (inputHeight + 2*padH - (dilationH * (kH - 1) + 1)) / dH + 1;
+  int64_t outputWidth  = (inputWidth + 2*padW - (dilationW * (kW - 1) + 1)) / dW + 1;
+  int64_t depthwiseMultiplier = nOutputPlane / nInputPlane;
+
+  THTensor_(resize4d)(output, batchSize, nOutputPlane, outputHeight, outputWidth);
+
+  real *input_data = THTensor_(data)(input);
+  real *output_data = THTensor_(data)(output);
+  real *weight_data = THTensor_(data)(weight);
+  real *bias_data = bias ? THTensor_(data)(bias) : NULL;
+  int64_t p;
+
+#pragma omp parallel for private(p)
+  for (p = 0; p < batchSize * nOutputPlane; p++) {
+    int64_t k = p % nOutputPlane;
+    real *in = input_data + ((p / nOutputPlane) * nInputPlane + k / depthwiseMultiplier) * inputHeight * inputWidth;
+    real *out = output_data + p * outputHeight * outputWidth;
+    real *w = weight_data + k * kH * kW;
+    int64_t oh, ow, ohBegin, ohEnd, owBegin, owEnd;
+    int i, j;
+
+    THVector_(fill)(out, bias_data ? bias_data[k] : 0, outputHeight * outputWidth);
+
+    for (i = 0; i < kH; i++) {
+      THNN_(SpatialDepthwiseConvolution_range)
+        (i * dilationH - padH, dH, inputHeight, outputHeight, &ohBegin, &ohEnd);
+      for (j = 0; j < kW; j++) {
+        real wv = w[i * kW + j];
+        int64_t offW = j * dilationW - padW;
+        THNN_(SpatialDepthwiseConvolution_range)
+          (offW, dW, inputWidth, outputWidth, &owBegin, &owEnd);
+        for (oh = ohBegin; oh < ohEnd; oh++) {
+          real *out_row = out + oh * outputWidth;
+          real *in_row = in + (oh * dH + i * dilationH - padH) * inputWidth + offW;
+          if (dW == 1) {
+            for (ow = owBegin; ow < owEnd; ow++)
+              out_row[ow] += wv * in_row[ow];
+          } else {
+            for (ow = owBegin; ow < owEnd; ow++)
+              out_row[ow] += wv * in_row[ow * dW];
+          }
+        }
+      }
+    }
+  }
+
+  THTensor_(free)(input);
+  THTensor_(free)(weight);
+  if (bias)
+    THTensor_(free)(bias);
+}
+
+void THNN_(SpatialDepthwiseConvolution_updateGradInput)(
+          THNNState *state,
+          THTensor *input,
+          THTensor *gradOutput,
+          THTensor *gradInput,
+          THTensor *weight,
+          int kW, int kH,
+          int dW, int dH,
+          int padW, int padH,
+          int dilationW, int dilationH)
+{
+  THNN_(SpatialDepthwiseConvolution_shapeCheck)
+    (input, gradOutput, weight, NULL, kH, kW, dH, dW, padH, padW, dilationH, dilationW);
+
+  gradOutput = THTensor_(newContiguous)(gradOutput);
+  weight = THTensor_(newContiguous)(weight);
+
+  THTensor_(resizeAs)(gradInput, input);
+  THTensor_(zero)(gradInput);
+
+  int64_t batchSize    = input->size[0];
+  int64_t nInputPlane  = input->size[1];
+  int64_t inputHeight  = input->size[2];
+  int64_t inputWidth   = input->size[3];
+  int64_t nOutputPlane = weight->size[0];
+  int64_t outputHeight = gradOutput->size[2];
+  int64_t outputWidth  = gradOutput->size[3];
+  int64_t depthwiseMultiplier = nOutputPlane / nInputPlane;
+
+  real *gradInput_data = THTensor_(data)(gradInput);
+  real *gradOutput_data = THTensor_(data)(gradOutput);
+  real *weight_data = THTensor_(data)(weight);
+  int64_t p;
+
+  // one thread per input plane, so the scatter never races
+#pragma omp parallel for private(p)
+  for (p = 0; p < batchSize * nInputPlane; p++) {
+    int64_t c = p % nInputPlane;
+    real *gin = gradInput_data + p * inputHeight * inputWidth;
+    int64_t k, oh, ow, ohBegin, ohEnd, owBegin, owEnd;
+    int i, j;
+
+    for (k = c * depthwiseMultiplier; k < (c + 1) * depthwiseMultiplier; k++) {
+      real *gout = gradOutput_data + ((p / nInputPlane) * nOutputPlane + k) * outputHeight * outputWidth;
+      real *w = weight_data + k * kH * kW;
+      for (i = 0; i < kH; i++) {
+        THNN_(SpatialDepthwiseConvolution_range)
+          (i * dilationH - padH, dH, inputHeight, outputHeight, &ohBegin, &ohEnd);
+        for (j = 0; j < kW; j++) {
+          real wv = w[i * kW + j];
+          int64_t offW = j * dilationW - padW;
+          THNN_(SpatialDepthwiseConvolution_range)
+            (offW, dW, inputWidth, outputWidth, &owBegin, &owEnd);
+          for (oh = ohBegin; oh < ohEnd; oh++) {
+            real *gout_row = gout + oh * outputWidth;
+            real *gin_row = gin + (oh * dH + i * dilationH - padH) * inputWidth + offW;
+            if (dW == 1) {
+              for (ow = owBegin; ow < owEnd; ow++)
+                gin_row[ow] += wv * gout_row[ow];
+            } else {
+              for (ow = owBegin; ow < owEnd; ow++)
+                gin_row[ow * dW] += wv * gout_row[ow];
+            }
+          }
+        }
+      }
+    }
+  }
+
+  THTensor_(free)(gradOutput);
+  THTensor_(free)(weight);
+}
+
+void THNN_(SpatialDepthwiseConvolution_accGradParameters)(
+          THNNState *state,
+          THTensor *input,
+          THTensor *gradOutput,
+          THTensor *gradWeight,
+          int kW, int kH,
+          int dW, int dH,
+          int padW, int padH,
+          int dilationW, int dilationH)
+{
+  THArgCheck(THTensor_(isContiguous)(gradWeight), 4, "gradWeight needs to be contiguous");
+  THNN_(SpatialDepthwiseConvolution_shapeCheck)
+    (input, gradOutput, gradWeight, NULL, kH, kW, dH, dW, padH, padW, dilationH, dilationW);
+
+  input = THTensor_(newContiguous)(input);
+  gradOutput = THTensor_(newContiguous)(gradOutput);
+
+  int64_t batchSize    = input->size[0];
+  int64_t nInputPlane  = input->size[1];
+  int64_t inputHeight  = input->size[2];
+  int64_t inputWidth   = input->size[3];
+  int64_t nOutputPlane = gradWeight->size[0];
+  int64_t outputHeight = gradOutput->size[2];
+  int64_t outputWidth  = gradOutput->size[3];
+  int64_t depthwiseMultiplier = nOutputPlane / nInputPlane;
+
+  real *input_data = THTensor_(data)(input);
+  real *gradOutput_data = THTensor_(data)(gradOutput);
+  real *gradWeight_data = THTensor_(data)(gradWeight);
+  int64_t k;
+
+  // like the CUDA kernel, gradWeight is overwritten rather than accumulated
+#pragma omp parallel for private(k)
+  for (k = 0; k < nOutputPlane; k++) {
+    int64_t n, oh, ow, ohBegin, ohEnd, owBegin, owEnd;
+    int i, j;
+    for (i = 0; i < kH; i++) {
+      THNN_(SpatialDepthwiseConvolution_range)
+        (i * dilationH - padH, dH, inputHeight, outputHeight, &ohBegin, &ohEnd);
+      for (j = 0; j < kW; j++) {
+        int64_t offW = j * dilationW - padW;
+        accreal sum = 0;
+        THNN_(SpatialDepthwiseConvolution_range)
+          (offW, dW, inputWidth, outputWidth, &owBegin, &owEnd);
+        for (n = 0; n < batchSize; n++) {
+          real *in = input_data + (n * nInputPlane + k / depthwiseMultiplier) * inputHeight * inputWidth;
+          real *gout = gradOutput_data + (n * nOutputPlane + k) * outputHeight * outputWidth;
+          for (oh = ohBegin; oh < ohEnd; oh++) {
+            real *gout_row = gout + oh * outputWidth;
+            real *in_row = in + (oh * dH + i * dilationH - padH) * inputWidth + offW;
+            for (ow = owBegin; ow < owEnd; ow++)
+              sum += gout_row[ow] * in_row[ow * dW];
+          }
+        }
+        gradWeight_data[(k * kH + i) * kW + j] = (real)sum;
+      }
+    }
+  }
+
+  THTensor_(free)(input);
+  THTensor_(free)(gradOutput);
+}
+
+#endif
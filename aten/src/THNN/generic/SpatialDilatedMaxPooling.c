@@ -150,6 +150,111 @@ static void THNN_(SpatialDilatedMaxPooling_updateOutput_frame)(
   }
 }
 
+// One output row of a channels-last frame. The output pixel's channels are
+// written contiguously, reading each window tap at stride nslices.
+static void THNN_(SpatialDilatedMaxPooling_updateOutput_channelsLast_row)(
+          real *input_p,
+          real *output_p,
+          THIndex_t *ind_p,
+          int64_t nslices,
+          int64_t iwidth,
+          int64_t iheight,
+          int64_t owidth,
+          int64_t i,
+          int kW,
+          int kH,
+          int dW,
+          int dH,
+          int padW,
+          int padH,
+          int dilationW,
+          int dilationH)
+{
+  int64_t j, k;
+  for (j = 0; j < owidth; j++)
+  {
+    int64_t hstart = i * dH - padH;
+    int64_t wstart = j * dW - padW;
+    int64_t hend = fminf(hstart + (kH - 1) * dilationH + 1, iheight);
+    int64_t wend = fminf(wstart + (kW - 1) * dilationW + 1, iwidth);
+    while(hstart < 0)
+      hstart += dilationH;
+    while(wstart < 0)
+      wstart += dilationW;
+
+    real *op = output_p + j*nslices;
+    THIndex_t *indp = ind_p + j*nslices;
+    for (k = 0; k < nslices; k++)
+    {
+      /* compute local max: */
+      int64_t maxindex = -1;
+      real maxval = -THInf;
+      int64_t x, y;
+      for(y = hstart; y < hend; y += dilationH)
+      {
+        for(x = wstart; x < wend; x += dilationW)
+        {
+          int64_t tcntr = y*iwidth + x;
+          real val = input_p[tcntr*nslices + k];
+          if (val > maxval)
+          {
+            maxval = val;
+            maxindex = tcntr;
+          }
+        }
+      }
+      op[k] = maxval;
+      indp[k] = maxindex + TH_INDEX_BASE;
+    }
+  }
+}
+
+// Channels-last input gives channels-last output and indices. The indices
+// hold the same in-plane offsets as in NCHW.
+static void THNN_(SpatialDilatedMaxPooling_updateOutput_channelsLast)(
+          THTensor *input,
+          THTensor *output,
+          THIndexTensor *indices,
+          int kW,
+          int kH,
+          int dW,
+          int dH,
+          int padW,
+          int padH,
+          int dilationW,
+          int dilationH,
+          int64_t owidth,
+          int64_t oheight)
+{
+  int64_t nbatch = input->size[0];
+  int64_t nslices = input->size[1];
+  int64_t iheight = input->size[2];
+  int64_t iwidth = input->size[3];
+  int64_t p;
+
+  THNN_(resizeChannelsLast)(output, nbatch, nslices, oheight, owidth);
+  THNN_(resizeIndicesChannelsLast)(indices, nbatch, nslices, oheight, owidth);
+
+  real *input_data = THTensor_(data)(input);
+  real *output_data = THTensor_(data)(output);
+  THIndex_t *indices_data = THIndexTensor_(data)(indices);
+
+#pragma omp parallel for private(p)
+  for (p = 0; p < nbatch*oheight; p++)
+  {
+    THNN_(SpatialDilatedMaxPooling_updateOutput_channelsLast_row)
+      (input_data + (p / oheight)*iheight*iwidth*nslices,
+       output_data + p*owidth*nslices,
+       indices_data + p*owidth*nslices,
+       nslices,
+       iwidth, iheight,
+       owidth, p % oheight,
+       kW, kH, dW, dH,
+       padW, padH,
+       dilationW, dilationH);
+  }
+}
+
 void THNN_(SpatialDilatedMaxPooling_updateOutput)(
           THNNState *state,
           THTensor *input,
@@ -214,6 +319,14 @@ void THNN_(SpatialDilatedMaxPooling_updateOutput)(
       --outputWidth;
   }
 
+  if (THNN_(isChannelsLast)(input))
+  {
+    THNN_(SpatialDilatedMaxPooling_updateOutput_channelsLast)
+      (input, output, indices, kW, kH, dW, dH, padW, padH,
+       dilationW, dilationH, outputWidth, outputHeight);
+    return;
+  }
+
   /* get contiguous input */
   input = THTensor_(newContiguous)(input);
 
@@ -341,8 +454,9 @@ void THNN_(SpatialDilatedMaxPooling_updateGradInput)(
     (input, gradOutput, indices, kH, kW, dH, dW,
      padH, padW, dilationH, dilationW, ceil_mode);
 
-  /* get contiguous gradOutput */
+  /* get contiguous gradOutput and indices */
   gradOutput = THTensor_(newContiguous)(gradOutput);
+  indices = THIndexTensor_(newContiguous)(indices);
 
   /* resize */
   THTensor_(resizeAs)(gradInput, input);
@@ -396,6 +510,7 @@ void THNN_(SpatialDilatedMaxPooling_updateGradInput)(
 
   /* cleanup */
   THTensor_(free)(gradOutput);
+  THIndexTensor_(free)(indices);
 }
 
 #endif
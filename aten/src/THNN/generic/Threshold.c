@@ -22,7 +22,7 @@ void THNN_(Threshold_updateOutput)(
   }
   else
   {
-    THTensor_(resizeAs)(output, input);
+    THNN_(resizeAsLayout)(output, input);
     TH_TENSOR_APPLY2(real, output, real, input,
       *output_data = (*input_data > threshold) ? *input_data : val;
     );
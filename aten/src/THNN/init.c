@@ -62,6 +62,9 @@
     THArgCheck(COND, ARG, FORMAT, s1.str);	\
   }
 
+#include "generic/ChannelsLast.c"
+#include "THGenerateFloatTypes.h"
+
 #include "generic/Abs.c"
 #include "THGenerateFloatTypes.h"
 
@@ -197,6 +200,9 @@
 #include "generic/SpatialConvolutionMap.c"
 #include "THGenerateFloatTypes.h"
 
+#include "generic/SpatialConvolutionWinograd.c"
+#include "THGenerateFloatTypes.h"
+
 #include "generic/SpatialConvolutionMM.c"
 #include "THGenerateFloatTypes.h"
 
@@ -215,6 +221,9 @@
 #include "generic/SpatialDilatedConvolution.c"
 #include "THGenerateFloatTypes.h"
 
+#include "generic/SpatialDepthwiseConvolution.c"
+#include "THGenerateFloatTypes.h"
+
 #include "generic/SpatialAdaptiveMaxPooling.c"
 #include "THGenerateFloatTypes.h"
 
@@ -13,6 +13,12 @@ $BUILD_ROOT/src/ATen/test/dlconvertor_test
 $BUILD_ROOT/src/ATen/test/native_test
 $BUILD_ROOT/src/ATen/test/scalar_tensor_test
 $BUILD_ROOT/src/ATen/test/undefined_tensor_test
+$BUILD_ROOT/src/ATen/test/caching_allocator_test
+if [ -d $BUILD_ROOT/contrib ]
+then
+  $BUILD_ROOT/contrib/data/test-prefetch
+  $BUILD_ROOT/contrib/data/test-mmap
+fi
 if [ "$VALGRIND" == "ON" ]
 then
   valgrind --suppressions=`dirname $0`/valgrind.sup --error-exitcode=1 $BUILD_ROOT/src/ATen/test/basic -n
@@ -0,0 +1,57 @@
+import argparse
+import os
+import subprocess
+import sys
+from timeit import default_timer as timer
+
+
+parser = argparse.ArgumentParser(
+    description='Measure the per-function dispatch overhead of the autograd '
+                'engine on deep chains of tiny operations.')
+parser.add_argument('--depth', type=int, default=10000,
+                    help='number of additions in the chain; default: 10000')
+parser.add_argument('--iters', type=int, default=10,
+                    help='number of timed backward passes; default: 10')
+parser.add_argument('--orders', type=str, default='fifo,sequence_nr',
+                    help='comma separated list of ready queue orders to try; '
+                         'default: fifo,sequence_nr')
+parser.add_argument('--worker', action='store_true', help=argparse.SUPPRESS)
+args = parser.parse_args()
+
+
+def run_worker():
+    import torch
+    from torch.autograd import Variable
+
+    x = Variable(torch.randn(1), requires_grad=True)
+
+    def step():
+        y = x
+        for _ in range(args.depth):
+            y = y + 1
+        start = timer()
+        y.backward()
+        return timer() - start
+
+    step()
+    print(sum(step() for _ in range(args.iters)) / args.iters)
+
+
+def main():
+    print("{:>12}\t{:>11}\t{:>11}".format("order", "ms/iter", "us/function"))
+    for order in args.orders.split(','):
+        env = dict(os.environ, PYTORCH_AUTOGRAD_QUEUE_ORDER=order)
+        cmd = [sys.executable, __file__, '--worker'] + sys.argv[1:]
+        elapsed = float(subprocess.check_output(cmd, env=env).decode().strip())
+        # The chain has an AccumulateGrad at its end, and a GraphRoot at the
+        # beginning.
+        num_functions = args.depth + 2
+        print("{:>12}\t{:>11.3f}\t{:>11.3f}".format(
+            order, 1000 * elapsed, 1e6 * elapsed / num_functions))
+
+
+if __name__ == '__main__':
+    if args.worker:
+        run_worker()
+    else:
+        main()
@@ -0,0 +1,71 @@
+import argparse
+import os
+import subprocess
+import sys
+from timeit import default_timer as timer
+
+
+parser = argparse.ArgumentParser(
+    description='Benchmark backward of a wide graph with different numbers '
+                'of autograd CPU threads.')
+parser.add_argument('--branches', type=int, default=64,
+                    help='number of independent branches; default: 64')
+parser.add_argument('--depth', type=int, default=8,
+                    help='number of matmuls in every branch; default: 8')
+parser.add_argument('--size', type=int, default=256,
+                    help='size of the square matrices; default: 256')
+parser.add_argument('--iters', type=int, default=10,
+                    help='number of timed backward passes; default: 10')
+parser.add_argument('--threads', type=str, default='1,2,4,8',
+                    help='comma separated list of thread counts to try; '
+                         'default: 1,2,4,8')
+parser.add_argument('--worker', action='store_true', help=argparse.SUPPRESS)
+args = parser.parse_args()
+
+
+def run_worker():
+    import torch
+    from torch.autograd import Variable
+
+    # Keep every worker single threaded, so that only the engine parallelism
+    # is measured.
+    torch.set_num_threads(1)
+    x = Variable(torch.randn(args.size, args.size), requires_grad=True)
+    weights = [[Variable(torch.randn(args.size, args.size) / args.size ** 0.5,
+                         requires_grad=True)
+                for _ in range(args.depth)]
+               for _ in range(args.branches)]
+
+    def step():
+        outputs = []
+        for branch in weights:
+            y = x
+            for w in branch:
+                y = y.mm(w).tanh()
+            outputs.append(y.sum())
+        loss = sum(outputs)
+        start = timer()
+        loss.backward()
+        return timer() - start
+
+    step()
+    print(sum(step() for _ in range(args.iters)) / args.iters)
+
+
+def main():
+    print("{:>8}\t{:>11}\t{:>8}".format("threads", "ms/iter", "speedup"))
+    baseline = None
+    for num_threads in [int(t) for t in args.threads.split(',')]:
+        env = dict(os.environ, PYTORCH_AUTOGRAD_CPU_THREADS=str(num_threads))
+        cmd = [sys.executable, __file__, '--worker'] + sys.argv[1:]
+        elapsed = float(subprocess.check_output(cmd, env=env).decode().strip())
+        baseline = baseline or elapsed
+        print("{:>8}\t{:>11.3f}\t{:>8.2f}".format(
+            num_threads, 1000 * elapsed, baseline / elapsed))
+
+
+if __name__ == '__main__':
+    if args.worker:
+        run_worker()
+    else:
+        main()
@@ -0,0 +1,97 @@
+import argparse
+from timeit import default_timer as timer
+
+import torch
+
+
+OPS = {
+    'add': lambda x, y: x.add(1),
+    'mul': lambda x, y: x.mul(y),
+    'div': lambda x, y: x.div(y),
+    'clamp': lambda x, y: x.clamp(-0.5, 0.5),
+    'copy': lambda x, y: x.contiguous(),
+    'sqrt': lambda x, y: x.sqrt(),
+    'exp': lambda x, y: x.exp(),
+    'tanh': lambda x, y: x.tanh(),
+    'pow': lambda x, y: x.pow(2.5),
+    'atan2': lambda x, y: x.atan2(y),
+}
+
+
+parser = argparse.ArgumentParser(
+    description='Time CPU pointwise operations over a sweep of tensor sizes, '
+                'operations, memory layouts and thread counts.')
+parser.add_argument('--sizes', type=str, default='1000,10000,100000,1000000,10000000',
+                    help='comma separated list of element counts; '
+                         'default: 1000,10000,100000,1000000,10000000')
+parser.add_argument('--ops', type=str, default=None,
+                    help='comma separated list of operations to run, out of ' +
+                         ', '.join(sorted(OPS)) + '; default: all')
+parser.add_argument('--layouts', type=str, default='contiguous,transposed,sliced,permuted',
+                    help='comma separated list of input layouts; '
+                         'default: contiguous,transposed,sliced,permuted')
+parser.add_argument('--threads', type=str, default='1,2,4,8',
+                    help='comma separated list of thread counts to try; '
+                         'default: 1,2,4,8')
+parser.add_argument('--type', type=str, default='torch.FloatTensor',
+                    help='tensor type; default: torch.FloatTensor')
+parser.add_argument('--min-time', type=float, default=0.2,
+                    help='seconds to spend timing each case; default: 0.2')
+args = parser.parse_args()
+
+
+def square(n):
+    rows = max(int(n ** 0.5), 1)
+    return rows, max(n // rows, 1)
+
+
+def make_input(layout, n):
+    rows, cols = square(n)
+    if layout == 'contiguous':
+        return torch.rand(rows, cols).type(args.type)
+    if layout == 'transposed':
+        return torch.rand(cols, rows).type(args.type).t()
+    if layout == 'sliced':
+        return torch.rand(rows, 2 * cols).type(args.type)[:, ::2]
+    if layout == 'permuted':
+        depth = max(int(rows ** 0.5), 1)
+        cube = torch.rand(cols, depth, max(rows // depth, 1)).type(args.type)
+        return cube.permute(1, 2, 0)
+    raise ValueError('unknown layout: ' + layout)
+
+
+def measure(fn):
+    fn()
+    iters = 0
+    start = timer()
+    while True:
+        fn()
+        iters += 1
+        elapsed = timer() - start
+        if elapsed >= args.min_time:
+            return elapsed / iters
+
+
+def main():
+    ops = args.ops.split(',') if args.ops else sorted(OPS)
+    threads = [int(t) for t in args.threads.split(',')]
+    print("{:>8}\t{:>10}\t{:>12}\t{}".format(
+        "op", "elements", "layout",
+        "\t".join("{:>10}".format("{} thr us".format(t)) for t in threads)))
+    for op in ops:
+        for n in [int(s) for s in args.sizes.split(',')]:
+            for layout in args.layouts.split(','):
+                x = make_input(layout, n)
+                # the second operand has the same size, but is contiguous
+                y = torch.rand(x.size()).type(args.type).add_(0.5)
+                times = []
+                for num_threads in threads:
+                    torch.set_num_threads(num_threads)
+                    times.append(measure(lambda: OPS[op](x, y)))
+                print("{:>8}\t{:>10}\t{:>12}\t{}".format(
+                    op, x.numel(), layout,
+                    "\t".join("{:>10.1f}".format(1e6 * t) for t in times)))
+
+
+if __name__ == '__main__':
+    main()
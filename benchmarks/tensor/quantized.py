@@ -0,0 +1,87 @@
+import argparse
+from timeit import default_timer as timer
+
+import torch
+import torch.nn.functional as F
+from torch.autograd import Variable
+
+
+parser = argparse.ArgumentParser(
+    description='Time the int8 quantized linear and conv2d against their float '
+                'versions over a sweep of sizes and thread counts.')
+parser.add_argument('--batch', type=int, default=64,
+                    help='number of samples; default: 64')
+parser.add_argument('--features', type=str, default='256,512,1024,2048',
+                    help='comma separated list of linear in/out features; '
+                         'default: 256,512,1024,2048')
+parser.add_argument('--channels', type=str, default='16,64,128',
+                    help='comma separated list of conv2d in/out channels; '
+                         'default: 16,64,128')
+parser.add_argument('--image-size', type=int, default=28,
+                    help='height and width of the conv2d input; default: 28')
+parser.add_argument('--threads', type=str, default='1,4',
+                    help='comma separated list of thread counts to try; '
+                         'default: 1,4')
+parser.add_argument('--min-time', type=float, default=0.2,
+                    help='seconds to spend timing each case; default: 0.2')
+args = parser.parse_args()
+
+ops = torch._C._VariableBase
+
+
+def measure(fn):
+    fn()
+    iters = 0
+    start = timer()
+    while True:
+        fn()
+        iters += 1
+        elapsed = timer() - start
+        if elapsed >= args.min_time:
+            return elapsed / iters
+
+
+def quantize_weight(w):
+    # symmetric, one scale per output channel
+    scales = w.view(w.size(0), -1).abs().max(1)[0] / 127
+    zero_points = Variable(torch.zeros(w.size(0)).long())
+    return torch.quantize_linear_per_channel(w, scales, zero_points, 0), scales
+
+
+def cases():
+    for n in [int(s) for s in args.features.split(',')]:
+        x = Variable(torch.randn(args.batch, n))
+        w = Variable(torch.randn(n, n))
+        b = Variable(torch.randn(n))
+        qw, ws = quantize_weight(w)
+        yield ('linear', '{}x{}'.format(n, n),
+               lambda: F.linear(x, w, b),
+               lambda: ops.quantized_linear(x, qw, ws, b))
+    for c in [int(s) for s in args.channels.split(',')]:
+        x = Variable(torch.randn(args.batch, c, args.image_size, args.image_size))
+        w = Variable(torch.randn(c, c, 3, 3))
+        b = Variable(torch.randn(c))
+        qw, ws = quantize_weight(w)
+        yield ('conv2d', '{}x{}x3x3'.format(c, c),
+               lambda: F.conv2d(x, w, b, 1, 1),
+               lambda: ops.quantized_conv2d(x, qw, ws, (1, 1), (1, 1), b))
+
+
+def main():
+    threads = [int(t) for t in args.threads.split(',')]
+    print("{:>8}\t{:>12}\t{:>7}\t{:>10}\t{:>10}\t{:>7}\t{:>9}".format(
+        "op", "weight", "threads", "float us", "int8 us", "speedup", "rel error"))
+    for op, size, float_fn, int8_fn in cases():
+        expected = float_fn().data
+        error = (int8_fn().data - expected).abs().max() / expected.abs().max()
+        for num_threads in threads:
+            torch.set_num_threads(num_threads)
+            float_time = measure(float_fn)
+            int8_time = measure(int8_fn)
+            print("{:>8}\t{:>12}\t{:>7}\t{:>10.1f}\t{:>10.1f}\t{:>7.2f}\t{:>9.4f}".format(
+                op, size, num_threads, 1e6 * float_time, 1e6 * int8_time,
+                float_time / int8_time, error))
+
+
+if __name__ == '__main__':
+    main()
@@ -1,13 +1,18 @@
 import contextlib
 import gc
+import json
 import sys
 import math
+import os
+import shutil
+import subprocess
 import torch
 import unittest
 import random
+import tempfile
 import warnings
 from copy import deepcopy
-from collections import OrderedDict
+from collections import OrderedDict, defaultdict
 from itertools import product
 from operator import mul
 from functools import reduce
@@ -1596,6 +1601,44 @@ class TestAutograd(TestCase):
         out.sum().backward(create_graph=True)
         self.assertEqual(x.grad.data, y_data)
 
+    def test_multithreaded_backward(self):
+        # the worker pool is started by the first backward, so the number of
+        # workers can only be set in a fresh process
+        script = """
+import torch
+from torch.autograd import Variable
+
+torch._C._set_num_autograd_cpu_threads(4)
+assert torch._C._get_num_autograd_cpu_threads() == 4
+
+x = Variable(torch.randn(10, 10), requires_grad=True)
+ws = [Variable(torch.randn(10, 10), requires_grad=True) for _ in range(32)]
+for _ in range(20):
+    x.grad = None
+    for w in ws:
+        w.grad = None
+    # independent branches that all flow into x, through one shared node
+    y = x * 2
+    sum(y.mm(w).tanh().sum() for w in ws).backward()
+
+    grad_y = torch.zeros(10, 10)
+    for w in ws:
+        d = 1 - (x.data * 2).mm(w.data).tanh() ** 2
+        assert (w.grad.data - (x.data * 2).t().mm(d)).abs().max() < 1e-4
+        grad_y += d.mm(w.data.t())
+    assert (x.grad.data - grad_y * 2).abs().max() < 1e-4
+
+try:
+    torch._C._set_num_autograd_cpu_threads(2)
+except RuntimeError:
+    pass
+else:
+    raise AssertionError('the number of workers changed after the first backward')
+"""
+        env = dict(os.environ)
+        env.pop('PYTORCH_AUTOGRAD_CPU_THREADS', None)
+        subprocess.check_call([sys.executable, '-c', script], env=env)
+
     def test_cat(self):
         f_args_variable = (Variable(torch.randn(1, S, S), requires_grad=True),
                            Variable(torch.randn(2, S, S), requires_grad=True),
@@ -1703,6 +1746,156 @@ class TestAutograd(TestCase):
             self.assertEqual(info.name, expected_name)
             last_end = info.cpu_interval.end
 
+    def test_profiler_grad_accumulation(self):
+        w = Variable(torch.randn(10, 10), requires_grad=True)
+        x = Variable(torch.randn(10, 10))
+
+        with profile() as p:
+            y = (x * w + x * w * 2).sum()
+            y.backward()
+
+        # both products flow into w through a single buffer, and the summed
+        # gradient is adopted as w.grad
+        self.assertEqual(w.grad.data, x.data * 3)
+        self.assertGreater(p.grad_accumulation['in_place'], 0)
+        self.assertGreater(p.grad_accumulation['stolen'], 0)
+
+        # a second backward sums into the existing .grad
+        with profile() as p:
+            (x * w).sum().backward()
+        self.assertEqual(w.grad.data, x.data * 4)
+        self.assertEqual(p.grad_accumulation['stolen'], 0)
+        self.assertGreater(p.grad_accumulation['in_place'], 0)
+
+    def test_profiler_stream(self):
+        x = Variable(torch.randn(10, 10))
+        tmpdir = tempfile.mkdtemp()
+        try:
+            path = os.path.join(tmpdir, 'trace.json')
+            with torch.autograd.profiler.stream(path, sample_every=2) as s:
+                for i in range(4):
+                    with torch.autograd.profiler.range('iter{}'.format(i)):
+                        y = x * 2 + 4 if i % 2 == 0 else x - 1
+                    torch.autograd.profiler.step()
+            self.assertEqual(s.dropped_events, 0)
+            with open(path) as f:
+                events = json.load(f)
+            # only iterations 0 and 2 are recorded, ranges included
+            names = [e['name'] for e in events if e['ph'] == 'B']
+            self.assertEqual(names, ['iter0', 'mul', 'add', 'iter2', 'mul', 'add'])
+            self.assertEqual(len([e for e in events if e['ph'] == 'E']), 6)
+
+            # ranges are dropped along with their ends, so the trace stays
+            # balanced however small the buffers are
+            for buffer_size in [1, 2, 5]:
+                with torch.autograd.profiler.stream(path, buffer_size=buffer_size) as s:
+                    for _ in range(100):
+                        with torch.autograd.profiler.range('outer'):
+                            y = x * 2 + 4
+                self.assertGreater(s.dropped_events, 0)
+                with open(path) as f:
+                    events = json.load(f)
+                depth = defaultdict(int)
+                for e in events:
+                    if e['ph'] == 'B':
+                        depth[e['tid']] += 1
+                    elif e['ph'] == 'E':
+                        depth[e['tid']] -= 1
+                        self.assertGreaterEqual(depth[e['tid']], 0)
+                self.assertTrue(all(d == 0 for d in depth.values()))
+        finally:
+            shutil.rmtree(tmpdir)
+
+    def test_profiler_shapes(self):
+        x = Variable(torch.randn(10, 20))
+        w = Variable(torch.randn(20, 30))
+
+        with profile(record_shapes=True) as p:
+            for _ in range(2):
+                y = x.mm(w)
+            z = x[:5].mm(w)
+
+        mm = [evt for evt in p.function_events if evt.name == 'mm']
+        self.assertEqual(len(mm), 3)
+        self.assertEqual(mm[0].input_shapes, [[10, 20], [20, 30]])
+        self.assertEqual(mm[0].input_dtypes, ['Float', 'Float'])
+        self.assertEqual(mm[0].flops_total, 2 * 10 * 20 * 30)
+        self.assertEqual(mm[0].bytes_total, (10 * 20 + 20 * 30 + 10 * 30) * 4)
+
+        averages = [evt for evt in p.key_averages(group_by_input_shapes=True) if evt.key == 'mm']
+        self.assertEqual(sorted(evt.count for evt in averages), [1, 2])
+        self.assertIn('GFLOP/s', p.key_averages(group_by_input_shapes=True).table())
+
+        # without grouping, a row mixes calls with different shapes
+        averages = [evt for evt in p.key_averages() if evt.key == 'mm']
+        self.assertEqual(len(averages), 1)
+        self.assertIsNone(averages[0].input_shapes)
+        self.assertIn('GFLOP/s', p.key_averages().table())
+        self.assertNotIn('Input shapes', p.key_averages().table())
+
+        with profile() as p:
+            y = x.mm(w)
+        self.assertIsNone(p.function_events[0].input_shapes)
+        self.assertNotIn('GFLOP/s', p.table())
+
+    def test_checkpoint(self):
+        x = Variable(torch.randn(4, 5), requires_grad=True)
+        w = Variable(torch.randn(5, 5), requires_grad=True)
+
+        def segment(x, w):
+            y = torch.nn.functional.dropout(x.mm(w).tanh(), 0.5, training=True)
+            return (y.exp() * x.sigmoid()).sum(1), y.mul(2)
+
+        def grads(mode=None, path=''):
+            x.grad = w.grad = None
+            torch.manual_seed(0)
+            if mode is None:
+                a, b = segment(x, w)
+            else:
+                a, b = torch._C._checkpoint(segment, (x, w), mode, path)
+            # recomputing must not disturb the random numbers seen afterwards
+            (a.sum() + b.sum()).backward()
+            return x.grad.data.clone(), w.grad.data.clone(), torch.rand(1)
+
+        expected = grads()
+        for mode in ['recompute', 'host', 'file']:
+            for result, exp in zip(grads(mode), expected):
+                self.assertEqual(result, exp)
+
+        tmpdir = tempfile.mkdtemp()
+        try:
+            path = os.path.join(tmpdir, 'saved')
+            for result, exp in zip(grads('file', path), expected):
+                self.assertEqual(result, exp)
+            # the file goes away with the graph
+            self.assertFalse(os.path.exists(path))
+        finally:
+            shutil.rmtree(tmpdir)
+
+        a, b = torch._C._checkpoint(segment, (x, w))
+        a.sum().backward()
+        self.assertRaisesRegex(RuntimeError, 'retain_graph', lambda: a.sum().backward())
+
+    @unittest.skipIf(not torch.cuda.is_available(), "CUDA unavailable")
+    def test_checkpoint_cuda_rng(self):
+        x = Variable(torch.randn(4, 5).cuda(), requires_grad=True)
+
+        def segment(x):
+            return torch.nn.functional.dropout(x, 0.5, training=True).exp(),
+
+        def grads(checkpointed):
+            x.grad = None
+            torch.cuda.manual_seed(0)
+            if checkpointed:
+                y, = torch._C._checkpoint(segment, (x,))
+            else:
+                y, = segment(x)
+            y.sum().backward()
+            return x.grad.data.clone(), torch.cuda.FloatTensor(1).uniform_()
+
+        for result, exp in zip(grads(True), grads(False)):
+            self.assertEqual(result, exp)
+
     def test_dir(self):
         x = Variable(torch.randn(10, 10))
         keys = dir(x)
@@ -2213,6 +2406,14 @@ method_tests = [
     ('det', lambda: random_fullrank_matrix_distinct_singular_value(S), (), 'distinct_postive_s', (), [skipIfNoLapack]),
     ('svd', lambda: random_fullrank_matrix_distinct_singular_value(S), (), '', (), [skipIfNoLapack]),
     ('gesv', (S, S), ((S, S),), '', (), [skipIfNoLapack]),
+    ('fft', (S, M, 2), ()),
+    ('fft', (S, S, 2), (True,), 'normalized_odd'),
+    ('ifft', (S, M, 2), ()),
+    ('ifft', (S, S, 2), (True,), 'normalized_odd'),
+    ('rfft', (S, M), ()),
+    ('rfft', (S, S), (True, False), 'normalized_twosided_odd'),
+    ('irfft', (S, M // 2 + 1, 2), (M,)),
+    ('irfft', (S, S // 2 + 1, 2), (S, True), 'normalized_odd'),
     ('eq', (S, S, S), ((S, S, S),)),
     ('eq', (S, S, S), ((1,),), 'broadcast_rhs'),
     ('eq', (1,), ((S, S, S),), 'broadcast_lhs'),
@@ -376,6 +376,28 @@ class _DistTestBase(object):
             group, group_id, rank, dist.reduce_op.MAX, -1, 10, 10
         )
 
+    def test_all_reduce_sum_large(self):
+        # large enough for the ring algorithm of the TCP backend
+        group, group_id, rank = self._init_global_test()
+        tensor = _build_tensor(70, 2 if rank == 0 else 10)
+        dist.all_reduce(tensor, dist.reduce_op.SUM, group_id)
+        self.assertEqual(tensor, _build_tensor(70, 2 + (10 * (len(group) - 1))))
+        self._barrier()
+
+    def test_all_reduce_bucketed_sum(self):
+        group, group_id, rank = self._init_global_test()
+        value = 2 if rank == 0 else 10
+        tensors = [_build_tensor(size, value) for size in range(1, 10)]
+        tensors.append(torch.DoubleTensor(5, 3).fill_(value))
+        tensors.append(_build_tensor(20, value))
+        dist.all_reduce_bucketed(tensors, dist.reduce_op.SUM, group_id, bucket_size=4096)
+        expected_value = 2 + (10 * (len(group) - 1))
+        for size, tensor in zip(range(1, 10), tensors):
+            self.assertEqual(tensor, _build_tensor(size, expected_value))
+        self.assertEqual(tensors[-2], torch.DoubleTensor(5, 3).fill_(expected_value))
+        self.assertEqual(tensors[-1], _build_tensor(20, expected_value))
+        self._barrier()
+
     def test_all_reduce_group_sum(self):
         group, group_id, rank = self._init_group_test()
         self._test_all_reduce_helper(
@@ -9,7 +9,11 @@ from torch.autograd import Variable, Function
 from torch.autograd.function import traceable
 from common import TestCase, run_tests
 import io
+import os
+import shutil
+import subprocess
 import sys
+import tempfile
 
 try:
     import torchvision
@@ -180,6 +184,122 @@ class TestJit(TestCase):
     def test_run_lstm_fusion_cpu(self):
         self.run_lstm_fusion(False)
 
+    @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
+    def test_fusion_compiler_stats_cpu(self):
+        def f(x, y):
+            return (x * y + y).sigmoid()
+
+        before = torch._C._jit_fusion_compiler_stats()
+        CompiledF = torch.jit.compile(nderivs=0)(f)
+        x = Variable(torch.randn(7, 5).float())
+        y = Variable(torch.randn(7, 5).float())
+        CompiledF(x, y)
+        with self.assertCompiled(CompiledF):
+            CompiledF(x, y)
+        after = torch._C._jit_fusion_compiler_stats()
+        # lookups are only counted when the on-disk cache is enabled
+        lookups = 1 if os.environ.get('PYTORCH_FUSION_CACHE_DIR') else 0
+        self.assertEqual(after['disk_cache_hits'] + after['disk_cache_misses'],
+                         before['disk_cache_hits'] + before['disk_cache_misses'] + lookups)
+        self.assertGreaterEqual(after['compile_seconds'], before['compile_seconds'])
+
+    @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
+    def test_fusion_disk_cache_cpu(self):
+        # the second process compiles g first rather than second, and must
+        # still find the kernel the first one stored
+        script = """
+import sys
+import torch
+from torch.autograd import Variable
+
+def f(x, y):
+    return (x + y).tanh()
+
+def g(x, y):
+    return (x * y + y).sigmoid()
+
+x = Variable(torch.randn(7, 5).float())
+y = Variable(torch.randn(7, 5).float())
+if sys.argv[1] == 'both':
+    torch.jit.compile(nderivs=0)(f)(x, y)
+before = torch._C._jit_fusion_compiler_stats()
+torch.jit.compile(nderivs=0)(g)(x, y)
+after = torch._C._jit_fusion_compiler_stats()
+print(after['disk_cache_hits'] - before['disk_cache_hits'],
+      after['disk_cache_misses'] - before['disk_cache_misses'])
+"""
+        tmpdir = tempfile.mkdtemp()
+        try:
+            env = dict(os.environ, PYTORCH_FUSION_CACHE_DIR=tmpdir)
+            env.pop('PYTORCH_FUSION_ASYNC', None)
+            lookups = [subprocess.check_output([sys.executable, '-c', script, arg], env=env).split()
+                       for arg in ['both', 'g']]
+            self.assertEqual([[int(n) for n in counts] for counts in lookups], [[0, 1], [1, 0]])
+        finally:
+            shutil.rmtree(tmpdir)
+
+    @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
+    def test_run_fusion_contiguity_cpu(self):
+        def f(x, y):
+            return torch.sigmoid(x * y + x).tanh()
+
+        CompiledF = torch.jit.compile(nderivs=0)(f)
+
+        # contiguous inputs use a specialized kernel, transposed ones fall
+        # back to the strided one
+        for transpose in [False, True]:
+            x = Variable(torch.randn(16, 8).float())
+            y = Variable(torch.randn(16, 8).float())
+            if transpose:
+                x, y = x.t(), y.t()
+            z = CompiledF(x, y)
+            with self.assertCompiled(CompiledF):
+                z2 = CompiledF(x, y)
+            self.assertEqual(z, f(x, y))
+            self.assertEqual(z, z2)
+
+    @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
+    def test_async_fusion_cpu(self):
+        # The fuser is configured once per process, so this runs in a child
+        # with a compiler that takes a while. Until the kernel is ready, the
+        # fusion group has to be run by the interpreter.
+        script = """
+import time
+import torch
+from torch.autograd import Variable
+
+def f(x, y):
+    return (x * y + y).sigmoid()
+
+def run():
+    with torch.autograd.profiler.profile() as prof:
+        z = CompiledF(x, y)
+    assert (z - f(x, y)).data.abs().max() < 1e-5
+    return [e.name for e in prof.function_events]
+
+CompiledF = torch.jit.compile(nderivs=0)(f)
+x = Variable(torch.randn(7, 5).float())
+y = Variable(torch.randn(7, 5).float())
+CompiledF(x, y)
+assert 'FusionGroup (unfused)' in run()
+deadline = time.time() + 60
+while 'FusionGroup' not in run():
+    assert time.time() < deadline, 'the fusion group was never compiled'
+    time.sleep(0.1)
+"""
+        tmpdir = tempfile.mkdtemp()
+        try:
+            cxx = os.path.join(tmpdir, 'slow-cxx')
+            with open(cxx, 'w') as f:
+                f.write('#!/bin/sh\nsleep 2\nexec "${REAL_CXX}" "$@"\n')
+            os.chmod(cxx, 0o755)
+            env = dict(os.environ, PYTORCH_FUSION_ASYNC='1', CXX=cxx,
+                       REAL_CXX=os.environ.get('CXX', 'g++'))
+            env.pop('PYTORCH_FUSION_CACHE_DIR', None)
+            subprocess.check_call([sys.executable, '-c', script], env=env)
+        finally:
+            shutil.rmtree(tmpdir)
+
     @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
     @unittest.skipIf(not RUN_CUDA, "fuser requires CUDA")
     def test_run_lstm_fusion_concat(self):
@@ -1324,6 +1324,40 @@ class TestNN(NNTestCase):
     def test_batchnorm_eval_cuda(self):
         self._test_batchnorm_eval(torch.cuda.FloatTensor)
 
+    def test_channels_last_cpu(self):
+        def channels_last(t):
+            return t.permute(0, 2, 3, 1).contiguous().permute(0, 3, 1, 2)
+
+        modules = [
+            nn.Conv2d(3, 8, 3, padding=1),
+            nn.Conv2d(3, 8, 1, bias=False),
+            nn.MaxPool2d(3, stride=2, padding=1),
+            nn.AvgPool2d(2),
+            nn.BatchNorm2d(3),
+            nn.BatchNorm2d(3).eval(),
+            nn.ReLU(),
+        ]
+        for module in modules:
+            input = torch.randn(2, 3, 7, 9)
+            input_nhwc = channels_last(input)
+            self.assertFalse(input_nhwc.is_contiguous())
+            module_nhwc = deepcopy(module)
+
+            x = Variable(input, requires_grad=True)
+            x_nhwc = Variable(input_nhwc, requires_grad=True)
+            output = module(x)
+            output_nhwc = module_nhwc(x_nhwc)
+            self.assertEqual(output.data, output_nhwc.data)
+
+            grad_output = torch.randn(output.size())
+            output.backward(grad_output)
+            output_nhwc.backward(grad_output)
+            self.assertEqual(x.grad.data, x_nhwc.grad.data)
+            for param, param_nhwc in zip(module.parameters(), module_nhwc.parameters()):
+                self.assertEqual(param.grad.data, param_nhwc.grad.data)
+            for buf, buf_nhwc in zip(module._all_buffers(), module_nhwc._all_buffers()):
+                self.assertEqual(buf, buf_nhwc)
+
     def test_MaxPool1d_indices(self):
         self._test_maxpool_indices(1)
 
@@ -2101,13 +2135,50 @@ class TestNN(NNTestCase):
             self.assertEqual(m.weight.grad.data,
                              torch.cat([m1.weight.grad.data, m2.weight.grad.data], 0))
 
+    def test_Conv2d_fast_paths(self):
+        # 3x3 stride 1 convolutions with enough planes go through Winograd and
+        # 1x1 convolutions skip the unfold; check both against a plain sum of
+        # shifted matrix products
+        def reference(input, weight, bias, padding):
+            if padding:
+                input = F.pad(input, (padding, padding, padding, padding))
+            n, c, h, w = input.size()
+            k, _, kh, kw = weight.size()
+            oh, ow = h - kh + 1, w - kw + 1
+            output = bias.view(1, k, 1)
+            for i in range(kh):
+                for j in range(kw):
+                    window = input[:, :, i:i + oh, j:j + ow].contiguous().view(n, c, -1)
+                    output = output + torch.matmul(weight[:, :, i, j], window)
+            return output.view(n, k, oh, ow)
+
+        for tp, prec in [(torch.FloatTensor, 1e-4), (torch.DoubleTensor, 1e-10)]:
+            for size, kernel_size, padding in [(5, 3, 1), (13, 3, 1), (11, 3, 0), (7, 1, 0)]:
+                m = nn.Conv2d(16, 12, kernel_size, padding=padding).type(tp)
+                i = Variable(torch.randn(2, 16, size, size + 1).type(tp), requires_grad=True)
+                output = m(i)
+
+                weight = Variable(m.weight.data.clone(), requires_grad=True)
+                bias = Variable(m.bias.data.clone())
+                i2 = Variable(i.data.clone(), requires_grad=True)
+                expected = reference(i2, weight, bias, padding)
+                self.assertEqual(output, expected, prec=prec)
+
+                grad_output = torch.randn(output.size()).type(tp)
+                output.backward(grad_output)
+                expected.backward(grad_output)
+                self.assertEqual(i.grad, i2.grad, prec=prec)
+                self.assertEqual(m.weight.grad, weight.grad, prec=prec)
+
     # Very similar to test_Conv2d_naive_groups but with special care to handle
     # the number of groups == number of input channels
-    @unittest.skipIf(not TEST_CUDA, 'CUDA not available')
     def test_Conv2d_depthwise_naive_groups(self):
-        types = [torch.cuda.FloatTensor, torch.cuda.DoubleTensor,
-                 torch.cuda.HalfTensor]
-        precs = [1e-5, 1e-5, 1e-2]
+        types = [torch.FloatTensor, torch.DoubleTensor]
+        precs = [1e-5, 1e-5]
+        if TEST_CUDA:
+            types += [torch.cuda.FloatTensor, torch.cuda.DoubleTensor,
+                      torch.cuda.HalfTensor]
+            precs += [1e-5, 1e-5, 1e-2]
         for tp, prec in zip(types, precs):
             for depth_multiplier in [1, 2]:
                 m = nn.Conv2d(2, 2 * depth_multiplier, kernel_size=3, groups=2).type(tp)
@@ -2350,6 +2421,102 @@ class TestNN(NNTestCase):
 
             (hx + cx).sum().backward()
 
+    def test_rnn_cell_fused_cpu(self):
+        # the CPU cells use the fused THNN kernels, compare them, and their
+        # backward, against the same cells written with autograd ops
+        from torch.nn._functions.thnn import rnnFusedPointwise as fusedBackend
+
+        def lstm_ref(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
+            hx, cx = hidden
+            gates = F.linear(input, w_ih, b_ih) + F.linear(hx, w_hh, b_hh)
+            ingate, forgetgate, cellgate, outgate = gates.chunk(4, 1)
+            cy = F.sigmoid(forgetgate) * cx + F.sigmoid(ingate) * F.tanh(cellgate)
+            return F.sigmoid(outgate) * F.tanh(cy), cy
+
+        def lstm_fused(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
+            igates = F.linear(input, w_ih)
+            hgates = F.linear(hidden[0], w_hh)
+            if b_ih is None:
+                return fusedBackend.LSTMFused.apply(igates, hgates, hidden[1])
+            return fusedBackend.LSTMFused.apply(igates, hgates, hidden[1], b_ih, b_hh)
+
+        def gru_ref(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
+            i_r, i_i, i_n = F.linear(input, w_ih, b_ih).chunk(3, 1)
+            h_r, h_i, h_n = F.linear(hidden, w_hh, b_hh).chunk(3, 1)
+            resetgate = F.sigmoid(i_r + h_r)
+            inputgate = F.sigmoid(i_i + h_i)
+            newgate = F.tanh(i_n + resetgate * h_n)
+            return newgate + inputgate * (hidden - newgate)
+
+        def gru_fused(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
+            gi = F.linear(input, w_ih)
+            gh = F.linear(hidden, w_hh)
+            if b_ih is None:
+                return fusedBackend.GRUFused.apply(gi, gh, hidden)
+            return fusedBackend.GRUFused.apply(gi, gh, hidden, b_ih, b_hh)
+
+        for module, ref, fused in ((nn.LSTMCell, lstm_ref, lstm_fused), (nn.GRUCell, gru_ref, gru_fused)):
+            for bias in (True, False):
+                cell = module(10, 20, bias=bias).double()
+                input = Variable(torch.randn(3, 10).double(), requires_grad=True)
+                hx = Variable(torch.randn(3, 20).double(), requires_grad=True)
+                if module is nn.LSTMCell:
+                    cx = Variable(torch.randn(3, 20).double(), requires_grad=True)
+                    hx = (hx, cx)
+                    inputs = (input,) + hx
+                else:
+                    inputs = (input, hx)
+                inputs = inputs + tuple(cell.parameters())
+
+                out_cell = cell(input, hx)
+                out = fused(input, hx, *cell.parameters())
+                out_ref = ref(input, hx, *cell.parameters())
+                if module is nn.LSTMCell:
+                    out_cell = out_cell[0] + out_cell[1] * 2
+                    out = out[0] + out[1] * 2
+                    out_ref = out_ref[0] + out_ref[1] * 2
+                self.assertEqual(out_cell, out_ref)
+                self.assertEqual(out, out_ref)
+
+                grad = torch.randn(3, 20).double()
+                grads = torch.autograd.grad(out, inputs, grad)
+                grads_cell = torch.autograd.grad(out_cell, inputs, grad)
+                grads_ref = torch.autograd.grad(out_ref, inputs, grad)
+                for g, g_cell, g_ref in zip(grads, grads_cell, grads_ref):
+                    self.assertEqual(g, g_ref)
+                    self.assertEqual(g_cell, g_ref)
+
+                def func(input, *args):
+                    if module is nn.LSTMCell:
+                        hy, cy = fused(input, args[:2], *args[2:])
+                        return hy + cy * 2
+                    return fused(input, args[0], *args[1:])
+                self.assertTrue(gradcheck(func, inputs))
+
+    def test_rnn_cell_gradgrad_cpu(self):
+        # the fused cells differentiate with autograd ops when the backward
+        # records a graph, so they support double backward
+        for module in (nn.LSTMCell, nn.GRUCell):
+            for bias in (True, False):
+                cell = module(3, 4, bias=bias).double()
+                input = Variable(torch.randn(2, 3).double(), requires_grad=True)
+                hx = Variable(torch.randn(2, 4).double(), requires_grad=True)
+                if module is nn.LSTMCell:
+                    cx = Variable(torch.randn(2, 4).double(), requires_grad=True)
+                    inputs = (input, hx, cx)
+
+                    def func(input, hx, cx, *params):
+                        hy, cy = cell(input, (hx, cx))
+                        return hy + cy * 2
+                else:
+                    inputs = (input, hx)
+
+                    def func(input, hx, *params):
+                        return cell(input, hx)
+                inputs = inputs + tuple(cell.parameters())
+                self.assertTrue(gradcheck(func, inputs))
+                self.assertTrue(gradgradcheck(func, inputs))
+
     @unittest.skipIf(not TEST_CUDNN, 'CUDNN not available')
     def test_cudnn_weight_format(self):
         rnns = [
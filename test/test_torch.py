@@ -390,6 +390,79 @@ class TestTorch(TestCase):
     def test_dim_reduction(self):
         self._test_dim_reduction(self, lambda t: t)
 
+    def test_dim_reduction_strided(self):
+        # contiguous, transposed and sliced inputs, with reduced slices long
+        # enough to be split into pieces. The expected values come from
+        # cumsum and sort, which don't go through the reduction code.
+        def total(t, dim):
+            return t.cumsum(dim).select(dim, -1)
+
+        x = torch.randn(70000, 3).double()
+        for t in (x, x.t().contiguous(), x.t(), x[::2], x[:, 1:]):
+            for dim in range(t.dim()):
+                ref = t.contiguous()
+                n = ref.size(dim)
+                mean = (total(ref, dim) / n).unsqueeze(dim)
+                var = total((ref - mean.expand_as(ref)) ** 2, dim) / (n - 1)
+                self.assertEqual(t.sum(dim), total(ref, dim), 1e-8)
+                self.assertEqual(t.var(dim), var, 1e-8)
+                self.assertEqual(t.std(dim, unbiased=False), (var * (n - 1) / n).sqrt(), 1e-8)
+                self.assertEqual(t.norm(2, dim), total(ref * ref, dim).sqrt(), 1e-8)
+                self.assertEqual(t.norm(1, dim), total(ref.abs(), dim), 1e-8)
+                self.assertEqual(t.norm(3, dim), total(ref.abs() ** 3, dim) ** (1. / 3), 1e-8)
+                values, indices = t.max(dim)
+                self.assertEqual(values, ref.gather(dim, indices.unsqueeze(dim)).squeeze(dim))
+                self.assertEqual(values, ref.sort(dim)[0].select(dim, -1))
+                values, indices = t.min(dim)
+                self.assertEqual(values, ref.gather(dim, indices.unsqueeze(dim)).squeeze(dim))
+                self.assertEqual(values, ref.sort(dim)[0].select(dim, 0))
+
+        # a slice with NaNs and a slice of only -inf, both split into pieces;
+        # max and min give the first NaN
+        x = torch.randn(3, 70000).double()
+        x[0, 50000] = float('nan')
+        x[0, 40000] = float('nan')
+        x[1].fill_(-float('inf'))
+        for t, dim in ((x, 1), (x.t().contiguous(), 0), (x.t(), 0)):
+            for values, indices in (t.max(dim), t.min(dim)):
+                self.assertTrue(math.isnan(values[0]))
+                self.assertEqual(indices[0], 40000)
+                self.assertEqual(values[1], -float('inf'))
+                self.assertEqual(indices[1], 0)
+            sums = t.sum(dim)
+            self.assertTrue(math.isnan(sums[0]))
+            self.assertEqual(sums[1], -float('inf'))
+            self.assertEqual(sums[2], x[2].cumsum(0)[-1], 1e-8)
+
+        # ties go to the first index
+        x = torch.Tensor(5, 100000).fill_(1)
+        self.assertEqual(x.max(1)[1], torch.LongTensor(5).zero_())
+        self.assertEqual(x.t().min(0)[1], torch.LongTensor(5).zero_())
+
+    def test_pointwise_strided(self):
+        # the larger size is enough work to run in parallel
+        for size in ((3, 5), (300, 700)):
+            x = torch.randn(*size).double()
+            y = torch.randn(*size).double()
+            inputs = [
+                (torch.randn(size[1], size[0]).double().t(), y),
+                (torch.randn(size[0], 3 * size[1]).double()[:, ::3], y.t().contiguous().t()),
+                (torch.randn(size[0], 6, size[1]).double()[:, 2],
+                 torch.randn(size[1], 6, size[0]).double()[:, 1].t()),
+                (torch.randn(size[1]).double().expand(*size), x),
+            ]
+            for a, b in inputs:
+                ac, bc = a.contiguous(), b.contiguous()
+                self.assertEqual(a + 2, ac + 2)
+                self.assertEqual(a * b, ac * bc)
+                self.assertEqual(a / b, ac / bc)
+                self.assertEqual(a.exp(), ac.exp())
+                self.assertEqual(a.abs().pow(2.5), ac.abs().pow(2.5))
+                self.assertEqual(torch.atan2(a, b), torch.atan2(ac, bc))
+                self.assertEqual(a.addcmul(0.5, a, b), ac.addcmul(0.5, ac, bc))
+                self.assertEqual(b.clone().t().copy_(a.t()).t(), ac)
+                self.assertEqual(b.clone().t().exp_().t(), bc.exp())
+
     def _testCSelection(self, torchfn, mathfn):
         # Two tensors
         size = (100, 100)
@@ -681,6 +754,66 @@ class TestTorch(TestCase):
         res2 = matrixmultiply(mat1, mat2)
         self.assertEqual(res, res2)
 
+        # integer types, large enough to span several blocks of the
+        # fallback gemm
+        n, m, p = 150, 300, 270
+        mat1 = torch.randn(n, m).mul(2).floor()
+        mat2 = torch.randn(m, p).mul(2).floor()
+        expected = torch.mm(mat1.double(), mat2.double())
+        for t in (torch.ShortTensor, torch.IntTensor, torch.LongTensor):
+            for m1, m2 in ((mat1, mat2), (mat1.t().contiguous().t(), mat2.t().contiguous().t())):
+                res = torch.mm(m1.type(t), m2.type(t))
+                self.assertEqual(res.double(), expected, 0)
+                res = torch.addmm(2, torch.ones(n, p).type(t), 3, m1.type(t), m2.type(t))
+                self.assertEqual(res.double(), expected * 3 + 2, 0)
+
+    def test_quantized_linear_conv2d(self):
+        Variable = torch.autograd.Variable
+        ops = torch._C._VariableBase
+
+        # round trip error is at most half a quantization step
+        x = torch.randn(7, 33)
+        q = torch.quantize_linear(Variable(x), 0.05, 3)
+        self.assertEqual(q.data.type(), 'torch.CharTensor')
+        self.assertEqual(torch.dequantize_linear(q, 0.05, 3).data, x, 0.025 + 1e-6)
+
+        # values far out of range, including infinities, saturate
+        x = torch.Tensor([-1e30, -float('inf'), -1000, 1000, float('inf'), 1e30])
+        q = torch.quantize_linear(Variable(x), 0.05, 3).data
+        self.assertEqual(q, torch.CharTensor([-128, -128, -128, 127, 127, 127]))
+
+        # weights are quantized symmetrically per output channel
+        w = torch.randn(16, 40)
+        ws = w.abs().max(1)[0] / 127
+        qw = torch.quantize_linear_per_channel(Variable(w), Variable(ws), Variable(torch.zeros(16).long()), 0)
+        dw = torch.dequantize_linear_per_channel(qw, Variable(ws), Variable(torch.zeros(16).long()), 0).data
+        self.assertLessEqual(((dw - w).abs() - ws.unsqueeze(1) / 2).max(), 1e-6)
+
+        for bias in (None, torch.randn(16)):
+            x = torch.randn(13, 40)
+            expected = x.mm(w.t())
+            if bias is None:
+                res = ops.quantized_linear(Variable(x), qw, Variable(ws)).data
+            else:
+                expected += bias.unsqueeze(0).expand_as(expected)
+                res = ops.quantized_linear(Variable(x), qw, Variable(ws), Variable(bias)).data
+            self.assertLessEqual((res - expected).abs().max(), 0.05 * expected.abs().max())
+        self.assertEqual(ops.quantized_linear(Variable(torch.Tensor()), qw, Variable(ws)).data.numel(), 0)
+
+        x = torch.randn(2, 3, 11, 9)
+        w = torch.randn(5, 3, 3, 3)
+        ws = w.view(5, -1).abs().max(1)[0] / 127
+        qw = torch.quantize_linear_per_channel(Variable(w), Variable(ws), Variable(torch.zeros(5).long()), 0)
+        for bias in (None, torch.randn(5)):
+            if bias is None:
+                res = ops.quantized_conv2d(Variable(x), qw, Variable(ws), (2, 1), (1, 1)).data
+                expected = torch.nn.functional.conv2d(Variable(x), Variable(w), None, (2, 1), (1, 1)).data
+            else:
+                res = ops.quantized_conv2d(Variable(x), qw, Variable(ws), (2, 1), (1, 1), Variable(bias)).data
+                expected = torch.nn.functional.conv2d(Variable(x), Variable(w), Variable(bias), (2, 1), (1, 1)).data
+            self.assertEqual(res.size(), expected.size())
+            self.assertLessEqual((res - expected).abs().max(), 0.05 * expected.abs().max())
+
     @staticmethod
     def _test_btrifact(self, cast):
         a = torch.FloatTensor((((1.3722, -0.9020),
@@ -1772,6 +1905,32 @@ class TestTorch(TestCase):
         # Make sure True isn't mistakenly taken as the 2nd dimension (interpreted as 1)
         self.assertRaises(TypeError, lambda: q.topk(4, True))
 
+    def test_sort_topk_large(self):
+        # large slices go through the parallel sort and the heap based topk
+        x = torch.randn(300000)
+        ref = sorted(x.tolist())
+        for dir in (True, False):
+            res, ind = x.sort(0, dir)
+            self.assertEqual(res.tolist(), ref[::-1] if dir else ref, 0)
+            self.assertEqual(x.index_select(0, ind), res, 0)
+
+            for k in (1, 7, 1000, 50000):
+                val, ind = x.topk(k, 0, dir, True)
+                self.assertEqual(val.tolist(), ref[::-1][:k] if dir else ref[:k], 0)
+                self.assertEqual(x.index_select(0, ind), val, 0)
+                val, ind = x.topk(k, 0, dir, False)
+                self.assertEqual(val.sort(0, dir)[0].tolist(), ref[::-1][:k] if dir else ref[:k], 0)
+
+        # many slices of a non-contiguous tensor
+        x = torch.randn(2000, 100).t()
+        res, ind = x.sort(1)
+        self.assertIsOrdered('ascending', x, res, ind, 'large non-contiguous')
+        val, ind = x.topk(10, 1)
+        self.assertEqual(val, res.index_select(1, torch.arange(1999, 1989, -1).long()), 0)
+        val, ind = x.kthvalue(1000, 1, False)
+        self.assertEqual(val, res[:, 999], 0)
+        self.assertEqual(x.gather(1, ind.unsqueeze(1)).squeeze(1), val, 0)
+
     def test_kthvalue(self):
         SIZE = 50
         x = torch.rand(SIZE, SIZE, SIZE)
@@ -2696,6 +2855,46 @@ class TestTorch(TestCase):
     def test_stft(self):
         self._test_stft(self, lambda x: x)
 
+    def test_fft_ifft_rfft_irfft(self):
+        Variable = torch.autograd.Variable
+
+        def naive_dft(x, inverse=False):
+            n = x.size(-2)
+            k = torch.arange(0, n).double()
+            angles = torch.ger(k, k).mul_((2 if inverse else -2) * math.pi / n)
+            re, im = x.select(-1, 0), x.select(-1, 1)
+            cos, sin = angles.cos(), angles.sin()
+            out_re = re.matmul(cos) - im.matmul(sin)
+            out_im = re.matmul(sin) + im.matmul(cos)
+            return torch.stack([out_re, out_im], -1)
+
+        # power of two sizes use radix-4/2 passes, all others Bluestein
+        for n in [1, 2, 3, 5, 8, 12, 16, 64, 100]:
+            x = torch.randn(3, n, 2).double()
+            ref = naive_dft(x)
+            result = Variable(x).fft().data
+            self.assertEqual(result, ref, 1e-8, 'fft result')
+            self.assertEqual(Variable(x).fft(True).data, ref / math.sqrt(n), 1e-8, 'normalized fft result')
+            self.assertEqual(Variable(x).ifft().data, naive_dft(x, inverse=True) / n, 1e-8, 'ifft result')
+            self.assertEqual(Variable(result).ifft().data, x, 1e-8, 'fft round trip')
+
+            real = torch.randn(3, n).double()
+            ref = naive_dft(torch.stack([real, torch.zeros(3, n).double()], -1))
+            onesided = Variable(real).rfft().data
+            self.assertEqual(onesided, ref[:, :n // 2 + 1], 1e-8, 'rfft result')
+            self.assertEqual(Variable(real).rfft(False, False).data, ref, 1e-8, 'twosided rfft result')
+            self.assertEqual(Variable(onesided).irfft(n).data, real, 1e-8, 'irfft result')
+
+        # onesided only applies to real input
+        for n in [5, 8]:
+            x = Variable(torch.randn(3, n, 2).double())
+            self.assertEqual(x._fft_with_size(True, True, False, n, False, True).data, x.fft().data, 0)
+
+        x = Variable(torch.randn(3, 5, 2))
+        self.assertRaises(RuntimeError, lambda: x.irfft(5))
+        self.assertRaises(RuntimeError, lambda: Variable(torch.randn(3, 5, 3)).fft())
+        self.assertRaises(RuntimeError, lambda: Variable(torch.LongTensor(3, 5)).rfft())
+
     @unittest.skip("Not implemented yet")
     def test_conv2(self):
         x = torch.rand(math.floor(torch.uniform(50, 100)), math.floor(torch.uniform(50, 100)))
@@ -2893,6 +3092,61 @@ class TestTorch(TestCase):
         self.assertEqual(x, y)
         torch.set_rng_state(rng_state)
 
+    def test_legacy_rng_state(self):
+        # states saved before the engines were added hold only the MT19937
+        # fields, which are 8 * (3 + 624 + 3) + 4 bytes padded to 8 on 64-bit
+        legacy_size = 5048
+        torch.randn(1)
+        state = torch.get_rng_state()
+        x = torch.randn(101)
+        torch.set_rng_state(state[:legacy_size].clone())
+        self.assertEqual(torch.randn(101), x, 0)
+        self.assertRaises(RuntimeError, lambda: torch.set_rng_state(state[:legacy_size - 1].clone()))
+
+    def test_philox_engine(self):
+        gen = torch.Generator()
+        self.assertEqual(gen.engine(), 'mt19937')
+        gen.set_engine('philox')
+        self.assertEqual(gen.engine(), 'philox')
+        self.assertRaises(RuntimeError, lambda: gen.set_engine('unknown'))
+
+        def sample():
+            return [torch.FloatTensor(100001).uniform_(generator=gen),
+                    torch.DoubleTensor(100001).normal_(generator=gen),
+                    torch.FloatTensor(100001).bernoulli_(0.3, generator=gen),
+                    torch.LongTensor(100001).random_(5, 10, generator=gen),
+                    torch.FloatTensor(1000, 2).select(1, 0).uniform_(generator=gen)]
+
+        num_threads = torch.get_num_threads()
+        try:
+            gen.manual_seed(123)
+            expected = sample()
+            for threads in [1, 2]:
+                torch.set_num_threads(threads)
+                gen.manual_seed(123)
+                for x, y in zip(sample(), expected):
+                    self.assertEqual(x, y, 0)
+        finally:
+            torch.set_num_threads(num_threads)
+
+        uniform, normal, bernoulli, random, strided = expected
+        self.assertTrue(0 <= uniform.min() and uniform.max() < 1)
+        self.assertLess(abs(normal.mean()), 0.02)
+        self.assertLess(abs(normal.std() - 1), 0.02)
+        self.assertLess(abs(bernoulli.mean() - 0.3), 0.01)
+        self.assertTrue(5 <= random.min() and random.max() < 10)
+
+        # bernoulli never draws 1 for p=0 nor 0 for p=1
+        self.assertEqual(torch.FloatTensor(100001).bernoulli_(0, generator=gen).max(), 0)
+        self.assertEqual(torch.FloatTensor(100001).bernoulli_(1, generator=gen).min(), 1)
+
+        # the state can be saved and restored like the default engine's
+        state = gen.get_state()
+        x = torch.randn(1000, generator=gen)
+        gen.set_state(state)
+        self.assertEqual(gen.engine(), 'philox')
+        self.assertEqual(torch.randn(1000, generator=gen), x, 0)
+
     @skipIfNoLapack
     def test_cholesky(self):
         x = torch.rand(10, 10) + 1e-1
@@ -3002,6 +3256,28 @@ class TestTorch(TestCase):
                 for uplo in (None, True, False):
                     checkPsdCholesky(a, uplo, inplace)
 
+    def test_cpu_caching_allocator(self):
+        enabled = torch._C._get_cpu_caching_allocator_enabled()
+        torch._C._set_cpu_caching_allocator_enabled(True)
+        try:
+            x = torch.randn(1000, 100)
+            expected = x * 2
+            data_ptr = x.data_ptr()
+            del x
+            stats = torch._C._cpu_caching_allocator_stats()
+            self.assertGreaterEqual(stats['bytes_cached'], 400000)
+            y = torch.randn(1000, 100)
+            self.assertEqual(y.data_ptr(), data_ptr)
+            self.assertEqual(y.data_ptr() % 64, 0)
+            self.assertGreater(torch._C._cpu_caching_allocator_stats()['hits'], stats['hits'])
+            y.copy_(expected / 2)
+            self.assertEqual(y * 2, expected)
+            del y
+            torch._C._cpu_caching_allocator_trim()
+            self.assertEqual(torch._C._cpu_caching_allocator_stats()['bytes_cached'], 0)
+        finally:
+            torch._C._set_cpu_caching_allocator_enabled(enabled)
+
     def test_numel(self):
         b = torch.ByteTensor(3, 100, 100)
         self.assertEqual(b.nelement(), 3 * 100 * 100)
@@ -4512,6 +4788,24 @@ class TestTorch(TestCase):
             xh2 = torch.load(f)
             self.assertEqual(xh.float(), xh2.float())
 
+    def test_half_tensor_math(self):
+        x = torch.randn(300, 7)
+        y = torch.randn(300, 7)
+        xh, yh = x.half(), y.half()
+        xf, yf = xh.float(), yh.float()
+
+        self.assertEqual((xh + yh).float(), (xf + yf).half().float(), 0)
+        self.assertEqual((xh - yh).float(), (xf - yf).half().float(), 0)
+        self.assertEqual((xh * yh).float(), (xf * yf).half().float(), 0)
+        self.assertEqual((xh * 2.5).float(), (xf * 2.5).half().float(), 0)
+        self.assertEqual(xh.sum(), xf.sum(), 1e-1)
+        self.assertEqual(xh.sum(1).float(), xf.sum(1).half().float(), 0)
+        self.assertEqual(xh.view(-1).dot(yh.view(-1)), xf.view(-1).dot(yf.view(-1)), 1e-1)
+
+        z = torch.HalfTensor(5, 5).zero_()
+        z.t()[1].fill_(2)
+        self.assertEqual(z.float().sum(), 10)
+
     @unittest.skipIf(not torch.cuda.is_available(), 'no CUDA')
     def test_half_tensor_cuda(self):
         x = torch.randn(5, 5).half()
@@ -4653,8 +4947,6 @@ class TestTorch(TestCase):
 
     def test_print(self):
         for t in torch._tensor_classes:
-            if t == torch.HalfTensor:
-                continue  # HalfTensor does not support fill
             if t in torch.sparse._sparse_tensor_classes:
                 continue
             if t.is_cuda and not torch.cuda.is_available():
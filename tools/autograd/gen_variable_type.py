@@ -148,6 +148,7 @@ ${no_zero_dim}
 ${version_counter}
 ${set_flags}
 ${record_trace}
+${record_shapes}
 ${save_outputs}
 return ${return_value};
 """)
@@ -156,6 +157,7 @@ METHOD_DEFINITION_BODY_VIA_TYPE = CodeTemplate("""\
 profiler::RecordFunction profiler("${name}");
 auto ret = Type::${method_prefix_derived}${api_name}(${args});
 ${record_trace}
+${record_shapes}
 return ${return_value};
 """)
 
@@ -174,6 +176,12 @@ if (jit::tracer::isTracing( ${tensor_args} )) {
 }
 """)
 
+RECORD_SHAPES = CodeTemplate("""\
+if (profiler.recordsShapes()) {
+  profiler.recordShapes( ${trace_inputs}, ${trace_outputs} );
+}
+""")
+
 RECORD_ATTRIBUTE = CodeTemplate("""\
 setattr(n, jit::stringToSymbol("${name}"), ${name});""")
 
@@ -572,7 +580,7 @@ def create_autograd_functions(top_env, autogen_functions):
             name = arg['name']
             if arg['type'] == 'Tensor' or (arg['type'] == 'Scalar' and is_output):
                 saved_variables.append('SavedVariable {}_;'.format(name))
-                release_variables.append('{}_.data.reset();'.format(name))
+                release_variables.append('{}_.reset_data();'.format(name))
                 ptr = 'shared_from_this()' if is_output else ''
                 unpack.append('auto {} = {}_.unpack({});'.format(name, name, ptr))
             elif arg['type'] == 'IntList':
@@ -786,6 +794,21 @@ def create_variable_type(top_env, aten_declarations):
             trace_outs = ['ret']
         return CodeTemplate("{ ${outs} }").substitute(outs=trace_outs)
 
+    def get_trace_inputs(env, declaration):
+        arguments = declaration['arguments']
+        tensor_args = [arg for arg in arguments if arg['simple_type'] in {'Tensor', 'TensorList'}]
+        if any(arg['simple_type'] == 'TensorList' for arg in tensor_args):
+            # Allocate a temporary vector with flatten and pass it in
+            return CodeTemplate("flatten( $tensor_args )").substitute(env)
+        else:
+            return CodeTemplate("{ ${tensor_args} }").substitute(env)
+
+    def emit_record_shapes(env, declaration):
+        # Only evaluated while the profiler records shapes, so building the
+        # input and output lists doesn't cost anything otherwise.
+        return RECORD_SHAPES.substitute(trace_inputs=get_trace_inputs(env, declaration),
+                                        trace_outputs=env['trace_outputs'])
+
     def emit_record_trace(env, declaration):
 
         # Operations involving Generator and Storage are not traceable
@@ -817,14 +840,7 @@ def create_variable_type(top_env, aten_declarations):
         # complicated, and is taught how to handle this situation.
 
         local = {}
-
-        arguments = declaration['arguments']
-        tensor_args = [arg for arg in arguments if arg['simple_type'] in {'Tensor', 'TensorList'}]
-        if any(arg['simple_type'] == 'TensorList' for arg in tensor_args):
-            # Allocate a temporary vector with flatten and pass it in
-            local['trace_inputs'] = CodeTemplate("flatten( $tensor_args )").substitute(env)
-        else:
-            local['trace_inputs'] = CodeTemplate("{ ${tensor_args} }").substitute(env)
+        local['trace_inputs'] = get_trace_inputs(env, declaration)
 
         local['record_attributes'] = []
         for arg in declaration['arguments']:
@@ -878,6 +894,7 @@ def create_variable_type(top_env, aten_declarations):
             env['trace_outputs'] = get_trace_outputs(declaration)
 
         env['record_trace'] = emit_record_trace(env, declaration)
+        env['record_shapes'] = emit_record_shapes(env, declaration)
 
         body.extend(METHOD_DEFINITION_BODY_VIA_TYPE.substitute(combined).split('\n'))
         return body
@@ -938,6 +955,7 @@ def create_variable_type(top_env, aten_declarations):
             env['trace_outputs'] = get_trace_outputs(declaration)
 
         env['record_trace'] = emit_record_trace(env, declaration)
+        env['record_shapes'] = emit_record_shapes(env, declaration)
 
         func = declaration.get('derivative')
 
@@ -625,6 +625,38 @@ Tensor _det_with_svd_backward(const std::vector<torch::autograd::Variable> &grad
   return svd_term + u.mm(sigma.pow(-1).mul_(det.mul(det_grad)).diag()).mm(v.transpose(0, 1));
 }
 
+// The unnormalized DFT matrix F is symmetric and F^H is the unnormalized
+// inverse DFT, so the gradient of a transform is the opposite transform with
+// the opposite scaling. Real-to-complex transforms drop the imaginary part of
+// the gradient (and zero-pad the one-sided gradient). Complex-to-real
+// transforms use each value k of the one-sided input for both k and n - k, so
+// their gradient is counted twice, except for the zero and Nyquist frequencies.
+Tensor fft_backward(const Tensor& grad, bool complex_input, bool complex_output,
+                    bool inverse, int64_t signal_size, bool normalized, bool onesided) {
+  int64_t n = signal_size;
+  double scale = normalized ? 1.0 : (inverse ? 1.0 / n : static_cast<double>(n));
+  if (complex_input && complex_output) {
+    return maybe_multiply(at::_fft_with_size(grad, true, true, !inverse, n, normalized, false), scale);
+  }
+  if (complex_output) {
+    auto full_grad = grad;
+    int64_t grad_n = grad.size(-2);
+    if (grad_n < n) {
+      auto pad_size = grad.sizes().vec();
+      pad_size[pad_size.size() - 2] = n - grad_n;
+      full_grad = at::cat({grad, grad.type().zeros(pad_size)}, -2);
+    }
+    auto real_grad = at::_fft_with_size(full_grad, true, true, true, n, normalized, false).select(-1, 0);
+    return maybe_multiply(real_grad, scale);
+  }
+  auto weight = grad.type().ones({n / 2 + 1, 1});
+  if (n > 2) {
+    weight.narrow(0, 1, (n - 1) / 2).fill_(2);
+  }
+  auto half_grad = at::_fft_with_size(grad, false, true, false, n, normalized, true);
+  return maybe_multiply(half_grad * weight, scale);
+}
+
 // Reference:
 // https://people.maths.ox.ac.uk/gilesm/files/NA-08-01.pdf
 // Sec. 2.3.1 Matrix inverse product
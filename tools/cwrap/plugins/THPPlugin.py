@@ -465,6 +465,10 @@ ${cpu}
                         if arg.get('long_args', False):
                             arg['no_kwargs'] = True
             for option in declaration['options']:
+                # Options of a cpu_half declaration can opt out again
+                if not option.get('cpu_half', True):
+                    defined_if = option.get('defined_if', '')
+                    option['defined_if'] = '!defined(TH_REAL_IS_HALF)' + (' && ' if defined_if else '') + defined_if
                 option['cname'] = 'TH{}Tensor_({})'.format(
                     'S' if option.get('sparse', False) else '', option['cname'])
                 if option.get('sparse', False):
@@ -11,12 +11,15 @@ from collections import defaultdict, namedtuple
 class range(object):
     def __init__(self, name):
         self.name = name
+        self.pushed = False
 
     def __enter__(self):
-        torch.autograd._push_range(self.name)
+        # a streaming profiler drops ranges that don't fit in its buffer
+        self.pushed = torch.autograd._push_range(self.name)
 
     def __exit__(self, *args):
-        torch.autograd._pop_range()
+        if self.pushed:
+            torch.autograd._pop_range()
         return False
 
 
@@ -100,15 +103,25 @@ class EventList(list):
 
             json.dump(chrome_events, f)
 
-    def key_averages(self):
+    def key_averages(self, group_by_input_shapes=False):
         """Averages all function events over their keys.
 
+        Arguments:
+            group_by_input_shapes (bool, optional): Keep calls with different
+                input shapes apart. Only useful when the events were recorded
+                with ``record_shapes=True``. Default: ``False``.
+
         Returns:
             An EventList containing FunctionEventAvg objects.
         """
         stats = defaultdict(FunctionEventAvg)
         for evt in self:
-            stats[evt.key] += evt
+            if group_by_input_shapes:
+                avg = stats[evt.key, str(evt.input_shapes)]
+                avg += evt
+                avg.input_shapes = evt.input_shapes
+            else:
+                stats[evt.key] += evt
         return EventList(stats.values())
 
     def total_average(self):
@@ -136,6 +149,18 @@ class profile(object):
             Adds approximately 4us of overhead to each tensor operation.
             Default: ``False``
 
+        record_shapes (bool, optional): Makes tensor operations and autograd
+            functions record the shapes and types of their inputs, along with
+            estimates of the floating point operations they performed and of
+            the bytes they read and wrote. Use
+            ``key_averages(group_by_input_shapes=True)`` to get the achieved
+            GFLOP/s and GB/s of every operation and shape. Default: ``False``
+
+    After exiting, ``grad_accumulation`` holds a dict counting how the backward
+    passes run under the profiler accumulated gradients: ``allocated`` sums and
+    copies that needed a new tensor, ``in_place`` sums written into an existing
+    buffer and ``stolen`` gradients that became ``.grad`` without a copy.
+
     .. warning:
         This context managers should not be called recursively, i.e. at most one
         instance should be enabled at any given time.
@@ -160,10 +185,12 @@ class profile(object):
         N5torch8autograd5CloneE                        4.088us          0.000us
     """
 
-    def __init__(self, enabled=True, use_cuda=False):
+    def __init__(self, enabled=True, use_cuda=False, record_shapes=False):
         self.enabled = enabled
         self.use_cuda = use_cuda
+        self.record_shapes = record_shapes
         self.function_events = None
+        self.grad_accumulation = None
         if not self.enabled:
             return
         self.entered = False
@@ -176,7 +203,7 @@ class profile(object):
         self.entered = True
         profiler_kind = torch.autograd.ProfilerState.CUDA if self.use_cuda \
             else torch.autograd.ProfilerState.CPU
-        torch.autograd._enable_profiler(profiler_kind)
+        torch.autograd._enable_profiler(profiler_kind, self.record_shapes)
         return self
 
     def __exit__(self, exc_type, exc_val, exc_tb):
@@ -184,6 +211,8 @@ class profile(object):
             return
         records = torch.autograd._disable_profiler()
         self.function_events = EventList(parse_cpu_trace(records))
+        self.grad_accumulation = dict(zip(('allocated', 'in_place', 'stolen'),
+                                          torch.autograd._grad_accumulation_counts()))
         return False
 
     def __repr__(self):
@@ -208,10 +237,10 @@ class profile(object):
         return self.function_events.export_chrome_trace(path)
     export_chrome_trace.__doc__ = EventList.export_chrome_trace.__doc__
 
-    def key_averages(self):
+    def key_averages(self, group_by_input_shapes=False):
         if self.function_events is None:
             raise RuntimeError("can't average a trace that didn't finish running")
-        return self.function_events.key_averages()
+        return self.function_events.key_averages(group_by_input_shapes)
     key_averages.__doc__ = EventList.key_averages.__doc__
 
     def total_average(self):
@@ -221,6 +250,63 @@ class profile(object):
     total_average.__doc__ = EventList.total_average.__doc__
 
 
+class stream(object):
+    """Context manager that streams autograd events to a Chrome trace file.
+
+    Unlike :class:`profile`, events aren't kept in memory until the end:
+    each thread buffers at most ``buffer_size`` of them, and a background
+    thread appends them to ``path`` every 100ms. Events that don't fit in
+    a full buffer are dropped; after exiting, ``dropped_events`` holds how
+    many were. The file can be loaded under the ``chrome://tracing`` URL.
+
+    With ``sample_every=N`` only one iteration in ``N`` is recorded, which
+    makes it cheap enough to leave enabled in long-running jobs. Iterations
+    are delimited by calls to :func:`step`.
+
+    Arguments:
+        path (str): Path where the trace will be written.
+        sample_every (int, optional): Record one iteration in this many.
+            Default: ``1``.
+        buffer_size (int, optional): Maximum number of events buffered by
+            each thread between writes. Default: ``65536``.
+        enabled (bool, optional): Setting this to False makes this context
+            manager a no-op. Default: ``True``.
+
+    Example:
+        >>> with torch.autograd.profiler.stream('trace.json', sample_every=100):
+        ...     for x, target in loader:
+        ...         loss_fn(model(x), target).backward()
+        ...         torch.autograd.profiler.step()
+    """
+    def __init__(self, path, sample_every=1, buffer_size=65536, enabled=True):
+        self.path = path
+        self.sample_every = sample_every
+        self.buffer_size = buffer_size
+        self.enabled = enabled
+        self.entered = False
+        self.dropped_events = None
+
+    def __enter__(self):
+        if not self.enabled:
+            return
+        if self.entered:
+            raise RuntimeError("autograd profiler traces are not reentrant")
+        self.entered = True
+        torch.autograd._enable_streaming_profiler(self.path, self.buffer_size, self.sample_every)
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        if not self.enabled:
+            return
+        self.dropped_events = torch.autograd._disable_streaming_profiler()
+        return False
+
+
+def step():
+    """Marks the end of an iteration for :class:`stream` sampling."""
+    torch.autograd._profiler_step()
+
+
 class emit_nvtx(object):
     """Context manager that makes every autograd operation emit an NVTX range.
 
@@ -295,7 +381,8 @@ def attr_formatter(name):
 class FormattedTimesMixin(object):
     """Helpers for FunctionEvent and FunctionEventAvg.
 
-    The subclass should define `*_time_total` and `count` attributes.
+    The subclass should define `*_time_total`, `flops_total`, `bytes_total`
+    and `count` attributes.
     """
     cpu_time_str = attr_formatter('cpu_time')
     cuda_time_str = attr_formatter('cuda_time')
@@ -310,6 +397,22 @@ class FormattedTimesMixin(object):
     def cuda_time(self):
         return 0.0 if self.count == 0 else 1.0 * self.cuda_time_total / self.count
 
+    @property
+    def gflops_per_second(self):
+        """Estimated FLOPs per second of CPU time, in billions."""
+        return 0.0 if self.cpu_time_total == 0 else 1e-3 * self.flops_total / self.cpu_time_total
+
+    @property
+    def gbytes_per_second(self):
+        """Estimated bytes read and written per second of CPU time, in billions."""
+        return 0.0 if self.cpu_time_total == 0 else 1e-3 * self.bytes_total / self.cpu_time_total
+
+    @property
+    def flops_per_byte(self):
+        """Arithmetic intensity. Ops well below the machine's ratio of peak
+        FLOP/s to memory bandwidth are memory-bound."""
+        return 0.0 if self.bytes_total == 0 else 1.0 * self.flops_total / self.bytes_total
+
 
 class Interval(object):
     def __init__(self, start, end):
@@ -330,13 +433,18 @@ class Kernel(object):
 # TODO: record TID too
 class FunctionEvent(FormattedTimesMixin):
     """Profiling information about a single function."""
-    def __init__(self, id, name, thread, cpu_start, cpu_end):
+    def __init__(self, id, name, thread, cpu_start, cpu_end,
+                 input_shapes=None, input_dtypes=None, flops=0, bytes=0):
         self.id = id
         self.name = name
         self.cpu_interval = Interval(cpu_start, cpu_end)
         self.thread = thread
         self.kernels = []
         self.count = 1
+        self.input_shapes = input_shapes
+        self.input_dtypes = input_dtypes
+        self.flops_total = flops
+        self.bytes_total = bytes
 
     def append_kernel(self, name, device, start, end):
         self.kernels.append(Kernel(name, device, Interval(start, end)))
@@ -362,7 +470,10 @@ class FunctionEventAvg(FormattedTimesMixin):
     """Used to average stats over multiple FunctionEvent objects."""
     def __init__(self):
         self.key = None
+        # only set when averaging calls with the same input shapes
+        self.input_shapes = None
         self.count = self.cpu_time_total = self.cuda_time_total = 0
+        self.flops_total = self.bytes_total = 0
 
     def __iadd__(self, other):
         if self.key is None:
@@ -371,6 +482,8 @@ class FunctionEventAvg(FormattedTimesMixin):
         assert other.key == self.key
         self.cpu_time_total += other.cpu_time
         self.cuda_time_total += other.cuda_time
+        self.flops_total += other.flops_total
+        self.bytes_total += other.bytes_total
         self.count += 1
         return self
 
@@ -441,6 +554,11 @@ def parse_cpu_trace(thread_records):
                 thread=start.thread_id(),
                 cpu_start=start_record.cpu_elapsed_us(start),
                 cpu_end=start_record.cpu_elapsed_us(record))
+            if record.has_shapes():
+                fe.input_shapes = record.input_shapes()
+                fe.input_dtypes = record.input_dtypes()
+                fe.flops_total = record.flops()
+                fe.bytes_total = record.bytes()
             if start.has_cuda():
                 cuda_start = adjusted_time(start)
                 cuda_end = adjusted_time(record)
@@ -538,12 +656,20 @@ def build_table(events, sort_by=None, header=None):
     if sort_by is not None:
         events = sorted(events, key=lambda evt: getattr(evt, sort_by))
 
+    # Throughput columns only make sense when shapes were recorded, and
+    # averages only have shapes when they were grouped by them
+    with_throughput = any(evt.bytes_total > 0 for evt in events)
+    with_shapes = any(evt.input_shapes is not None for evt in events)
+    num_cols = 8 if with_throughput else 5
+
     max_name_length = max(len(evt.key) for evt in events)
     max_name_length += 4  # Add some nice padding
     col_width = 15
     col_format = '  {: >' + str(col_width) + '}'
-    row_format = '{: <' + str(max_name_length) + '}' + col_format * 5
-    header_sep = '-' * max_name_length + ('  ' + '-' * col_width) * 5
+    row_format = '{: <' + str(max_name_length) + '}' + col_format * num_cols
+    header_sep = '-' * max_name_length + ('  ' + '-' * col_width) * num_cols
+    if with_shapes:
+        row_format += '  {}'
 
     # Have to use a list because nonlocal is Py3 only...
     result = ['']
@@ -554,14 +680,25 @@ def build_table(events, sort_by=None, header=None):
 
     # Actual printing
     if header is not None:
-        line_length = max_name_length + (col_width + 2) * 5
+        line_length = max_name_length + (col_width + 2) * num_cols
         append('=' * line_length)
         append(header)
     append(header_sep)
-    append(row_format.format('Name', 'CPU time', 'CUDA time', 'Calls', 'CPU total', 'CUDA total'))
+    columns = ['Name', 'CPU time', 'CUDA time', 'Calls', 'CPU total', 'CUDA total']
+    if with_throughput:
+        columns += ['GFLOP/s', 'GB/s', 'FLOP/byte']
+    if with_shapes:
+        columns += ['Input shapes']
+    append(row_format.format(*columns))
     append(header_sep)
     for evt in events:
-        append(row_format.format(evt.key, evt.cpu_time_str, evt.cuda_time_str,
-                                 evt.count, evt.cpu_time_total_str, evt.cuda_time_total_str))
+        row = [evt.key, evt.cpu_time_str, evt.cuda_time_str,
+               evt.count, evt.cpu_time_total_str, evt.cuda_time_total_str]
+        if with_throughput:
+            row += ['{:.3f}'.format(evt.gflops_per_second), '{:.3f}'.format(evt.gbytes_per_second),
+                    '{:.3f}'.format(evt.flops_per_byte)]
+        if with_shapes:
+            row += ['' if evt.input_shapes is None else str(evt.input_shapes)]
+        append(row_format.format(*row))
 
     return result[0]
@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <TH/TH.h>
 #include "THP.h"
+#include "torch/csrc/utils/python_strings.h"
 
 PyObject *THPGeneratorClass = NULL;
 
@@ -104,12 +105,46 @@ static PyObject * THPGenerator_initialSeed(THPGenerator *self)
   END_HANDLE_TH_ERRORS
 }
 
+static PyObject * THPGenerator_setEngine(THPGenerator *self, PyObject *engine)
+{
+  HANDLE_TH_ERRORS
+  THGenerator *generator = THPGenerator_TH_CData(self);
+  THPUtils_assert(THPUtils_checkString(engine), "set_engine expects a string, "
+          "but got %s", THPUtils_typename(engine));
+  std::string name = THPUtils_unpackString(engine);
+  if (name == "mt19937") {
+    THGenerator_setEngine(generator, TH_RANDOM_ENGINE_MT19937);
+  } else if (name == "philox") {
+    THGenerator_setEngine(generator, TH_RANDOM_ENGINE_PHILOX);
+  } else {
+    THPUtils_setError("unknown random engine '%s', expected 'mt19937' or 'philox'",
+        name.c_str());
+    return NULL;
+  }
+  Py_INCREF(self);
+  return (PyObject*)self;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPGenerator_engine(THPGenerator *self)
+{
+  HANDLE_TH_ERRORS
+  THGenerator *generator = THPGenerator_TH_CData(self);
+  if (THGenerator_engine(generator) == TH_RANDOM_ENGINE_PHILOX) {
+    return THPUtils_packString("philox");
+  }
+  return THPUtils_packString("mt19937");
+  END_HANDLE_TH_ERRORS
+}
+
 static PyMethodDef THPGenerator_methods[] = {
   {"get_state",       (PyCFunction)THPGenerator_getState,       METH_NOARGS,  NULL},
   {"set_state",       (PyCFunction)THPGenerator_setState,       METH_O,       NULL},
   {"manual_seed",     (PyCFunction)THPGenerator_manualSeed,     METH_O,       NULL},
   {"seed",            (PyCFunction)THPGenerator_seed,           METH_NOARGS,  NULL},
   {"initial_seed",    (PyCFunction)THPGenerator_initialSeed,    METH_NOARGS,  NULL},
+  {"set_engine",      (PyCFunction)THPGenerator_setEngine,      METH_O,       NULL},
+  {"engine",          (PyCFunction)THPGenerator_engine,         METH_NOARGS,  NULL},
   {NULL}
 };
 
@@ -527,6 +527,39 @@ static PyObject *THPModule_getBackcompatKeepdimWarn(PyObject *module)
   else Py_RETURN_FALSE;
 }
 
+static PyObject *THPModule_setCPUCachingAllocatorEnabled(PyObject *module, PyObject *arg) {
+  THPUtils_assert(PyBool_Check(arg), "set_cpu_caching_allocator_enabled expects a bool, "
+          "but got %s", THPUtils_typename(arg));
+  THCachingAllocator_setEnabled(arg == Py_True);
+  Py_RETURN_NONE;
+}
+
+static PyObject *THPModule_getCPUCachingAllocatorEnabled(PyObject *module)
+{
+  if (THCachingAllocator_isEnabled()) Py_RETURN_TRUE;
+  else Py_RETURN_FALSE;
+}
+
+// Releases the blocks cached globally and by every thread, not just this one
+static PyObject *THPModule_trimCPUCachingAllocator(PyObject *module)
+{
+  THCachingAllocator_trim();
+  Py_RETURN_NONE;
+}
+
+static PyObject *THPModule_CPUCachingAllocatorStats(PyObject *module)
+{
+  THCachingAllocatorStats stats;
+  THCachingAllocator_getStats(&stats);
+  int64_t allocations = stats.hits + stats.misses;
+  return Py_BuildValue("{s:n,s:n,s:L,s:L,s:d}",
+      "bytes_in_use", stats.bytesInUse,
+      "bytes_cached", stats.bytesCached,
+      "hits", (long long)stats.hits,
+      "misses", (long long)stats.misses,
+      "hit_rate", allocations ? (double)stats.hits / allocations : 0.0);
+}
+
 PyObject *THPModule_hasDistributed(PyObject *_unused)
 {
 #ifdef WITH_DISTRIBUTED
@@ -604,6 +637,12 @@ static PyMethodDef TorchMethods[] = {
   {"_get_backcompat_broadcast_warn", (PyCFunction)THPModule_getBackcompatBroadcastWarn, METH_NOARGS, NULL},
   {"_set_backcompat_keepdim_warn", (PyCFunction)THPModule_setBackcompatKeepdimWarn, METH_O, NULL},
   {"_get_backcompat_keepdim_warn", (PyCFunction)THPModule_getBackcompatKeepdimWarn, METH_NOARGS, NULL},
+  {"_set_cpu_caching_allocator_enabled", (PyCFunction)THPModule_setCPUCachingAllocatorEnabled, METH_O, NULL},
+  {"_get_cpu_caching_allocator_enabled", (PyCFunction)THPModule_getCPUCachingAllocatorEnabled, METH_NOARGS, NULL},
+  {"_cpu_caching_allocator_trim", (PyCFunction)THPModule_trimCPUCachingAllocator, METH_NOARGS, NULL},
+  {"_cpu_caching_allocator_stats", (PyCFunction)THPModule_CPUCachingAllocatorStats, METH_NOARGS, NULL},
+  {"_set_num_autograd_cpu_threads", (PyCFunction)THPEngine_setNumCPUThreads, METH_O, NULL},
+  {"_get_num_autograd_cpu_threads", (PyCFunction)THPEngine_getNumCPUThreads, METH_NOARGS, NULL},
   {"get_num_threads", (PyCFunction)THPModule_getNumThreads,     METH_NOARGS,  NULL},
   {"set_num_threads", (PyCFunction)THPModule_setNumThreads,     METH_O,       NULL},
   {"_get_cudnn_enabled", (PyCFunction)THPModule_userEnabledCuDNN, METH_NOARGS,     NULL},
@@ -0,0 +1,283 @@
+#include "torch/csrc/autograd/checkpoint.h"
+
+#include <ATen/PinnedMemoryAllocator.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "torch/csrc/autograd/grad_mode.h"
+#include "torch/csrc/autograd/saved_variable.h"
+#include "torch/csrc/utils/auto_gpu.h"
+
+#ifdef WITH_CUDA
+#include <THC/THC.h>
+extern THCState* state;
+#endif
+
+namespace torch { namespace autograd {
+
+static thread_local CheckpointSegment* current_segment = nullptr;
+
+// Held while a segment is re-run, so that it's only done once. Re-runs swap
+// the global generators, so they are serialized across all segments. It's
+// recursive because a segment could unpack tensors of another one while it
+// is being re-run.
+static std::recursive_mutex recompute_mutex;
+
+static int64_t file_tell(std::FILE* file) {
+#ifdef _MSC_VER
+  return _ftelli64(file);
+#else
+  return ftello(file);
+#endif
+}
+
+static bool file_seek(std::FILE* file, int64_t offset, int whence) {
+#ifdef _MSC_VER
+  return _fseeki64(file, offset, whence) == 0;
+#else
+  return fseeko(file, offset, whence) == 0;
+#endif
+}
+
+static std::runtime_error file_error(const char* what, const std::string& path) {
+  return std::runtime_error(std::string("checkpoint: ") + what + " '" +
+      (path.empty() ? "<tmpfile>" : path) + "': " + std::strerror(errno));
+}
+
+CheckpointSegment::CheckpointSegment(Mode mode, function_type fn,
+                                     variable_list inputs, std::string path)
+  : mode_(mode)
+  , fn(std::move(fn))
+  , inputs(std::move(inputs))
+  , path(std::move(path))
+  , file(nullptr)
+  , recompute_pos(-1) {
+  if (mode_ == Mode::Recompute) {
+    if (!this->fn) {
+      throw std::runtime_error("checkpoint: Recompute mode needs a function to re-run");
+    }
+    // CUDAGenerator::copy isn't implemented, so CUDA states are saved as
+    // torch.cuda.get_rng_state does.
+    auto& generator = at::globalContext().defaultGenerator(at::kCPU);
+    rng_state = at::CPU(at::kFloat).generator();
+    rng_state->copy(generator);
+    cuda_rng_states = get_cuda_rng_states();
+  } else if (mode_ == Mode::File) {
+    file = this->path.empty() ? std::tmpfile() : std::fopen(this->path.c_str(), "w+b");
+    if (!file) {
+      throw file_error("can't open", this->path);
+    }
+  }
+}
+
+CheckpointSegment::~CheckpointSegment() {
+  if (file) {
+    std::fclose(file);
+    if (!path.empty()) {
+      std::remove(path.c_str());
+    }
+  }
+}
+
+CheckpointSegment* CheckpointSegment::current() {
+  return current_segment;
+}
+
+void CheckpointSegment::save(SavedVariable& saved, bool is_leaf) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& data = saved.data;
+
+  if (recompute_pos >= 0) {
+    // Re-running the segment: hand the tensor over to the slot the original
+    // SavedVariable points to. The new SavedVariable dies with the graph
+    // built by the re-run, so it can keep its copy.
+    if (recompute_pos >= static_cast<int64_t>(slots.size())) {
+      throw std::runtime_error("checkpoint: the segment saved more tensors when it "
+                               "was recomputed than in the forward pass");
+    }
+    auto& slot = slots[recompute_pos++];
+    if (!slot.released) {
+      slot.data = data;
+    }
+    return;
+  }
+
+  // Leaves are kept alive by their owners anyway, so copying them out
+  // wouldn't free anything. Recompute has to number every saved tensor so
+  // the re-run can be matched against the forward pass.
+  if (mode_ == Mode::Host && (is_leaf || !data.type().is_cuda())) {
+    return;
+  }
+  if (mode_ == Mode::File && is_leaf) {
+    return;
+  }
+
+  Slot slot;
+  slot.type = &data.type();
+  slot.device = data.type().is_cuda() ? data.get_device() : -1;
+  slot.sizes = data.sizes().vec();
+  slot.offset = -1;
+  slot.released = false;
+  if (mode_ == Mode::Host) {
+    auto& cpu_type = data.type().toBackend(at::kCPU);
+    slot.data = cpu_type.tensorWithAllocator(
+        data.sizes(), std::unique_ptr<at::Allocator>(new at::PinnedMemoryAllocator()));
+    slot.data.copy_(data);
+  } else if (mode_ == Mode::File) {
+    auto cpu_data = data.toBackend(at::kCPU).contiguous();
+    auto element_size = cpu_data.type().elementSizeInBytes();
+    size_t numel = cpu_data.numel();
+    if (!file_seek(file, 0, SEEK_END) || (slot.offset = file_tell(file)) < 0 ||
+        std::fwrite(cpu_data.data_ptr(), element_size, numel, file) != numel) {
+      throw file_error("can't write to", path);
+    }
+  }
+
+  saved.segment = shared_from_this();
+  saved.segment_slot = slots.size();
+  slots.emplace_back(std::move(slot));
+  data.reset();
+}
+
+at::Tensor CheckpointSegment::load(size_t index) {
+  if (mode_ == Mode::Recompute) {
+    std::lock_guard<std::recursive_mutex> recompute_lock(recompute_mutex);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (slots[index].data.defined()) {
+        return slots[index].data;
+      }
+    }
+    recompute();
+    std::lock_guard<std::mutex> lock(mutex);
+    return slots[index].data;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& slot = slots[index];
+  AutoGPU guard(slot.device);
+  auto result = slot.type->tensor(slot.sizes);
+  if (mode_ == Mode::Host) {
+    result.copy_(slot.data);
+  } else {
+    auto cpu_data = slot.type->is_cuda() ? slot.type->toBackend(at::kCPU).tensor(slot.sizes) : result;
+    auto element_size = cpu_data.type().elementSizeInBytes();
+    size_t numel = cpu_data.numel();
+    if (!file_seek(file, slot.offset, SEEK_SET) ||
+        std::fread(cpu_data.data_ptr(), element_size, numel, file) != numel) {
+      throw file_error("can't read from", path);
+    }
+    if (slot.type->is_cuda()) {
+      result.copy_(cpu_data);
+    }
+  }
+  return result;
+}
+
+void CheckpointSegment::release(size_t index) {
+  std::lock_guard<std::mutex> lock(mutex);
+  // Space in the file is only reclaimed when the segment goes away.
+  slots[index].data.reset();
+  slots[index].released = true;
+}
+
+// Returns the states of the generators of the CUDA devices the inputs are
+// on, in device order.
+std::vector<std::pair<int, at::Tensor>> CheckpointSegment::get_cuda_rng_states() const {
+  std::vector<std::pair<int, at::Tensor>> states;
+#ifdef WITH_CUDA
+  std::vector<int> devices;
+  for (auto& input : inputs) {
+    if (input.defined() && input.type().is_cuda()) {
+      devices.push_back(input.get_device());
+    }
+  }
+  std::sort(devices.begin(), devices.end());
+  devices.erase(std::unique(devices.begin(), devices.end()), devices.end());
+  for (int device : devices) {
+    AutoGPU guard(device);
+    auto rng_state = at::CPU(at::kByte).tensor();
+    THCRandom_getRNGState(state, (THByteTensor*)rng_state.unsafeGetTH(false));
+    states.emplace_back(device, std::move(rng_state));
+  }
+#endif
+  return states;
+}
+
+void CheckpointSegment::set_cuda_rng_states(const std::vector<std::pair<int, at::Tensor>>& states) {
+#ifdef WITH_CUDA
+  for (auto& device_state : states) {
+    AutoGPU guard(device_state.first);
+    THCRandom_setRNGState(state, (THByteTensor*)device_state.second.unsafeGetTH(false));
+  }
+#endif
+}
+
+// Called with recompute_mutex held, which covers swapping the generators and
+// the re-run, but not mutex: save() takes it as the re-run saves its tensors.
+void CheckpointSegment::recompute() {
+  auto& generator = at::globalContext().defaultGenerator(at::kCPU);
+  auto rng_now = at::CPU(at::kFloat).generator();
+  rng_now->copy(generator);
+  auto cuda_rng_now = get_cuda_rng_states();
+  generator.copy(*rng_state);
+  set_cuda_rng_states(cuda_rng_states);
+
+  auto finish = [&]() {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto saved_count = recompute_pos;
+    recompute_pos = -1;
+    generator.copy(*rng_now);
+    set_cuda_rng_states(cuda_rng_now);
+    return saved_count;
+  };
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    recompute_pos = 0;
+  }
+  try {
+    AutoGradMode grad_mode(true);
+    AutoCheckpointSegment segment_guard(this);
+    fn(inputs);
+  } catch (...) {
+    finish();
+    throw;
+  }
+  if (finish() != static_cast<int64_t>(slots.size())) {
+    throw std::runtime_error("checkpoint: the segment saved fewer tensors when it "
+                             "was recomputed than in the forward pass");
+  }
+}
+
+AutoCheckpointSegment::AutoCheckpointSegment(CheckpointSegment* segment)
+  : prev_segment(current_segment) {
+  current_segment = segment;
+}
+
+AutoCheckpointSegment::~AutoCheckpointSegment() {
+  current_segment = prev_segment;
+}
+
+variable_list checkpoint(const CheckpointSegment::function_type& fn,
+                         const variable_list& inputs,
+                         CheckpointSegment::Mode mode,
+                         const std::string& path) {
+  if (current_segment) {
+    return fn(inputs);
+  }
+
+  variable_list detached;
+  if (mode == CheckpointSegment::Mode::Recompute) {
+    detached.reserve(inputs.size());
+    for (auto& input : inputs) {
+      detached.emplace_back(input.defined() ? make_variable(input.data(), input.requires_grad())
+                                            : Variable());
+    }
+  }
+  auto segment = std::make_shared<CheckpointSegment>(mode, fn, std::move(detached), path);
+  AutoCheckpointSegment segment_guard(segment.get());
+  return fn(inputs);
+}
+
+}} // namespace torch::autograd
@@ -0,0 +1,102 @@
+#pragma once
+
+// Checkpointed segments of the forward pass. Tensors saved for backward by
+// Functions created inside a segment are not kept in their original place:
+// they are either dropped and recomputed by re-running the segment when the
+// backward pass first unpacks one of them, or copied out to pinned host
+// memory or to a file and copied back when unpacked.
+
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <ATen/ATen.h>
+
+#include "torch/csrc/autograd/variable.h"
+
+namespace torch { namespace autograd {
+
+struct SavedVariable;
+
+struct CheckpointSegment : std::enable_shared_from_this<CheckpointSegment> {
+  enum class Mode {
+    // Drop saved tensors and re-run the segment to get them back.
+    Recompute,
+    // Move saved CUDA tensors to pinned host memory. CPU tensors are kept.
+    Host,
+    // Write saved tensors to a file.
+    File,
+  };
+
+  using function_type = std::function<variable_list(const variable_list&)>;
+
+  // fn and inputs are only needed (and fn is only called) in Recompute mode.
+  // File mode writes to path, or to an anonymous temporary file if it's
+  // empty; the file is removed when the segment is destroyed.
+  CheckpointSegment(Mode mode, function_type fn=nullptr,
+                    variable_list inputs={}, std::string path="");
+  ~CheckpointSegment();
+
+  // The segment that saved variables created on this thread belong to, or
+  // nullptr outside of segments.
+  static CheckpointSegment* current();
+
+  Mode mode() const { return mode_; }
+
+  // Called by the SavedVariable constructor. Takes the tensor out of saved
+  // unless the segment decides to leave it in place.
+  void save(SavedVariable& saved, bool is_leaf);
+  at::Tensor load(size_t slot);
+  void release(size_t slot);
+
+private:
+  struct Slot {
+    at::Tensor data;
+    const at::Type* type;
+    int device;
+    std::vector<int64_t> sizes;
+    int64_t offset;
+    bool released;
+  };
+
+  void recompute();
+  std::vector<std::pair<int, at::Tensor>> get_cuda_rng_states() const;
+  static void set_cuda_rng_states(const std::vector<std::pair<int, at::Tensor>>& states);
+
+  Mode mode_;
+  function_type fn;
+  variable_list inputs;
+  std::unique_ptr<at::Generator> rng_state;
+  // (device, state) for the CUDA devices the inputs are on
+  std::vector<std::pair<int, at::Tensor>> cuda_rng_states;
+  std::string path;
+  std::FILE* file;
+  std::mutex mutex;
+  std::vector<Slot> slots;
+  // Index of the next slot filled in while the segment is being recomputed,
+  // or -1 if it isn't.
+  int64_t recompute_pos;
+};
+
+// Makes segment the current one on this thread while it's alive.
+struct AutoCheckpointSegment {
+  AutoCheckpointSegment(CheckpointSegment* segment);
+  ~AutoCheckpointSegment();
+  CheckpointSegment* prev_segment;
+};
+
+// Runs fn(inputs) as a checkpointed segment and returns its outputs. In
+// Recompute mode fn may be called again during backward, on detached copies
+// of inputs and with the CPU RNG state and the RNG states of the inputs' CUDA
+// devices it saw the first time, so it must perform the same operations in
+// the same order. Checkpoints nested in a segment are part of the enclosing
+// segment.
+variable_list checkpoint(const CheckpointSegment::function_type& fn,
+                         const variable_list& inputs,
+                         CheckpointSegment::Mode mode=CheckpointSegment::Mode::Recompute,
+                         const std::string& path="");
+
+}} // namespace torch::autograd
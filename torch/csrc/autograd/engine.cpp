@@ -4,9 +4,11 @@
 #include "torch/csrc/autograd/functions/basic_ops.h"
 #include "torch/csrc/utils/auto_gpu.h"
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
+#include <cstdlib>
 #include <functional>
 #include <iostream>
 #include <mutex>
@@ -28,13 +30,15 @@ namespace torch { namespace autograd {
 // NB: -1 indicates the CPU worker!
 static constexpr int NO_DEVICE = -2;
 static thread_local int worker_device = NO_DEVICE;
+// Index of this thread among the workers of worker_device. There is exactly
+// one worker per GPU, but CPU functions can be executed by a pool of threads.
+static thread_local int worker_index = 0;
 
 // XXX: Changes to the way multithreading works in execute should be done with
-// great care. Right now the implementation guarantees that a single function's
-// apply will never be entered concurrently (even if multiple graphs are
-// executed at the same time). Adding multiple threads per-device or removing
-// engine thread affinity to the device can break this invariant, and we depend
-// on it in a few places (e.g. AccumulateGrad function).
+// great care. A single function's apply is entered only once per graph task,
+// but with more than one CPU worker, functions that are shared by graphs
+// executed at the same time (e.g. AccumulateGrad of a common leaf) can be
+// entered concurrently. Such functions have to do their own locking.
 
 struct FunctionTask {
   GraphTask* base;
@@ -50,13 +54,65 @@ struct FunctionTask {
     , inputs(std::move(inputs)) {}
 };
 
+// Protects a single shard of a ReadyQueue. Critical sections only move a
+// task in or out of a deque, so spinning is cheaper than going through a
+// mutex, which showed up in the dispatch of tiny functions.
+struct SpinLock {
+  std::atomic<bool> locked;
+
+  SpinLock() : locked(false) {}
+
+  void lock() {
+    while (locked.exchange(true, std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  }
+
+  void unlock() {
+    locked.store(false, std::memory_order_release);
+  }
+};
+
+// Every worker owns a shard of tasks. Tasks pushed by a worker of the same
+// device go to its own shard, while tasks coming from other threads are
+// distributed round-robin. Workers take tasks from their own shard and, once
+// it is empty, steal from the others. Wakeups of a graph task's owner (see
+// thread_main) are delivered to a per-worker mailbox that is never stolen
+// from.
+//
+// With FIFO order a shard is a deque, from which the owner takes the oldest
+// task and thieves take the newest one. With SequenceNr order it's a max-heap
+// on Function::sequence_nr.
+//
+// The queue mutex is only taken by workers going to sleep and by the threads
+// that have to wake them up, so dispatch between busy workers is lock-free
+// apart from the shard spinlocks.
 struct ReadyQueue {
-  std::deque<FunctionTask> queue;
+  struct Shard {
+    std::deque<FunctionTask> queue;
+    SpinLock lock;
+  };
+
+  ReadyQueue(int device, int num_workers, ReadyQueueOrder order);
+
+  int device;
+  ReadyQueueOrder order;
+  std::vector<std::unique_ptr<Shard>> shards;
+  std::vector<int> mailboxes;
+  // Can transiently drop below zero when a task is stolen before its push
+  // got to increment the counter.
+  std::atomic<int64_t> num_queued;
+  std::atomic<int> num_sleeping;
+  std::atomic<unsigned> next_shard;
   std::condition_variable not_empty;
   std::mutex mutex;
 
   void push_front(FunctionTask item);
-  FunctionTask pop_back();
+  void wake_worker(int worker);
+  FunctionTask pop_back(int worker);
+
+private:
+  bool try_pop(int worker, FunctionTask& task);
 };
 
 struct GraphTask {
@@ -77,7 +133,10 @@ struct GraphTask {
   std::unordered_map<Function*, InputBuffer> not_ready;
   std::unordered_map<Function*, int> dependencies;
 
+  // Device and worker index of the thread that called execute() if it was
+  // an engine worker, NO_DEVICE otherwise.
   int owner;
+  int owner_worker;
 
   GraphTask(bool keep_graph, bool grad_mode, const Engine::pre_callback_map& pre_callbacks, const Engine::post_callback_map& post_callbacks)
     : exception()
@@ -91,35 +150,159 @@ struct GraphTask {
     , post_callbacks(post_callbacks)
     , not_ready()
     , dependencies()
-    , owner(NO_DEVICE) {}
+    , owner(NO_DEVICE)
+    , owner_worker(0) {}
 };
 
+static bool sequence_nr_less(const FunctionTask& a, const FunctionTask& b) {
+  return a.fn->sequence_nr < b.fn->sequence_nr;
+}
+
+ReadyQueue::ReadyQueue(int device, int num_workers, ReadyQueueOrder order)
+  : device(device)
+  , order(order)
+  , shards()
+  , mailboxes(num_workers, 0)
+  , num_queued(0)
+  , num_sleeping(0)
+  , next_shard(0) {
+  for (int i = 0; i < num_workers; ++i) {
+    shards.emplace_back(new Shard());
+  }
+}
+
 auto ReadyQueue::push_front(FunctionTask item) -> void {
+  int num_workers = shards.size();
+  int idx;
+  if (num_workers == 1) {
+    idx = 0;
+  } else if (worker_device == device) {
+    idx = worker_index;
+  } else {
+    idx = next_shard++ % num_workers;
+  }
+  auto& shard = *shards[idx];
   {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::lock_guard<SpinLock> lock(shard.lock);
     ++item.base->outstanding_tasks;
-    queue.push_front(std::move(item));
+    if (order == ReadyQueueOrder::FIFO) {
+      shard.queue.push_front(std::move(item));
+    } else {
+      shard.queue.push_back(std::move(item));
+      std::push_heap(shard.queue.begin(), shard.queue.end(), sequence_nr_less);
+    }
+  }
+  ++num_queued;
+  // Sleepers increment num_sleeping before they check num_queued, so one of
+  // us is guaranteed to see the other's update.
+  if (num_sleeping.load() > 0) {
+    std::lock_guard<std::mutex> lock(mutex);
+    not_empty.notify_one();
+  }
+}
+
+auto ReadyQueue::wake_worker(int worker) -> void {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++mailboxes.at(worker);
+  }
+  not_empty.notify_all();
+}
+
+auto ReadyQueue::try_pop(int worker, FunctionTask& task) -> bool {
+  int num_workers = shards.size();
+  for (int i = 0; i < num_workers; ++i) {
+    int idx = (worker + i) % num_workers;
+    auto& shard = *shards[idx];
+    std::lock_guard<SpinLock> lock(shard.lock);
+    auto& queue = shard.queue;
+    if (queue.empty()) continue;
+    if (order == ReadyQueueOrder::SequenceNr) {
+      std::pop_heap(queue.begin(), queue.end(), sequence_nr_less);
+      task = std::move(queue.back()); queue.pop_back();
+    } else if (idx == worker) {
+      task = std::move(queue.back()); queue.pop_back();
+    } else {
+      task = std::move(queue.front()); queue.pop_front();
+    }
+    --num_queued;
+    return true;
+  }
+  return false;
+}
+
+auto ReadyQueue::pop_back(int worker) -> FunctionTask {
+  FunctionTask task(nullptr, nullptr, InputBuffer(0));
+  while (true) {
+    if (num_queued.load() > 0 && try_pop(worker, task)) {
+      return task;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    ++num_sleeping;
+    not_empty.wait(lock, [this, worker]{
+      return num_queued.load() > 0 || mailboxes[worker] > 0;
+    });
+    --num_sleeping;
+    if (mailboxes[worker] > 0) {
+      // A wakeup carries no task - it only makes the worker recheck whether
+      // the graph task it owns has finished.
+      --mailboxes[worker];
+      return task;
+    }
   }
-  not_empty.notify_one();
 }
 
-auto ReadyQueue::pop_back() -> FunctionTask {
-  std::unique_lock<std::mutex> lock(mutex);
-  not_empty.wait(lock, [this]{ return !queue.empty(); });
-  auto task = std::move(queue.back()); queue.pop_back();
-  return task;
+static ReadyQueueOrder default_ready_queue_order() {
+  const char *env = getenv("PYTORCH_AUTOGRAD_QUEUE_ORDER");
+  if (env && std::string(env) == "sequence_nr") {
+    return ReadyQueueOrder::SequenceNr;
+  }
+  return ReadyQueueOrder::FIFO;
+}
+
+static int default_num_cpu_threads() {
+  const char *env = getenv("PYTORCH_AUTOGRAD_CPU_THREADS");
+  if (env) {
+    int num_threads = atoi(env);
+    if (num_threads > 0) return num_threads;
+  }
+  return 1;
 }
 
-Engine::Engine() : ready_queues() {
+Engine::Engine()
+  : ready_queues()
+  , threads_started(false)
+  , cpu_threads(default_num_cpu_threads())
+  , queue_order(default_ready_queue_order()) {
 }
 
 // This Engine's ReadyQueues and their corresponding threads are leaked here
 Engine::~Engine() = default;
 
-auto Engine::thread_init(int device) -> void {
+auto Engine::set_num_cpu_threads(int num_threads) -> void {
+  if (num_threads < 1) {
+    throw std::runtime_error("the number of autograd CPU threads has to be positive");
+  }
+  if (threads_started.load()) {
+    throw std::runtime_error("the number of autograd CPU threads can't be "
+                             "changed after the first backward pass");
+  }
+  cpu_threads = num_threads;
+}
+
+auto Engine::set_ready_queue_order(ReadyQueueOrder order) -> void {
+  if (threads_started.load()) {
+    throw std::runtime_error("the order of the autograd ready queues can't be "
+                             "changed after the first backward pass");
+  }
+  queue_order = order;
+}
+
+auto Engine::thread_init(int device, int worker) -> void {
   THInferNumThreads();
   AutoGPU guard(device);
   worker_device = device;
+  worker_index = worker;
   thread_main(nullptr);
 }
 
@@ -140,7 +323,10 @@ auto Engine::thread_init(int device) -> void {
 auto Engine::thread_main(GraphTask *graph_task) -> void {
   auto queue = ready_queues[worker_device + 1];
   while (!graph_task || graph_task->outstanding_tasks > 0) {
-    FunctionTask task = queue->pop_back();
+    FunctionTask task = queue->pop_back(worker_index);
+    // Wakeups don't carry a graph task, they only make us recheck the loop
+    // condition.
+    if (!task.base) continue;
     if (task.fn && !task.base->has_error.load()) {
       GradMode::set_enabled(task.base->grad_mode);
       try {
@@ -150,6 +336,7 @@ auto Engine::thread_main(GraphTask *graph_task) -> void {
       }
     }
     auto base_owner = task.base->owner;
+    auto base_owner_worker = task.base->owner_worker;
     // Task from a non-worker thread. Easy case.
     if (base_owner == NO_DEVICE) {
       if (--task.base->outstanding_tasks == 0) {
@@ -159,18 +346,13 @@ auto Engine::thread_main(GraphTask *graph_task) -> void {
     } else {
       // If it's a task initiated from this thread, decrease the counter, but
       // don't do anything - loop condition will do all checks for us next.
-      if (base_owner == worker_device) {
+      if (base_owner == worker_device && base_owner_worker == worker_index) {
         --task.base->outstanding_tasks;
-      // Otherwise send a dummy function task to the owning thread just to
-      // ensure that it's not sleeping. If it has work, it might see that
-      // graph_task->outstanding_tasks == 0 before it gets to the task, but
-      // it's a no-op anyway.
-      } else if (base_owner != worker_device) {
-        if (--task.base->outstanding_tasks == 0) {
-          // Synchronize outstanding_tasks with queue mutex
-          std::atomic_thread_fence(std::memory_order_release);
-          ready_queue(base_owner).push_front(FunctionTask(task.base, nullptr, InputBuffer(0)));
-        }
+      // Otherwise wake up the owning thread just to ensure that it's not
+      // sleeping. The graph task can be freed as soon as the counter drops
+      // to zero, so it must not be accessed after the decrement.
+      } else if (--task.base->outstanding_tasks == 0) {
+        ready_queue(base_owner).wake_worker(base_owner_worker);
       }
     }
   }
@@ -349,6 +531,7 @@ auto Engine::execute(const function_list& input_roots,
     });
   } else {
     graph_task.owner = worker_device;
+    graph_task.owner_worker = worker_index;
     lock.unlock();
     thread_main(&graph_task);
   }
@@ -391,13 +574,19 @@ auto Engine::start_threads() -> void {
     num_devices = 0;
   }
 #endif
-  // One for CPU, plus one for every GPU device
-  int num_threads = num_devices + 1;
-  ready_queues = std::vector<std::shared_ptr<ReadyQueue>>(num_threads);
-  for (auto& queue : ready_queues)
-    queue.reset(new ReadyQueue());
-  for (int i = 0; i < num_threads; ++i) {
-    std::thread t(&Engine::thread_init, this, i - 1);
+  // One queue for CPU, plus one for every GPU device
+  int num_queues = num_devices + 1;
+  ready_queues = std::vector<std::shared_ptr<ReadyQueue>>(num_queues);
+  ready_queues[0].reset(new ReadyQueue(-1, cpu_threads, queue_order));
+  for (int i = 1; i < num_queues; ++i)
+    ready_queues[i].reset(new ReadyQueue(i - 1, 1, queue_order));
+  threads_started = true;
+  for (int worker = 0; worker < cpu_threads; ++worker) {
+    std::thread t(&Engine::thread_init, this, -1, worker);
+    t.detach();
+  }
+  for (int i = 1; i < num_queues; ++i) {
+    std::thread t(&Engine::thread_init, this, i - 1, 0);
     t.detach();
   }
 }
@@ -4,8 +4,10 @@
 // to "root" variables (variables created by the user with requires_grad=True).
 
 #include <Python.h>
+#include <atomic>
 #include <deque>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -20,6 +22,16 @@ struct ReadyQueue;
 struct FunctionTask;
 struct GraphTask;
 
+// Order in which the ready functions of a device are executed.
+enum class ReadyQueueOrder {
+  // In the order in which they became ready.
+  FIFO,
+  // Functions with larger sequence numbers first, i.e. the ones created
+  // later in the forward pass. Gradients of parameters used early in the
+  // forward pass are then produced as early as possible.
+  SequenceNr,
+};
+
 // A single instance of this struct should be created through the whole process lifetime.
 // The worker thread creation logic and Engine's destructor rely on this.
 struct Engine {
@@ -46,16 +58,29 @@ struct Engine {
 
   void queue_callback(std::function<void()> callback);
 
+  // Sets the number of worker threads executing CPU functions. Has to be
+  // called before the first call to execute(). Defaults to the value of
+  // the PYTORCH_AUTOGRAD_CPU_THREADS environment variable, or 1 if unset.
+  void set_num_cpu_threads(int num_threads);
+  int num_cpu_threads() const { return cpu_threads; }
+
+  // Has to be called before the first call to execute(). Defaults to FIFO,
+  // unless PYTORCH_AUTOGRAD_QUEUE_ORDER is set to "sequence_nr".
+  void set_ready_queue_order(ReadyQueueOrder order);
+
 protected:
   void compute_dependencies(Function* root, GraphTask& task);
   void evaluate_function(FunctionTask& task);
   ReadyQueue& ready_queue(int device);
   void start_threads();
-  virtual void thread_init(int device);
+  virtual void thread_init(int device, int worker);
   virtual void thread_main(GraphTask *task);
   virtual void thread_on_exception(FunctionTask& task, std::exception& e);
 
   std::once_flag start_threads_flag;
+  std::atomic_bool threads_started;
+  int cpu_threads;
+  ReadyQueueOrder queue_order;
   std::vector<std::shared_ptr<ReadyQueue>> ready_queues;
   std::vector<std::function<void()>> final_callbacks;
   std::mutex post_callbacks_lock;
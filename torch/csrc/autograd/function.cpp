@@ -1,6 +1,7 @@
 #include "Python.h"
 #include "function.h"
 
+#include <atomic>
 #include <string>
 
 #include "variable.h"
@@ -35,6 +36,14 @@ auto makeFlags(const T &inputs) -> FunctionFlags {
   return f;
 }
 
+// Shared by all threads, so that the numbers of functions created by
+// different threads can be compared.
+static std::atomic<uint64_t> sequence_nr_counter(0);
+
+auto Function::next_sequence_nr() -> uint64_t {
+  return sequence_nr_counter.fetch_add(1, std::memory_order_relaxed);
+}
+
 auto Function::flags(const variable_list& inputs) -> FunctionFlags {
   return makeFlags(inputs);
 }
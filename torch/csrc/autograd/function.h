@@ -15,6 +15,7 @@
 
 #include <ATen/ATen.h>
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -52,6 +53,7 @@ struct FunctionFlags {
 struct Function : std::enable_shared_from_this<Function> {
   Function()
     : num_inputs(0)
+    , sequence_nr(next_sequence_nr())
     , next_functions()
     , pre_hooks()
     , post_hooks()
@@ -60,6 +62,7 @@ struct Function : std::enable_shared_from_this<Function> {
 
   Function(FunctionFlags&& flags)
     : num_inputs(0)
+    , sequence_nr(next_sequence_nr())
     , next_functions(std::move(flags.next_functions))
     , pre_hooks()
     , post_hooks()
@@ -80,6 +83,11 @@ struct Function : std::enable_shared_from_this<Function> {
     if (jit::tracer::isTracingVar(inputs)) {
       return tracedApply(inputs);
     }
+    if (rec.recordsShapes()) {
+      auto outputs = apply(inputs);
+      rec.recordShapes(inputs, outputs);
+      return outputs;
+    }
     return apply(inputs);
   }
 
@@ -151,7 +159,13 @@ struct Function : std::enable_shared_from_this<Function> {
   static void setUpContextEdge(jit::Node* this_node,
                                const variable_list& inputs, const variable_list& outputs);
 
+  // Returns increasing numbers for the functions created by any thread.
+  static uint64_t next_sequence_nr();
+
   int num_inputs;
+  // Functions created later in the forward pass have larger sequence numbers.
+  // The engine can use them to prioritize ready functions.
+  uint64_t sequence_nr;
   function_list next_functions;
   std::vector<std::shared_ptr<FunctionPreHook>> pre_hooks;
   std::vector<std::shared_ptr<FunctionPostHook>> post_hooks;
@@ -2,6 +2,7 @@
 #include "accumulate_grad.h"
 
 #include "torch/csrc/autograd/grad_mode.h"
+#include "torch/csrc/autograd/profiler.h"
 #include "torch/csrc/autograd/variable.h"
 #include "torch/csrc/autograd/functions/basic_ops.h"
 #include "torch/csrc/autograd/functions/tensor.h"
@@ -18,8 +19,8 @@ AccumulateGrad::AccumulateGrad(Variable variable_)
 }
 
 auto AccumulateGrad::apply(const variable_list& grads) -> variable_list {
-  // XXX: this method is not thread-safe!
   check_input_variables("AccumulateGrad", grads, 1, 0);
+  std::lock_guard<std::mutex> lock(mutex);
 
   if (!grads[0].defined())
     return {};
@@ -35,9 +36,22 @@ auto AccumulateGrad::apply(const variable_list& grads) -> variable_list {
     new_grad = (*hook)({new_grad})[0];
   }
 
+  using profiler::GradAccumulation;
+  using profiler::recordGradAccumulation;
+
+  // Without hooks new_grad shares its handle with grads[0]; a hook may have
+  // returned a Variable it still holds, so then only one handle is ours.
+  int handles = variable.hooks().empty() ? 2 : 1;
   auto& grad = variable.grad();
   if (!grad.defined()) {
-    variable.grad() = new_grad.clone();
+    if (!GradMode::is_enabled() && is_uniquely_owned(new_grad, handles)) {
+      // Nothing else can observe this buffer, so adopt it instead of copying.
+      variable.grad() = new_grad;
+      recordGradAccumulation(GradAccumulation::Stolen);
+    } else {
+      variable.grad() = new_grad.clone();
+      recordGradAccumulation(GradAccumulation::Allocated);
+    }
   } else if (!GradMode::is_enabled()) {
     // This case is not strictly necessary, but it makes the first-order only case
     // slightly more efficient and, what's more important, more predictable for
@@ -46,11 +60,14 @@ auto AccumulateGrad::apply(const variable_list& grads) -> variable_list {
     // on the internet.
     if (grad.type().is_sparse() && !new_grad.type().is_sparse()) {
       grad.data() = new_grad.data() + grad.data();
+      recordGradAccumulation(GradAccumulation::Allocated);
     } else {
       grad.data() += new_grad.data();
+      recordGradAccumulation(GradAccumulation::InPlace);
     }
   } else {
     variable.grad() = grad + new_grad;
+    recordGradAccumulation(GradAccumulation::Allocated);
   }
 
   return variable_list();
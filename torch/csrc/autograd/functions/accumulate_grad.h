@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 #include "torch/csrc/autograd/function.h"
 #include "torch/csrc/autograd/variable.h"
 
@@ -11,6 +13,9 @@ struct AccumulateGrad : public Function {
   virtual variable_list apply(const variable_list& inputs) override;
 
   Variable variable;
+  // Graphs executed at the same time can share leaves, and apply can then
+  // be entered concurrently by different CPU workers.
+  std::mutex mutex;
 };
 
 }}
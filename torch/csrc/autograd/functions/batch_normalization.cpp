@@ -157,9 +157,9 @@ auto BatchNormBackward::apply(const variable_list& grad_outputs) -> variable_lis
 };
 
 auto BatchNormBackward::releaseVariables() -> void {
-  input.data.reset();
-  weight.data.reset();
-  bias.data.reset();
+  input.reset_data();
+  weight.reset_data();
+  bias.reset_data();
 }
 
 Variable getReturnTupleVar(PyObject *p, Py_ssize_t pos) {
@@ -193,9 +193,9 @@ auto BatchNormBackwardBackward::apply(const variable_list& grad_grad_inputs) ->
 };
 
 auto BatchNormBackwardBackward::releaseVariables() -> void {
-  input.data.reset();
-  weight.data.reset();
-  grad_output.data.reset();
+  input.reset_data();
+  weight.reset_data();
+  grad_output.reset_data();
 }
 
 
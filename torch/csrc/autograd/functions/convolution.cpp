@@ -124,6 +124,7 @@ auto ConvParams::use_nnpack(const at::Tensor& input) const -> bool {
          !is_dilated() && // or dilation
          !transposed &&   // or transposed tensors
          input.ndimension() == 4 && // must be in NCHW format
+         input.is_contiguous() &&
          input.size(0) >= 16; // ensure large enough batch size to ensure perf, tuneable
 #endif
   return false;
@@ -134,7 +135,8 @@ auto ConvParams::use_nnpack(const at::Tensor& input) const -> bool {
 // a depthwise multiplier)
 auto ConvParams::is_depthwise(
         const at::Tensor& input, const at::Tensor& weight, int groups) const -> bool {
-  return input.type().is_cuda() &&
+  return (input.type().is_cuda() || input.type().scalarType() == at::kFloat ||
+          input.type().scalarType() == at::kDouble) &&
          !transposed &&
          input.ndimension() == 4 &&
          input.size(1) == groups &&
@@ -142,6 +144,21 @@ auto ConvParams::is_depthwise(
          weight.size(0) % input.size(1) == 0; // output channels must be a multiple of input channels
 }
 
+// The CPU kernel for plain 2d convolutions takes channels-last (NHWC strided)
+// inputs as they are and returns channels-last outputs.
+auto ConvParams::use_channels_last(const at::Tensor& input) const -> bool {
+  if (input.type().is_cuda() || input.ndimension() != 4 || input.is_contiguous() ||
+      transposed || is_dilated() || groups != 1) {
+    return false;
+  }
+  auto sizes = input.sizes();
+  auto strides = input.strides();
+  return (sizes[0] == 1 || strides[0] == sizes[1] * sizes[2] * sizes[3]) &&
+         (sizes[1] == 1 || strides[1] == 1) &&
+         (sizes[2] == 1 || strides[2] == sizes[1] * sizes[3]) &&
+         (sizes[3] == 1 || strides[3] == sizes[1]);
+}
+
 std::string ConvForward::name() { return "ConvForward"; }
 
 auto ConvForward::output_size(at::Tensor& input, at::Tensor& weight) const -> std::vector<int64_t> {
@@ -271,7 +288,10 @@ auto ConvForward::apply(const variable_list& inputs) -> variable_list {
 
   AutoGPU guard(inputs[0]);
 
-  auto input = inputs[0].data().contiguous();
+  auto input = inputs[0].data();
+  if (!use_channels_last(input)) {
+    input = input.contiguous();
+  }
   auto weight = inputs[1].data();
   auto bias = inputs[2].opt_data();
 
@@ -508,9 +528,9 @@ auto ConvBackward::apply(const variable_list& grad_outputs) -> variable_list {
 };
 
 auto ConvBackward::releaseVariables() -> void {
-  input_.data.reset();
-  weight_.data.reset();
-  bias_.data.reset();
+  input_.reset_data();
+  weight_.reset_data();
+  bias_.reset_data();
 }
 
 
@@ -728,10 +748,10 @@ auto ConvBackwardBackward::apply(const variable_list& grad_grad_inputs) -> varia
 }
 
 auto ConvBackwardBackward::releaseVariables() -> void {
-  input_.data.reset();
-  weight_.data.reset();
-  bias_.data.reset();
-  grad_output_.data.reset();
+  input_.reset_data();
+  weight_.reset_data();
+  bias_.reset_data();
+  grad_output_.reset_data();
 }
 
 // Forward and backward functions for Tensor
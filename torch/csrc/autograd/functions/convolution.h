@@ -34,6 +34,7 @@ struct ConvParams {
   bool use_cudnn(const at::Tensor& input) const;
   bool use_nnpack(const at::Tensor& input) const;
   bool is_depthwise(const at::Tensor& input, const at::Tensor& weight, int groups) const;
+  bool use_channels_last(const at::Tensor& input) const;
 };
 
 struct ConvForward : public ForwardFunction<>, public ConvParams, public HasSymbolic {
@@ -4,6 +4,7 @@
 
 #include "torch/csrc/autograd/variable.h"
 
+#include <TH/TH.h>
 #include <sstream>
 
 namespace torch { namespace autograd {
@@ -35,6 +36,23 @@ variable_list wrap_outputs(const variable_list& inputs, tensor_list&& outputs,
   return result;
 }
 
+// All dense TH and THC tensors share the generic THTensor/THStorage layout,
+// so the refcounts can be read through the Float instantiation whatever the
+// actual type is.
+static bool th_uniquely_owned(const at::Tensor& tensor) {
+  auto th = static_cast<THFloatTensor*>(tensor.unsafeGetTH(false));
+  return th->refcount == 1 && (!th->storage || th->storage->refcount == 1);
+}
+
+bool is_uniquely_owned(const Variable& var, int handles) {
+  return var.defined() &&
+         !var.type().is_sparse() &&
+         !var.is_view() &&
+         var.get()->use_count() <= handles &&
+         var.data().get()->use_count() == 1 &&
+         th_uniquely_owned(var.data());
+}
+
 void check_input_variables(const char* name, const variable_list& inputs, int args, int required_args) {
   if (required_args == -1) {
     required_args = args;
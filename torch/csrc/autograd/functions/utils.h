@@ -40,4 +40,11 @@ variable_list wrap_outputs(const variable_list& inputs, tensor_list&& outputs,
  */
 void check_input_variables(const char* name, const variable_list& inputs, int args, int required_args=-1);
 
+/**
+ * Returns true if `var` is a dense Variable referenced by at most `handles`
+ * Variable handles, is not a view and no other tensor shares its data, i.e.
+ * the caller may adopt it or modify it in-place without anybody noticing.
+ */
+bool is_uniquely_owned(const Variable& var, int handles=1);
+
 }}
@@ -1,7 +1,11 @@
 #include <Python.h>
 #include "torch/csrc/utils/pybind.h"
+#include "torch/csrc/autograd/checkpoint.h"
 #include "torch/csrc/autograd/grad_mode.h"
 #include "torch/csrc/autograd/profiler.h"
+#include "torch/csrc/autograd/python_variable.h"
+#include "torch/csrc/utils/auto_gil.h"
+#include "torch/csrc/utils/object_ptr.h"
 
 #include "THP.h"
 
@@ -33,20 +37,39 @@ PyObject * THPAutograd_initExtension(PyObject *_unused)
   .def("device",&torch::autograd::profiler::Event::device)
   .def("cpu_elapsed_us",&torch::autograd::profiler::Event::cpu_elapsed_us)
   .def("cuda_elapsed_us",&torch::autograd::profiler::Event::cuda_elapsed_us)
-  .def("has_cuda",&torch::autograd::profiler::Event::has_cuda);
+  .def("has_cuda",&torch::autograd::profiler::Event::has_cuda)
+  .def("has_shapes",&torch::autograd::profiler::Event::has_shapes)
+  .def("input_shapes",&torch::autograd::profiler::Event::input_shapes)
+  .def("input_dtypes",&torch::autograd::profiler::Event::input_dtypes)
+  .def("flops",&torch::autograd::profiler::Event::flops)
+  .def("bytes",&torch::autograd::profiler::Event::bytes);
   py::enum_<torch::autograd::profiler::ProfilerState>(m,"ProfilerState")
   .value("Disabled", torch::autograd::profiler::ProfilerState::Disabled)
   .value("CPU", torch::autograd::profiler::ProfilerState::CPU)
   .value("CUDA", torch::autograd::profiler::ProfilerState::CUDA)
-  .value("NVTX", torch::autograd::profiler::ProfilerState::NVTX);
+  .value("NVTX", torch::autograd::profiler::ProfilerState::NVTX)
+  .value("Stream", torch::autograd::profiler::ProfilerState::Stream);
 
-  m.def("_enable_profiler", torch::autograd::profiler::enableProfiler);
+  m.def("_enable_profiler", torch::autograd::profiler::enableProfiler,
+        py::arg("state"), py::arg("record_shapes") = false);
   m.def("_disable_profiler", torch::autograd::profiler::disableProfiler);
+  m.def("_enable_streaming_profiler", torch::autograd::profiler::enableStreamingProfiler);
+  m.def("_disable_streaming_profiler", torch::autograd::profiler::disableStreamingProfiler);
+  m.def("_profiler_step", torch::autograd::profiler::step);
 
+  m.def("_grad_accumulation_counts", []() {
+    using namespace torch::autograd::profiler;
+    return std::make_tuple(
+        grad_accumulation_counts[static_cast<int>(GradAccumulation::Allocated)].load(),
+        grad_accumulation_counts[static_cast<int>(GradAccumulation::InPlace)].load(),
+        grad_accumulation_counts[static_cast<int>(GradAccumulation::Stolen)].load());
+  });
+
+  // Returns whether the range was recorded, and so has to be popped.
   m.def("_push_range", [](const char *name) {
     using namespace torch::autograd::profiler;
-    if (state  == ProfilerState::Disabled) return;
-    pushRange(name);
+    if (!isRecording()) return false;
+    return pushRange(name);
   });
   m.def("_pop_range", []() {
     using namespace torch::autograd::profiler;
@@ -79,10 +102,86 @@ static PyObject * is_grad_enabled(PyObject* _unused, PyObject *arg) {
   END_HANDLE_TH_ERRORS
 }
 
+static PyObject* wrap_variables(const variable_list& vars) {
+  THPObjectPtr tuple(PyTuple_New(vars.size()));
+  if (!tuple) throw python_error();
+  for (size_t i = 0; i < vars.size(); ++i) {
+    THPObjectPtr var(THPVariable_Wrap(vars[i]));
+    if (!var) throw python_error();
+    PyTuple_SET_ITEM(tuple.get(), i, var.release());
+  }
+  return tuple.release();
+}
+
+static variable_list unwrap_variables(PyObject* tuple, const char* what) {
+  if (THPVariable_Check(tuple)) {
+    return {((THPVariable*)tuple)->cdata};
+  }
+  if (!PyTuple_Check(tuple)) {
+    at::runtime_error("%s must be a Variable or a tuple of Variables (got %s)",
+        what, Py_TYPE(tuple)->tp_name);
+  }
+  variable_list vars(PyTuple_GET_SIZE(tuple));
+  for (size_t i = 0; i < vars.size(); ++i) {
+    PyObject* item = PyTuple_GET_ITEM(tuple, i);
+    if (!THPVariable_Check(item)) {
+      at::runtime_error("%s must be a Variable or a tuple of Variables (got %s at index %d)",
+          what, Py_TYPE(item)->tp_name, (int)i);
+    }
+    vars[i] = ((THPVariable*)item)->cdata;
+  }
+  return vars;
+}
+
+// The segment keeps the function to re-run it during backward, possibly on
+// an engine thread, so the reference is only dropped with the GIL held.
+static CheckpointSegment::function_type wrap_checkpoint_function(PyObject* fn) {
+  Py_INCREF(fn);
+  std::shared_ptr<PyObject> fn_ptr(fn, [](PyObject* obj) {
+    AutoGIL gil;
+    Py_DECREF(obj);
+  });
+  return [fn_ptr](const variable_list& inputs) -> variable_list {
+    AutoGIL gil;
+    THPObjectPtr args(wrap_variables(inputs));
+    THPObjectPtr result(PyObject_CallObject(fn_ptr.get(), args.get()));
+    if (!result) throw python_error();
+    return unwrap_variables(result.get(), "checkpointed function output");
+  };
+}
+
+// _checkpoint(fn, inputs, mode='recompute', path='') runs fn(*inputs) as a
+// checkpointed segment and returns its outputs as a tuple.
+static PyObject * python_checkpoint(PyObject* _unused, PyObject *args) {
+  HANDLE_TH_ERRORS
+  PyObject* fn = nullptr;
+  PyObject* inputs = nullptr;
+  const char* mode = "recompute";
+  const char* path = "";
+  if (!PyArg_ParseTuple(args, "OO|ss", &fn, &inputs, &mode, &path)) {
+    return NULL;
+  }
+  CheckpointSegment::Mode segment_mode;
+  if (strcmp(mode, "recompute") == 0) {
+    segment_mode = CheckpointSegment::Mode::Recompute;
+  } else if (strcmp(mode, "host") == 0) {
+    segment_mode = CheckpointSegment::Mode::Host;
+  } else if (strcmp(mode, "file") == 0) {
+    segment_mode = CheckpointSegment::Mode::File;
+  } else {
+    at::runtime_error("mode must be one of 'recompute', 'host' or 'file' (got '%s')", mode);
+  }
+  auto outputs = torch::autograd::checkpoint(
+      wrap_checkpoint_function(fn), unwrap_variables(inputs, "inputs"), segment_mode, path);
+  return wrap_variables(outputs);
+  END_HANDLE_TH_ERRORS
+}
+
 // autograd methods on torch._C
 static PyMethodDef methods[] = {
   {"set_grad_enabled", (PyCFunction)set_grad_enabled, METH_O, NULL},
   {"is_grad_enabled", (PyCFunction)is_grad_enabled, METH_NOARGS, NULL},
+  {"_checkpoint", (PyCFunction)python_checkpoint, METH_VARARGS, NULL},
   {NULL, NULL, 0, NULL}
 };
 
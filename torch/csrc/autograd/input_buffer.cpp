@@ -1,11 +1,25 @@
 #include "torch/csrc/autograd/input_buffer.h"
 
 #include "torch/csrc/assertions.h"
+#include "torch/csrc/autograd/grad_mode.h"
+#include "torch/csrc/autograd/profiler.h"
 #include "torch/csrc/autograd/functions/basic_ops.h"
+#include "torch/csrc/autograd/functions/utils.h"
 #include "torch/csrc/utils/auto_gpu.h"
 
 namespace torch { namespace autograd {
 
+using profiler::GradAccumulation;
+using profiler::recordGradAccumulation;
+
+// Summing in-place doesn't record history, so it's only done when the
+// backward pass itself isn't being differentiated.
+static bool can_accumulate_into(const Variable& acc, const Variable& var) {
+  return !GradMode::is_enabled() &&
+         &acc.type() == &var.type() &&
+         acc.sizes().equals(var.sizes()) &&
+         is_uniquely_owned(acc);
+}
 
 void InputBuffer::add(size_t pos, Variable var) {
   TORCH_ASSERT(pos >= 0 && pos < buffer.size());
@@ -15,6 +29,13 @@ void InputBuffer::add(size_t pos, Variable var) {
   auto& old_var = buffer[pos];
   if (!old_var.defined()) {
     buffer[pos] = std::move(var);
+  } else if (can_accumulate_into(old_var, var)) {
+    old_var.data() += var.data();
+    recordGradAccumulation(GradAccumulation::InPlace);
+  } else if (can_accumulate_into(var, old_var)) {
+    var.data() += old_var.data();
+    buffer[pos] = std::move(var);
+    recordGradAccumulation(GradAccumulation::InPlace);
   } else {
     // ATen doesn't route sparse additions correctly...
     if (old_var.type().is_sparse()) {
@@ -22,6 +43,7 @@ void InputBuffer::add(size_t pos, Variable var) {
     } else {
       buffer[pos] = old_var + var;
     }
+    recordGradAccumulation(GradAccumulation::Allocated);
   }
 }
 
@@ -1,17 +1,215 @@
 #include "torch/csrc/autograd/profiler.h"
 #include "torch/csrc/autograd/function.h"
+#include "torch/csrc/autograd/functions/convolution.h"
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
 
 namespace torch { namespace autograd { namespace profiler {
 
 ProfilerState state = ProfilerState::Disabled;
+bool record_shapes = false;
+std::atomic<bool> sampled_in(true);
 uint32_t next_thread_id = 0;
 std::mutex all_event_lists_mutex;
 std::list<std::shared_ptr<RangeEventList>> all_event_lists;
 thread_local std::shared_ptr<RangeEventList> event_list;
 thread_local int32_t thread_id;
+std::atomic<uint64_t> grad_accumulation_counts[static_cast<int>(GradAccumulation::NumKinds)];
+
+namespace {
+
+struct CStringHash {
+  std::size_t operator()(const char* str) const {
+    // FNV-1a
+    std::size_t hash = 14695981039346656037ULL;
+    for (; *str; ++str) {
+      hash = (hash ^ static_cast<unsigned char>(*str)) * 1099511628211ULL;
+    }
+    return hash;
+  }
+};
+
+struct CStringEqual {
+  bool operator()(const char* a, const char* b) const {
+    return std::strcmp(a, b) == 0;
+  }
+};
+
+std::mutex interned_names_mutex;
+// Elements of an unordered_set never move, so their c_str()s stay valid.
+std::unordered_set<std::string> interned_names;
+// Per-thread index of interned_names, keyed by the interned pointers.
+thread_local std::unordered_set<const char*, CStringHash, CStringEqual> local_interned_names;
+
+uint64_t sample_every = 1;
+std::atomic<uint64_t> iteration(0);
+
+} // anonymous namespace
+
+const char* intern(const char* name) {
+  auto it = local_interned_names.find(name);
+  if (it != local_interned_names.end()) {
+    return *it;
+  }
+  const char* result;
+  {
+    std::lock_guard<std::mutex> guard(interned_names_mutex);
+    result = interned_names.emplace(name).first->c_str();
+  }
+  local_interned_names.insert(result);
+  return result;
+}
+
+bool RecordFunction::pushFunctionRange(Function* fn) {
+  return pushRange(fn->name());
+}
+
+namespace {
+
+const std::unordered_set<std::string> pointwise_ops = {
+  "abs", "add", "addcdiv", "addcmul", "ceil", "clamp", "cos", "cosh", "div",
+  "elu", "exp", "floor", "fmod", "hardtanh", "leaky_relu", "lerp", "log",
+  "log1p", "mul", "neg", "pow", "reciprocal", "relu", "remainder", "round",
+  "rsqrt", "sigmoid", "sign", "sin", "sinh", "softplus", "sqrt", "sub",
+  "tan", "tanh", "threshold", "trunc",
+};
 
-void RecordFunction::pushFunctionRange(Function* fn) {
-  pushRange(fn->name());
+const std::unordered_set<std::string> reduction_ops = {
+  "batch_norm", "cumprod", "cumsum", "log_softmax", "mean", "norm", "prod",
+  "softmax", "std", "sum", "var",
+};
+
+int64_t size(const variable_list& tensors, std::size_t i, int64_t dim) {
+  if (i >= tensors.size() || !tensors[i].defined() || tensors[i].dim() <= dim) {
+    return 0;
+  }
+  return tensors[i].size(dim);
+}
+
+int64_t numel(const variable_list& tensors, std::size_t i) {
+  if (i >= tensors.size() || !tensors[i].defined()) {
+    return 0;
+  }
+  return tensors[i].numel();
+}
+
+// Multiply-adds of a convolution, from the input, weight and output sizes.
+// Weights are out x in/groups x k... when the convolution is direct and
+// in x out/groups x k... when it's transposed, so in both cases each
+// element of the smaller side meets weight.numel() / weight.size(0) others.
+double convMacs(bool transposed, int64_t input_numel, const at::Tensor& weight,
+                int64_t output_numel) {
+  if (!weight.defined() || weight.dim() == 0 || weight.size(0) == 0) {
+    return 0;
+  }
+  double per_element = static_cast<double>(weight.numel()) / weight.size(0);
+  return (transposed ? input_numel : output_numel) * per_element;
+}
+
+// Rough FLOP counts of the ops that usually dominate: matrix products and
+// convolutions count two per multiply-add, pointwise ops one per output
+// element and reductions one per input element. Anything else counts zero.
+double estimateFlops(Function* fn, const char* name, const variable_list& inputs,
+                     const variable_list& outputs) {
+  if (fn) {
+    auto conv = dynamic_cast<ConvParams*>(fn);
+    if (!conv) {
+      return 0;
+    }
+    if (dynamic_cast<ConvForward*>(fn)) {
+      if (inputs.size() < 2) {
+        return 0;
+      }
+      double macs = convMacs(conv->transposed, numel(inputs, 0), inputs[1], numel(outputs, 0));
+      return 2 * macs + (numel(inputs, 2) ? numel(outputs, 0) : 0);
+    }
+    // ConvBackward: grad_output -> grad_input, grad_weight, grad_bias. The
+    // weight's shape is only known when its gradient is computed.
+    if (outputs.size() < 2 || !outputs[1].defined()) {
+      return 0;
+    }
+    double macs = convMacs(conv->transposed, numel(outputs, 0), outputs[1], numel(inputs, 0));
+    return 2 * macs * (outputs[0].defined() ? 2 : 1) + (numel(outputs, 2) ? numel(inputs, 0) : 0);
+  }
+
+  std::string op = name;
+  if (op.compare(0, 2, "s_") == 0) op = op.substr(2);
+  if (op.compare(0, 5, "thnn_") == 0) op = op.substr(5);
+  if (!op.empty() && op.back() == '_') op.pop_back();
+  static const std::string forward_suffix = "_forward";
+  if (op.size() > forward_suffix.size() &&
+      op.compare(op.size() - forward_suffix.size(), forward_suffix.size(), forward_suffix) == 0) {
+    op.resize(op.size() - forward_suffix.size());
+  }
+
+  if (op == "mm") {
+    return 2.0 * size(inputs, 0, 0) * size(inputs, 0, 1) * size(inputs, 1, 1);
+  } else if (op == "addmm") {
+    double mn = static_cast<double>(size(inputs, 1, 0)) * size(inputs, 2, 1);
+    return 2.0 * mn * size(inputs, 1, 1) + mn;
+  } else if (op == "bmm") {
+    return 2.0 * size(inputs, 0, 0) * size(inputs, 0, 1) * size(inputs, 0, 2) * size(inputs, 1, 2);
+  } else if (op == "baddbmm" || op == "addbmm") {
+    return 2.0 * size(inputs, 1, 0) * size(inputs, 1, 1) * size(inputs, 1, 2) * size(inputs, 2, 2) +
+           numel(outputs, 0);
+  } else if (op == "mv") {
+    return 2.0 * numel(inputs, 0);
+  } else if (op == "addmv") {
+    return 2.0 * numel(inputs, 1) + numel(outputs, 0);
+  } else if (op == "dot") {
+    return 2.0 * numel(inputs, 0);
+  } else if (op == "ger") {
+    return static_cast<double>(numel(outputs, 0));
+  } else if (op == "addr") {
+    return 2.0 * numel(outputs, 0);
+  } else if (op.find("conv") != std::string::npos && op.find("backward") == std::string::npos &&
+             inputs.size() >= 2) {
+    bool transposed = op.find("transpose") != std::string::npos;
+    return 2 * convMacs(transposed, numel(inputs, 0), inputs[1], numel(outputs, 0));
+  } else if (pointwise_ops.count(op)) {
+    return static_cast<double>(numel(outputs, 0));
+  } else if (reduction_ops.count(op)) {
+    return static_cast<double>(numel(inputs, 0));
+  }
+  return 0;
+}
+
+} // anonymous namespace
+
+void RecordFunction::recordShapes(const variable_list& inputs, const variable_list& outputs) {
+  if (!recordsShapes()) return;
+  active = false;
+  if (state != ProfilerState::CPU && state != ProfilerState::CUDA) {
+    if (state != ProfilerState::Disabled) popRange();
+    return;
+  }
+  // Blocks of the event list never reallocate, so the event stays put.
+  Event& pop = getEventList().record(EventKind::PopRange, "", thread_id,
+                                     state == ProfilerState::CUDA);
+  auto result = std::make_shared<OpShapes>();
+  result->input_shapes.reserve(inputs.size());
+  result->input_dtypes.reserve(inputs.size());
+  for (auto& input : inputs) {
+    if (input.defined()) {
+      result->input_shapes.emplace_back(input.sizes().vec());
+      result->input_dtypes.emplace_back(at::toString(input.type().scalarType()));
+      result->bytes += static_cast<double>(input.numel()) * input.type().elementSizeInBytes();
+    } else {
+      result->input_shapes.emplace_back();
+      result->input_dtypes.emplace_back();
+    }
+  }
+  for (auto& output : outputs) {
+    if (output.defined()) {
+      result->bytes += static_cast<double>(output.numel()) * output.type().elementSizeInBytes();
+    }
+  }
+  result->flops = estimateFlops(fn, name, inputs, outputs);
+  pop.set_shapes(std::move(result));
 }
 
 #ifdef WITH_CUDA
@@ -26,8 +224,11 @@ static void onEachDevice(std::function<void(int)> op) {
 }
 #endif
 
-void enableProfiler(ProfilerState new_state) {
+void enableProfiler(ProfilerState new_state, bool new_record_shapes) {
   TORCH_ASSERT(new_state != ProfilerState::Disabled);
+  if (new_state == ProfilerState::Stream) {
+    throw std::runtime_error("use enableStreamingProfiler to stream events");
+  }
 #ifndef WITH_CUDA
   if (new_state == ProfilerState::NVTX)
     throw std::runtime_error("Can't use NVTX profiler - PyTorch was compiled without CUDA");
@@ -36,6 +237,12 @@ void enableProfiler(ProfilerState new_state) {
       throw std::runtime_error("can't change kind of profiling (e.g. NVTX to CPU) while profiler is running");
   }
   state = new_state;
+  record_shapes = new_record_shapes && new_state != ProfilerState::NVTX;
+  sample_every = 1;
+  sampled_in = true;
+  for (auto& count : grad_accumulation_counts) {
+    count = 0;
+  }
 
 #ifdef WITH_CUDA
   if(state == ProfilerState::CUDA) {
@@ -63,9 +270,13 @@ thread_event_lists disableProfiler() {
   if (state == ProfilerState::Disabled) {
     throw std::runtime_error("can't disable profiler when it's not running");
   }
+  if (state == ProfilerState::Stream) {
+    throw std::runtime_error("use disableStreamingProfiler to stop streaming events");
+  }
   ProfilerState old_state = state;
   mark("__stop_profile");
   state = ProfilerState::Disabled;
+  record_shapes = false;
   if (old_state == ProfilerState::NVTX) {
     return thread_event_lists();
   } else {
@@ -87,4 +298,182 @@ thread_event_lists disableProfiler() {
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Streaming
+
+thread_local std::shared_ptr<EventRing> event_ring;
+uint64_t stream_session = 0;
+
+namespace {
+
+struct TraceWriter {
+  TraceWriter(const std::string& path, std::size_t buffer_events);
+  ~TraceWriter();
+
+  void flush();
+  void run();
+
+  std::FILE* file;
+  std::size_t buffer_events;
+  int64_t start_ns;
+  bool first_event;
+  // rings of all threads that recorded in this session, under rings_mutex
+  std::vector<std::shared_ptr<EventRing>> rings;
+  // wakes up the writer thread early when the profiler is disabled
+  std::mutex stop_mutex;
+  std::condition_variable stop_cv;
+  bool stop;
+  std::thread thread;
+};
+
+constexpr auto flush_interval = std::chrono::milliseconds(100);
+
+// Guards writer and its rings. Threads that saw the Stream state just before
+// the profiler was disabled can still register a ring afterwards.
+std::mutex rings_mutex;
+std::unique_ptr<TraceWriter> writer;
+
+void writeJSONString(std::FILE* file, const char* str) {
+  std::fputc('"', file);
+  for (; *str; ++str) {
+    unsigned char c = *str;
+    if (c == '"' || c == '\\') {
+      std::fputc('\\', file);
+      std::fputc(c, file);
+    } else if (c < 0x20) {
+      std::fprintf(file, "\\u%04x", c);
+    } else {
+      std::fputc(c, file);
+    }
+  }
+  std::fputc('"', file);
+}
+
+TraceWriter::TraceWriter(const std::string& path, std::size_t buffer_events)
+  : file(std::fopen(path.c_str(), "w"))
+  , buffer_events(buffer_events)
+  , start_ns(getTime())
+  , first_event(true)
+  , stop(false) {
+  if (!file) {
+    throw std::runtime_error("profiler: can't open '" + path + "': " + std::strerror(errno));
+  }
+  std::fputs("[\n", file);
+  thread = std::thread(&TraceWriter::run, this);
+}
+
+TraceWriter::~TraceWriter() {
+  {
+    std::lock_guard<std::mutex> guard(stop_mutex);
+    stop = true;
+  }
+  stop_cv.notify_one();
+  thread.join();
+  flush();
+  std::fputs("\n]\n", file);
+  std::fclose(file);
+}
+
+void TraceWriter::run() {
+  std::unique_lock<std::mutex> lock(stop_mutex);
+  while (!stop) {
+    stop_cv.wait_for(lock, flush_interval);
+    lock.unlock();
+    flush();
+    lock.lock();
+  }
+}
+
+// Only called by one thread at a time: the writer thread, then the
+// destructor after it has joined.
+void TraceWriter::flush() {
+  std::vector<std::shared_ptr<EventRing>> current_rings;
+  {
+    std::lock_guard<std::mutex> guard(rings_mutex);
+    current_rings = rings;
+  }
+  for (auto& ring : current_rings) {
+    auto tid = ring->thread_id;
+    ring->drain([&](const StreamEvent& event) {
+      const char* phase = event.kind == EventKind::PushRange ? "B" :
+                          event.kind == EventKind::PopRange ? "E" : "i";
+      std::fputs(first_event ? "" : ",\n", file);
+      first_event = false;
+      std::fputs("{\"name\":", file);
+      writeJSONString(file, event.name);
+      std::fprintf(file, ",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}",
+                   phase, (event.cpu_ns - start_ns) / 1000.0, tid);
+    });
+  }
+  std::fflush(file);
+}
+
+} // anonymous namespace
+
+EventRing& registerEventRing() {
+  uint32_t ring_thread_id;
+  {
+    std::lock_guard<std::mutex> guard(all_event_lists_mutex);
+    ring_thread_id = next_thread_id++;
+  }
+  std::lock_guard<std::mutex> guard(rings_mutex);
+  if (!writer) {
+    // streaming was just disabled: give the thread a ring that drops everything
+    event_ring = std::make_shared<EventRing>(0, ring_thread_id, stream_session);
+    return *event_ring;
+  }
+  event_ring = std::make_shared<EventRing>(writer->buffer_events, ring_thread_id,
+                                           stream_session);
+  writer->rings.push_back(event_ring);
+  return *event_ring;
+}
+
+void enableStreamingProfiler(const std::string& path, std::size_t buffer_events,
+                             uint64_t every) {
+  if (state != ProfilerState::Disabled) {
+    throw std::runtime_error("can't start streaming while the profiler is running");
+  }
+  if (buffer_events == 0 || every == 0) {
+    throw std::runtime_error("buffer_events and sample_every must be positive");
+  }
+  {
+    std::lock_guard<std::mutex> guard(rings_mutex);
+    writer.reset(new TraceWriter(path, buffer_events));
+  }
+  stream_session++;
+  sample_every = every;
+  iteration = 0;
+  sampled_in = true;
+  for (auto& count : grad_accumulation_counts) {
+    count = 0;
+  }
+  state = ProfilerState::Stream;
+}
+
+uint64_t disableStreamingProfiler() {
+  if (state != ProfilerState::Stream) {
+    throw std::runtime_error("can't disable streaming when it's not running");
+  }
+  state = ProfilerState::Disabled;
+  record_shapes = false;
+  sampled_in = true;
+  uint64_t dropped = 0;
+  std::unique_ptr<TraceWriter> old_writer;
+  {
+    std::lock_guard<std::mutex> guard(rings_mutex);
+    for (auto& ring : writer->rings) {
+      dropped += ring->dropped;
+    }
+    old_writer = std::move(writer);
+  }
+  // the last flush takes rings_mutex too
+  old_writer.reset();
+  return dropped;
+}
+
+void step() {
+  if (state == ProfilerState::Disabled) return;
+  sampled_in = (++iteration % sample_every) == 0;
+}
+
 }}}
@@ -4,6 +4,7 @@
 #include <nvToolsExt.h>
 #endif
 #include <thread>
+#include <atomic>
 #include <iostream>
 #include <mutex>
 #include <memory>
@@ -14,6 +15,7 @@
 #include <sstream>
 #include <forward_list>
 #include <tuple>
+#include <unordered_set>
 #include "ATen/ATen.h"
 #include "torch/csrc/cuda/cuda_check.h"
 #ifdef WITH_CUDA
@@ -23,6 +25,8 @@
 namespace torch { namespace autograd {
 
 struct Function;
+struct Variable;
+using variable_list = std::vector<Variable>;
 
 namespace profiler {
 
@@ -36,6 +40,24 @@ inline uint64_t getTime() {
   return duration_cast<nanoseconds>(clock::now().time_since_epoch()).count();
 }
 
+// Returns a copy of name that lives as long as the process. Events keep
+// these pointers instead of their own strings. Looking up a name that was
+// already seen on the calling thread doesn't allocate or take a lock.
+const char* intern(const char* name);
+inline const char* intern(const std::string& name) {
+  return intern(name.c_str());
+}
+
+// Shapes and dtypes of the inputs of a range, with rough estimates of the
+// floating point operations it performed and of the bytes it read and
+// wrote. Undefined inputs have an empty dtype.
+struct OpShapes {
+  std::vector<std::vector<int64_t>> input_shapes;
+  std::vector<std::string> input_dtypes;
+  double flops = 0;
+  double bytes = 0;
+};
+
 enum class EventKind {
   Mark,
   PushRange,
@@ -43,9 +65,10 @@ enum class EventKind {
 };
 
 struct Event {
-  Event(EventKind kind, std::string name, uint32_t thread_id, bool record_cuda)
+  // name must be interned
+  Event(EventKind kind, const char* name, uint32_t thread_id, bool record_cuda)
   : kind_(kind)
-  , name_(std::move(name))
+  , name_(name)
   , thread_id_(thread_id) {
 #ifdef WITH_CUDA
     if(record_cuda) {
@@ -69,7 +92,7 @@ struct Event {
     }
     throw std::runtime_error("unknown EventKind");
   }
-  const std::string & name() const {
+  std::string name() const {
     return name_;
   }
   uint32_t thread_id() const {
@@ -105,15 +128,35 @@ struct Event {
   int device() const {
     return device_;
   }
+  // Only set on the PopRange events of ranges that recorded their shapes.
+  void set_shapes(std::shared_ptr<const OpShapes> shapes) {
+    shapes_ = std::move(shapes);
+  }
+  bool has_shapes() const {
+    return shapes_ != nullptr;
+  }
+  std::vector<std::vector<int64_t>> input_shapes() const {
+    return shapes_ ? shapes_->input_shapes : std::vector<std::vector<int64_t>>();
+  }
+  std::vector<std::string> input_dtypes() const {
+    return shapes_ ? shapes_->input_dtypes : std::vector<std::string>();
+  }
+  double flops() const {
+    return shapes_ ? shapes_->flops : 0;
+  }
+  double bytes() const {
+    return shapes_ ? shapes_->bytes : 0;
+  }
 private:
   EventKind kind_;
-  std::string name_;
+  const char* name_;
   uint32_t thread_id_;
   int64_t cpu_ns_; // signed to allow for negative intervals
 #ifdef WITH_CUDA
   cudaEvent_t event = nullptr;
 #endif
   int device_ = -1;
+  std::shared_ptr<const OpShapes> shapes_;
 };
 
 // a linked-list of fixed sized vectors, to avoid
@@ -134,11 +177,12 @@ struct RangeEventList {
   }
 
   template<typename... Args>
-  void record(Args&&... args) {
+  Event& record(Args&&... args) {
     if (blocks.empty() || blocks.front().size() == num_block_elements) {
       allocBlock();
     }
     blocks.front().emplace_back(std::forward<Args>(args)...);
+    return blocks.front().back();
   }
 
   std::vector<Event> consolidate() {
@@ -155,14 +199,80 @@ struct RangeEventList {
   std::forward_list<block_type> blocks;
 };
 
+// Events recorded in streaming mode. They go to a fixed-size ring per
+// thread, which a background thread drains into a Chrome trace file, so
+// memory use doesn't grow with the length of the run.
+struct StreamEvent {
+  EventKind kind;
+  const char* name;
+  int64_t cpu_ns;
+};
+
+// Single producer (the recording thread), single consumer (the writer).
+// Events that don't fit are dropped and counted. A PushRange is only stored
+// if there's also room for its PopRange, which then always fits, so the
+// trace never has unmatched ranges.
+struct EventRing {
+  EventRing(std::size_t capacity, uint32_t thread_id, uint64_t session)
+  : events(capacity), thread_id(thread_id), session(session)
+  , head(0), tail(0), dropped(0), reserved(0) {}
+
+  // Returns whether the event was stored. A PopRange must only be recorded
+  // if its PushRange was.
+  bool record(EventKind kind, const char* name) {
+    auto h = head.load(std::memory_order_relaxed);
+    if (kind == EventKind::PopRange) {
+      if (reserved == 0) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      reserved--;
+    } else {
+      std::size_t needed = kind == EventKind::PushRange ? 2 : 1;
+      if (h - tail.load(std::memory_order_acquire) + reserved + needed > events.size()) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      if (kind == EventKind::PushRange) reserved++;
+    }
+    events[h % events.size()] = StreamEvent{kind, name, static_cast<int64_t>(getTime())};
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  template<typename F>
+  void drain(F fn) {
+    auto t = tail.load(std::memory_order_relaxed);
+    auto h = head.load(std::memory_order_acquire);
+    for (; t != h; ++t) {
+      fn(events[t % events.size()]);
+    }
+    tail.store(t, std::memory_order_release);
+  }
+
+  std::vector<StreamEvent> events;
+  const uint32_t thread_id;
+  const uint64_t session;
+  std::atomic<std::size_t> head;
+  std::atomic<std::size_t> tail;
+  std::atomic<uint64_t> dropped;
+  // slots held for the PopRanges of the stored PushRanges (producer only)
+  std::size_t reserved;
+};
+
 enum class ProfilerState {
     Disabled,
     CPU, // CPU-only profiling
     CUDA, // CPU + CUDA events
     NVTX,  // only emit NVTX markers
+    Stream, // CPU events streamed to a Chrome trace (see enableStreamingProfiler)
 };
 
 extern ProfilerState state;
+// Whether RecordFunctions capture the shapes of their inputs.
+extern bool record_shapes;
+// False while a sampled profiler skips the current iteration.
+extern std::atomic<bool> sampled_in;
 extern uint32_t next_thread_id;
 extern std::mutex all_event_lists_mutex;
 extern std::list<std::shared_ptr<RangeEventList>> all_event_lists;
@@ -170,6 +280,24 @@ extern std::list<std::shared_ptr<RangeEventList>> all_event_lists;
 extern thread_local std::shared_ptr<RangeEventList> event_list;
 extern thread_local int32_t thread_id;
 
+// How the engine accumulated gradients while the profiler was enabled.
+// Allocated counts sums and clones that needed a new tensor, InPlace sums
+// written into a buffer nobody else could observe and Stolen incoming
+// gradients that became .grad without a copy.
+enum class GradAccumulation {
+  Allocated,
+  InPlace,
+  Stolen,
+  NumKinds
+};
+
+extern std::atomic<uint64_t> grad_accumulation_counts[static_cast<int>(GradAccumulation::NumKinds)];
+
+inline void recordGradAccumulation(GradAccumulation kind) {
+  if (state == ProfilerState::Disabled) return;
+  grad_accumulation_counts[static_cast<int>(kind)]++;
+}
+
 inline RangeEventList& getEventList() {
   if (!event_list) {
     std::lock_guard<std::mutex> guard(all_event_lists_mutex);
@@ -180,7 +308,27 @@ inline RangeEventList& getEventList() {
   return *event_list;
 }
 
-inline void mark(std::string name, bool include_cuda = true) {
+extern thread_local std::shared_ptr<EventRing> event_ring;
+extern uint64_t stream_session;
+EventRing& registerEventRing();
+
+inline EventRing& getEventRing() {
+  if (!event_ring || event_ring->session != stream_session) {
+    return registerEventRing();
+  }
+  return *event_ring;
+}
+
+// Returns false if a streaming profiler dropped the event.
+inline bool record(EventKind kind, const char* name, bool include_cuda) {
+  if (state == ProfilerState::Stream) {
+    return getEventRing().record(kind, name);
+  }
+  getEventList().record(kind, name, thread_id, include_cuda && state == ProfilerState::CUDA);
+  return true;
+}
+
+inline void mark(const std::string& name, bool include_cuda = true) {
   if (state == ProfilerState::NVTX) {
 #ifdef WITH_CUDA
     nvtxMarkA(name.c_str());
@@ -188,22 +336,29 @@ inline void mark(std::string name, bool include_cuda = true) {
     throw std::logic_error("mark called with NVTX tracing, but compiled without CUDA");
 #endif
   } else {
-    getEventList().record(EventKind::Mark, std::move(name), thread_id, include_cuda && state == ProfilerState::CUDA);
+    record(EventKind::Mark, intern(name), include_cuda);
   }
 }
 
-inline void pushRange(std::string name) {
+// Returns false if the range was dropped, in which case popRange must not
+// be called for it.
+inline bool pushRange(const char* name) {
   if (state == ProfilerState::NVTX) {
 #ifdef WITH_CUDA
-    nvtxRangePushA(name.c_str());
+    nvtxRangePushA(name);
+    return true;
 #else
     throw std::logic_error("pushRange called with NVTX tracing, but compiled without CUDA");
 #endif
   } else {
-    getEventList().record(EventKind::PushRange, std::move(name), thread_id, state == ProfilerState::CUDA);
+    return record(EventKind::PushRange, intern(name), true);
   }
 }
 
+inline bool pushRange(const std::string& name) {
+  return pushRange(name.c_str());
+}
+
 inline void popRange() {
   if (state == ProfilerState::NVTX) {
 #ifdef WITH_CUDA
@@ -212,40 +367,74 @@ inline void popRange() {
     throw std::logic_error("popRange called with NVTX tracing, but compiled without CUDA");
 #endif
   } else {
-    getEventList().record(EventKind::PopRange, std::string(), thread_id, state == ProfilerState::CUDA);
+    record(EventKind::PopRange, "", true);
   }
 }
 
+inline bool isRecording() {
+  return state != ProfilerState::Disabled && sampled_in.load(std::memory_order_relaxed);
+}
+
 struct RecordFunction {
   explicit RecordFunction(Function *fn) {
-    if (state == ProfilerState::Disabled) return;
-    pushFunctionRange(fn);
+    if (!isRecording()) return;
+    active = pushFunctionRange(fn);
+    if (active && record_shapes) this->fn = fn;
   }
 
-  explicit RecordFunction(std::string name) {
-    if (state == ProfilerState::Disabled) return;
-    pushRange(std::move(name));
-  }
+  explicit RecordFunction(const std::string& name) : RecordFunction(name.c_str()) {}
 
   explicit RecordFunction(const char *name) {
-    if (state == ProfilerState::Disabled) return;
-    pushRange(name);
+    if (!isRecording()) return;
+    active = pushRange(name);
+    if (active && record_shapes) this->name = intern(name);
   }
 
   ~RecordFunction() {
-    if (state == ProfilerState::Disabled) return;
+    // A range pushed before a sampled iteration ended is still closed.
+    if (!active || state == ProfilerState::Disabled) return;
     popRange();
   }
 
+  // True if the profiler wants recordShapes to be called for this range.
+  bool recordsShapes() const {
+    return active && (fn || name);
+  }
+
+  // Ends the range, then attaches the shapes of inputs to it, along with
+  // FLOP and byte estimates that also take outputs into account. Computing
+  // them isn't counted in the time of the range.
+  void recordShapes(const variable_list& inputs, const variable_list& outputs);
+
   // Needed only because we don't have Function defined yet.
-  void pushFunctionRange(Function *fn);
+  bool pushFunctionRange(Function *fn);
+
+private:
+  bool active = false;
+  // Only set when shapes are recorded.
+  Function* fn = nullptr;
+  const char* name = nullptr;
 };
 
 using thread_event_lists = std::vector<std::vector<Event>>;
 // NOTE: changing profiler modes is **NOT THREAD SAFE**. You should ensure that
 // there no autograd functions are being executed when these function are used.
-void enableProfiler(ProfilerState state);
+// With record_shapes, ATen ops and autograd Functions also record the
+// shapes of their inputs and estimates of their FLOPs and bytes moved.
+void enableProfiler(ProfilerState state, bool record_shapes=false);
 thread_event_lists disableProfiler();
 
+// Streams CPU events to a Chrome trace file at path while the profiler is
+// enabled, instead of keeping them until disableProfiler. Each thread
+// buffers at most buffer_events events between flushes. Only one iteration
+// in sample_every is recorded, where iterations are delimited by step(), so
+// the profiler can stay on in long-running jobs.
+void enableStreamingProfiler(const std::string& path, std::size_t buffer_events,
+                             uint64_t sample_every);
+// Returns the number of events that were dropped because a buffer was full.
+uint64_t disableStreamingProfiler();
+// Marks the end of an iteration for sampling.
+void step();
+
 } // namespace profiler
 }} // namespace torch::autograd
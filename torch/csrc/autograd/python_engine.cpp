@@ -23,13 +23,13 @@ static torch::autograd::python::PythonEngine engine;
 
 namespace torch { namespace autograd { namespace python {
 
-void PythonEngine::thread_init(int device) {
+void PythonEngine::thread_init(int device, int worker) {
   // Create a PyThreadState, but release the GIL. This lets AutoGIL calls
   // inside thread_main acquire the GIL without having to create a new
   // PyThreadState each time.
   AutoGIL gil;
   AutoNoGIL no_gil;
-  Engine::thread_init(device);
+  Engine::thread_init(device, worker);
 }
 
 void PythonEngine::thread_on_exception(FunctionTask& task, std::exception& e) {
@@ -299,6 +299,23 @@ PyObject* THPEngine_queue_callback(PyObject *self, PyObject *_callback) {
   END_HANDLE_TH_ERRORS
 }
 
+PyObject *THPEngine_setNumCPUThreads(PyObject *_unused, PyObject *arg) {
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkLong(arg), "_set_num_autograd_cpu_threads expects an int, "
+          "but got %s", THPUtils_typename(arg));
+  _maybe_reinitialize_engine_after_fork();
+  engine.set_num_cpu_threads((int)THPUtils_unpackLong(arg));
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject *THPEngine_getNumCPUThreads(PyObject *_unused) {
+  HANDLE_TH_ERRORS
+  _maybe_reinitialize_engine_after_fork();
+  return PyLong_FromLong(engine.num_cpu_threads());
+  END_HANDLE_TH_ERRORS
+}
+
 PyObject *THPEngine_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
   return type->tp_alloc(type, 0);
@@ -4,11 +4,14 @@
 #include "torch/csrc/autograd/engine.h"
 
 bool THPEngine_initModule(PyObject *module);
+// torch._C._set_num_autograd_cpu_threads and _get_num_autograd_cpu_threads
+PyObject *THPEngine_setNumCPUThreads(PyObject *_unused, PyObject *arg);
+PyObject *THPEngine_getNumCPUThreads(PyObject *_unused);
 
 namespace torch { namespace autograd { namespace python {
 
 struct PythonEngine : public Engine {
-  virtual void thread_init(int device) override;
+  virtual void thread_init(int device, int worker) override;
   virtual void thread_on_exception(FunctionTask& task, std::exception& e) override;
   virtual void execute(
       const function_list& roots,
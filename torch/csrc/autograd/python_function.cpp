@@ -209,6 +209,9 @@ auto PyFunction::is_traceable() -> bool {
 auto PyFunction::releaseVariables() -> void {
   AutoGIL gil;
   auto f = (THPFunction*) obj;
+  for (auto& saved_var : f->saved_variables) {
+    saved_var.reset_data();
+  }
   f->saved_variables.clear();
   f->has_freed_buffers = 1;
 }
@@ -974,7 +977,15 @@ static PyObject *unpack_saved_variables(
     return NULL;
   auto saved_for = THPFunction_asFunction(self);
   for (int i = 0; i < num_saved; i++) {
-    auto unpacked_var = saved_variables[i].unpack(saved_for);
+    Variable unpacked_var;
+    if (saved_variables[i].segment) {
+      // Loading from a checkpointed segment may wait for it to be recomputed,
+      // which takes the GIL if the segment is a Python function.
+      AutoNoGIL no_gil;
+      unpacked_var = saved_variables[i].unpack(saved_for);
+    } else {
+      unpacked_var = saved_variables[i].unpack(saved_for);
+    }
     THPObjectPtr value;
     if (!unpacked_var.defined()) {
       Py_INCREF(Py_None);
@@ -1,5 +1,6 @@
 #include "torch/csrc/autograd/saved_variable.h"
 
+#include "torch/csrc/autograd/checkpoint.h"
 #include "torch/csrc/autograd/function.h"
 
 using namespace at;
@@ -26,9 +27,13 @@ SavedVariable::SavedVariable(const Variable& variable, bool is_output)
   if (variable.tracing_state()) {
     tracing_state.reset(new jit::tracer::ValueTracingState(*variable.tracing_state()));
   }
+  if (auto checkpoint_segment = CheckpointSegment::current()) {
+    checkpoint_segment->save(*this, variable.is_leaf());
+  }
 }
 
 auto SavedVariable::unpack(std::shared_ptr<Function> saved_for) const -> Variable {
+  auto data = segment ? segment->load(segment_slot) : this->data;
   if (!data.defined()) {
     if (version.defined()) {
       throw std::runtime_error(ERR_BACKWARD_TWICE);
@@ -75,6 +80,14 @@ auto SavedVariable::unpack(std::shared_ptr<Function> saved_for) const -> Variabl
   return var;
 }
 
+void SavedVariable::reset_data() {
+  data.reset();
+  if (segment) {
+    segment->release(segment_slot);
+    segment.reset();
+  }
+}
+
 const char* ERR_BACKWARD_TWICE =
     "Trying to backward through the graph a second time, but the buffers have "
     "already been freed. Specify retain_graph=True when calling backward "
@@ -13,6 +13,7 @@
 namespace torch { namespace autograd {
 
 struct Function;
+struct CheckpointSegment;
 
 extern const char* ERR_BACKWARD_TWICE;
 
@@ -22,7 +23,8 @@ struct SavedVariable {
     , has_grad_fn(false)
     , version()
     , requires_grad(false)
-    , expected_version(-1) {}
+    , expected_version(-1)
+    , segment_slot(0) {}
 
   SavedVariable(const Variable& variable, bool is_output);
 
@@ -39,8 +41,14 @@ struct SavedVariable {
   int expected_version;
   int output_nr;
   std::unique_ptr<jit::tracer::ValueTracingState> tracing_state;
+  // If the variable was saved in a checkpointed segment, data may have been
+  // moved out to it. It's then loaded from segment_slot when unpacking.
+  std::shared_ptr<CheckpointSegment> segment;
+  size_t segment_slot;
 
   Variable unpack(std::shared_ptr<Function> saved_for=nullptr) const;
+  // Frees the saved tensor, wherever it's kept.
+  void reset_data();
 };
 
 }} // namespace torch::autograd
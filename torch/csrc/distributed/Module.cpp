@@ -155,6 +155,17 @@ PyObject* THDPModule_initMasterWorker(PyObject *_unused, PyObject *args)
   END_HANDLE_TH_ERRORS
 }
 
+PyObject* THDPModule_flushCommands(PyObject *_unused)
+{
+  HANDLE_TH_ERRORS
+  {
+    AutoNoGIL nogil;
+    THDMasterWorkerFlush();
+  }
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
 #ifdef WITH_CUDA
 PyObject* THDPModule_registerStream(PyObject *_unused, PyObject *_stream)
 {
@@ -637,6 +648,58 @@ PyObject* THDPModule_allReduce(PyObject *_unused, PyObject *args)
   END_HANDLE_TH_ERRORS
 }
 
+PyObject* THDPModule_allReduceBucketed(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  std::vector<at::Tensor> descriptors;
+  std::size_t length;
+  std::size_t bucket_bytes;
+  THDGroup group;
+  THDReduceOp op;
+  THPObjectPtr sequence;
+
+  if (PyTuple_GET_SIZE(args) != 4 || !PySequence_Check(PyTuple_GET_ITEM(args, 0)) ||
+        !THPUtils_checkLong(PyTuple_GET_ITEM(args, 2))) {
+    goto invalid_arguments;
+  }
+
+  sequence = THPObjectPtr(PySequence_Fast(PyTuple_GET_ITEM(args, 0),
+                                          "expected a sequence"));
+  if (!sequence.get()) {
+    goto invalid_arguments;
+  }
+
+  length = static_cast<std::size_t>(PySequence_Fast_GET_SIZE(sequence.get()));
+
+  descriptors.reserve(length);
+
+  for (std::size_t i = 0; i < length; ++i) {
+    if (!THPModule_isTensor(PySequence_Fast_GET_ITEM(sequence.get(), i))) {
+      goto invalid_arguments;
+    }
+
+    descriptors.push_back(
+      THDPModule_makeDescriptor(PySequence_Fast_GET_ITEM(sequence.get(), i))
+    );
+  }
+
+  op = _getReduceOp(PyTuple_GET_ITEM(args, 1));
+  bucket_bytes = THPUtils_unpackLong(PyTuple_GET_ITEM(args, 2));
+  group = _getGroup(PyTuple_GET_ITEM(args, 3));
+
+  {
+    AutoNoGIL guard;
+    THDAllReduceBucketed(descriptors.data(), length, op, bucket_bytes, group);
+  }
+  Py_RETURN_NONE;
+
+invalid_arguments:
+  THPUtils_invalidArguments(args, NULL, "all_reduce_bucketed", 1,
+                            "(list[tensor] in_out, reduce_op op, int bucket_size, group gr)");
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
 PyObject* THDPModule_reduce(PyObject *_unused, PyObject *args)
 {
   HANDLE_TH_ERRORS
@@ -1008,6 +1071,7 @@ static struct PyMethodDef _THDPModule_methods[] = {
   {"_dist_destroy_process_group", (PyCFunction)THDPModule_destroyProcessGroup, METH_NOARGS, NULL},
   {"_dist_clear_group_cache", (PyCFunction)THDPModule_clearGroupCache, METH_VARARGS, NULL},
   {"_dist_init_master_worker", (PyCFunction)THDPModule_initMasterWorker, METH_VARARGS, NULL},
+  {"_dist_flush_commands", (PyCFunction)THDPModule_flushCommands, METH_NOARGS, NULL},
 #ifdef WITH_CUDA
   {"_dist_register_stream", (PyCFunction)THDPModule_registerStream, METH_O, NULL},
 #endif
@@ -1019,6 +1083,7 @@ static struct PyMethodDef _THDPModule_methods[] = {
   {"_dist_recv_any_source", (PyCFunction)THDPModule_recvAnySource, METH_O, NULL},
   {"_dist_recv", (PyCFunction)THDPModule_recv, METH_VARARGS, NULL},
   {"_dist_all_reduce", (PyCFunction)THDPModule_allReduce, METH_VARARGS, NULL},
+  {"_dist_all_reduce_bucketed", (PyCFunction)THDPModule_allReduceBucketed, METH_VARARGS, NULL},
   {"_dist_all_reduce_multigpu", (PyCFunction)THDPModule_allReduceMultiGPU, METH_VARARGS, NULL},
   {"_dist_reduce", (PyCFunction)THDPModule_reduce, METH_VARARGS, NULL},
   {"_dist_reduce_multigpu", (PyCFunction)THDPModule_reduceMultiGPU, METH_VARARGS, NULL},
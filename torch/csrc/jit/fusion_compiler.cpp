@@ -17,8 +17,14 @@
 #include <vector>
 #include <sstream>
 #include <iostream>
+#include <fstream>
+#include <chrono>
+#include <future>
+#include <cerrno>
+#include <cstring>
 #include <dlfcn.h>
 #include <unistd.h>
+#include <sys/stat.h>
 
 namespace torch { namespace jit {
 
@@ -169,6 +175,33 @@ void ${kernelName}(IndexType totalElements, void ** args) {
 }
 )");
 
+// Used when all inputs and outputs are contiguous. The offset of every tensor
+// is then just linearIndex, so the loop has no divisions and the compiler is
+// free to vectorize it.
+auto cpu_contiguous_compilation_unit_template = CodeTemplate(R"(
+#include <cstddef>
+#include <math.h>
+#include <iostream>
+${type_declarations}
+
+#define OMP_THRESHOLD 100000
+static void ${kernelName}_kernel(IndexType totalElements, ${formals}) {
+  #pragma omp parallel for simd if(totalElements > OMP_THRESHOLD)
+  for (IndexType linearIndex = 0;
+        linearIndex < totalElements;
+        linearIndex += 1) {
+      ${tensorOffsets}
+      // calculate the results
+      ${kernelBody}
+    }
+}
+
+extern "C"
+void ${kernelName}(IndexType totalElements, void ** args) {
+  ${kernelName}_kernel(totalElements ${,argument_loads});
+}
+)");
+
 // curDimIndex = linearId % sizes[i]; // % sizes[i] is not needed for d == 0, because we already guard for numel outside the index calculation
 // offset += curDimIndex*strides[i]; // *strides[i] is optional if list_is_cont becaause strides.back() == 1
 // linearId /= sizes[i];
@@ -256,10 +289,11 @@ std::vector<ConcatDesc> emitCompilationUnit(std::ostream & out,
   std::stringstream tensorOffsets;
   std::vector<std::string> formals;
   std::vector<std::string> argument_loads;
+  std::vector<const TensorDesc*> formal_descs;
   auto emitFormal = [&](Value * n, const TensorDesc & desc) {
     std::string tensor = "t" + std::to_string(formals.size()); //can't be unique() because Param may be an output
     size_t nDim = desc.nDim();
-    emitIndexingFor(tensorOffsets, tensor, nDim,  desc.lastIsContiguous());
+    formal_descs.push_back(&desc);
     env.s("tensor",tensor);
     env.d("formal_index", formals.size() + 1); // + 1 because the first argument is the linearIndex
     env.d("nDim",nDim);
@@ -293,6 +327,21 @@ std::vector<ConcatDesc> emitCompilationUnit(std::ostream & out,
       }
     }
   }
+  // CUDA kernels are bound by memory bandwidth, so only the CPU ones get a
+  // specialized contiguous loop.
+  bool use_contiguous_loop = !use_cuda &&
+    std::all_of(formal_descs.begin(), formal_descs.end(), [](const TensorDesc* desc) {
+      return desc->isContiguous();
+    });
+  for(size_t i = 0; i < formal_descs.size(); ++i) {
+    std::string tensor = "t" + std::to_string(i);
+    if(use_contiguous_loop) {
+      env.s("tensor",tensor);
+      tensorOffsets << format("IndexType ${tensor}_offset = linearIndex;\n",env);
+    } else {
+      emitIndexingFor(tensorOffsets, tensor, formal_descs[i]->nDim(), formal_descs[i]->lastIsContiguous());
+    }
+  }
   size_t formal_count = 0;
   for(auto p : subgraph.inputs()) {
     env.s("node",valueName(p));
@@ -321,6 +370,8 @@ std::vector<ConcatDesc> emitCompilationUnit(std::ostream & out,
   env.s("type_declarations", type_declarations_template.format(env));
   if(use_cuda) {
     out << cuda_compilation_unit_template.format(env);
+  } else if(use_contiguous_loop) {
+    out << cpu_contiguous_compilation_unit_template.format(env);
   } else {
     out << cpu_compilation_unit_template.format(env);
   }
@@ -584,17 +635,30 @@ struct TempFile {
   FILE* file()  {
     return file_;
   }
+  // atomically moves the file to path, which is then kept after destruction.
+  // Returns false, and leaves the file where it was, if the rename fails.
+  bool persistAs(const std::string & path) {
+    sync();
+    if(rename(name_.c_str(), path.c_str()) != 0)
+      return false;
+    name_ = path;
+    persistent_ = true;
+    return true;
+  }
   ~TempFile() {
     if(file_ != nullptr) {
       // unlink first to ensure another mkstemps doesn't
       // race between close and unlink
-      unlink(name_.c_str());
+      if(!persistent_) {
+        unlink(name_.c_str());
+      }
       fclose(file_);
     }
   }
 private:
   FILE * file_ = nullptr;
   std::string name_;
+  bool persistent_ = false;
 };
 
 static void* checkDL(void * x) {
@@ -632,11 +696,13 @@ static const std::string cpp_template = "/tmp/pytorch_fuserXXXXXX.cpp";
 // actually supports it or not, so we heuristically use the host
 // compiler to predict if the runtime compiler supports the option we
 // want.  This probably won't work if you're cross-compiling.
+#ifndef __PPC64__
+#define FUSER_MARCH "-march=native "
+#else
+#define FUSER_MARCH ""
+#endif
 static const std::string compile_string =
-  "\"${cxx}\" -O3 -g "
-#ifndef __PPC64__ 
-  "-march=native "
-#endif 
+  "\"${cxx}\" -O3 -g " FUSER_MARCH
   "-std=c++11 -fPIC ${fopenmp} -shared \"${cpp_file}\" -o \"${so_file}\"";
 
 static void runCompiler(FusionCompilerConfig & config, const std::string & cpp_file, const std::string & so_file) {
@@ -656,6 +722,97 @@ static void runCompiler(FusionCompilerConfig & config, const std::string & cpp_f
 }
 
 
+static std::string commandOutput(const std::string & cmd) {
+  std::string output;
+  FILE * pipe = popen(cmd.c_str(), "r");
+  JIT_ASSERT(pipe);
+  char buf[256];
+  while(fgets(buf, sizeof(buf), pipe)) {
+    output += buf;
+  }
+  pclose(pipe);
+  return output;
+}
+
+static std::string compilerVersion(FusionCompilerConfig & config) {
+  if(config.cxx_version.empty()) {
+    config.cxx_version = commandOutput("\"" + config.cxx + "\" --version");
+  }
+  return config.cxx_version;
+}
+
+// The macros the compiler predefines for the host CPU, e.g. __AVX2__. Kernels
+// are built with -march=native, so a kernel compiled on one machine may not
+// run on another, even with the same compiler.
+static std::string compilerTarget(FusionCompilerConfig & config) {
+  if(config.cxx_target.empty()) {
+    config.cxx_target = commandOutput(
+      "\"" + config.cxx + "\" " FUSER_MARCH "-std=c++11 -E -dM -x c++ - < /dev/null");
+  }
+  return config.cxx_target;
+}
+
+// 64-bit FNV-1a. Unlike std::hash, it's stable across processes and builds,
+// which matters for the names of the files in the on-disk cache.
+static uint64_t fnv1a(const std::string & str) {
+  uint64_t hash = 14695981039346656037ULL;
+  for(unsigned char c : str) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+static bool readFile(const std::string & path, std::string & contents) {
+  std::ifstream file(path, std::ios::binary);
+  if(!file)
+    return false;
+  std::stringstream ss;
+  ss << file.rdbuf();
+  contents = ss.str();
+  return true;
+}
+
+// Compiled CPU kernels are stored in config.cache_dir as <key>.so, next to
+// the source they were compiled from (<key>.cpp). The key is a hash of the
+// source together with the compiler, its flags and the host CPU features it
+// targets, and the source is compared on every hit to rule out hash
+// collisions. Files are only ever created with an atomic rename, so many
+// processes can share a single directory.
+struct DiskKernelCache {
+  DiskKernelCache(FusionCompilerConfig & config, const std::string & compilation_unit)
+  : config(config), compilation_unit(compilation_unit) {
+    std::stringstream key;
+    key << compilation_unit << "\n" << compile_string << "\n" << config.cxx << "\n"
+        << compilerVersion(config) << "\n" << compilerTarget(config) << "\n" << config.openmp;
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long) fnv1a(key.str()));
+    so_path = config.cache_dir + "/" + hex + ".so";
+    cpp_path = config.cache_dir + "/" + hex + ".cpp";
+  }
+  bool contains() const {
+    std::string cached_source;
+    return access(so_path.c_str(), R_OK) == 0 &&
+           readFile(cpp_path, cached_source) &&
+           cached_source == compilation_unit;
+  }
+  // Returns false if the entry couldn't be created, in which case so_file
+  // is still a temporary and has to be loaded from its own name.
+  bool insert(TempFile & cpp_file, TempFile & so_file) {
+    // the source goes last, because its presence marks a complete entry
+    if(!so_file.persistAs(so_path) || !cpp_file.persistAs(cpp_path)) {
+      std::cerr << "warning: pytorch jit fuser can't add a kernel to the cache in "
+                << config.cache_dir << ": " << strerror(errno) << "\n";
+      return false;
+    }
+    return true;
+  }
+  FusionCompilerConfig & config;
+  const std::string & compilation_unit;
+  std::string so_path;
+  std::string cpp_path;
+};
+
 static const std::string disas_string =
   "objdump -M  intel -d \"${so_file}\"";
 static void disas(const std::string & so_file) {
@@ -666,24 +823,44 @@ static void disas(const std::string & so_file) {
   JIT_ASSERT(r == 0);
 }
 
+// Every CPU kernel is emitted under this name rather than under its
+// per-process name, so that the source, and hence the key in the on-disk
+// cache, is the same in every process. Each kernel lives in its own library
+// opened with RTLD_LOCAL, so the names can't clash.
+static const std::string cpu_kernel_symbol = "fused_kernel";
+
 struct CPUFusionFunction : public CompiledFusionFunction {
-  CPUFusionFunction(const std::string & name, AnnotatedGraph & agraph, FusionCompilerConfig & config)
+  CPUFusionFunction(const std::string & name, AnnotatedGraph & agraph, FusionCompilerConfig & config, FusionCompilerStats & stats)
   : CompiledFusionFunction(name, agraph) {
-    TempFile so_file(so_template, 3);
-    TempFile cpp_file(cpp_template, 4);
-
     std::stringstream cu;
-    concat_desc = codegen::emitCompilationUnit(cu, name, agraph, false);
+    concat_desc = codegen::emitCompilationUnit(cu, cpu_kernel_symbol, agraph, false);
     compilation_unit = cu.str();
-    cpp_file.write(compilation_unit);
-    cpp_file.sync();
-    runCompiler(config, cpp_file.name(), so_file.name());
-    if(config.debug) {
-      std::cout << compilation_unit << "\n";
-      disas(so_file.name());
+
+    if(config.cache_dir.empty()) {
+      TempFile so_file(so_template, 3);
+      TempFile cpp_file(cpp_template, 4);
+      compile(config, stats, cpp_file, so_file);
+      so_lib.reset(new DynamicLibrary(so_file.name().c_str()));
+    } else {
+      DiskKernelCache cache(config, compilation_unit);
+      if(cache.contains()) {
+        stats.disk_cache_hits++;
+      } else {
+        stats.disk_cache_misses++;
+        // temporary files are created in the cache directory, so that they
+        // can be renamed into place
+        TempFile so_file(config.cache_dir + "/tmpXXXXXX.so", 3);
+        TempFile cpp_file(config.cache_dir + "/tmpXXXXXX.cpp", 4);
+        compile(config, stats, cpp_file, so_file);
+        if(!cache.insert(cpp_file, so_file)) {
+          // the library can still be used, it just won't be reused
+          so_lib.reset(new DynamicLibrary(so_file.name().c_str()));
+        }
+      }
+      if(!so_lib)
+        so_lib.reset(new DynamicLibrary(cache.so_path.c_str()));
     }
-    so_lib.reset(new DynamicLibrary(so_file.name().c_str()));
-    kernel = reinterpret_cast<void(*)(uint32_t, void**)>(so_lib->sym(name.c_str()));
+    kernel = reinterpret_cast<void(*)(uint32_t, void**)>(so_lib->sym(cpu_kernel_symbol.c_str()));
   }
 protected:
   virtual at::Backend backend() const override {
@@ -692,6 +869,18 @@ protected:
   virtual void launch_raw(uint32_t numel, void ** arguments) override {
     kernel(numel, arguments);
   }
+  void compile(FusionCompilerConfig & config, FusionCompilerStats & stats, TempFile & cpp_file, TempFile & so_file) {
+    cpp_file.write(compilation_unit);
+    cpp_file.sync();
+    auto start = std::chrono::steady_clock::now();
+    runCompiler(config, cpp_file.name(), so_file.name());
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    stats.compile_seconds += elapsed.count();
+    if(config.debug) {
+      std::cout << compilation_unit << "\n";
+      disas(so_file.name());
+    }
+  }
   std::unique_ptr<DynamicLibrary> so_lib;
   void (*kernel)(uint32_t, void**) = nullptr;
 };
@@ -715,23 +904,55 @@ std::shared_ptr<CompiledFusionFunction> FusionCompiler::getOrCompile(AnnotatedGr
     key << i << "\n";
   std::string key_ = key.str();
 
+  // The lock only covers the lookup and the insertion of a pending entry.
+  // Compiling can take seconds, and other fusion groups shouldn't wait for it,
+  // while threads that want this very kernel wait on the entry's future.
+  std::unique_lock<std::mutex> lock(mutex_);
   auto it = cache.find(key_);
-  if (it == cache.end()) {
-    std::string name = "kernel_" + std::to_string(cache.size());
-    CompiledFusionFunction * raw_func;
+  if(it != cache.end()) {
+    auto pending = it->second;
+    lock.unlock();
+    return pending.get();
+  }
+  std::string name = "kernel_" + std::to_string(cache.size());
+  std::promise<std::shared_ptr<CompiledFusionFunction>> promise;
+  cache.emplace(key_, promise.get_future().share());
+  // the compile works on copies, which are merged back once it's done
+  FusionCompilerConfig config = config_;
+  FusionCompilerStats stats;
+  lock.unlock();
+
+  std::shared_ptr<CompiledFusionFunction> func;
+  try {
     if(agraph.is_cuda) {
 #ifdef WITH_CUDA
-      raw_func = new CUDAFusionFunction(name, agraph);
+      func = std::make_shared<CUDAFusionFunction>(name, agraph);
 #else
       throw std::runtime_error("cannot compile a CUDA fusion group, CUDA is not enabled.");
 #endif
     } else {
       JIT_ASSERT(canCompileOnCPU());
-      raw_func = new CPUFusionFunction(name, agraph, config_);
+      func = std::make_shared<CPUFusionFunction>(name, agraph, config, stats);
     }
-    it = cache.emplace(key_, std::shared_ptr<CompiledFusionFunction>(raw_func)).first;
+  } catch(...) {
+    // drop the entry, so that the next call tries again
+    lock.lock();
+    cache.erase(key_);
+    lock.unlock();
+    promise.set_exception(std::current_exception());
+    throw;
   }
-  return it->second;
+
+  lock.lock();
+  config_.openmp = config_.openmp && config.openmp;
+  if(config_.cxx_version.empty())
+    config_.cxx_version = config.cxx_version;
+  stats_.disk_cache_hits += stats.disk_cache_hits;
+  stats_.disk_cache_misses += stats.disk_cache_misses;
+  stats_.compile_seconds += stats.compile_seconds;
+  lock.unlock();
+  promise.set_value(func);
+  return func;
 }
 
 std::shared_ptr<CompiledFusionFunction> FusionCompiler::getOrCompile(Node* fusion_group) {
@@ -788,9 +1009,19 @@ FusionCompiler::FusionCompiler() {
   }
   const char * debug_env = getenv("PYTORCH_FUSION_DEBUG");
   config_.debug = debug_env && atoi(debug_env) != 0;
+  const char * async_env = getenv("PYTORCH_FUSION_ASYNC");
+  config_.async_cpu = async_env && atoi(async_env) != 0;
+  const char * cache_dir_env = getenv("PYTORCH_FUSION_CACHE_DIR");
+  if(cache_dir_env != nullptr && *cache_dir_env != '\0') {
+    if(mkdir(cache_dir_env, 0700) != 0 && errno != EEXIST) {
+      std::cerr << "warning: pytorch jit fuser can't create kernel cache directory "
+                << cache_dir_env << ", disabling the on-disk cache\n";
+    } else {
+      config_.cache_dir = cache_dir_env;
+    }
+  }
 }
 
-//TODO: thread safety
 FusionCompiler & sharedFusionCompiler() {
   static FusionCompiler compiler;
   return compiler;
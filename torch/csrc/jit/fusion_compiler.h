@@ -4,6 +4,8 @@
 #include "ATen/ATen.h"
 #include <string>
 #include <algorithm>
+#include <future>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 
@@ -38,6 +40,11 @@ struct TensorDesc {
     return contiguity.size() == 0 || contiguity.back();
   }
 
+  // can the whole tensor be indexed with a single linear index?
+  bool isContiguous() const {
+    return nDim_ <= 1 && lastIsContiguous();
+  }
+
   static std::vector<bool> findContiguous(
     const at::IntList& sizes,
     const at::IntList& strides);
@@ -123,6 +130,23 @@ struct FusionCompilerConfig {
   std::string cxx = "g++"; // compiler location
   bool debug = false; // emit debugging information about fusions
   bool openmp = true;
+  // directory in which compiled CPU kernels are persisted across processes,
+  // the on-disk cache is disabled if it's empty
+  std::string cache_dir;
+  // output of `cxx --version`, lazily filled in to key the on-disk cache
+  std::string cxx_version;
+  // macros `cxx -march=native` predefines, lazily filled in to key the
+  // on-disk cache by the host CPU features
+  std::string cxx_target;
+  // compile CPU fusion groups in the background, and run them unfused until
+  // the kernel is ready
+  bool async_cpu = false;
+};
+
+struct FusionCompilerStats {
+  uint64_t disk_cache_hits = 0; // CPU kernels loaded from cache_dir
+  uint64_t disk_cache_misses = 0; // CPU kernels compiled because they weren't in cache_dir
+  double compile_seconds = 0; // total time spent in the host compiler
 };
 
 // caching compiler
@@ -148,9 +172,21 @@ struct FusionCompiler {
   bool canCompileOnCPU() const {
     return config_.cxx.size() > 0;
   }
+  bool compilesCPUAsynchronously() const {
+    return config_.async_cpu;
+  }
+  FusionCompilerStats stats() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return stats_;
+  }
 private:
+  // getOrCompile can be called from background compilation threads,
+  // mutex_ guards the members below but isn't held while compiling
+  mutable std::mutex mutex_;
   FusionCompilerConfig config_;
-  std::unordered_map<std::string, std::shared_ptr<CompiledFusionFunction>> cache;
+  FusionCompilerStats stats_;
+  // kernels that are still being compiled have a pending future
+  std::unordered_map<std::string, std::shared_future<std::shared_ptr<CompiledFusionFunction>>> cache;
 };
 
 FusionCompiler & sharedFusionCompiler();
@@ -4,6 +4,7 @@
 #include "torch/csrc/jit/python_ir.h"
 #include "torch/csrc/jit/python_arg_flatten.h"
 #include "torch/csrc/jit/export.h"
+#include "torch/csrc/jit/fusion_compiler.h"
 #include "torch/csrc/jit/python_compiled_function.h"
 #include "torch/csrc/jit/passes/graph_fuser.h"
 #include "torch/csrc/jit/passes/onnx.h"
@@ -53,6 +54,14 @@ void initJITBindings(PyObject *module) {
    .def("_jit_run_cpp_tests", runJITCPPTests)
    .def("_jit_flatten", [](py::handle& obj) {
      return python::flatten(obj).vars;
+   })
+   .def("_jit_fusion_compiler_stats", []() {
+     auto stats = sharedFusionCompiler().stats();
+     py::dict result;
+     result["disk_cache_hits"] = stats.disk_cache_hits;
+     result["disk_cache_misses"] = stats.disk_cache_misses;
+     result["compile_seconds"] = stats.compile_seconds;
+     return result;
    });
 
   initPythonIRBindings(module);
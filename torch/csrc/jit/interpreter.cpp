@@ -11,6 +11,10 @@
 #include "torch/csrc/autograd/functions/special.h"
 #include "torch/csrc/jit/fusion_compiler.h"
 
+#include <atomic>
+#include <future>
+#include <iostream>
+
 namespace py = pybind11;
 
 namespace torch { namespace jit {
@@ -183,6 +187,70 @@ Operation createEvalOperation(CppOp * op) {
 }
 
 using tensor_list = std::vector<at::Tensor>;
+
+// State shared between a CPU fusion group operation and the thread that
+// compiles its kernel in the background. Until the kernel is ready, the
+// operation runs the fusion group's subgraph node by node.
+struct AsyncFusionState {
+  Code fallback;
+  std::shared_ptr<CompiledFusionFunction> fusion_fn; // valid once ready is set
+  std::atomic<bool> ready {false};
+  std::future<void> compilation;
+  ~AsyncFusionState() {
+    // the compilation thread refers to this state and to the fusion group node
+    if(compilation.valid())
+      compilation.wait();
+  }
+};
+
+static void launchFusion(CompiledFusionFunction & fusion_fn,
+                         const list_of_retainable & inputs,
+                         list_of_retainable & outputs) {
+  tensor_list tinputs, toutputs;
+  tinputs.reserve(inputs.size());
+  for(auto & i : inputs) {
+    tinputs.push_back(unsafeToTensorShare(i));
+  }
+  fusion_fn.launch(tinputs, toutputs);
+  for(auto & o : toutputs) {
+    outputs.push_back(toRetainableSteal(std::move(o)));
+  }
+}
+
+Operation createAsyncFusionOperation(Node * node) {
+  auto state = std::make_shared<AsyncFusionState>();
+  auto subgraph = node->g(kSubgraph);
+  state->fallback = Code(subgraph);
+  AsyncFusionState * raw_state = state.get();
+  state->compilation = std::async(std::launch::async, [node, raw_state] {
+    try {
+      raw_state->fusion_fn = sharedFusionCompiler().getOrCompile(node);
+      raw_state->ready.store(true, std::memory_order_release);
+    } catch(std::exception & e) {
+      std::cerr << "warning: pytorch jit fuser failed to compile a fusion group, "
+                << "it will keep running unfused: " << e.what() << "\n";
+    }
+  });
+  return [state](const list_of_retainable & inputs, list_of_retainable & outputs) {
+    if(state->ready.load(std::memory_order_acquire)) {
+      autograd::profiler::RecordFunction record("FusionGroup");
+      launchFusion(*state->fusion_fn, inputs, outputs);
+      return;
+    }
+    autograd::profiler::RecordFunction record("FusionGroup (unfused)");
+    tensor_list tinputs, toutputs;
+    tinputs.reserve(inputs.size());
+    for(auto & i : inputs) {
+      tinputs.push_back(unsafeToTensorShare(i));
+    }
+    InterpreterState interp(state->fallback);
+    interp.runOneStage(tinputs, toutputs);
+    for(auto & o : toutputs) {
+      outputs.push_back(toRetainableSteal(std::move(o)));
+    }
+  };
+}
+
 // Returns a function implementing functionality of a given node,
 // or nullptr if it's a no-op for autograd.
 Operation getOperation(jit::Node *node) {
@@ -195,18 +263,13 @@ Operation getOperation(jit::Node *node) {
       return createCppOperation(value);
     }
   IR_ELSEIF(FusionGroup)
+    if(!value->i(kis_cuda) && sharedFusionCompiler().compilesCPUAsynchronously()) {
+      return createAsyncFusionOperation(value);
+    }
     auto fusion_fn = sharedFusionCompiler().getOrCompile(value);
     return [fusion_fn](const list_of_retainable & inputs, list_of_retainable & outputs) {
       autograd::profiler::RecordFunction record("FusionGroup");
-      tensor_list tinputs, toutputs;
-      tinputs.reserve(inputs.size());
-      for(auto & i : inputs) {
-        tinputs.push_back(unsafeToTensorShare(i));
-      }
-      fusion_fn->launch(tinputs, toutputs);
-      for(auto & o : toutputs) {
-        outputs.push_back(toRetainableSteal(std::move(o)));
-      }
+      launchFusion(*fusion_fn, inputs, outputs);
     };
   IR_ELSEIF(Constant)
     auto t = value->t(kvalue);
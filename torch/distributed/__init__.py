@@ -132,6 +132,14 @@ def init_master_worker(backend, init_method='env://', **kwargs):
         raise RuntimeError("distributed module initialization failed")
 
 
+def _flush_commands():
+    """Sends the commands buffered for the workers without waiting for the
+    batches to fill up. Only valid in master-worker mode."""
+    assert torch.distributed._initialized == _INITIALIZED_MW, \
+        "_flush_commands only supported in master-worker mode"
+    torch._C._dist_flush_commands()
+
+
 class reduce_op(object):
     SUM = object()
     PRODUCT = object()
@@ -336,6 +344,30 @@ def all_reduce(tensor, op=reduce_op.SUM, group=group.WORLD):
     return torch._C._dist_all_reduce(tensor, op, group)
 
 
+def all_reduce_bucketed(tensor_list, op=reduce_op.SUM, group=group.WORLD, bucket_size=1 << 20):
+    """Reduces many tensors across all machines, like calling :func:`all_reduce`
+    on each of them.
+
+    Consecutive tensors of the same type are flattened into buckets of at most
+    ``bucket_size`` bytes and each bucket is reduced with a single collective,
+    which is much faster than reducing many small tensors (e.g. gradients of a
+    model) one by one. Tensors larger than ``bucket_size`` are reduced on
+    their own.
+
+    Arguments:
+        tensor_list (List[Tensor]): Inputs and outputs of the collective. The
+            function operates in-place. All processes must pass tensors of
+            the same types and sizes, in the same order.
+        op (optional): One of the values from ``torch.distributed.reduce_op``
+            enum.  Specifies an operation used for element-wise reductions.
+        group (optional): Group of the collective.
+        bucket_size (int, optional): Maximum size of a bucket in bytes.
+    """
+    assert torch.distributed._initialized == _INITIALIZED_PG, \
+        "collective only supported in process-group mode"
+    return torch._C._dist_all_reduce_bucketed(tensor_list, op, bucket_size, group)
+
+
 def reduce_multigpu(tensor_list, dst, op=reduce_op.SUM, group=group.WORLD):
     """Reduces the tensor data on multiple GPUs across all machines. Each tensor
     in tensor_list should reside on a separate GPU
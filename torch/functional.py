@@ -5,8 +5,10 @@ from functools import reduce
 import math
 
 __all__ = [
-    'split', 'chunk', 'stack', 'unbind', 'btriunpack', 'matmul', 'det', 'stft',
-    'hann_window', 'hamming_window', 'bartlett_window',
+    'split', 'chunk', 'stack', 'unbind', 'btriunpack', 'matmul', 'det', 'fft',
+    'ifft', 'rfft', 'irfft', 'stft', 'hann_window', 'hamming_window', 'bartlett_window',
+    'quantize_linear', 'dequantize_linear', 'quantize_linear_per_channel',
+    'dequantize_linear_per_channel',
 ]
 
 
@@ -267,6 +269,96 @@ def det(var):
     return var.det()
 
 
+def fft(var, normalized=False):
+    r"""Complex-to-complex discrete Fourier transform.
+
+    This method computes the one dimensional transform along the second to
+    last dimension of :attr:`var`, whose last dimension must be of size 2 and
+    holds the real and the imaginary parts of the complex values:
+
+    .. math::
+        X[\omega] = \sum_{n=0}^{N-1} x[n]\ e^{-j \frac{2 \pi \cdot \omega n}{N}}
+
+    All leading dimensions are treated as a batch. Sizes that are not powers
+    of two are supported, but are slower. If :attr:`normalized` is ``True``,
+    the result is divided by :math:`\sqrt{N}`, which makes the transform
+    unitary.
+
+    Arguments:
+        var (Variable): the input of size :math:`(* \times N \times 2)`
+        normalized (bool, optional): controls whether to return the normalized result
+
+    Returns:
+        Variable: A Variable of size :math:`(* \times N \times 2)` containing the transform
+    """
+    if torch.is_tensor(var):
+        raise ValueError("fft is currently only supported on Variable")
+    return var.fft(normalized)
+
+
+def ifft(var, normalized=False):
+    r"""Complex-to-complex inverse discrete Fourier transform.
+
+    The inverse of :meth:`torch.fft`, i.e., ``ifft(fft(x)) == x``. Unless
+    :attr:`normalized` is ``True``, the result is divided by :math:`N`.
+
+    Arguments:
+        var (Variable): the input of size :math:`(* \times N \times 2)`
+        normalized (bool, optional): controls whether to return the normalized result
+
+    Returns:
+        Variable: A Variable of size :math:`(* \times N \times 2)` containing the inverse transform
+    """
+    if torch.is_tensor(var):
+        raise ValueError("ifft is currently only supported on Variable")
+    return var.ifft(normalized)
+
+
+def rfft(var, normalized=False, onesided=True):
+    r"""Real-to-complex discrete Fourier transform.
+
+    Computes the same transform as :meth:`torch.fft` for a real input of size
+    :math:`(* \times N)`. Since the result satisfies the Hermitian symmetry,
+    i.e., :math:`X[\omega] = X[N - \omega]^*`, only the first
+    :math:`\lfloor \frac{N}{2} \rfloor + 1` values are returned unless
+    :attr:`onesided` is ``False``.
+
+    Arguments:
+        var (Variable): the real input of size :math:`(* \times N)`
+        normalized (bool, optional): controls whether to return the normalized result
+        onesided (bool, optional): controls whether to avoid redundancy in the return value
+
+    Returns:
+        Variable: A Variable of size :math:`(* \times M \times 2)` containing the transform
+    """
+    if torch.is_tensor(var):
+        raise ValueError("rfft is currently only supported on Variable")
+    return var.rfft(normalized, onesided)
+
+
+def irfft(var, signal_size, normalized=False):
+    r"""Complex-to-real inverse discrete Fourier transform.
+
+    The inverse of :meth:`torch.rfft`: takes the
+    :math:`\lfloor \frac{signal\_size}{2} \rfloor + 1` non-redundant values
+    of a Hermitian signal and returns the real signal of size
+    :attr:`signal_size`. :attr:`signal_size` is needed because both even and
+    odd sizes lead to the same number of non-redundant values. The imaginary
+    parts of the zero and Nyquist frequencies are ignored.
+
+    Arguments:
+        var (Variable): the input of size :math:`(* \times M \times 2)`
+        signal_size (int): the size of the real signal
+        normalized (bool, optional): controls whether to return the normalized result
+
+    Returns:
+        Variable: A Variable of size :math:`(* \times signal\_size)` containing the real signal
+    """
+    if torch.is_tensor(var):
+        raise ValueError("irfft is currently only supported on Variable")
+    return var.irfft(signal_size, normalized)
+
+
 def stft(var, frame_length, hop, fft_size=None, return_onesided=True, window=None, pad_end=0):
     r"""Short-time Fourier transform (STFT).
 
@@ -440,3 +532,74 @@ def bartlett_window(window_length, periodic=True):
         return window[:-1]
     else:
         return window
+
+
+def quantize_linear(var, scale, zero_point):
+    r"""Quantizes a floating point Variable to int8.
+
+    .. math::
+        q = \text{clamp}(\text{round}(x / scale) + zero\_point, -128, 127)
+
+    Arguments:
+        var (Variable): the input
+        scale (float): the quantization step, must be positive
+        zero_point (int): the value that 0 maps to, in :math:`[-128, 127]`
+
+    Returns:
+        Variable: A CharTensor Variable of the same size as :attr:`var`
+    """
+    if torch.is_tensor(var):
+        raise ValueError("quantize_linear is currently only supported on Variable")
+    return torch._C._VariableBase.quantize_linear(var, scale, zero_point)
+
+
+def dequantize_linear(var, scale, zero_point):
+    r"""The inverse of :meth:`torch.quantize_linear`, i.e.
+    :math:`(q - zero\_point) \cdot scale`.
+
+    Arguments:
+        var (Variable): a CharTensor Variable
+        scale (float): the quantization step
+        zero_point (int): the value that 0 maps to
+
+    Returns:
+        Variable: A FloatTensor Variable of the same size as :attr:`var`
+    """
+    if torch.is_tensor(var):
+        raise ValueError("dequantize_linear is currently only supported on Variable")
+    return torch._C._VariableBase.dequantize_linear(var, scale, zero_point)
+
+
+def quantize_linear_per_channel(var, scales, zero_points, axis):
+    r"""Like :meth:`torch.quantize_linear`, with one scale and zero point per
+    slice of :attr:`var` along :attr:`axis`.
+
+    Arguments:
+        var (Variable): the input
+        scales (Variable): ``var.size(axis)`` scales
+        zero_points (Variable): ``var.size(axis)`` zero points
+        axis (int): the dimension the slices are taken along
+
+    Returns:
+        Variable: A CharTensor Variable of the same size as :attr:`var`
+    """
+    if torch.is_tensor(var):
+        raise ValueError("quantize_linear_per_channel is currently only supported on Variable")
+    return torch._C._VariableBase.quantize_linear_per_channel(var, scales, zero_points, axis)
+
+
+def dequantize_linear_per_channel(var, scales, zero_points, axis):
+    r"""The inverse of :meth:`torch.quantize_linear_per_channel`.
+
+    Arguments:
+        var (Variable): a CharTensor Variable
+        scales (Variable): ``var.size(axis)`` scales
+        zero_points (Variable): ``var.size(axis)`` zero points
+        axis (int): the dimension the slices are taken along
+
+    Returns:
+        Variable: A FloatTensor Variable of the same size as :attr:`var`
+    """
+    if torch.is_tensor(var):
+        raise ValueError("dequantize_linear_per_channel is currently only supported on Variable")
+    return torch._C._VariableBase.dequantize_linear_per_channel(var, scales, zero_points, axis)
@@ -58,6 +58,54 @@ DataChannel* DataChannel::newChannel(THDChannelType type, std::string init_metho
 #undef GET_CONFIG
 
 
+void DataChannel::allReduceBucketed(std::vector<at::Tensor>& data,
+                                    THDReduceOp operation,
+                                    std::size_t bucket_bytes,
+                                    THDGroup group_id) {
+  auto tensor_bytes = [](const at::Tensor& tensor) -> std::size_t {
+    return tensor.type().elementSizeInBytes() * tensor.numel();
+  };
+
+  std::size_t begin = 0;
+  while (begin < data.size()) {
+    const auto& type = data[begin].type();
+    std::size_t bytes = tensor_bytes(data[begin]);
+    std::size_t end = begin + 1;
+    while (end < data.size() && &data[end].type() == &type &&
+           bytes + tensor_bytes(data[end]) <= bucket_bytes) {
+      bytes += tensor_bytes(data[end]);
+      ++end;
+    }
+
+    if (end - begin == 1 && data[begin].is_contiguous()) {
+      if (data[begin].numel() > 0)
+        allReduce(data[begin], operation, group_id);
+    } else {
+      std::vector<at::Tensor> flat_tensors;
+      for (std::size_t i = begin; i < end; ++i) {
+        if (data[i].numel() > 0)
+          flat_tensors.push_back(data[i].contiguous().view({-1}));
+      }
+      if (!flat_tensors.empty()) {
+        auto bucket = at::cat(flat_tensors, 0);
+        allReduce(bucket, operation, group_id);
+
+        int64_t offset = 0;
+        for (std::size_t i = begin; i < end; ++i) {
+          int64_t numel = data[i].numel();
+          if (numel == 0)
+            continue;
+          data[i].copy_(bucket.narrow(0, offset, numel).view(data[i].sizes()));
+          offset += numel;
+        }
+      }
+    }
+
+    begin = end;
+  }
+}
+
+
 DataChannel::Group::Group()
 {}
 
@@ -114,6 +114,16 @@ struct DataChannel {
                          THDGroup group_id = THDGroupWORLD) = 0;
   virtual void allReduce(at::Tensor& data, THDReduceOp operation,
                          THDGroup group_id = THDGroupWORLD) = 0;
+  /**
+   * All reduce many (usually small) tensors. Consecutive tensors of the same
+   * type are flattened into buckets of at most `bucket_bytes` bytes and each
+   * bucket is reduced with a single `allReduce`. Tensors larger than
+   * `bucket_bytes` get a bucket of their own.
+   */
+  virtual void allReduceBucketed(std::vector<at::Tensor>& data,
+                                 THDReduceOp operation,
+                                 std::size_t bucket_bytes,
+                                 THDGroup group_id = THDGroupWORLD);
   /**
    * Reduce multiple GPUs on a number of nodes
    * data[0]'s GPU in dstRank will receive the result
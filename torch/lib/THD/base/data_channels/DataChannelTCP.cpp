@@ -37,6 +37,13 @@ inline std::uint64_t pow2(T value) {
   return pof2;
 }
 
+// Tensors of at least this size are reduced with the ring algorithm when the
+// group has more than two processes.
+constexpr std::uint64_t RING_ALLREDUCE_MIN_BYTES = 1 << 16;
+// Ring allreduce transfers chunks in segments of this size, so that reducing
+// one segment overlaps with receiving the next one.
+constexpr std::uint64_t RING_ALLREDUCE_SEGMENT_BYTES = 1 << 18;
+
 } // namespace
 
 
@@ -363,17 +370,12 @@ void DataChannelTCP::scatter(std::vector<at::Tensor>& input,
 void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
                                THDGroup group_id) {
   /*
-   * Allreduce implementation is recursive doubling algorithm. It is good
-   * algorithm for small sizes of message but other (theoratically better)
-   * implementations could not be addapted because of non-commutative
-   * operations on tensors (operation cannot be commutative because this could
-   * introduce different numerical errors on different workers).
+   * Small tensors are reduced with recursive doubling, which needs only
+   * log(p) steps. Large tensors are reduced with the ring algorithm, which
+   * makes every process send and receive ~2n bytes instead of n * log(p).
    *
    * More about efficiency can be found here:
    *   > http://www.mcs.anl.gov/~thakur/papers/ijhpca-coll.pdf (section 4.5)
-   *
-   * Implementation is based on:
-   *   > https://github.com/pmodels/mpich/blob/master/src/mpi/coll/allreduce.c
    */
 
   std::lock_guard<std::mutex> lock(_mutex);
@@ -386,6 +388,31 @@ void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
   if (!exists)
     return;
 
+  std::uint64_t tensor_bytes = data.type().elementSizeInBytes() * data.numel();
+  if (group.size() > 2 && tensor_bytes >= RING_ALLREDUCE_MIN_BYTES &&
+      static_cast<std::uint64_t>(data.numel()) >= group.size()) {
+    _allReduceRing(data, operation, group, group_rank);
+  } else {
+    _allReduceRecursiveDoubling(data, operation, group, group_rank);
+  }
+}
+
+
+void DataChannelTCP::_allReduceRecursiveDoubling(at::Tensor& data,
+                                                 THDReduceOp operation,
+                                                 const DataChannel::Group& group,
+                                                 rank_type group_rank) {
+  /*
+   * Recursive doubling is a good algorithm for small sizes of message.
+   * Reduce-scatter based algorithms like Rabenseifner's could not be adapted
+   * because of non-commutative operations on tensors (operation cannot be
+   * commutative because this could introduce different numerical errors on
+   * different workers).
+   *
+   * Implementation is based on:
+   *   > https://github.com/pmodels/mpich/blob/master/src/mpi/coll/allreduce.c
+   */
+
   std::uint64_t tensor_bytes = data.type().elementSizeInBytes() * data.numel();
   auto tmp_tensor = data.clone();
 
@@ -438,6 +465,108 @@ void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
 }
 
 
+void DataChannelTCP::_allReduceRing(at::Tensor& data, THDReduceOp operation,
+                                    const DataChannel::Group& group,
+                                    rank_type group_rank) {
+  /*
+   * The tensor is split into one chunk per process. In the reduce-scatter
+   * phase every process sends one chunk to its right neighbour in each step
+   * and reduces the chunk received from its left neighbour into its data, so
+   * after p - 1 steps every process holds one fully reduced chunk. In the
+   * allgather phase these chunks go around the ring once more.
+   *
+   * Operations on tensors are not commutative (see recursive doubling), but
+   * every chunk is reduced by a single process in a fixed order and then
+   * copied, so the result is still bitwise identical on all processes.
+   */
+
+  rank_type size = group.size();
+  auto left = group.mustGetGlobalRank((group_rank + size - 1) % size);
+  auto right = group.mustGetGlobalRank((group_rank + 1) % size);
+
+  auto flat = data.view({-1});
+  int64_t chunk_numel = flat.numel() / size;
+  int64_t chunk_rem = flat.numel() % size;
+  auto chunk = [&](rank_type i) {
+    int64_t begin = i * chunk_numel + std::min<int64_t>(i, chunk_rem);
+    return flat.narrow(0, begin, chunk_numel + (static_cast<int64_t>(i) < chunk_rem ? 1 : 0));
+  };
+
+  int64_t segment_numel = std::max<int64_t>(
+    1, RING_ALLREDUCE_SEGMENT_BYTES / data.type().elementSizeInBytes());
+  segment_numel = std::min(segment_numel, chunk_numel + (chunk_rem > 0 ? 1 : 0));
+  auto buffer = data.type().tensor({2, segment_numel});
+
+  for (rank_type step = 0; step < size - 1; ++step) {
+    auto send_chunk = chunk((group_rank + size - step) % size);
+    auto recv_chunk = chunk((group_rank + size - step - 1) % size);
+    _ringExchange(send_chunk, right, recv_chunk, left, buffer, segment_numel,
+                  &operation);
+  }
+
+  for (rank_type step = 0; step < size - 1; ++step) {
+    auto send_chunk = chunk((group_rank + 1 + size - step) % size);
+    auto recv_chunk = chunk((group_rank + size - step) % size);
+    _ringExchange(send_chunk, right, recv_chunk, left, buffer, segment_numel,
+                  nullptr);
+  }
+}
+
+
+void DataChannelTCP::_ringExchange(at::Tensor& send_chunk, rank_type dst_rank,
+                                   at::Tensor& recv_chunk, rank_type src_rank,
+                                   at::Tensor& buffer, int64_t segment_numel,
+                                   const THDReduceOp* operation) {
+  /*
+   * Sends `send_chunk` and receives `recv_chunk` segment by segment. When
+   * `operation` is given, received segments go to alternating halves of
+   * `buffer` and are reduced into `recv_chunk` while the next segment is
+   * being received; otherwise they are received in place.
+   */
+
+  auto segment = [segment_numel](at::Tensor& tensor, int64_t i) {
+    int64_t begin = i * segment_numel;
+    return tensor.narrow(0, begin, std::min(segment_numel, tensor.numel() - begin));
+  };
+  int64_t send_segments = (send_chunk.numel() + segment_numel - 1) / segment_numel;
+  int64_t recv_segments = (recv_chunk.numel() + segment_numel - 1) / segment_numel;
+
+  std::vector<req_ptr> send_requests;
+  for (int64_t i = 0; i < send_segments; ++i) {
+    auto send_segment = segment(send_chunk, i);
+    send_requests.emplace_back(isend(send_segment, dst_rank));
+  }
+
+  if (!operation) {
+    std::vector<req_ptr> recv_requests;
+    for (int64_t i = 0; i < recv_segments; ++i) {
+      auto recv_segment = segment(recv_chunk, i);
+      recv_requests.emplace_back(ireceive(recv_segment, src_rank));
+    }
+    for (auto& request : recv_requests)
+      request->wait();
+  } else {
+    auto receive_segment = [&](int64_t i) {
+      auto target = buffer[i % 2].narrow(0, 0, segment(recv_chunk, i).numel());
+      return req_ptr(ireceive(target, src_rank));
+    };
+    req_ptr recv_request = receive_segment(0);
+    for (int64_t i = 0; i < recv_segments; ++i) {
+      recv_request->wait();
+      if (i + 1 < recv_segments)
+        recv_request = receive_segment(i + 1);
+
+      auto result = segment(recv_chunk, i);
+      auto received = buffer[i % 2].narrow(0, 0, result.numel());
+      _reduce(result, received, *operation);
+    }
+  }
+
+  for (auto& request : send_requests)
+    request->wait();
+}
+
+
 void DataChannelTCP::reduce(at::Tensor& data, THDReduceOp operation,
                             rank_type dst_rank, THDGroup group_id) {
   /*
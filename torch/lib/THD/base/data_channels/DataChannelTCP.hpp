@@ -93,6 +93,15 @@ private:
   void _receive(const at::Tensor& data, rank_type src_id);
   void _reduce(at::Tensor& result, at::Tensor& data,
                THDReduceOp operation) const;
+  void _allReduceRecursiveDoubling(at::Tensor& data, THDReduceOp operation,
+                                   const DataChannel::Group& group,
+                                   rank_type group_rank);
+  void _allReduceRing(at::Tensor& data, THDReduceOp operation,
+                      const DataChannel::Group& group, rank_type group_rank);
+  void _ringExchange(at::Tensor& send_chunk, rank_type dst_rank,
+                     at::Tensor& recv_chunk, rank_type src_rank,
+                     at::Tensor& buffer, int64_t segment_numel,
+                     const THDReduceOp* operation);
 
 
   rank_type _rank; // Rank of current process, range: [0.._processes.size()-1]
@@ -4,6 +4,7 @@
 
 #include <unistd.h>
 #include <climits>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <exception>
@@ -11,33 +12,80 @@
 #include <string>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 #include <iostream>
 
 namespace thd {
 namespace {
 
-void sendMessage(int socket, std::unique_ptr<rpc::RPCMessage> msg) {
-  auto& bytes = msg.get()->bytes();
+constexpr char COMMAND_BATCH_SIZE_ENV[] = "THD_COMMAND_BATCH_SIZE";
+constexpr std::size_t DEFAULT_COMMAND_BATCH_SIZE = 64 * 1024;
+
+std::size_t loadBatchSize() {
+  const char* value = std::getenv(COMMAND_BATCH_SIZE_ENV);
+  if (value == nullptr)
+    return DEFAULT_COMMAND_BATCH_SIZE;
+  // std::stoul skips leading whitespace and wraps negative numbers around,
+  // so only accept plain digits
+  std::string str_value(value);
+  if (str_value.empty() ||
+      str_value.find_first_not_of("0123456789") != std::string::npos)
+    throw std::runtime_error(std::string(COMMAND_BATCH_SIZE_ENV) +
+        " should be a number of bytes, got '" + str_value + "'");
+  try {
+    return std::stoul(str_value);
+  } catch (const std::out_of_range&) {
+    throw std::runtime_error(std::string(COMMAND_BATCH_SIZE_ENV) +
+        " is too large: " + str_value);
+  }
+}
+
+/*
+ * A batch is sent as its total length followed by the messages, each
+ * prefixed with its own length:
+ *   [batch length][msg 1 length][msg 1]...[msg n length][msg n]
+ */
+void appendMessage(std::string& batch, const rpc::ByteArray& bytes) {
   std::uint64_t msg_length = static_cast<std::uint64_t>(bytes.length());
+  batch.append(reinterpret_cast<const char*>(&msg_length), sizeof(msg_length));
+  batch.append(bytes.data(), bytes.length());
+}
 
-  send_bytes<std::uint64_t>(socket, &msg_length, 1, true);
+void sendBatch(int socket, const std::string& batch) {
+  std::uint64_t batch_length = static_cast<std::uint64_t>(batch.size());
+
+  send_bytes<std::uint64_t>(socket, &batch_length, 1, true);
   send_bytes<std::uint8_t>(
     socket,
-    reinterpret_cast<const std::uint8_t*>(bytes.data()),
-    msg_length
+    reinterpret_cast<const std::uint8_t*>(batch.data()),
+    batch_length
   );
 }
 
-std::unique_ptr<rpc::RPCMessage> receiveMessage(int socket) {
-  std::uint64_t msg_length;
-  recv_bytes<std::uint64_t>(socket, &msg_length, 1);
-
-  std::unique_ptr<std::uint8_t[]> bytes(new std::uint8_t[msg_length]);
-  recv_bytes<std::uint8_t>(socket, bytes.get(), msg_length);
-
-  return std::unique_ptr<rpc::RPCMessage>(
-    new rpc::RPCMessage(reinterpret_cast<char*>(bytes.get()), msg_length)
-  );
+std::vector<std::unique_ptr<rpc::RPCMessage>> receiveBatch(int socket) {
+  std::uint64_t batch_length;
+  recv_bytes<std::uint64_t>(socket, &batch_length, 1);
+
+  std::unique_ptr<std::uint8_t[]> bytes(new std::uint8_t[batch_length]);
+  recv_bytes<std::uint8_t>(socket, bytes.get(), batch_length);
+
+  std::vector<std::unique_ptr<rpc::RPCMessage>> messages;
+  std::uint64_t offset = 0;
+  while (offset < batch_length) {
+    std::uint64_t msg_length;
+    if (batch_length - offset < sizeof(msg_length))
+      throw std::runtime_error("received a malformed command batch");
+    std::memcpy(&msg_length, bytes.get() + offset, sizeof(msg_length));
+    offset += sizeof(msg_length);
+    if (batch_length - offset < msg_length)
+      throw std::runtime_error("received a malformed command batch");
+
+    messages.emplace_back(new rpc::RPCMessage(
+      reinterpret_cast<char*>(bytes.get() + offset), msg_length
+    ));
+    offset += msg_length;
+  }
+  return messages;
 }
 
 } // anonymous namespace
@@ -49,6 +97,8 @@ MasterCommandChannel::MasterCommandChannel(InitMethod::Config config)
   , _error_pipe(-1)
   , _error(nullptr)
   , _mutexes(config.world_size)
+  , _batch_size(loadBatchSize())
+  , _batches(config.world_size)
 {
   _sockets[0] = config.master.listen_socket;
 }
@@ -69,6 +119,7 @@ MasterCommandChannel::~MasterCommandChannel() {
     if (socket == -1) continue;
     try {
       sendMessage(rpc::packMessage(Functions::exit), i);
+      flush(i);
     } catch(...) {}
     ::close(socket);
   }
@@ -116,18 +167,50 @@ void MasterCommandChannel::errorHandler() {
   }
 }
 
-void MasterCommandChannel::sendMessage(std::unique_ptr<rpc::RPCMessage> msg, int rank) {
+void MasterCommandChannel::checkError() {
   // Throw error received from a worker.
   if (_error) {
     throw std::runtime_error(*_error);
   }
+}
+
+void MasterCommandChannel::sendMessage(std::unique_ptr<rpc::RPCMessage> msg, int rank) {
+  checkError();
 
   if ((rank <= 0) || (rank >= _sockets.size())) {
     throw std::domain_error("sendMessage received invalid rank as parameter");
   }
 
   std::lock_guard<std::mutex> guard(_mutexes[rank]);
-  ::thd::sendMessage(_sockets[rank], std::move(msg));
+  appendMessage(_batches[rank], msg->bytes());
+  if (_batches[rank].size() >= _batch_size)
+    flushUnlocked(rank);
+}
+
+void MasterCommandChannel::flush(int rank) {
+  checkError();
+
+  if ((rank <= 0) || (rank >= _sockets.size())) {
+    throw std::domain_error("flush received invalid rank as parameter");
+  }
+
+  std::lock_guard<std::mutex> guard(_mutexes[rank]);
+  flushUnlocked(rank);
+}
+
+void MasterCommandChannel::flushAll() {
+  for (std::size_t rank = 1; rank < _sockets.size(); ++rank)
+    flush(rank);
+}
+
+// Requires _mutexes[rank] to be held.
+void MasterCommandChannel::flushUnlocked(int rank) {
+  if (_batches[rank].empty())
+    return;
+
+  std::string batch;
+  std::swap(batch, _batches[rank]);
+  ::thd::sendBatch(_sockets[rank], batch);
 }
 
 std::tuple<rank_type, std::string> MasterCommandChannel::recvError() {
@@ -199,8 +282,8 @@ bool WorkerCommandChannel::init() {
   return true;
 }
 
-std::unique_ptr<rpc::RPCMessage> WorkerCommandChannel::recvMessage() {
-  return ::thd::receiveMessage(_socket);
+std::vector<std::unique_ptr<rpc::RPCMessage>> WorkerCommandChannel::recvMessages() {
+  return ::thd::receiveBatch(_socket);
 }
 
 void WorkerCommandChannel::sendError(const std::string& error) {
@@ -19,11 +19,21 @@ struct MasterCommandChannel {
 
   bool init();
 
+  /*
+   * Commands are buffered per worker and sent as a single framed batch once
+   * the buffer grows past the batch size (THD_COMMAND_BATCH_SIZE bytes, 0
+   * sends every message right away), or when `flush` is called. Callers have
+   * to flush before waiting for anything a worker sends back.
+   */
   void sendMessage(std::unique_ptr<rpc::RPCMessage> msg, int rank);
+  void flush(int rank);
+  void flushAll();
 
 private:
   std::tuple<rank_type, std::string> recvError();
   void errorHandler();
+  void checkError();
+  void flushUnlocked(int rank);
 
   rank_type _rank;
   std::vector<int> _sockets;
@@ -33,6 +43,9 @@ private:
   std::unique_ptr<std::string> _error;
   std::thread _error_thread;
   std::vector<std::mutex> _mutexes;
+
+  std::size_t _batch_size;
+  std::vector<std::string> _batches;
 };
 
 struct WorkerCommandChannel {
@@ -41,7 +54,8 @@ struct WorkerCommandChannel {
 
   bool init();
 
-  std::unique_ptr<rpc::RPCMessage> recvMessage();
+  // Receives one batch of commands, in the order they were sent.
+  std::vector<std::unique_ptr<rpc::RPCMessage>> recvMessages();
   void sendError(const std::string& error);
 
 private:
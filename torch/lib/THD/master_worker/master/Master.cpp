@@ -40,3 +40,9 @@ void THDMasterWorkerInit(THDChannelType channel_type, std::string init_method =
 
   END_HANDLE_EXCEPTIONS
 }
+
+void THDMasterWorkerFlush() {
+  HANDLE_EXCEPTIONS
+  masterCommandChannel->flushAll();
+  END_HANDLE_EXCEPTIONS
+}
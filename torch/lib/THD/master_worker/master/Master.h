@@ -5,3 +5,5 @@
 
 THD_API void THDMasterWorkerInit(THDChannelType channel_type, std::string init_method,
                                  int world_size, std::string group_name, int rank);
+// Sends all commands the master still buffers to the workers.
+THD_API void THDMasterWorkerFlush();
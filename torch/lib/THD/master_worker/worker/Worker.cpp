@@ -24,16 +24,17 @@ using namespace thd::worker;
 void THDWorkerMain(std::string init_method, int world_size,
                    std::string group_name, int rank) {
   auto config = thd::getInitConfig(init_method, world_size, group_name, rank);
-  std::unique_ptr<RPCMessage> command;
   workerCommandChannel.reset(new thd::WorkerCommandChannel(config));
   if (!workerCommandChannel->init()) {
     return;
   }
 
   while (true) {
-    command = workerCommandChannel->recvMessage();
+    auto commands = workerCommandChannel->recvMessages();
     try {
-      execute(std::move(command));
+      for (auto& command : commands) {
+        execute(std::move(command));
+      }
     } catch (std::exception& e) {
       std::cerr << "WORKER ERROR: " << e.what() << std::endl;
       workerCommandChannel->sendError(e.what());
@@ -27,6 +27,15 @@ void THDAllReduce(THDTensorDescriptor& desc, THDReduceOp operation, THDGroup gro
   dataChannel->allReduce(desc, operation, group);
 }
 
+void THDAllReduceBucketed(THDTensorDescriptor* data,
+                          size_t len,
+                          THDReduceOp operation,
+                          size_t bucket_bytes,
+                          THDGroup group) {
+  std::vector<at::Tensor> dataVec(data, data + len);
+  dataChannel->allReduceBucketed(dataVec, operation, bucket_bytes, group);
+}
+
 void THDReduceMultiGPU(THDTensorDescriptor* desc,
                        size_t len,
                        THDReduceOp operation,
@@ -11,6 +11,11 @@ THD_API void THDAllReduceMultiGPU(THDTensorDescriptor* data,
                                   THDGroup group);
 THD_API void THDAllReduce(THDTensorDescriptor& desc, THDReduceOp operation,
                           THDGroup group);
+THD_API void THDAllReduceBucketed(THDTensorDescriptor* data,
+                                  size_t len,
+                                  THDReduceOp operation,
+                                  size_t bucket_bytes,
+                                  THDGroup group);
 THD_API void THDReduceMultiGPU(THDTensorDescriptor* desc,
                                size_t len,
                                THDReduceOp operation,
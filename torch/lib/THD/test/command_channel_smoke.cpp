@@ -9,12 +9,17 @@
 #include <string>
 #include <system_error>
 #include <thread>
+#include <vector>
 
 using namespace thd;
 
 std::vector<std::thread> g_all_workers;
 std::mutex g_mutex;
 std::unique_ptr<Barrier> g_barrier;
+std::unique_ptr<Barrier> g_first_batch;
+bool g_batched;
+
+constexpr std::size_t NUM_MESSAGES = 3;
 
 void init_worker(const int& rank, const std::string& master_addr) {
   g_mutex.lock();
@@ -25,12 +30,28 @@ void init_worker(const int& rank, const std::string& master_addr) {
 
   assert(channel->init());
 
-  auto msg = channel->recvMessage();
-  std::string expected = std::string("hello to worker ") +
-      std::to_string(rank) + " from master";
-  fprintf(stderr, "Worker %d: received '%.*s'\n", rank,
-      (int)msg.get()->bytes().length(), msg.get()->bytes().data());
-  assert(expected.compare(msg.get()->bytes().to_string()) == 0);
+  std::vector<std::unique_ptr<rpc::RPCMessage>> msgs;
+  // the master flushes after the first message, long before the batch is full
+  auto first = channel->recvMessages();
+  assert(first.size() == 1);
+  msgs.push_back(std::move(first[0]));
+  g_first_batch->wait();
+
+  while (msgs.size() < NUM_MESSAGES) {
+    auto batch = channel->recvMessages();
+    // with batching enabled the rest arrives in a single batch
+    assert(g_batched ? batch.size() == NUM_MESSAGES - 1 : batch.size() == 1);
+    for (auto& msg : batch)
+      msgs.push_back(std::move(msg));
+  }
+
+  for (std::size_t i = 0; i < NUM_MESSAGES; ++i) {
+    std::string expected = std::string("hello to worker ") +
+        std::to_string(rank) + " from master (" + std::to_string(i) + ")";
+    fprintf(stderr, "Worker %d: received '%.*s'\n", rank,
+        (int)msgs[i].get()->bytes().length(), msgs[i].get()->bytes().data());
+    assert(expected.compare(msgs[i].get()->bytes().to_string()) == 0);
+  }
 
   /*
    * We need to wait until master will do all receiving and sending. This
@@ -45,21 +66,35 @@ void init_master(int world_size, const std::string& master_port) {
   setenv(WORLD_SIZE_ENV, std::to_string(world_size).data(), 1);
   setenv(RANK_ENV, "0", 1);
   setenv(MASTER_PORT_ENV, master_port.data(), 1);
+  setenv("THD_COMMAND_BATCH_SIZE", g_batched ? "65536" : "0", 1);
   auto channel = std::make_shared<thd::MasterCommandChannel>(thd::getInitConfig("env://")); // reads all env variable
   g_mutex.unlock();
 
   assert(channel->init());
 
-  for (int worker_rank = 1; worker_rank < world_size; ++worker_rank) {
-    rpc::ByteArray arr;
-    arr.append("hello to worker ", sizeof("hello to worker ") - 1);
-    arr.append(std::to_string(worker_rank).c_str(), std::to_string(worker_rank).size());
-    arr.append(" from master", sizeof(" from master") - 1);
+  auto send = [&](int worker_rank, std::size_t i) {
+    std::string str = std::string("hello to worker ") +
+        std::to_string(worker_rank) + " from master (" + std::to_string(i) + ")";
+    rpc::ByteArray arr(str.data(), str.size());
 
     fprintf(stderr, "master: about to send a message to worker %d\n", worker_rank);
     auto rpc_msg = std::unique_ptr<rpc::RPCMessage>(new rpc::RPCMessage(arr));
     channel->sendMessage(std::move(rpc_msg), worker_rank);
+  };
+
+  for (int worker_rank = 1; worker_rank < world_size; ++worker_rank) {
+    send(worker_rank, 0);
   }
+  channel->flushAll();
+  // the workers only get here once the partial batches have arrived
+  g_first_batch->wait();
+
+  for (int worker_rank = 1; worker_rank < world_size; ++worker_rank) {
+    for (std::size_t i = 1; i < NUM_MESSAGES; ++i) {
+      send(worker_rank, i);
+    }
+  }
+  channel->flushAll();
 
   g_barrier->wait();
 
@@ -70,8 +105,11 @@ void init_master(int world_size, const std::string& master_port) {
 }
 
 void run_test_case(const std::string& name, int world_size,
-                   const std::string& master_addr, const std::string& master_port) {
+                   const std::string& master_addr, const std::string& master_port,
+                   bool batched = true) {
+  g_batched = batched;
   g_barrier.reset(new Barrier(world_size));
+  g_first_batch.reset(new Barrier(world_size));
   for (int rank = 1; rank < world_size; ++rank) {
     g_all_workers.push_back(
       std::thread(init_worker, rank, master_addr + ":" + master_port)
@@ -109,6 +147,12 @@ int main() {
     master_port = "55555";
     run_test_case(test_name, world_size, master_addr, master_port);
 
+    test_name = "Unbatched test";
+    world_size = 4;
+    master_addr = "127.0.0.1";
+    master_port = "55555";
+    run_test_case(test_name, world_size, master_addr, master_port, false);
+
     test_name = "Many workers test";
     world_size = 12;
     master_addr = "127.0.0.1";
@@ -143,6 +143,14 @@ void test_allReduce(std::shared_ptr<thd::DataChannel> data_channel, int workers)
                          -1, data_channel->getNumProcesses() - 1);
 }
 
+void test_allReduce_large(std::shared_ptr<thd::DataChannel> data_channel, int workers) {
+  // large enough for the ring algorithm of DataChannelTCP
+  auto rank = data_channel->getRank();
+  auto int_tensor = buildTensor<int>({256, 1024}, rank == 0 ? 2 : rank);
+  data_channel->allReduce(*int_tensor, THDReduceOp::THDReduceSUM, 0);
+  ASSERT_TENSOR_VALUE(int, *int_tensor, 2 + (workers * (workers + 1) / 2))
+}
+
 void test_scatter(std::shared_ptr<thd::DataChannel> data_channel) {
   if (g_data_channel_type == "gloo") {
     return; // XXX: Gloo does not support scatter
@@ -618,6 +626,7 @@ void run_all_tests(std::shared_ptr<thd::DataChannel> data_channel, int workers)
   test_broadcast(data_channel);
   test_reduce(data_channel, workers);
   test_allReduce(data_channel, workers);
+  test_allReduce_large(data_channel, workers);
   test_scatter(data_channel);
   test_gather(data_channel);
   test_allGather(data_channel);
@@ -1,4 +1,5 @@
 import warnings
+import torch
 from torch.autograd import NestedIOFunction
 import torch.backends.cudnn as cudnn
 from .. import functional as F
@@ -9,6 +10,15 @@ try:
 except ImportError:
     pass
 
+# CPU tensor types with fused THNN cell kernels
+_fused_cpu_types = {'torch.FloatTensor', 'torch.DoubleTensor'}
+
+
+def _use_fused(input):
+    # The fused backward falls back to autograd ops when it records a graph,
+    # so the cells that are trained use the kernels too.
+    return input.is_cuda or input.data.type() in _fused_cpu_types
+
 
 def RNNReLUCell(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
     hy = F.relu(F.linear(input, w_ih, b_ih) + F.linear(hidden, w_hh, b_hh))
@@ -21,7 +31,7 @@ def RNNTanhCell(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
 
 
 def LSTMCell(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
-    if input.is_cuda:
+    if _use_fused(input):
         igates = F.linear(input, w_ih)
         hgates = F.linear(hidden[0], w_hh)
         state = fusedBackend.LSTMFused.apply
@@ -45,7 +55,7 @@ def LSTMCell(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
 
 def GRUCell(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
 
-    if input.is_cuda:
+    if _use_fused(input):
         gi = F.linear(input, w_ih)
         gh = F.linear(hidden, w_hh)
         state = fusedBackend.GRUFused.apply
@@ -1,5 +1,6 @@
 import torch
-from torch.autograd.function import Function, InplaceFunction, once_differentiable
+from torch.autograd import Variable
+from torch.autograd.function import Function, InplaceFunction
 from torch._thnn import type2backend
 
 
@@ -11,6 +12,8 @@ class GRUFused(Function):
         hy = input_gate.new()
         workspace = input_gate.new(hx.numel() * 5)
 
+        # the gate inputs are only read back when backward records a graph
+        ctx.save_for_backward(input_gate, hidden_gate, hx, ibias, hbias)
         ctx.has_bias = False
         if ibias is not None:
             ctx.has_bias = True
@@ -30,17 +33,45 @@ class GRUFused(Function):
         return hy
 
     @staticmethod
-    @once_differentiable
     def backward(ctx, gradOutput):
-        ctx.backend = type2backend[type(gradOutput)]
+        if torch.is_grad_enabled():
+            # create_graph: differentiate the cell with autograd ops instead
+            return GRUFused._differentiable_backward(ctx, gradOutput)
 
-        gradInputHx = gradOutput.new()
-        gradInInput = gradOutput.new(*ctx.igate_size)
-        gradInHidden = gradOutput.new(*ctx.hgate_size)
+        backend = type2backend[type(gradOutput.data)]
 
-        ctx.backend.GRUFused_updateGradInput(
-            ctx.backend.library_state,
-            gradInInput, gradInHidden, gradOutput, gradInputHx, ctx.workspace)
+        gradInputHx = gradOutput.data.new()
+        gradInInput = gradOutput.data.new(*ctx.igate_size)
+        gradInHidden = gradOutput.data.new(*ctx.hgate_size)
+
+        backend.GRUFused_updateGradInput(
+            backend.library_state,
+            gradInInput, gradInHidden, gradOutput.data, gradInputHx, ctx.workspace)
+
+        gb1 = gb2 = None
+        if ctx.has_bias:
+            gb1 = Variable(gradInInput.sum(0, keepdim=False))
+            gb2 = Variable(gradInHidden.sum(0, keepdim=False))
+        return Variable(gradInInput), Variable(gradInHidden), Variable(gradInputHx), gb1, gb2
+
+    @staticmethod
+    def _differentiable_backward(ctx, gradOutput):
+        input_gate, hidden_gate, hx, ibias, hbias = ctx.saved_variables
+        if ctx.has_bias:
+            input_gate = input_gate + ibias
+            hidden_gate = hidden_gate + hbias
+        i_r, i_i, i_n = input_gate.chunk(3, 1)
+        h_r, h_i, h_n = hidden_gate.chunk(3, 1)
+        resetgate = (i_r + h_r).sigmoid()
+        inputgate = (i_i + h_i).sigmoid()
+        newgate = (i_n + resetgate * h_n).tanh()
+
+        gradInputHx = gradOutput * inputgate
+        gradNew = gradOutput * (1 - inputgate) * (1 - newgate * newgate)
+        gradReset = gradNew * h_n * resetgate * (1 - resetgate)
+        gradInput = gradOutput * (hx - newgate) * inputgate * (1 - inputgate)
+        gradInInput = torch.cat([gradReset, gradInput, gradNew], 1)
+        gradInHidden = torch.cat([gradReset, gradInput, gradNew * resetgate], 1)
 
         gb1 = gb2 = None
         if ctx.has_bias:
@@ -56,6 +87,13 @@ class LSTMFused(Function):
         hy = input_gate.new()
         cy = input_gate.new()
 
+        # The kernel overwrites input_gate with the activated gates. When a
+        # graph is recorded the original gates are kept for a backward that
+        # records a graph too.
+        gates = input_gate
+        if any(ctx.needs_input_grad):
+            gates = input_gate.clone()
+        ctx.save_for_backward(input_gate, hidden_gate, cx, ibias, hbias, cy)
         ctx.has_bias = False
         if ibias is not None:
             ctx.has_bias = True
@@ -64,30 +102,62 @@ class LSTMFused(Function):
             if hbias.dim() == 1:
                 hbias = hbias.unsqueeze(0)
 
-        # input_gate gets overwritten with some intermediate values to use in backwards
         ctx.backend.LSTMFused_updateOutput(
             ctx.backend.library_state,
-            input_gate, hidden_gate,
+            gates, hidden_gate,
             ibias, hbias,
             cx, hy, cy)
 
+        ctx.gates = gates
         ctx.hgate_size = hidden_gate.size()
-        ctx.save_for_backward(input_gate, cx, cy)
 
         return hy, cy
 
     @staticmethod
-    @once_differentiable
     def backward(ctx, *gradOutput):
-        ctx.backend = type2backend[type(gradOutput[0])]
-        gradInputCx = gradOutput[0].new()
-        gradInGates = gradOutput[0].new(*ctx.hgate_size)
+        if torch.is_grad_enabled():
+            # create_graph: differentiate the cell with autograd ops instead
+            return LSTMFused._differentiable_backward(ctx, *gradOutput)
 
-        saved_tens, cx, cy = ctx.saved_tensors
-        ctx.backend.LSTMFused_updateGradInput(
-            ctx.backend.library_state,
-            saved_tens, gradInGates, cx, cy,
-            gradOutput[0], gradOutput[1], gradInputCx)
+        backend = type2backend[type(gradOutput[0].data)]
+        gradInputCx = gradOutput[0].data.new()
+        gradInGates = gradOutput[0].data.new(*ctx.hgate_size)
+
+        _, _, cx, _, _, cy = ctx.saved_tensors
+        backend.LSTMFused_updateGradInput(
+            backend.library_state,
+            ctx.gates, gradInGates, cx, cy,
+            gradOutput[0].data, gradOutput[1].data, gradInputCx)
+
+        gb1 = gb2 = None
+        if ctx.has_bias:
+            gb1 = Variable(gradInGates.sum(0, keepdim=False))
+            gb2 = Variable(gradInGates.sum(0, keepdim=False))
+
+        gradInGates = Variable(gradInGates)
+        return gradInGates, gradInGates, Variable(gradInputCx), gb1, gb2
+
+    @staticmethod
+    def _differentiable_backward(ctx, gradHy, gradCy):
+        input_gate, hidden_gate, cx, ibias, hbias, _ = ctx.saved_variables
+        gates = input_gate + hidden_gate
+        if ctx.has_bias:
+            gates = gates + ibias + hbias
+        ingate, forgetgate, cellgate, outgate = gates.chunk(4, 1)
+        ingate = ingate.sigmoid()
+        forgetgate = forgetgate.sigmoid()
+        cellgate = cellgate.tanh()
+        outgate = outgate.sigmoid()
+        tanh_cy = (forgetgate * cx + ingate * cellgate).tanh()
+
+        gradCy = gradCy + gradHy * outgate * (1 - tanh_cy * tanh_cy)
+        gradInGates = torch.cat([
+            gradCy * cellgate * ingate * (1 - ingate),
+            gradCy * cx * forgetgate * (1 - forgetgate),
+            gradCy * ingate * (1 - cellgate * cellgate),
+            gradHy * tanh_cy * outgate * (1 - outgate),
+        ], 1)
+        gradInputCx = gradCy * forgetgate
 
         gb1 = gb2 = None
         if ctx.has_bias: